@@ -0,0 +1,74 @@
+/*! --------------------------------------------------------------------
+ *	Telemetry System	-	@file nmea_throughput.c
+ *----------------------------------------------------------------------
+ * HES-SO Valais Wallis 
+ * Systems Engineering
+ * Infotronics
+ * ---------------------------------------------------------------------
+ * @author agent
+ * @date 19.10.2026
+ * ---------------------------------------------------------------------
+ * @brief throughput benchmark of the NMEA parser of the transmitter : a
+ *        stream of the sentences of one epoch is parsed one character at
+ *        a time, the time per sentence and per character is printed
+ *
+ *        usage : nmea_throughput [epochs]
+ * ---------------------------------------------------------------------
+ * Telemetry system for the Valais Wallis Racing Team.
+ * This file contains code for the base station of the telemetry system.
+ * The base station receives the live measurements sent via Wi-Fi by the
+ * onboard device and stores them for the dashboards.
+ *--------------------------------------------------------------------*/
+
+//includes
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+//project file includes
+#include "nmea_parser.h"
+
+//sentences of one epoch of a u-blox module
+static const char * sentences[] = {
+    "$GNRMC,162134.00,A,4617.63609,N,00731.94398,E,0.006,,170524,,,A,V*",
+    "$GNVTG,,T,,M,0.006,N,0.011,K,A*",
+    "$GNGGA,162134.00,4617.63609,N,00731.94398,E,1,12,0.9,500.0,M,48.0,M,,*",
+    "$GNGSA,A,3,10,12,,,,,,,,,,,1.5,0.9,1.2,1*",
+    "$GPGSV,3,1,11,10,62,291,42,12,46,065,40,13,10,321,28,15,45,229,38*",      //not used : skipped
+    "$GNGLL,4617.63609,N,00731.94398,E,162134.00,A,A*",
+};
+
+int main(int argc, char ** argv)
+{
+    long epochs = argc > 1 ? atol(argv[1]) : 200000;
+    char stream[1024] = "";
+
+    for(size_t i = 0; i < sizeof(sentences)/sizeof(sentences[0]); i++)
+    {
+        uint8_t checksum = 0;
+        for(const char * p = sentences[i] + 1; *p != '*'; p++)
+            checksum ^= (uint8_t)*p;
+        sprintf(stream + strlen(stream), "%s%02X\r\n", sentences[i], checksum);
+    }
+    size_t length = strlen(stream);
+
+    tNmeaParser parser;
+    nmea_parser_init(&parser);
+
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    long count = 0;
+    for(long e = 0; e < epochs; e++)
+        for(size_t i = 0; i < length; i++)
+            count += nmea_parse(&parser, (uint8_t)stream[i]) != NMEA_SENTENCE_NONE;
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+
+    printf("nmea parser : %ld sentences in %.3f s, %.0f ns/sentence, %.1f ns/character, %.1f MB/s (errors %u)\n",
+           count, seconds, seconds / count * 1e9, seconds / (epochs * length) * 1e9,
+           epochs * length / seconds / 1e6, parser.checksumErrors + parser.formatErrors);
+    return 0;
+}
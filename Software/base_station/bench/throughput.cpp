@@ -0,0 +1,218 @@
+/*! --------------------------------------------------------------------
+ *	Telemetry System	-	@file throughput.cpp
+ *----------------------------------------------------------------------
+ * HES-SO Valais Wallis 
+ * Systems Engineering
+ * Infotronics
+ * ---------------------------------------------------------------------
+ * @author agent
+ * @date 19.10.2026
+ * ---------------------------------------------------------------------
+ * @brief throughput benchmark of the base station : synthetic live
+ *        packets of each format are decoded and stored in a temporary
+ *        column store, the number of packets per second is printed
+ *
+ *        usage : base_station_bench [channels] [packets]
+ * ---------------------------------------------------------------------
+ * Telemetry system for the Valais Wallis Racing Team.
+ * This file contains code for the base station of the telemetry system.
+ * The base station receives the live measurements sent via Wi-Fi by the
+ * onboard device and stores them for the dashboards.
+ *--------------------------------------------------------------------*/
+
+//includes
+#include <arpa/inet.h>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+//project file includes
+#include "live_decoder.h"
+#include "live_protocol.h"
+#include "receiver.h"
+
+namespace {
+
+typedef std::vector<uint8_t> Packet;
+
+void put32(Packet & p, uint32_t v)
+{
+    for(int i = 0; i < 4; i++)
+        p.push_back(v >> (8 * i));
+}
+
+Packet header(uint8_t type, uint32_t sequence, uint32_t hash)
+{
+    tLiveHeader h;
+    h.magic = LIVE_MAGIC;
+    h.version = LIVE_PROTOCOL_VERSION;
+    h.type = type;
+    h.keepAlive = sequence % 100;
+    h.sequence = sequence;
+    h.schemaHash = hash;
+    h.time = 1760000000000000ULL + sequence * 1000ULL;
+    Packet p(sizeof(h));
+    memcpy(p.data(), &h, sizeof(h));
+    return p;
+}
+
+//channel descriptors of the synthetic car (all u32) and their hash
+Packet descriptors(int channels, uint32_t & hash)
+{
+    Packet d;
+    for(int i = 0; i < channels; i++)
+    {
+        std::string name = "Sensor" + std::to_string(i);
+        d.push_back(LIVE_CH_U32);
+        d.push_back(name.size());
+        d.insert(d.end(), name.begin(), name.end());
+        d.push_back(0);
+    }
+    hash = liveCrc32(0, d.data(), d.size());
+    return d;
+}
+
+Packet schemaPacket(int channels)
+{
+    uint32_t hash;
+    Packet d = descriptors(channels, hash);
+    Packet p = header(LIVE_PKT_SCHEMA, 0, hash);
+
+    tLiveSchemaHeader s{0, 1, 0, (uint16_t)channels};
+    p.resize(p.size() + sizeof(s));
+    memcpy(p.data() + p.size() - sizeof(s), &s, sizeof(s));
+    p.insert(p.end(), d.begin(), d.end());
+    return p;
+}
+
+uint32_t value(int channel, uint32_t sequence)
+{
+    //a quarter of the channels change on every sample
+    return channel % 4 == 0 ? sequence * 7 + channel : channel * 1000;
+}
+
+Packet dataPacket(int channels, uint32_t sequence, uint32_t hash)
+{
+    Packet p = header(LIVE_PKT_DATA, sequence, hash);
+    for(int i = 0; i < channels; i++)
+        put32(p, value(i, sequence));
+    return p;
+}
+
+Packet deltaPacket(int channels, uint32_t sequence, uint32_t keyframe, uint32_t hash)
+{
+    Packet p = header(LIVE_PKT_DELTA, sequence, hash);
+    put32(p, keyframe);
+
+    size_t bitmap = p.size();
+    p.resize(p.size() + (channels + 7) / 8, 0);
+    for(int i = 0; i < channels; i++)
+    {
+        if(value(i, sequence) != value(i, keyframe))
+        {
+            p[bitmap + i / 8] |= 1 << (i % 8);
+            put32(p, value(i, sequence));
+        }
+    }
+    return p;
+}
+
+Packet jsonPacket(int channels, uint32_t sequence)
+{
+    std::string s;
+    char sep = '{';
+    for(int i = 0; i < channels; i++)
+    {
+        s += sep;
+        s += "\"Sensor" + std::to_string(i) + "\":" + std::to_string(value(i, sequence));
+        sep = ',';
+    }
+    s += ",\"Time\":" + std::to_string(1760000000000000ULL + sequence * 1000ULL);
+    s += ",\"Seq\":" + std::to_string(sequence) + ",\"KeepAliveCounter\":" + std::to_string(sequence % 100) + "}";
+    return Packet(s.begin(), s.end());
+}
+
+//decode and store the packets, returns the packets per second
+double run(const char * format, const std::vector<Packet> & packets, const std::string & directory, int channels)
+{
+    ReceiverOptions options;
+    options.storeDirectory = directory + "/" + format;
+    options.nack = false;
+    Receiver receiver(options);
+
+    sockaddr_in from{};
+    from.sin_family = AF_INET;
+    from.sin_addr.s_addr = htonl(0x0A000002);
+
+    auto start = std::chrono::steady_clock::now();
+    int64_t time = 1760000000000000000LL;      //same clock as the packets (ns)
+    for(const Packet & p : packets)
+        receiver.handle(-1, from, p.data(), p.size(), time += 1000000);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    double rate = packets.size() / seconds;
+    size_t bytes = 0;
+    for(const Packet & p : packets)
+        bytes += p.size();
+    printf("%-8s %4d channels : %9.0f packets/s, %7.1f MB/s, %5.2f us/packet\n",
+           format, channels, rate, bytes / seconds / 1e6, seconds * 1e6 / packets.size());
+    receiver.printStats();
+    return rate;
+}
+
+} // namespace
+
+int main(int argc, char ** argv)
+{
+    int channels = argc > 1 ? atoi(argv[1]) : 100;
+    int count = argc > 2 ? atoi(argv[2]) : 200000;
+    if(channels <= 0 || channels > 200 || count <= 0)
+    {
+        fprintf(stderr, "usage : %s [channels (1..200)] [packets]\n", argv[0]);
+        return 1;
+    }
+
+    char directory[] = "/tmp/base_station_benchXXXXXX";
+    if(!mkdtemp(directory))
+    {
+        perror("mkdtemp");
+        return 1;
+    }
+
+    uint32_t hash;
+    descriptors(channels, hash);
+
+    std::vector<Packet> json, binary, delta;
+    for(int i = 0; i < count; i++)
+        json.push_back(jsonPacket(channels, i));
+
+    binary.push_back(schemaPacket(channels));
+    for(int i = 0; i < count; i++)
+        binary.push_back(dataPacket(channels, i, hash));
+
+    //keyframe every 50 packets, as LiveKeyframePeriod
+    delta.push_back(schemaPacket(channels));
+    uint32_t keyframe = 0;
+    for(int i = 0; i < count; i++)
+    {
+        if(i % 50 == 0)
+        {
+            keyframe = i;
+            delta.push_back(dataPacket(channels, i, hash));
+        }
+        else
+        {
+            delta.push_back(deltaPacket(channels, i, keyframe, hash));
+        }
+    }
+
+    run("json", json, directory, channels);
+    run("binary", binary, directory, channels);
+    run("delta", delta, directory, channels);
+
+    std::string cleanup = std::string("rm -rf ") + directory;
+    return system(cleanup.c_str()) == 0 ? 0 : 1;
+}
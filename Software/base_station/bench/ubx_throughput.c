@@ -0,0 +1,61 @@
+/*! --------------------------------------------------------------------
+ *	Telemetry System	-	@file ubx_throughput.c
+ *----------------------------------------------------------------------
+ * HES-SO Valais Wallis 
+ * Systems Engineering
+ * Infotronics
+ * ---------------------------------------------------------------------
+ * @author agent
+ * @date 19.10.2026
+ * ---------------------------------------------------------------------
+ * @brief throughput benchmark of the UBX parser of the transmitter : a
+ *        stream of NAV-PVT frames is parsed one byte at a time, the time
+ *        per frame and per byte is printed to compare with the NMEA path
+ *
+ *        usage : ubx_throughput [frames]
+ * ---------------------------------------------------------------------
+ * Telemetry system for the Valais Wallis Racing Team.
+ * This file contains code for the base station of the telemetry system.
+ * The base station receives the live measurements sent via Wi-Fi by the
+ * onboard device and stores them for the dashboards.
+ *--------------------------------------------------------------------*/
+
+//includes
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+//project file includes
+#include "ubx_parser.h"
+
+int main(int argc, char ** argv)
+{
+    long frames = argc > 1 ? atol(argv[1]) : 1000000;
+    uint8_t payload[UBX_NAV_PVT_LENGTH];
+    uint8_t frame[UBX_NAV_PVT_LENGTH + UBX_FRAME_OVERHEAD];
+
+    for(size_t i = 0; i < sizeof(payload); i++)
+        payload[i] = (uint8_t)(i * 37);
+    payload[20] = UBX_FIX_3D;
+    int length = ubx_frame(frame, UBX_CLASS_NAV, UBX_ID_NAV_PVT, payload, sizeof(payload));
+
+    tUbxParser parser;
+    ubx_parser_init(&parser);
+
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    long count = 0;
+    for(long f = 0; f < frames; f++)
+        for(int i = 0; i < length; i++)
+            count += ubx_parse(&parser, frame[i]) == UBX_MSG_NAV_PVT;
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+
+    printf("ubx parser : %ld frames in %.3f s, %.0f ns/frame, %.1f ns/byte, %.1f MB/s (errors %u)\n",
+           count, seconds, seconds / count * 1e9, seconds / ((double)frames * length) * 1e9,
+           frames * length / seconds / 1e6, parser.checksumErrors + parser.formatErrors);
+    return 0;
+}
@@ -0,0 +1,231 @@
+/*! --------------------------------------------------------------------
+ *	Telemetry System	-	@file column_store.cpp
+ *----------------------------------------------------------------------
+ * HES-SO Valais Wallis 
+ * Systems Engineering
+ * Infotronics
+ * ---------------------------------------------------------------------
+ * @author agent
+ * @date 19.10.2026
+ * ---------------------------------------------------------------------
+ * @brief Column store appends the decoded samples of one car to memory
+ *        mapped column files that the dashboards can map read-only.
+ * ---------------------------------------------------------------------
+ * Telemetry system for the Valais Wallis Racing Team.
+ * This file contains code for the base station of the telemetry system.
+ * The base station receives the live measurements sent via Wi-Fi by the
+ * onboard device and stores them for the dashboards.
+ *--------------------------------------------------------------------*/
+
+//includes
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+//project file includes
+#include "column_store.h"
+
+//rows of a new column file (the files grow by doubling)
+#define COLUMN_INITIAL_ROWS (64*1024)
+
+namespace {
+
+//create a directory and its parents
+bool makeDirectories(const std::string & path)
+{
+    for(size_t pos = path.find('/', 1); ; pos = path.find('/', pos + 1))
+    {
+        std::string part = path.substr(0, pos);
+        if(mkdir(part.c_str(), 0755) != 0 && errno != EEXIST)
+            return false;
+        if(pos == std::string::npos)
+            return true;
+    }
+}
+
+//file name of a column (characters that are not allowed in file names are replaced)
+std::string columnFileName(const std::string & name)
+{
+    std::string file = name;
+    for(char & c : file)
+    {
+        if(c == '/' || c == '\\' || c == ' ' || c == '\0')
+            c = '_';
+    }
+    return file + ".col";
+}
+
+} // namespace
+
+//-----------------------------------------------------------------------------------------------------------------------
+ColumnStore::ColumnStore(std::string directory)
+    : directory_(std::move(directory)),
+      segment_(-1),
+      rows_(0),
+      capacity_(0)
+{
+}
+
+ColumnStore::~ColumnStore()
+{
+    closeSegment();
+}
+
+//-----------------------------------------------------------------------------------------------------------------------
+/*! @brief close the current segment and open a new one with these value columns
+*   @retval false if a file could not be created
+*/
+bool ColumnStore::openSegment(const std::vector<std::string> & columns)
+{
+    closeSegment();
+
+    //next free segment number (segments of a previous run are kept)
+    std::string segmentDir;
+    struct stat st;
+    do
+    {
+        segment_++;
+        segmentDir = directory_ + "/segment_" + std::to_string(segment_);
+    } while(stat(segmentDir.c_str(), &st) == 0);
+
+    if(!makeDirectories(segmentDir))
+    {
+        fprintf(stderr, "column store : cannot create %s (%s)\n", segmentDir.c_str(), strerror(errno));
+        return false;
+    }
+
+    rows_ = 0;
+    capacity_ = COLUMN_INITIAL_ROWS;
+
+    bool ok = openColumn(segmentDir + "/time.col", "time", COLUMN_TYPE_INT64) &&
+              openColumn(segmentDir + "/seq.col", "seq", COLUMN_TYPE_UINT64);
+
+    for(size_t i = 0; ok && i < columns.size(); i++)
+        ok = openColumn(segmentDir + "/" + std::to_string(i) + "_" + columnFileName(columns[i]), columns[i], COLUMN_TYPE_FLOAT64);
+
+    if(!ok)
+        closeSegment();
+    return ok;
+}
+
+//-----------------------------------------------------------------------------------------------------------------------
+/*! @brief create and map a column file
+*/
+bool ColumnStore::openColumn(const std::string & path, const std::string & name, uint32_t type)
+{
+    Column column{};
+    column.fd = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if(column.fd < 0)
+    {
+        fprintf(stderr, "column store : cannot create %s (%s)\n", path.c_str(), strerror(errno));
+        return false;
+    }
+
+    column.mapSize = sizeof(ColumnHeader) + capacity_ * sizeof(double);
+    if(ftruncate(column.fd, column.mapSize) != 0)
+    {
+        close(column.fd);
+        return false;
+    }
+
+    void * map = mmap(nullptr, column.mapSize, PROT_READ | PROT_WRITE, MAP_SHARED, column.fd, 0);
+    if(map == MAP_FAILED)
+    {
+        close(column.fd);
+        return false;
+    }
+
+    column.map = (uint8_t *)map;
+    column.header = (ColumnHeader *)map;
+    memcpy(column.header->magic, COLUMN_MAGIC, sizeof(COLUMN_MAGIC));
+    column.header->type = type;
+    column.header->elementSize = sizeof(double);
+    column.header->rows = 0;
+    column.header->capacity = capacity_;
+    strncpy(column.header->name, name.c_str(), sizeof(column.header->name) - 1);
+
+    columns_.push_back(column);
+    return true;
+}
+
+//-----------------------------------------------------------------------------------------------------------------------
+/*! @brief double the capacity of all the columns of the segment
+*/
+bool ColumnStore::grow()
+{
+    uint64_t capacity = capacity_ * 2;
+
+    for(auto & column : columns_)
+    {
+        size_t mapSize = sizeof(ColumnHeader) + capacity * sizeof(double);
+        if(ftruncate(column.fd, mapSize) != 0)
+            return false;
+
+        void * map = mremap(column.map, column.mapSize, mapSize, MREMAP_MAYMOVE);
+        if(map == MAP_FAILED)
+            return false;
+
+        column.map = (uint8_t *)map;
+        column.mapSize = mapSize;
+        column.header = (ColumnHeader *)map;
+        column.header->capacity = capacity;
+    }
+
+    capacity_ = capacity;
+    return true;
+}
+
+//-----------------------------------------------------------------------------------------------------------------------
+/*! @brief append a row to the current segment
+*   @param time reception time (ns since epoch)
+*   @param sequence sequence number of the sample
+*   @param values one value per column of the segment
+*   @retval false if no segment is open or a file could not grow
+*/
+bool ColumnStore::append(int64_t time, uint64_t sequence, const double * values)
+{
+    if(columns_.empty() || (rows_ == capacity_ && !grow()))
+        return false;
+
+    size_t offset = sizeof(ColumnHeader) + rows_ * sizeof(double);
+
+    memcpy(columns_[0].map + offset, &time, sizeof(time));
+    memcpy(columns_[1].map + offset, &sequence, sizeof(sequence));
+    for(size_t i = 2; i < columns_.size(); i++)
+        memcpy(columns_[i].map + offset, &values[i - 2], sizeof(double));
+
+    rows_++;
+    for(auto & column : columns_)        //publish the row
+        __atomic_store_n(&column.header->rows, rows_, __ATOMIC_RELEASE);
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------------------------------------------------
+/*! @brief flush the mapped files to the disk
+*/
+void ColumnStore::sync()
+{
+    for(auto & column : columns_)
+        msync(column.map, column.mapSize, MS_ASYNC);
+}
+
+//-----------------------------------------------------------------------------------------------------------------------
+/*! @brief unmap the files of the current segment, the files are truncated to their rows
+*/
+void ColumnStore::closeSegment()
+{
+    for(auto & column : columns_)
+    {
+        column.header->capacity = rows_;
+        munmap(column.map, column.mapSize);
+        if(ftruncate(column.fd, sizeof(ColumnHeader) + rows_ * sizeof(double)) != 0)
+            perror("column store : truncate");
+        close(column.fd);
+    }
+    columns_.clear();
+}
@@ -0,0 +1,109 @@
+/*! --------------------------------------------------------------------
+ *	Telemetry System	-	@file column_store.h
+ *----------------------------------------------------------------------
+ * HES-SO Valais Wallis 
+ * Systems Engineering
+ * Infotronics
+ * ---------------------------------------------------------------------
+ * @author agent
+ * @date 19.10.2026
+ * ---------------------------------------------------------------------
+ * @brief Column store appends the decoded samples of one car to memory
+ *        mapped column files that the dashboards can map read-only.
+ * ---------------------------------------------------------------------
+ * Telemetry system for the Valais Wallis Racing Team.
+ * This file contains code for the base station of the telemetry system.
+ * The base station receives the live measurements sent via Wi-Fi by the
+ * onboard device and stores them for the dashboards.
+ *--------------------------------------------------------------------*/
+
+#ifndef __COLUMN_STORE_H
+#define __COLUMN_STORE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/*
+ * Layout : <directory>/segment_<n>/<column>.col
+ *
+ * A new segment is opened when the schema of the car changes. Every
+ * segment contains the columns "time" (int64, ns since epoch), "seq"
+ * (uint64, sequence number or keep alive counter) and one float64 column
+ * per decoded value. All the columns of a segment have the same number of
+ * rows. A column file is a ColumnHeader followed by the values, the rows
+ * field is written last so readers never see a partial row.
+ */
+
+#define COLUMN_MAGIC            "VTCOL1"
+#define COLUMN_TYPE_INT64       1
+#define COLUMN_TYPE_UINT64      2
+#define COLUMN_TYPE_FLOAT64     3
+
+/*! @brief header of a column file
+    @param magic COLUMN_MAGIC
+    @param type type of the values (COLUMN_TYPE_x)
+    @param elementSize size of a value in bytes
+    @param rows number of values written
+    @param capacity number of values the file can hold
+    @param name name of the column
+*/
+struct ColumnHeader {
+    char magic[8];
+    uint32_t type;
+    uint32_t elementSize;
+    uint64_t rows;
+    uint64_t capacity;
+    char name[96];
+};
+
+/*! @brief memory mapped column store of one car */
+class ColumnStore {
+public:
+    /*! @param directory directory of the car */
+    explicit ColumnStore(std::string directory);
+    ~ColumnStore();
+
+    ColumnStore(const ColumnStore &) = delete;
+    ColumnStore & operator=(const ColumnStore &) = delete;
+
+    /*! @brief close the current segment and open a new one with these value columns
+    *   @retval false if a file could not be created
+    */
+    bool openSegment(const std::vector<std::string> & columns);
+
+    /*! @brief append a row to the current segment
+    *   @param time reception time (ns since epoch)
+    *   @param sequence sequence number of the sample
+    *   @param values one value per column of the segment
+    *   @retval false if no segment is open or a file could not grow
+    */
+    bool append(int64_t time, uint64_t sequence, const double * values);
+
+    /*! @brief flush the mapped files to the disk */
+    void sync();
+
+    /*! @brief number of rows of the current segment */
+    uint64_t rows() const { return rows_; }
+
+private:
+    struct Column {
+        int fd;
+        uint8_t * map;
+        size_t mapSize;
+        ColumnHeader * header;
+    };
+
+    bool openColumn(const std::string & path, const std::string & name, uint32_t type);
+    bool grow();
+    void closeSegment();
+
+    std::string directory_;
+    int segment_;
+    std::vector<Column> columns_;
+    uint64_t rows_;
+    uint64_t capacity_;
+};
+
+#endif /*__COLUMN_STORE_H*/
@@ -0,0 +1,696 @@
+/*! --------------------------------------------------------------------
+ *	Telemetry System	-	@file live_decoder.cpp
+ *----------------------------------------------------------------------
+ * HES-SO Valais Wallis 
+ * Systems Engineering
+ * Infotronics
+ * ---------------------------------------------------------------------
+ * @author agent
+ * @date 19.10.2026
+ * ---------------------------------------------------------------------
+ * @brief Live decoder converts the live packets of one car (json, binary,
+ *        delta, class and batch packets) into rows of numeric values. Packets
+ *        are decoded in place, memory is only allocated when the schema
+ *        of the car changes.
+ * ---------------------------------------------------------------------
+ * Telemetry system for the Valais Wallis Racing Team.
+ * This file contains code for the base station of the telemetry system.
+ * The base station receives the live measurements sent via Wi-Fi by the
+ * onboard device and stores them for the dashboards.
+ *--------------------------------------------------------------------*/
+
+//includes
+#include <algorithm>
+#include <charconv>
+#include <cctype>
+#include <cmath>
+#include <cstring>
+
+//project file includes
+#include "live_decoder.h"
+#include "live_protocol.h"
+
+namespace {
+
+//number of columns of a channel (string channels contain up to two numbers, coordinates are latitude and longitude)
+int columnCount(uint8_t type)
+{
+    return type == LIVE_CH_STRING || type == LIVE_CH_COORD ? 2 : 1;
+}
+
+uint16_t readLe16(const uint8_t * p)
+{
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+uint32_t readLe32(const uint8_t * p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+uint64_t readLe64(const uint8_t * p)
+{
+    return readLe32(p) | (uint64_t)readLe32(p + 4) << 32;
+}
+
+//parse up to two numbers in a text value, missing numbers are NaN
+void parseNumbers(const char * text, const char * end, double * values)
+{
+    values[0] = values[1] = NAN;
+
+    for(int n = 0; n < 2 && text < end; n++)
+    {
+        while(text < end && !(std::isdigit((unsigned char)*text) || *text == '-' || *text == '+' || *text == '.'))
+            text++;
+        if(text < end && *text == '+')
+            text++;
+
+        auto result = std::from_chars(text, end, values[n]);
+        if(result.ec != std::errc())
+            return;
+        text = result.ptr;
+    }
+}
+
+//true if sequence a is after sequence b (wrap around safe)
+bool sequenceAfter(uint32_t a, uint32_t b)
+{
+    return (int32_t)(a - b) > 0;
+}
+
+const uint8_t * skipSpaces(const uint8_t * p, const uint8_t * end)
+{
+    while(p < end && (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n'))
+        p++;
+    return p;
+}
+
+//find the closing quote of a json string starting after the opening quote
+const uint8_t * stringEnd(const uint8_t * p, const uint8_t * end)
+{
+    while(p < end && *p != '"')
+        p += (*p == '\\') ? 2 : 1;
+    return p < end ? p : nullptr;
+}
+
+} // namespace
+
+//-----------------------------------------------------------------------------------------------------------------------
+/*! @brief CRC32 (IEEE) update, same as crc32_ieee_update of the device
+*   @param crc CRC of the previous data (0 for the first call)
+*   @param data data to add
+*   @param length length of the data
+*   @retval updated CRC
+*/
+uint32_t liveCrc32(uint32_t crc, const uint8_t * data, size_t length)
+{
+    static uint32_t table[256];
+    static bool tableReady = false;
+
+    if(!tableReady)
+    {
+        for(uint32_t i = 0; i < 256; i++)
+        {
+            uint32_t c = i;
+            for(int k = 0; k < 8; k++)
+                c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            table[i] = c;
+        }
+        tableReady = true;
+    }
+
+    crc = ~crc;
+    for(size_t i = 0; i < length; i++)
+        crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    return ~crc;
+}
+
+//-----------------------------------------------------------------------------------------------------------------------
+LiveDecoder::LiveDecoder()
+    : format_(Format::None),
+      schemaHash_(0),
+      pendingHash_(0),
+      jsonClass_(false),
+      keyframeSequence_(0),
+      keyframeValid_(false)
+{
+}
+
+//-----------------------------------------------------------------------------------------------------------------------
+/*! @brief decode a datagram
+*   @param data content of the datagram
+*   @param length length of the datagram
+*   @param sink receiver of the schema changes and samples
+*/
+void LiveDecoder::decode(const uint8_t * data, size_t length, LiveSampleSink & sink)
+{
+    stats_.packets++;
+
+    if(length >= sizeof(tLiveBatchHeader) && readLe16(data) == LIVE_MAGIC && data[3] == LIVE_PKT_BATCH)
+    {
+        if(!decodeBatch(data, length, sink))
+            stats_.errors++;
+    }
+    else if(!decodePacket(data, length, 0, sink))
+    {
+        stats_.errors++;
+    }
+}
+
+//-----------------------------------------------------------------------------------------------------------------------
+/*! @brief decode one packet (json or binary)
+*   @retval false if the packet is malformed
+*/
+bool LiveDecoder::decodePacket(const uint8_t * data, size_t length, uint16_t timeDelta, LiveSampleSink & sink)
+{
+    const uint8_t * start = skipSpaces(data, data + length);
+
+    if(start < data + length && *start == '{')         //json packets always start with '{'
+        return decodeJson(data, length, timeDelta, sink);
+
+    if(length < sizeof(tLiveHeader) || readLe16(data) != LIVE_MAGIC || data[2] != LIVE_PROTOCOL_VERSION)
+        return false;
+
+    switch(data[3])
+    {
+        case LIVE_PKT_SCHEMA:   return decodeSchema(data, length, sink);
+        case LIVE_PKT_DATA:     return decodeData(data, length, timeDelta, sink);
+        case LIVE_PKT_DELTA:    return decodeDelta(data, length, timeDelta, sink);
+        case LIVE_PKT_CLASS:    return decodeClass(data, length, timeDelta, sink);
+        case LIVE_PKT_LAP:      return decodeLap(data, length, sink);
+        default:                return false;
+    }
+}
+
+//-----------------------------------------------------------------------------------------------------------------------
+/*! @brief decode a lap packet, it does not depend on the schema
+*/
+bool LiveDecoder::decodeLap(const uint8_t * data, size_t length, LiveSampleSink & sink)
+{
+    if(length < sizeof(tLiveHeader) + sizeof(tLiveLap))
+        return false;
+
+    const uint8_t * ptr = data + sizeof(tLiveHeader);
+    LiveLapEvent lap;
+    lap.event = ptr[offsetof(tLiveLap, event)];
+    lap.sector = ptr[offsetof(tLiveLap, sector)];
+    lap.lap = readLe16(ptr + offsetof(tLiveLap, lap));
+    lap.duration = readLe32(ptr + offsetof(tLiveLap, duration));
+    lap.time = (int64_t)readLe64(data + offsetof(tLiveHeader, time));
+
+    stats_.laps++;
+    sink.onLap(lap);
+    return true;
+}
+
+//-----------------------------------------------------------------------------------------------------------------------
+/*! @brief decode a batch packet, every entry is decoded as a packet
+*/
+bool LiveDecoder::decodeBatch(const uint8_t * data, size_t length, LiveSampleSink & sink)
+{
+    const uint8_t * ptr = data + sizeof(tLiveBatchHeader);
+    const uint8_t * end = data + length;
+    int count = data[offsetof(tLiveBatchHeader, count)];
+
+    for(int i = 0; i < count; i++)
+    {
+        if(end - ptr < (ptrdiff_t)sizeof(tLiveBatchEntry))
+            return false;
+
+        uint16_t timeDelta = readLe16(ptr + offsetof(tLiveBatchEntry, timeDelta));
+        uint16_t entryLength = readLe16(ptr + offsetof(tLiveBatchEntry, length));
+        ptr += sizeof(tLiveBatchEntry);
+
+        if(end - ptr < entryLength || !decodePacket(ptr, entryLength, timeDelta, sink))
+            return false;
+        ptr += entryLength;
+    }
+    return true;
+}
+
+//-----------------------------------------------------------------------------------------------------------------------
+/*! @brief decode a schema fragment, the schema is installed when all the
+*          fragments with the same hash are received and the hash is correct
+*/
+bool LiveDecoder::decodeSchema(const uint8_t * data, size_t length, LiveSampleSink & sink)
+{
+    if(length < sizeof(tLiveHeader) + sizeof(tLiveSchemaHeader))
+        return false;
+
+    uint32_t hash = readLe32(data + offsetof(tLiveHeader, schemaHash));
+    if(format_ == Format::Binary && hash == schemaHash_)       //schema already installed
+        return true;
+
+    const uint8_t * fragment = data + sizeof(tLiveHeader);
+    int index = fragment[offsetof(tLiveSchemaHeader, fragmentIndex)];
+    int count = fragment[offsetof(tLiveSchemaHeader, fragmentCount)];
+    int channelCount = readLe16(fragment + offsetof(tLiveSchemaHeader, channelCount));
+
+    if(count == 0 || index >= count)
+        return false;
+
+    if(hash != pendingHash_ || (int)pendingFragments_.size() != count)     //new schema
+    {
+        pendingHash_ = hash;
+        pendingFragments_.assign(count, {});
+        pendingReceived_.assign(count, false);
+    }
+
+    //read the channel descriptors of the fragment
+    std::vector<LiveChannel> & channels = pendingFragments_[index];
+    channels.clear();
+
+    const uint8_t * ptr = fragment + sizeof(tLiveSchemaHeader);
+    const uint8_t * end = data + length;
+
+    for(int i = 0; i < channelCount; i++)
+    {
+        LiveChannel channel{};
+
+        if(end - ptr < 2)
+            return false;
+        channel.type = *ptr++;
+        int nameLength = *ptr++;
+        if(end - ptr < nameLength + 1)
+            return false;
+        channel.name.assign((const char *)ptr, nameLength);
+        ptr += nameLength;
+        int unitLength = *ptr++;
+        if(end - ptr < unitLength)
+            return false;
+        channel.unit.assign((const char *)ptr, unitLength);
+        ptr += unitLength;
+
+        channels.push_back(std::move(channel));
+    }
+    pendingReceived_[index] = true;
+
+    if(std::find(pendingReceived_.begin(), pendingReceived_.end(), false) != pendingReceived_.end())
+        return true;        //wait for the other fragments
+
+    //all fragments received, check the hash
+    std::vector<LiveChannel> schema;
+    uint32_t crc = 0;
+
+    for(auto & fragmentChannels : pendingFragments_)
+    {
+        for(auto & channel : fragmentChannels)
+        {
+            uint8_t nameLength = channel.name.size();
+            uint8_t unitLength = channel.unit.size();
+            crc = liveCrc32(crc, &channel.type, 1);
+            crc = liveCrc32(crc, &nameLength, 1);
+            crc = liveCrc32(crc, (const uint8_t *)channel.name.data(), nameLength);
+            crc = liveCrc32(crc, &unitLength, 1);
+            crc = liveCrc32(crc, (const uint8_t *)channel.unit.data(), unitLength);
+            schema.push_back(std::move(channel));
+        }
+    }
+
+    pendingFragments_.clear();
+    pendingReceived_.clear();
+
+    if(crc != pendingHash_)
+        return false;
+
+    schemaHash_ = pendingHash_;
+    installSchema(std::move(schema), Format::Binary, sink);
+    return true;
+}
+
+//-----------------------------------------------------------------------------------------------------------------------
+/*! @brief read the binary value of a channel into its columns
+*   @retval position after the value, nullptr if the packet is too short
+*/
+const uint8_t * LiveDecoder::readValue(const LiveChannel & channel, const uint8_t * ptr, const uint8_t * end, double * values)
+{
+    switch(channel.type)
+    {
+        case LIVE_CH_U32:
+            if(end - ptr < 4)
+                return nullptr;
+            values[0] = readLe32(ptr);
+            return ptr + 4;
+
+        case LIVE_CH_I32:
+            if(end - ptr < 4)
+                return nullptr;
+            values[0] = (int32_t)readLe32(ptr);
+            return ptr + 4;
+
+        case LIVE_CH_COORD:
+            if(end - ptr < 8)
+                return nullptr;
+            values[0] = (int32_t)readLe32(ptr) / (double)LIVE_COORD_SCALE;
+            values[1] = (int32_t)readLe32(ptr + 4) / (double)LIVE_COORD_SCALE;
+            return ptr + 8;
+
+        case LIVE_CH_CENTI:
+            if(end - ptr < 4)
+                return nullptr;
+            values[0] = readLe32(ptr) / (double)LIVE_CENTI_SCALE;
+            return ptr + 4;
+
+        case LIVE_CH_BOOL:
+            if(end - ptr < 1)
+                return nullptr;
+            values[0] = *ptr ? 1.0 : 0.0;
+            return ptr + 1;
+
+        case LIVE_CH_STRING:
+        {
+            if(end - ptr < 1 || end - ptr - 1 < *ptr)
+                return nullptr;
+            const char * text = (const char *)ptr + 1;
+            parseNumbers(text, text + *ptr, values);
+            return ptr + 1 + *ptr;
+        }
+
+        default:
+            return nullptr;
+    }
+}
+
+//-----------------------------------------------------------------------------------------------------------------------
+/*! @brief decode a binary data packet (also the keyframe of the delta packets)
+*/
+bool LiveDecoder::decodeData(const uint8_t * data, size_t length, uint16_t timeDelta, LiveSampleSink & sink)
+{
+    if(format_ != Format::Binary || readLe32(data + offsetof(tLiveHeader, schemaHash)) != schemaHash_)
+    {
+        stats_.noSchema++;
+        return true;
+    }
+
+    const uint8_t * ptr = data + sizeof(tLiveHeader);
+    const uint8_t * end = data + length;
+
+    for(const auto & channel : channels_)
+    {
+        ptr = readValue(channel, ptr, end, &values_[channel.column]);
+        if(ptr == nullptr)
+            return false;
+    }
+
+    LiveSample sample{true, readLe32(data + offsetof(tLiveHeader, sequence)), data[offsetof(tLiveHeader, keepAlive)],
+                      (int64_t)readLe64(data + offsetof(tLiveHeader, time)), timeDelta, values_.data()};
+
+    if(!keyframeValid_ || sequenceAfter(sample.sequence, keyframeSequence_))      //newest keyframe (backfilled packets are older)
+    {
+        std::copy(values_.begin(), values_.end(), keyframe_.begin());
+        keyframeSequence_ = sample.sequence;
+        keyframeValid_ = true;
+    }
+
+    stats_.samples++;
+    sink.onSample(sample);
+    return true;
+}
+
+//-----------------------------------------------------------------------------------------------------------------------
+/*! @brief decode a delta packet : the values are the ones of the keyframe
+*          replaced by the changed channels of the bitmap
+*/
+bool LiveDecoder::decodeDelta(const uint8_t * data, size_t length, uint16_t timeDelta, LiveSampleSink & sink)
+{
+    if(format_ != Format::Binary || readLe32(data + offsetof(tLiveHeader, schemaHash)) != schemaHash_)
+    {
+        stats_.noSchema++;
+        return true;
+    }
+
+    size_t bitmapLength = (channels_.size() + 7) / 8;
+    if(length < sizeof(tLiveHeader) + sizeof(tLiveDeltaHeader) + bitmapLength)
+        return false;
+
+    const uint8_t * delta = data + sizeof(tLiveHeader);
+    if(!keyframeValid_ || readLe32(delta + offsetof(tLiveDeltaHeader, keyframeSequence)) != keyframeSequence_)
+    {
+        stats_.noKeyframe++;
+        return true;
+    }
+
+    const uint8_t * bitmap = delta + sizeof(tLiveDeltaHeader);
+    const uint8_t * ptr = bitmap + bitmapLength;
+    const uint8_t * end = data + length;
+
+    std::copy(keyframe_.begin(), keyframe_.end(), values_.begin());
+
+    for(size_t i = 0; i < channels_.size(); i++)
+    {
+        if(bitmap[i / 8] & (1u << (i % 8)))        //channel changed
+        {
+            ptr = readValue(channels_[i], ptr, end, &values_[channels_[i].column]);
+            if(ptr == nullptr)
+                return false;
+        }
+    }
+
+    LiveSample sample{true, readLe32(data + offsetof(tLiveHeader, sequence)), data[offsetof(tLiveHeader, keepAlive)],
+                      (int64_t)readLe64(data + offsetof(tLiveHeader, time)), timeDelta, values_.data()};
+    stats_.samples++;
+    sink.onSample(sample);
+    return true;
+}
+
+//-----------------------------------------------------------------------------------------------------------------------
+/*! @brief decode a class packet : only the channels of the bitmap are part of
+*          the sample, the other columns are NaN
+*/
+bool LiveDecoder::decodeClass(const uint8_t * data, size_t length, uint16_t timeDelta, LiveSampleSink & sink)
+{
+    if(format_ != Format::Binary || readLe32(data + offsetof(tLiveHeader, schemaHash)) != schemaHash_)
+    {
+        stats_.noSchema++;
+        return true;
+    }
+
+    size_t bitmapLength = (channels_.size() + 7) / 8;
+    if(length < sizeof(tLiveHeader) + sizeof(tLiveClassHeader) + bitmapLength)
+        return false;
+
+    const uint8_t * bitmap = data + sizeof(tLiveHeader) + sizeof(tLiveClassHeader);
+    const uint8_t * ptr = bitmap + bitmapLength;
+    const uint8_t * end = data + length;
+
+    std::fill(values_.begin(), values_.end(), NAN);
+
+    for(size_t i = 0; i < channels_.size(); i++)
+    {
+        if(bitmap[i / 8] & (1u << (i % 8)))        //channel of the class
+        {
+            ptr = readValue(channels_[i], ptr, end, &values_[channels_[i].column]);
+            if(ptr == nullptr)
+                return false;
+        }
+    }
+
+    LiveSample sample{true, readLe32(data + offsetof(tLiveHeader, sequence)), data[offsetof(tLiveHeader, keepAlive)],
+                      (int64_t)readLe64(data + offsetof(tLiveHeader, time)), timeDelta, values_.data()};
+    stats_.samples++;
+    sink.onSample(sample);
+    return true;
+}
+
+//-----------------------------------------------------------------------------------------------------------------------
+/*! @brief decode a json packet. The channels are expected in the same order
+*          as the previous packet, the schema is rebuilt if they changed. A
+*          class packet ("Class" key) contains only some channels : its new
+*          channels are added to the schema
+*/
+bool LiveDecoder::decodeJson(const uint8_t * data, size_t length, uint16_t timeDelta, LiveSampleSink & sink)
+{
+    LiveSample sample{false, 0, 0, 0, timeDelta, nullptr};
+
+    int ret = format_ == Format::Json ? parseJson(data, length, false, sample) : 1;
+
+    if(ret == 1)        //new channels : build the schema from this packet
+    {
+        bool merge = format_ == Format::Json;
+        if(parseJson(data, length, true, sample) != 0)
+            return false;
+
+        if(jsonClass_ && merge)     //channels of one class : keep the channels of the other classes
+        {
+            std::vector<LiveChannel> channels = channels_;
+            for(auto & channel : jsonSchema_)
+            {
+                if(std::none_of(channels.begin(), channels.end(), [&](const LiveChannel & c) { return c.name == channel.name; }))
+                    channels.push_back(std::move(channel));
+            }
+            jsonSchema_ = std::move(channels);
+        }
+        installSchema(std::move(jsonSchema_), Format::Json, sink);
+        ret = parseJson(data, length, false, sample);
+    }
+
+    if(ret != 0)
+        return false;
+
+    sample.values = values_.data();
+    stats_.samples++;
+    sink.onSample(sample);
+    return true;
+}
+
+//-----------------------------------------------------------------------------------------------------------------------
+/*! @brief parse a json packet
+*   @param build true to read the channels of the packet into jsonSchema_, false to read the values
+*   @param sample sample with the sequence and keep alive of the packet
+*   @retval 0 on success, 1 if the channels differ from the schema, -1 if malformed
+*/
+int LiveDecoder::parseJson(const uint8_t * data, size_t length, bool build, LiveSample & sample)
+{
+    const uint8_t * end = data + length;
+    const uint8_t * p = skipSpaces(data, end);
+    size_t index = 0;
+    bool written = false;
+
+    jsonClass_ = false;
+
+    if(build)
+        jsonSchema_.clear();
+
+    if(p >= end || *p++ != '{')
+        return -1;
+
+    p = skipSpaces(p, end);
+    if(p < end && *p == '}')
+        p = end;
+
+    while(p < end)
+    {
+        //key
+        if(*p++ != '"')
+            return -1;
+        const uint8_t * keyEnd = stringEnd(p, end);
+        if(keyEnd == nullptr)
+            return -1;
+        std::string_view key((const char *)p, keyEnd - p);
+
+        p = skipSpaces(keyEnd + 1, end);
+        if(p >= end || *p++ != ':')
+            return -1;
+        p = skipSpaces(p, end);
+        if(p >= end)
+            return -1;
+
+        //value
+        uint8_t type;
+        double values[2] = {NAN, NAN};
+
+        if(*p == '"')
+        {
+            const uint8_t * valueEnd = stringEnd(p + 1, end);
+            if(valueEnd == nullptr)
+                return -1;
+            parseNumbers((const char *)p + 1, (const char *)valueEnd, values);
+            type = LIVE_CH_STRING;
+            p = valueEnd + 1;
+        }
+        else if(end - p >= 4 && memcmp(p, "true", 4) == 0)
+        {
+            values[0] = 1.0;
+            type = LIVE_CH_BOOL;
+            p += 4;
+        }
+        else if(end - p >= 5 && memcmp(p, "false", 5) == 0)
+        {
+            values[0] = 0.0;
+            type = LIVE_CH_BOOL;
+            p += 5;
+        }
+        else
+        {
+            auto result = std::from_chars((const char *)p, (const char *)end, values[0]);
+            if(result.ec != std::errc())
+                return -1;
+            type = LIVE_CH_U32;
+            p = (const uint8_t *)result.ptr;
+        }
+
+        if(key == "Seq")
+        {
+            sample.hasSequence = true;
+            sample.sequence = (uint32_t)values[0];
+        }
+        else if(key == "Time")
+        {
+            sample.time = (int64_t)values[0];
+        }
+        else if(key == "KeepAliveCounter")
+        {
+            sample.keepAlive = (uint8_t)values[0];
+        }
+        else if(key == "Class")
+        {
+            jsonClass_ = true;
+            if(!build && !written)      //channels of the other classes are not part of the sample
+                std::fill(values_.begin(), values_.end(), NAN);
+        }
+        else if(build)
+        {
+            jsonSchema_.push_back({std::string(key), std::string(), type, 0});
+        }
+        else
+        {
+            if(index >= channels_.size() || channels_[index].type != type || channels_[index].name != key)
+            {
+                if(!jsonClass_)
+                    return 1;
+
+                //class packet : the channels are in schema order with gaps, search from the current position
+                size_t i = index;
+                while(i < channels_.size() && (channels_[i].type != type || channels_[i].name != key))
+                    i++;
+                if(i == channels_.size())
+                    return 1;
+                index = i;
+            }
+            const LiveChannel & channel = channels_[index++];
+            for(int c = 0; c < columnCount(type); c++)
+                values_[channel.column + c] = values[c];
+            written = true;
+        }
+
+        //next field
+        p = skipSpaces(p, end);
+        if(p >= end)
+            return -1;
+        if(*p == '}')
+            break;
+        if(*p++ != ',')
+            return -1;
+        p = skipSpaces(p, end);
+    }
+
+    if(build)
+        return 0;
+
+    return (jsonClass_ || index == channels_.size()) ? 0 : 1;
+}
+
+//-----------------------------------------------------------------------------------------------------------------------
+/*! @brief install a new schema and assign the columns of the channels
+*/
+void LiveDecoder::installSchema(std::vector<LiveChannel> && channels, Format format, LiveSampleSink & sink)
+{
+    format_ = format;
+    channels_ = std::move(channels);
+    columnNames_.clear();
+
+    for(auto & channel : channels_)
+    {
+        channel.column = columnNames_.size();
+        columnNames_.push_back(channel.name);
+        if(columnCount(channel.type) == 2)
+            columnNames_.push_back(channel.name + "#2");
+    }
+
+    values_.assign(columnNames_.size(), NAN);
+    keyframe_.assign(columnNames_.size(), NAN);
+    keyframeValid_ = false;
+
+    stats_.schemas++;
+    sink.onSchema(*this);
+}
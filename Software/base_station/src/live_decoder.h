@@ -0,0 +1,169 @@
+/*! --------------------------------------------------------------------
+ *	Telemetry System	-	@file live_decoder.h
+ *----------------------------------------------------------------------
+ * HES-SO Valais Wallis 
+ * Systems Engineering
+ * Infotronics
+ * ---------------------------------------------------------------------
+ * @author agent
+ * @date 19.10.2026
+ * ---------------------------------------------------------------------
+ * @brief Live decoder converts the live packets of one car (json, binary,
+ *        delta, class and batch packets) into rows of numeric values. Packets
+ *        are decoded in place, memory is only allocated when the schema
+ *        of the car changes.
+ * ---------------------------------------------------------------------
+ * Telemetry system for the Valais Wallis Racing Team.
+ * This file contains code for the base station of the telemetry system.
+ * The base station receives the live measurements sent via Wi-Fi by the
+ * onboard device and stores them for the dashboards.
+ *--------------------------------------------------------------------*/
+
+#ifndef __LIVE_DECODER_H
+#define __LIVE_DECODER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/*! @brief channel of the live stream
+    @param name name of the channel in the live transmission
+    @param unit unit of the channel (empty if not set)
+    @param type type of the value (LIVE_CH_x)
+    @param column index of the first column of the channel
+*/
+struct LiveChannel {
+    std::string name;
+    std::string unit;
+    uint8_t type;
+    uint16_t column;
+};
+
+/*! @brief decoded sample
+    @param hasSequence the packet contains a sequence number
+    @param sequence sequence number of the sample
+    @param keepAlive keep alive counter of the sample
+    @param time synchronised time of the sample (µs since 1970, 0 if the car clock is not synchronised)
+    @param timeDelta time since the first packet of the batch (ms, 0 if not batched)
+    @param values values of all the columns
+*/
+struct LiveSample {
+    bool hasSequence;
+    uint32_t sequence;
+    uint8_t keepAlive;
+    int64_t time;
+    uint16_t timeDelta;
+    const double * values;
+};
+
+/*! @brief lap or sector event of the lap timer of the car
+    @param event event type (LIVE_LAP_x)
+    @param sector index of the completed sector (0 = first sector)
+    @param lap number of the lap of the event (1 = first lap)
+    @param duration time of the sector or of the lap (ms)
+    @param time synchronised time of the line crossing (µs since 1970, 0 if the car clock is not synchronised)
+*/
+struct LiveLapEvent {
+    uint8_t event;
+    uint8_t sector;
+    uint16_t lap;
+    uint32_t duration;
+    int64_t time;
+};
+
+class LiveDecoder;
+
+/*! @brief receives the output of a live decoder */
+class LiveSampleSink {
+public:
+    virtual ~LiveSampleSink() = default;
+    /*! @brief the columns of the decoder changed (called before the first sample with the new columns) */
+    virtual void onSchema(const LiveDecoder & decoder) = 0;
+    /*! @brief a sample was decoded */
+    virtual void onSample(const LiveSample & sample) = 0;
+    /*! @brief a lap or sector event was decoded */
+    virtual void onLap(const LiveLapEvent & /*lap*/) {}
+};
+
+/*! @brief decoder statistics
+    @param packets datagrams decoded
+    @param samples samples decoded
+    @param schemas schemas installed
+    @param noSchema binary packets dropped because the schema is unknown
+    @param noKeyframe delta packets dropped because their keyframe was missed
+    @param laps lap and sector events decoded
+    @param errors malformed packets
+*/
+struct LiveDecoderStats {
+    uint64_t packets = 0;
+    uint64_t samples = 0;
+    uint64_t schemas = 0;
+    uint64_t noSchema = 0;
+    uint64_t noKeyframe = 0;
+    uint64_t laps = 0;
+    uint64_t errors = 0;
+};
+
+/*! @brief live decoder of one car */
+class LiveDecoder {
+public:
+    LiveDecoder();
+
+    /*! @brief decode a datagram
+    *   @param data content of the datagram
+    *   @param length length of the datagram
+    *   @param sink receiver of the schema changes and samples
+    */
+    void decode(const uint8_t * data, size_t length, LiveSampleSink & sink);
+
+    /*! @brief channels of the current schema */
+    const std::vector<LiveChannel> & channels() const { return channels_; }
+    /*! @brief names of the columns (string channels have two columns) */
+    const std::vector<std::string> & columns() const { return columnNames_; }
+    /*! @brief decoder statistics */
+    const LiveDecoderStats & stats() const { return stats_; }
+
+private:
+    enum class Format { None, Json, Binary };
+
+    bool decodePacket(const uint8_t * data, size_t length, uint16_t timeDelta, LiveSampleSink & sink);
+    bool decodeSchema(const uint8_t * data, size_t length, LiveSampleSink & sink);
+    bool decodeData(const uint8_t * data, size_t length, uint16_t timeDelta, LiveSampleSink & sink);
+    bool decodeDelta(const uint8_t * data, size_t length, uint16_t timeDelta, LiveSampleSink & sink);
+    bool decodeClass(const uint8_t * data, size_t length, uint16_t timeDelta, LiveSampleSink & sink);
+    bool decodeLap(const uint8_t * data, size_t length, LiveSampleSink & sink);
+    bool decodeBatch(const uint8_t * data, size_t length, LiveSampleSink & sink);
+    bool decodeJson(const uint8_t * data, size_t length, uint16_t timeDelta, LiveSampleSink & sink);
+    int parseJson(const uint8_t * data, size_t length, bool build, LiveSample & sample);
+    const uint8_t * readValue(const LiveChannel & channel, const uint8_t * ptr, const uint8_t * end, double * values);
+    void installSchema(std::vector<LiveChannel> && channels, Format format, LiveSampleSink & sink);
+
+    Format format_;
+    std::vector<LiveChannel> channels_;
+    std::vector<std::string> columnNames_;
+    std::vector<double> values_;
+
+    //binary schema
+    uint32_t schemaHash_;
+    uint32_t pendingHash_;
+    std::vector<std::vector<LiveChannel>> pendingFragments_;
+    std::vector<bool> pendingReceived_;
+
+    //json schema read from a packet
+    std::vector<LiveChannel> jsonSchema_;
+    bool jsonClass_;
+
+    //delta frames
+    std::vector<double> keyframe_;
+    uint32_t keyframeSequence_;
+    bool keyframeValid_;
+
+    LiveDecoderStats stats_;
+};
+
+/*! @brief CRC32 (IEEE) update, same as crc32_ieee_update of the device */
+uint32_t liveCrc32(uint32_t crc, const uint8_t * data, size_t length);
+
+#endif /*__LIVE_DECODER_H*/
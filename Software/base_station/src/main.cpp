@@ -0,0 +1,106 @@
+/*! --------------------------------------------------------------------
+ *	Telemetry System	-	@file main.cpp
+ *----------------------------------------------------------------------
+ * HES-SO Valais Wallis 
+ * Systems Engineering
+ * Infotronics
+ * ---------------------------------------------------------------------
+ * @author agent
+ * @date 19.10.2026
+ * ---------------------------------------------------------------------
+ * @brief main file of the base station receiver service
+ *
+ *        usage : base_station [-p port]... [-g group]... [-i interface] [-d directory] [-s seconds] [--no-nack]
+ *          -p        UDP port of the live transmission (repeatable, default 7070)
+ *          -g        multicast group of the live transmission to join (repeatable)
+ *          -i        IPv4 address of the interface joining the groups
+ *                    (broadcast transmissions need no option)
+ *          -d        directory of the column store (default live_store)
+ *          -s        statistics period in seconds (0 = no statistics, default 5)
+ *          --no-nack do not request the missing samples
+ * ---------------------------------------------------------------------
+ * Telemetry system for the Valais Wallis Racing Team.
+ * This file contains code for the base station of the telemetry system.
+ * The base station receives the live measurements sent via Wi-Fi by the
+ * onboard device and stores them for the dashboards.
+ *--------------------------------------------------------------------*/
+
+//includes
+#include <atomic>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+//project file includes
+#include "receiver.h"
+
+static std::atomic<bool> stopRequest(false);
+
+static void onSignal(int)
+{
+    stopRequest = true;
+}
+
+static void usage(const char * name)
+{
+    fprintf(stderr, "usage : %s [-p port]... [-g group]... [-i interface] [-d directory] [-s seconds] [--no-nack]\n", name);
+}
+
+int main(int argc, char ** argv)
+{
+    ReceiverOptions options;
+
+    for(int i = 1; i < argc; i++)
+    {
+        if(!strcmp(argv[i], "-p") && i + 1 < argc)
+        {
+            int port = atoi(argv[++i]);
+            if(port <= 0 || port > 65535)
+            {
+                fprintf(stderr, "invalid port %s\n", argv[i]);
+                return 1;
+            }
+            options.ports.push_back((uint16_t)port);
+        }
+        else if(!strcmp(argv[i], "-g") && i + 1 < argc)
+        {
+            options.groups.push_back(argv[++i]);
+        }
+        else if(!strcmp(argv[i], "-i") && i + 1 < argc)
+        {
+            options.interface = argv[++i];
+        }
+        else if(!strcmp(argv[i], "-d") && i + 1 < argc)
+        {
+            options.storeDirectory = argv[++i];
+        }
+        else if(!strcmp(argv[i], "-s") && i + 1 < argc)
+        {
+            options.statsPeriod = atoi(argv[++i]);
+        }
+        else if(!strcmp(argv[i], "--no-nack"))
+        {
+            options.nack = false;
+        }
+        else
+        {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if(options.ports.empty())
+        options.ports.push_back(7070);
+
+    signal(SIGINT, onSignal);
+    signal(SIGTERM, onSignal);
+
+    Receiver receiver(options);
+    if(!receiver.open())
+        return 1;
+
+    receiver.run(stopRequest);
+    receiver.printStats();
+    return 0;
+}
@@ -0,0 +1,530 @@
+/*! --------------------------------------------------------------------
+ *	Telemetry System	-	@file receiver.cpp
+ *----------------------------------------------------------------------
+ * HES-SO Valais Wallis 
+ * Systems Engineering
+ * Infotronics
+ * ---------------------------------------------------------------------
+ * @author agent
+ * @date 19.10.2026
+ * ---------------------------------------------------------------------
+ * @brief Receiver reads the live datagrams of one or more cars on UDP
+ *        ports, decodes them, tracks the lost packets and stores the
+ *        samples in the column store of each car.
+ * ---------------------------------------------------------------------
+ * Telemetry system for the Valais Wallis Racing Team.
+ * This file contains code for the base station of the telemetry system.
+ * The base station receives the live measurements sent via Wi-Fi by the
+ * onboard device and stores them for the dashboards.
+ *--------------------------------------------------------------------*/
+
+//includes
+#include <arpa/inet.h>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <poll.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+//project file includes
+#include "receiver.h"
+#include "live_protocol.h"
+
+//max number of datagrams read by one recvmmsg call
+#define RECEIVER_BATCH 64
+//max size of a datagram (json packets with many sensors are larger than the MTU)
+#define RECEIVER_DATAGRAM_SIZE 9000
+//socket receive buffer
+#define RECEIVER_SOCKET_BUFFER (4*1024*1024)
+//poll timeout
+#define RECEIVER_POLL_MS 200
+//size of the control data of a datagram (reception timestamp)
+#define RECEIVER_CONTROL_SIZE 64
+
+namespace {
+
+int64_t nowNs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+//reception time of a datagram set by the kernel (SO_TIMESTAMPNS), fallback if not available
+int64_t kernelTime(msghdr & message, int64_t fallback)
+{
+    for(cmsghdr * c = CMSG_FIRSTHDR(&message); c != nullptr; c = CMSG_NXTHDR(&message, c))
+    {
+        if(c->cmsg_level == SOL_SOCKET && c->cmsg_type == SCM_TIMESTAMPNS)
+        {
+            struct timespec ts;
+            memcpy(&ts, CMSG_DATA(c), sizeof(ts));
+            return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+        }
+    }
+    return fallback;
+}
+
+} // namespace
+
+//-----------------------------------------------------------------------------------------------------------------------
+/*! @brief add the sequence of a received sample. The gaps are NACKed only
+*          above the anchor and when they fit in the window
+*   @param sequence sequence number
+*   @param time synchronised time of the sample (µs since 1970, 0 if not synchronised)
+*   @param receiveTime reception time of the sample (µs since 1970)
+*   @param missing newly missing sequences (filled up to maxMissing)
+*   @param maxMissing size of missing
+*   @retval number of sequences written to missing
+*/
+int SequenceTracker::add(uint32_t sequence, int64_t time, int64_t receiveTime, uint32_t * missing, int maxMissing)
+{
+    stats_.received++;
+
+    int32_t diff = (int32_t)(sequence - expected_);
+
+    if(started_ && diff < 0 && restarted(time, receiveTime))
+    {
+        stats_.restarts++;
+        started_ = false;
+    }
+
+    if(!started_)           //first sample or car restarted
+    {
+        started_ = true;
+        anchor_ = sequence;
+        expected_ = sequence + 1;
+        lastNew_ = receiveTime;
+        newestTime_ = time;
+        return 0;
+    }
+
+    if(diff >= 0)           //newer sample : the live stream is running
+    {
+        lastNew_ = receiveTime;
+        if(time > newestTime_)
+            newestTime_ = time;
+    }
+
+    if(diff == 0)           //next sample
+    {
+        expected_++;
+        return 0;
+    }
+
+    if(diff > 0)            //gap : samples between expected and sequence are missing
+    {
+        int count = 0;
+        stats_.lost += diff;
+
+        //the last sequences of a long gap are kept to count the backfilled ones, a long gap is not NACKed (older than the history of the car)
+        uint32_t first = diff <= SEQUENCE_WINDOW ? expected_ : sequence - SEQUENCE_WINDOW;
+        for(uint32_t s = first; s != sequence; s++)
+        {
+            window_[s % SEQUENCE_WINDOW] = s + 1;
+            if(diff <= SEQUENCE_WINDOW && count < maxMissing)
+                missing[count++] = s;
+        }
+        expected_ = sequence + 1;
+        return count;
+    }
+
+    //older sample : retransmitted, backfilled or duplicated, the tracker is not moved
+    if(window_[sequence % SEQUENCE_WINDOW] == sequence + 1)
+    {
+        window_[sequence % SEQUENCE_WINDOW] = 0;
+        stats_.recovered++;
+        stats_.lost--;
+    }
+    else if((int32_t)(sequence - anchor_) < 0 || diff < -SEQUENCE_WINDOW)
+    {
+        stats_.late++;
+    }
+    else
+    {
+        stats_.duplicates++;
+    }
+    return 0;
+}
+
+//-----------------------------------------------------------------------------------------------------------------------
+/*! @brief an older sequence is a restart of the car if no newer sample came
+*          for SEQUENCE_RESTART_SILENCE_US (backfilled and retransmitted
+*          samples come between the live samples) and if its car time is
+*          not older than the newest sample (the clock of a restarted car is
+*          0 until it is synchronised again)
+*   @param time synchronised time of the sample (µs since 1970, 0 if not synchronised)
+*   @param receiveTime reception time of the sample (µs since 1970)
+*   @retval true if the car restarted
+*/
+bool SequenceTracker::restarted(int64_t time, int64_t receiveTime) const
+{
+    if(receiveTime - lastNew_ < SEQUENCE_RESTART_SILENCE_US)
+        return false;
+
+    return time == 0 || newestTime_ == 0 || time >= newestTime_ - SEQUENCE_RESTART_MAX_AGE_US;
+}
+
+//-----------------------------------------------------------------------------------------------------------------------
+/*! @brief add the keep alive counter of a packet without sequence number (0..99)
+*/
+void SequenceTracker::addKeepAlive(uint8_t keepAlive)
+{
+    stats_.received++;
+
+    if(lastKeepAlive_ >= 0 && keepAlive != (lastKeepAlive_ + 1) % 100)
+        stats_.keepAliveGaps++;
+    lastKeepAlive_ = keepAlive;
+}
+
+//-----------------------------------------------------------------------------------------------------------------------
+Car::Car(std::string carId, const std::string & storeDirectory)
+    : id(std::move(carId)),
+      store(storeDirectory + "/" + id),
+      address{},
+      socket(-1),
+      receiveTime(0),
+      missingCount(0),
+      clockLead(0),
+      syncAnswers(0),
+      bestLap(0)
+{
+}
+
+//-----------------------------------------------------------------------------------------------------------------------
+/*! @brief the schema of the car changed : open a new segment of the store
+*/
+void Car::onSchema(const LiveDecoder & liveDecoder)
+{
+    store.openSegment(liveDecoder.columns());
+    printf("%s : schema with %zu channels\n", id.c_str(), liveDecoder.channels().size());
+}
+
+//-----------------------------------------------------------------------------------------------------------------------
+/*! @brief track the sequence of a sample and store it. The samples are
+*          stored with the synchronised time of the car when it is known.
+*          The samples of the priority classes skip ahead of the others on
+*          the car, their sequence space is tracked apart
+*/
+void Car::onSample(const LiveSample & sample)
+{
+    if(sample.hasSequence)
+    {
+        SequenceTracker & lane = (sample.sequence & LIVE_SEQUENCE_PRIORITY) ? priorityTracker : tracker;
+        missingCount += lane.add(sample.sequence, sample.time, receiveTime / 1000, missing + missingCount, (int)(sizeof(missing)/sizeof(missing[0])) - missingCount);
+    }
+    else
+        tracker.addKeepAlive(sample.keepAlive);
+
+    int64_t time = receiveTime;
+    if(sample.time != 0)
+    {
+        time = sample.time * 1000;
+        clockLead = sample.time - receiveTime / 1000;
+    }
+
+    store.append(time, sample.hasSequence ? sample.sequence : sample.keepAlive, sample.values);
+}
+
+//-----------------------------------------------------------------------------------------------------------------------
+/*! @brief print and keep a lap or sector event of the car
+*/
+void Car::onLap(const LiveLapEvent & lap)
+{
+    laps.push_back(lap);
+
+    if(lap.event == LIVE_LAP_LAP)
+    {
+        bool best = bestLap == 0 || lap.duration < bestLap;
+        if(best)
+            bestLap = lap.duration;
+        printf("%s : lap %u %u:%02u.%03u%s\n", id.c_str(), lap.lap, lap.duration / 60000, lap.duration / 1000 % 60, lap.duration % 1000, best ? " (best)" : "");
+    }
+    else
+    {
+        printf("%s : lap %u sector %u %u.%03u\n", id.c_str(), lap.lap, lap.sector + 1, lap.duration / 1000, lap.duration % 1000);
+    }
+}
+
+//-----------------------------------------------------------------------------------------------------------------------
+Receiver::Receiver(ReceiverOptions options)
+    : options_(std::move(options))
+{
+}
+
+Receiver::~Receiver()
+{
+    for(int s : sockets_)
+        close(s);
+}
+
+//-----------------------------------------------------------------------------------------------------------------------
+/*! @brief open the sockets
+*   @retval false if a socket could not be opened
+*/
+bool Receiver::open()
+{
+    for(uint16_t port : options_.ports)
+    {
+        int s = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+        if(s < 0)
+        {
+            perror("receiver : socket");
+            return false;
+        }
+
+        int enable = 1;
+        int bufferSize = RECEIVER_SOCKET_BUFFER;
+        setsockopt(s, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(enable));
+        setsockopt(s, SOL_SOCKET, SO_RCVBUF, &bufferSize, sizeof(bufferSize));
+        setsockopt(s, SOL_SOCKET, SO_TIMESTAMPNS, &enable, sizeof(enable));     //reception time of the time sync requests
+
+        sockaddr_in local{};
+        local.sin_family = AF_INET;
+        local.sin_port = htons(port);
+        local.sin_addr.s_addr = htonl(INADDR_ANY);
+
+        if(bind(s, (sockaddr *)&local, sizeof(local)) != 0)
+        {
+            fprintf(stderr, "receiver : bind port %u : %s\n", port, strerror(errno));
+            close(s);
+            return false;
+        }
+
+        if(!joinGroups(s))
+        {
+            close(s);
+            return false;
+        }
+
+        sockets_.push_back(s);
+        printf("listening on port %u\n", port);
+    }
+    return true;
+}
+
+//-----------------------------------------------------------------------------------------------------------------------
+/*! @brief join the multicast groups of the options on a socket. Broadcast
+*          datagrams are received without joining anything
+*   @retval false if a group is invalid or could not be joined
+*/
+bool Receiver::joinGroups(int socket)
+{
+    for(const std::string & group : options_.groups)
+    {
+        ip_mreq request{};
+
+        if(inet_pton(AF_INET, group.c_str(), &request.imr_multiaddr) != 1 || !IN_MULTICAST(ntohl(request.imr_multiaddr.s_addr)))
+        {
+            fprintf(stderr, "receiver : invalid multicast group %s\n", group.c_str());
+            return false;
+        }
+
+        request.imr_interface.s_addr = htonl(INADDR_ANY);
+        if(!options_.interface.empty() && inet_pton(AF_INET, options_.interface.c_str(), &request.imr_interface) != 1)
+        {
+            fprintf(stderr, "receiver : invalid interface address %s\n", options_.interface.c_str());
+            return false;
+        }
+
+        if(setsockopt(socket, IPPROTO_IP, IP_ADD_MEMBERSHIP, &request, sizeof(request)) != 0)
+        {
+            fprintf(stderr, "receiver : join %s : %s\n", group.c_str(), strerror(errno));
+            return false;
+        }
+        printf("joined group %s\n", group.c_str());
+    }
+    return true;
+}
+
+//-----------------------------------------------------------------------------------------------------------------------
+/*! @brief receive until stop is set
+*/
+void Receiver::run(const std::atomic<bool> & stop)
+{
+    //receive buffers (allocated once)
+    std::vector<uint8_t> buffers(RECEIVER_BATCH * RECEIVER_DATAGRAM_SIZE);
+    std::vector<mmsghdr> messages(RECEIVER_BATCH);
+    std::vector<iovec> iovecs(RECEIVER_BATCH);
+    std::vector<sockaddr_in> addresses(RECEIVER_BATCH);
+    std::vector<uint8_t> controls(RECEIVER_BATCH * RECEIVER_CONTROL_SIZE);
+    std::vector<pollfd> fds;
+
+    for(int s : sockets_)
+        fds.push_back({s, POLLIN, 0});
+
+    auto lastStats = std::chrono::steady_clock::now();
+
+    while(!stop)
+    {
+        if(poll(fds.data(), fds.size(), RECEIVER_POLL_MS) < 0 && errno != EINTR)
+        {
+            perror("receiver : poll");
+            return;
+        }
+
+        for(auto & fd : fds)
+        {
+            if(!(fd.revents & POLLIN))
+                continue;
+
+            int count;
+            do      //read all the waiting datagrams
+            {
+                for(int i = 0; i < RECEIVER_BATCH; i++)
+                {
+                    iovecs[i] = {&buffers[i * RECEIVER_DATAGRAM_SIZE], RECEIVER_DATAGRAM_SIZE};
+                    messages[i].msg_hdr = {};
+                    messages[i].msg_hdr.msg_iov = &iovecs[i];
+                    messages[i].msg_hdr.msg_iovlen = 1;
+                    messages[i].msg_hdr.msg_name = &addresses[i];
+                    messages[i].msg_hdr.msg_namelen = sizeof(addresses[i]);
+                    messages[i].msg_hdr.msg_control = &controls[i * RECEIVER_CONTROL_SIZE];
+                    messages[i].msg_hdr.msg_controllen = RECEIVER_CONTROL_SIZE;
+                }
+
+                count = recvmmsg(fd.fd, messages.data(), RECEIVER_BATCH, MSG_DONTWAIT, nullptr);
+                int64_t time = nowNs();
+
+                for(int i = 0; i < count; i++)
+                    handle(fd.fd, addresses[i], &buffers[i * RECEIVER_DATAGRAM_SIZE], messages[i].msg_len, kernelTime(messages[i].msg_hdr, time));
+            } while(count == RECEIVER_BATCH);
+        }
+
+        if(options_.statsPeriod > 0 && std::chrono::steady_clock::now() - lastStats >= std::chrono::seconds(options_.statsPeriod))
+        {
+            lastStats = std::chrono::steady_clock::now();
+            printStats();
+            for(auto & entry : cars_)
+                entry.second->store.sync();
+        }
+    }
+}
+
+//-----------------------------------------------------------------------------------------------------------------------
+/*! @brief handle one datagram
+*   @param socket socket the datagram came on (-1 = no NACK)
+*   @param from sender address
+*   @param data content of the datagram
+*   @param length length of the datagram
+*   @param time reception time (ns since epoch)
+*/
+void Receiver::handle(int socket, const sockaddr_in & from, const uint8_t * data, size_t length, int64_t time)
+{
+    if(length == sizeof(tLiveSync) && data[0] == (LIVE_MAGIC & 0xFF) && data[1] == (LIVE_MAGIC >> 8) && data[3] == LIVE_PKT_SYNC_REQUEST)
+    {
+        answerSync(socket, from, data, time);       //from the sync port of the car, not the live port
+        return;
+    }
+
+    Car & c = car(from);
+    c.address = from;
+    c.socket = socket;
+    c.receiveTime = time;
+    c.missingCount = 0;
+
+    c.decoder.decode(data, length, c);
+
+    if(options_.nack && socket >= 0 && c.missingCount > 0)
+        sendNack(c);
+}
+
+//-----------------------------------------------------------------------------------------------------------------------
+/*! @brief car of a sender address, created on its first packet
+*/
+Car & Receiver::car(const sockaddr_in & from)
+{
+    auto it = cars_.find(from.sin_addr.s_addr);
+    if(it != cars_.end())
+        return *it->second;
+
+    char id[INET_ADDRSTRLEN];
+    inet_ntop(AF_INET, &from.sin_addr, id, sizeof(id));
+    printf("new car %s\n", id);
+
+    auto & entry = cars_[from.sin_addr.s_addr];
+    entry = std::make_unique<Car>(id, options_.storeDirectory);
+    return *entry;
+}
+
+//-----------------------------------------------------------------------------------------------------------------------
+/*! @brief send a NACK with the missing sequences of the current datagram to the car
+*/
+void Receiver::sendNack(Car & c)
+{
+    uint8_t packet[sizeof(tLiveNackHeader) + 4 * LIVE_NACK_MAX_COUNT];
+    int count = c.missingCount < LIVE_NACK_MAX_COUNT ? c.missingCount : LIVE_NACK_MAX_COUNT;
+
+    tLiveNackHeader header;
+    header.magic = LIVE_MAGIC;          //little endian host
+    header.version = LIVE_PROTOCOL_VERSION;
+    header.type = LIVE_PKT_NACK;
+    header.count = count;
+    memcpy(packet, &header, sizeof(header));
+
+    for(int i = 0; i < count; i++)
+    {
+        uint8_t * p = packet + sizeof(header) + 4 * i;
+        p[0] = c.missing[i];
+        p[1] = c.missing[i] >> 8;
+        p[2] = c.missing[i] >> 16;
+        p[3] = c.missing[i] >> 24;
+    }
+
+    if(sendto(c.socket, packet, sizeof(header) + 4 * count, 0, (const sockaddr *)&c.address, sizeof(c.address)) > 0)
+        c.tracker.stats().nackSent++;
+}
+
+//-----------------------------------------------------------------------------------------------------------------------
+/*! @brief answer a time sync request with the reception and transmission times
+*   @param socket socket the request came on (-1 = no answer)
+*   @param from address of the sync port of the car
+*   @param data request
+*   @param time reception time of the request (ns since epoch)
+*/
+void Receiver::answerSync(int socket, const sockaddr_in & from, const uint8_t * data, int64_t time)
+{
+    Car & c = car(from);
+    c.syncAnswers++;
+
+    if(socket < 0)
+        return;
+
+    tLiveSync answer;
+    memcpy(&answer, data, sizeof(answer));      //keeps the origin time of the car (little endian host)
+    answer.type = LIVE_PKT_SYNC_RESPONSE;
+    answer.receiveTime = time / 1000;
+    answer.transmitTime = nowNs() / 1000;
+
+    sendto(socket, &answer, sizeof(answer), 0, (const sockaddr *)&from, sizeof(from));
+}
+
+//-----------------------------------------------------------------------------------------------------------------------
+/*! @brief print the statistics of all the cars
+*/
+void Receiver::printStats()
+{
+    for(auto & entry : cars_)
+    {
+        Car & c = *entry.second;
+        const LiveDecoderStats & d = c.decoder.stats();
+        const SequenceStats & s = c.tracker.stats();
+        const SequenceStats & p = c.priorityTracker.stats();
+
+        printf("%s : packets %llu samples %llu rows %llu | lost %llu recovered %llu duplicates %llu late %llu restarts %llu keepalive gaps %llu nack %llu | "
+               "priority lost %llu recovered %llu | "
+               "no schema %llu no keyframe %llu errors %llu | sync %llu clock lead %lld us\n",
+               c.id.c_str(),
+               (unsigned long long)d.packets, (unsigned long long)d.samples, (unsigned long long)c.store.rows(),
+               (unsigned long long)s.lost, (unsigned long long)s.recovered, (unsigned long long)s.duplicates,
+               (unsigned long long)s.late, (unsigned long long)s.restarts,
+               (unsigned long long)s.keepAliveGaps, (unsigned long long)s.nackSent,
+               (unsigned long long)p.lost, (unsigned long long)p.recovered,
+               (unsigned long long)d.noSchema, (unsigned long long)d.noKeyframe, (unsigned long long)d.errors,
+               (unsigned long long)c.syncAnswers, (long long)c.clockLead);
+    }
+    fflush(stdout);
+}
@@ -0,0 +1,178 @@
+/*! --------------------------------------------------------------------
+ *	Telemetry System	-	@file receiver.h
+ *----------------------------------------------------------------------
+ * HES-SO Valais Wallis 
+ * Systems Engineering
+ * Infotronics
+ * ---------------------------------------------------------------------
+ * @author agent
+ * @date 19.10.2026
+ * ---------------------------------------------------------------------
+ * @brief Receiver reads the live datagrams of one or more cars on UDP
+ *        ports, decodes them, tracks the lost packets and stores the
+ *        samples in the column store of each car.
+ * ---------------------------------------------------------------------
+ * Telemetry system for the Valais Wallis Racing Team.
+ * This file contains code for the base station of the telemetry system.
+ * The base station receives the live measurements sent via Wi-Fi by the
+ * onboard device and stores them for the dashboards.
+ *--------------------------------------------------------------------*/
+
+#ifndef __RECEIVER_H
+#define __RECEIVER_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <netinet/in.h>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "column_store.h"
+#include "live_decoder.h"
+
+//number of recent sequences remembered to detect retransmitted and backfilled samples
+#define SEQUENCE_WINDOW 1024
+//time without a new sample after which an old sequence is a restart of the car (µs)
+#define SEQUENCE_RESTART_SILENCE_US 3000000
+//max age of the car time of the first sample after a restart (µs, backfilled samples are older)
+#define SEQUENCE_RESTART_MAX_AGE_US 1000000
+
+/*! @brief sequence statistics of a car
+    @param received samples received
+    @param lost samples missing (gaps in the sequence)
+    @param recovered missing samples received later (retransmitted or backfilled)
+    @param duplicates samples received twice
+    @param late old samples outside the window or before the first sample (backfilled after a long outage)
+    @param restarts restarts of the car (sequence starting again)
+    @param keepAliveGaps gaps of the keep alive counter (packets without sequence)
+    @param nackSent NACK packets sent to the car
+*/
+struct SequenceStats {
+    uint64_t received = 0;
+    uint64_t lost = 0;
+    uint64_t recovered = 0;
+    uint64_t duplicates = 0;
+    uint64_t late = 0;
+    uint64_t restarts = 0;
+    uint64_t keepAliveGaps = 0;
+    uint64_t nackSent = 0;
+};
+
+/*! @brief tracks the sequence numbers of a car and finds the missing ones.
+*          Only the newer sequences move the tracker forward, the older ones
+*          are retransmitted, backfilled or duplicated samples. A restart of
+*          the car is detected when the old sequences come after a silence
+*          of the newer ones and do not carry an old car time
+*/
+class SequenceTracker {
+public:
+    /*! @brief add the sequence of a received sample
+    *   @param sequence sequence number
+    *   @param time synchronised time of the sample (µs since 1970, 0 if not synchronised)
+    *   @param receiveTime reception time of the sample (µs since 1970)
+    *   @param missing newly missing sequences (filled up to maxMissing)
+    *   @param maxMissing size of missing
+    *   @retval number of sequences written to missing
+    */
+    int add(uint32_t sequence, int64_t time, int64_t receiveTime, uint32_t * missing, int maxMissing);
+
+    /*! @brief add the keep alive counter of a packet without sequence number */
+    void addKeepAlive(uint8_t keepAlive);
+
+    SequenceStats & stats() { return stats_; }
+
+private:
+    bool restarted(int64_t time, int64_t receiveTime) const;
+
+    bool started_ = false;
+    uint32_t anchor_ = 0;                       //first sequence since the start of the car (never NACKed below)
+    uint32_t expected_ = 0;
+    int64_t lastNew_ = 0;                       //reception time of the last newer sample (µs)
+    int64_t newestTime_ = 0;                    //car time of the newest sample (µs, 0 if not synchronised)
+    int lastKeepAlive_ = -1;
+    uint32_t window_[SEQUENCE_WINDOW] = {};     //sequence + 1 of the missing samples (0 = not missing)
+    SequenceStats stats_;
+};
+
+/*! @brief state of one car */
+class Car : public LiveSampleSink {
+public:
+    Car(std::string id, const std::string & storeDirectory);
+
+    void onSchema(const LiveDecoder & decoder) override;
+    void onSample(const LiveSample & sample) override;
+    void onLap(const LiveLapEvent & lap) override;
+
+    std::string id;
+    LiveDecoder decoder;
+    ColumnStore store;
+    SequenceTracker tracker;
+    SequenceTracker priorityTracker;    //samples of the priority classes (own sequence space, LIVE_SEQUENCE_PRIORITY)
+    sockaddr_in address;        //address the last packet came from (NACK destination)
+    int socket;                 //socket the last packet came on
+    int64_t receiveTime;        //reception time of the current datagram (ns)
+    uint32_t missing[64];       //sequences to NACK for the current datagram
+    int missingCount;
+    int64_t clockLead;          //car time - reception time of the last timestamped sample (µs, includes the transmission delay)
+    uint64_t syncAnswers;       //time sync requests answered
+    std::vector<LiveLapEvent> laps;     //lap and sector events of the session
+    uint32_t bestLap;           //best lap time (ms, 0 if no lap completed)
+};
+
+/*! @brief receiver options
+    @param ports UDP ports to listen on
+    @param storeDirectory root directory of the column stores
+    @param nack send NACKs for the missing sequences
+    @param statsPeriod period of the statistics print (seconds, 0 = disabled)
+    @param groups multicast groups joined on every port (live transmission sent once to all the laptops)
+    @param interface IPv4 address of the interface joining the groups (empty = chosen by the kernel)
+*/
+struct ReceiverOptions {
+    std::vector<uint16_t> ports;
+    std::vector<std::string> groups;
+    std::string interface;
+    std::string storeDirectory = "live_store";
+    bool nack = true;
+    int statsPeriod = 5;
+};
+
+/*! @brief live receiver of all the cars */
+class Receiver {
+public:
+    explicit Receiver(ReceiverOptions options);
+    ~Receiver();
+
+    /*! @brief open the sockets
+    *   @retval false if a socket could not be opened
+    */
+    bool open();
+
+    /*! @brief receive until stop is set */
+    void run(const std::atomic<bool> & stop);
+
+    /*! @brief handle one datagram (also used by the benchmark)
+    *   @param socket socket the datagram came on (-1 = no NACK)
+    *   @param from sender address
+    *   @param data content of the datagram
+    *   @param length length of the datagram
+    *   @param time reception time (ns since epoch, kernel timestamp when available)
+    */
+    void handle(int socket, const sockaddr_in & from, const uint8_t * data, size_t length, int64_t time);
+
+    /*! @brief print the statistics of all the cars */
+    void printStats();
+
+private:
+    bool joinGroups(int socket);
+    Car & car(const sockaddr_in & from);
+    void sendNack(Car & car);
+    void answerSync(int socket, const sockaddr_in & from, const uint8_t * data, int64_t time);
+
+    ReceiverOptions options_;
+    std::vector<int> sockets_;
+    std::unordered_map<uint32_t, std::unique_ptr<Car>> cars_;     //cars by IPv4 address
+};
+
+#endif /*__RECEIVER_H*/
@@ -0,0 +1,32 @@
+/*! --------------------------------------------------------------------
+ *	Telemetry System	-	@file check.h
+ *----------------------------------------------------------------------
+ * HES-SO Valais Wallis 
+ * Systems Engineering
+ * Infotronics
+ * ---------------------------------------------------------------------
+ * @author agent
+ * @date 19.10.2026
+ * ---------------------------------------------------------------------
+ * @brief checks of the tests : a failed condition is printed with its
+ *        file and line and counted, the test returns 1 if any failed
+ * ---------------------------------------------------------------------
+ * Telemetry system for the Valais Wallis Racing Team.
+ * This file contains code for the base station of the telemetry system.
+ * The base station receives the live measurements sent via Wi-Fi by the
+ * onboard device and stores them for the dashboards.
+ *--------------------------------------------------------------------*/
+
+#ifndef __CHECK_H
+#define __CHECK_H
+
+#include <stdio.h>
+
+//! number of failed checks of the test
+static int failures = 0;
+
+//! check a condition, print and count it if it is false
+#define CHECK(condition) \
+    do { if(!(condition)) { printf("%s:%d : %s\n", __FILE__, __LINE__, #condition); failures++; } } while(0)
+
+#endif /*__CHECK_H*/
@@ -0,0 +1,174 @@
+/*! --------------------------------------------------------------------
+ *	Telemetry System	-	@file fusion_test.c
+ *----------------------------------------------------------------------
+ * HES-SO Valais Wallis 
+ * Systems Engineering
+ * Infotronics
+ * ---------------------------------------------------------------------
+ * @author agent
+ * @date 19.10.2026
+ * ---------------------------------------------------------------------
+ * @brief test of the fusion of the recorder on the host : a car on a
+ *        circle of 150 m radius at 90 km/h, GPS fixes at 1 Hz, a wheel
+ *        speed 2 % too high and steps at 100 Hz. The mean position error
+ *        is compared to the error of the last fix held between the fixes
+ * ---------------------------------------------------------------------
+ * Telemetry system for the Valais Wallis Racing Team.
+ * This file contains code for the base station of the telemetry system.
+ * The base station receives the live measurements sent via Wi-Fi by the
+ * onboard device and stores them for the dashboards.
+ *--------------------------------------------------------------------*/
+
+//includes
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+//project file includes
+#include "check.h"
+#include "fusion.h"
+#include "memory_management.h"
+#include "config_read.h"
+
+//track : circle around the center, counterclockwise
+#define TRACK_LAT 462300000                 //center (1e-7 degree)
+#define TRACK_LON 73600000
+#define TRACK_RADIUS 150.0                  //m
+#define TRACK_SPEED 25.0                    //m/s
+#define M_PER_DEGREE 111320.0
+
+#define STEP_MS 10
+#define FIX_PERIOD_MS 1000
+#define WARMUP_S 20                         //errors counted after the first courses
+#define DURATION_S 120
+
+#define WHEEL_ERROR 1.02                    //wheel speed too high
+#define YAW_OFFSET 100000                   //raw value of the yaw rate sensor at rest
+#define YAW_BIAS 50                         //bias of the yaw rate sensor (0.01 deg/s)
+
+//buffers and config read by the fusion
+struct config configFile;
+tSensor sensorBuffer[MAX_SENSORS];
+struct k_mutex sensorBufferMutex;
+tGps gpsBuffer;
+struct k_mutex gpsBufferMutex;
+
+//position on the circle at a time (s)
+static void track_point(double t, double * x, double * y)
+{
+    double angle = t * TRACK_SPEED / TRACK_RADIUS;
+    *x = TRACK_RADIUS * cos(angle);
+    *y = TRACK_RADIUS * sin(angle);
+}
+
+//local coordinates (m) to 1e-7 degree
+static void track_coord(double x, double y, int32_t * lat, int32_t * lon)
+{
+    *lat = TRACK_LAT + (int32_t)lround(y / M_PER_DEGREE * 1e7);
+    *lon = TRACK_LON + (int32_t)lround(x / (M_PER_DEGREE * cos(TRACK_LAT / 1e7 * M_PI / 180.0)) * 1e7);
+}
+
+//1e-7 degree to local coordinates (m)
+static void track_local(int32_t lat, int32_t lon, double * x, double * y)
+{
+    *y = (lat - TRACK_LAT) / 1e7 * M_PER_DEGREE;
+    *x = (lon - TRACK_LON) / 1e7 * M_PER_DEGREE * cos(TRACK_LAT / 1e7 * M_PI / 180.0);
+}
+
+/*! @brief drive the circle
+* @param wheel wheel speed sensor used
+* @param yaw yaw rate sensor used
+* @param hold error of the last fix held instead of the fusion
+* @retval mean position error after the warmup (m)
+*/
+static double simulate(bool wheel, bool yaw, bool hold)
+{
+    struct sFusion * cfg = &configFile.GPS.Fusion;
+    tFusionState state;
+    double errorSum = 0.0;
+    int errorCount = 0;
+
+    memset(cfg, 0, sizeof(*cfg));
+    memset(sensorBuffer, 0, sizeof(sensorBuffer));
+    memset(&gpsBuffer, 0, sizeof(gpsBuffer));
+    sensorBuffer[0].name_log = "Wheel speed";
+    sensorBuffer[1].name_log = "Yaw rate";
+    configFile.sensorCount = 2;
+
+    cfg->Enabled = true;
+    cfg->WheelSpeed = wheel ? "Wheel speed" : NULL;
+    cfg->WheelSpeedFactor = 1000;
+    cfg->YawRate = yaw ? "Yaw rate" : NULL;
+    cfg->YawRateFactor = 1000;
+    cfg->YawRateOffset = YAW_OFFSET;
+    CHECK(fusion_init(STEP_MS));
+
+    sensorBuffer[0].value = (uint32_t)lround(TRACK_SPEED * 360.0 * WHEEL_ERROR);                                      //0.01 km/h
+    sensorBuffer[1].value = (uint32_t)(YAW_OFFSET + lround(TRACK_SPEED / TRACK_RADIUS * 18000.0 / M_PI) + YAW_BIAS);  //0.01 deg/s
+
+    for(int n = 0; n <= DURATION_S * 1000 / STEP_MS; n++)
+    {
+        double t = n * STEP_MS / 1000.0;
+        double x, y;
+
+        if(n % (FIX_PERIOD_MS / STEP_MS) == 0)      //new fix
+        {
+            track_point(t, &x, &y);
+            track_coord(x, y, &gpsBuffer.lat, &gpsBuffer.lon);
+            gpsBuffer.speed = (uint32_t)lround(TRACK_SPEED * 360.0);
+            gpsBuffer.fix = true;
+            gpsBuffer.updates++;
+        }
+
+        fusion_step(&state);
+        if(hold)
+        {
+            state.lat = gpsBuffer.lat;
+            state.lon = gpsBuffer.lon;
+        }
+
+        if(t >= WARMUP_S)
+        {
+            double ex, ey;
+            track_point(t, &x, &y);
+            track_local(state.lat, state.lon, &ex, &ey);
+            errorSum += hypot(ex - x, ey - y);
+            errorCount++;
+        }
+    }
+
+    //speed of the wheel or of the GPS
+    CHECK(abs((int)state.speed - (int)lround(TRACK_SPEED * 360.0 * (wheel ? WHEEL_ERROR : 1.0))) <= 1);
+
+    return errorSum / errorCount;
+}
+
+int main(void)
+{
+    double yawError = simulate(true, true, false);
+    double courseError = simulate(true, false, false);
+    double gpsError = simulate(false, false, false);
+    double holdError = simulate(false, false, true);
+
+    printf("fusion : mean position error %.2f m with the yaw rate sensor (bias %.1f deg/s), %.2f m with the gps course, "
+           "%.2f m with the gps speed and course, %.2f m holding the last fix\n",
+           yawError, YAW_BIAS / 100.0, courseError, gpsError, holdError);
+
+    CHECK(yawError < holdError / 3);
+    CHECK(courseError < holdError / 3);
+    CHECK(gpsError < holdError / 3);
+
+    //disabled in the config file or without log frame rate
+    CHECK(!fusion_init(0));
+    configFile.GPS.Fusion.Enabled = false;
+    CHECK(!fusion_init(STEP_MS));
+
+    if(failures > 0)
+    {
+        printf("%d failures\n", failures);
+        return 1;
+    }
+    printf("fusion : ok\n");
+    return 0;
+}
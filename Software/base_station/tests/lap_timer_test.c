@@ -0,0 +1,201 @@
+/*! --------------------------------------------------------------------
+ *	Telemetry System	-	@file lap_timer_test.c
+ *----------------------------------------------------------------------
+ * HES-SO Valais Wallis 
+ * Systems Engineering
+ * Infotronics
+ * ---------------------------------------------------------------------
+ * @author agent
+ * @date 19.10.2026
+ * ---------------------------------------------------------------------
+ * @brief test of the lap timer of the transmitter on the host : a car on
+ *        a circle of 200 m radius at 20 m/s, fixes at 10 Hz across
+ *        midnight. The lap and sector times and the local times of the
+ *        crossings are compared to the analytic values
+ * ---------------------------------------------------------------------
+ * Telemetry system for the Valais Wallis Racing Team.
+ * This file contains code for the base station of the telemetry system.
+ * The base station receives the live measurements sent via Wi-Fi by the
+ * onboard device and stores them for the dashboards.
+ *--------------------------------------------------------------------*/
+
+//includes
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+//project file includes
+#include "check.h"
+#include "lap_timer.h"
+#include "config_read.h"
+
+//track : circle around the center, counterclockwise
+#define TRACK_LAT 462300000                 //center (1e-7 degree)
+#define TRACK_LON 73600000
+#define TRACK_RADIUS 200.0                  //m
+#define TRACK_SPEED 20.0                    //m/s
+#define TRACK_SECTORS 3                     //sectors of the same length, the first one starts at the start/finish line
+#define TRACK_LAPS 5
+#define M_PER_DEGREE 111320.0
+
+#define FIX_PERIOD_MS 100
+#define FIX_START_MS (86400000 - 90000)     //first fix 90 s before midnight
+#define BOOT_OFFSET_US 123456789LL          //local time of the first fix
+#define FIX_LATENCY_US 30000LL              //reception of the fixes after their epoch
+
+//a crossing is within the resolution of the positions (1e-7 degree = 1.1 cm, 0.56 ms at 20 m/s),
+//a duration between two crossings is also rounded to the ms
+#define MAX_CROSS_ERROR_US 1000
+#define MAX_DURATION_ERROR_MS 1.5
+
+//config read by the lap timer
+struct config configFile;
+
+//position on the circle at an angle (rad, 0 = east of the center)
+static void track_point(double angle, double radius, int32_t * lat, int32_t * lon)
+{
+    double latCenter = TRACK_LAT / 1e7;
+    *lat = TRACK_LAT + (int32_t)lround(radius * sin(angle) / M_PER_DEGREE * 1e7);
+    *lon = TRACK_LON + (int32_t)lround(radius * cos(angle) / (M_PER_DEGREE * cos(latCenter * M_PI / 180.0)) * 1e7);
+}
+
+//timing line across the track at an angle
+static void track_line(struct sTrackLine * line, double angle)
+{
+    int32_t lat, lon;
+
+    track_point(angle, TRACK_RADIUS - 10.0, &lat, &lon);
+    line->Lat1 = lat;
+    line->Lon1 = lon;
+    track_point(angle, TRACK_RADIUS + 10.0, &lat, &lon);
+    line->Lat2 = lat;
+    line->Lon2 = lon;
+}
+
+static void track_init(int sectors, int minLapTime)
+{
+    struct sTrack * track = &configFile.GPS.Track;
+
+    memset(track, 0, sizeof(*track));
+    track_line(&track->StartFinish, 0.0);
+    for(int i = 1; i < sectors; i++)
+        track_line(&track->Sectors[i - 1], 2.0 * M_PI * i / sectors);
+    track->sectorCount = sectors - 1;
+    track->MinLapTime = minLapTime;
+}
+
+//laps on the circle, every event is compared to the analytic times
+static void test_laps(void)
+{
+    const double lapTime = 2.0 * M_PI * TRACK_RADIUS / TRACK_SPEED;     //s
+    const double startAngle = -0.3;                                     //first fix before the start/finish line
+    tLapEvent events[LAP_TIMER_MAX_EVENTS];
+    int laps = 0, sectors = 0;
+    double maxError = 0.0;
+    long long maxCrossError = 0;
+
+    track_init(TRACK_SECTORS, 0);
+    CHECK(lap_timer_init());
+
+    for(int n = 0; laps < TRACK_LAPS && n < 100000; n++)
+    {
+        double t = n * FIX_PERIOD_MS / 1000.0;
+        double angle = startAngle + t * TRACK_SPEED / TRACK_RADIUS;
+        int32_t lat, lon;
+
+        track_point(angle, TRACK_RADIUS, &lat, &lon);
+        uint32_t time = (FIX_START_MS + n * FIX_PERIOD_MS) % 86400000;
+        int64_t local = BOOT_OFFSET_US + FIX_LATENCY_US + (int64_t)n * FIX_PERIOD_MS * 1000;
+
+        int count = lap_timer_fix(lat, lon, time, local, events);
+        CHECK(count <= LAP_TIMER_MAX_EVENTS);
+
+        for(int i = 0; i < count; i++)
+        {
+            const tLapEvent * e = &events[i];
+
+            //analytic time of the crossing since the first fix (s)
+            int lines = e->type == LAP_EVENT_LAP ? (e->lap * TRACK_SECTORS) : ((e->lap - 1) * TRACK_SECTORS + e->sector + 1);
+            double cross = (lines * 2.0 * M_PI / TRACK_SECTORS - startAngle) * TRACK_RADIUS / TRACK_SPEED;
+            double duration = e->type == LAP_EVENT_LAP ? lapTime : lapTime / TRACK_SECTORS;
+            int64_t crossLocal = BOOT_OFFSET_US + FIX_LATENCY_US + (int64_t)llround(cross * 1e6);
+
+            CHECK(fabs(e->duration - duration * 1000.0) <= MAX_DURATION_ERROR_MS);
+            CHECK(llabs(e->local - crossLocal) <= MAX_CROSS_ERROR_US);
+            maxError = fmax(maxError, fabs(e->duration - duration * 1000.0));
+            if(llabs(e->local - crossLocal) > maxCrossError)
+                maxCrossError = llabs(e->local - crossLocal);
+
+            if(e->type == LAP_EVENT_LAP)
+            {
+                CHECK(e->lap == laps + 1);
+                CHECK(i == count - 1);
+                laps++;
+            }
+            else
+            {
+                CHECK(e->lap == laps + 1);
+                CHECK(e->sector == sectors % TRACK_SECTORS);
+                sectors++;
+            }
+        }
+    }
+
+    CHECK(laps == TRACK_LAPS);
+    CHECK(sectors == TRACK_LAPS * TRACK_SECTORS);
+    printf("lap timer : %d laps of %.3f s across midnight, max error of the crossings %lld us, of the durations %.2f ms\n",
+           laps, lapTime, maxCrossError, maxError);
+}
+
+//crossings closer to the start of the lap than the min lap time, backwards or after a gap are ignored
+static void test_ignored(void)
+{
+    tLapEvent events[LAP_TIMER_MAX_EVENTS];
+    int32_t lat[2], lon[2];
+    int count = 0;
+
+    track_init(1, 20000);
+    CHECK(lap_timer_init());
+
+    track_point(-0.01, TRACK_RADIUS, &lat[0], &lon[0]);
+    track_point(0.01, TRACK_RADIUS, &lat[1], &lon[1]);
+
+    //lap 1 starts, the line is crossed again 5 s later : too short
+    CHECK(lap_timer_fix(lat[0], lon[0], 1000, 1000000, events) == 0);
+    CHECK(lap_timer_fix(lat[1], lon[1], 1100, 1100000, events) == 0);
+    CHECK(lap_timer_fix(lat[0], lon[0], 5000, 5000000, events) == 0);       //backwards
+    CHECK(lap_timer_fix(lat[1], lon[1], 5100, 5100000, events) == 0);       //before the min lap time
+
+    //same epoch twice
+    CHECK(lap_timer_fix(lat[0], lon[0], 30000, 30000000, events) == 0);
+    CHECK(lap_timer_fix(lat[0], lon[0], 30000, 30000000, events) == 0);
+
+    //gap of 3 s between the fixes on both sides : no interpolation
+    CHECK(lap_timer_fix(lat[1], lon[1], 33000, 33000000, events) == 0);
+
+    //lap completed
+    CHECK(lap_timer_fix(lat[0], lon[0], 40000, 40000000, events) == 0);
+    count = lap_timer_fix(lat[1], lon[1], 40100, 40100000, events);
+    CHECK(count == 1);
+    CHECK(count == 1 && events[0].type == LAP_EVENT_LAP && events[0].lap == 1 && events[0].duration == 39000);
+
+    //no start/finish line : disabled
+    memset(&configFile.GPS.Track, 0, sizeof(configFile.GPS.Track));
+    CHECK(!lap_timer_init());
+    CHECK(lap_timer_fix(lat[0], lon[0], 50000, 50000000, events) == 0);
+}
+
+int main(void)
+{
+    test_laps();
+    test_ignored();
+
+    if(failures > 0)
+    {
+        printf("%d failures\n", failures);
+        return 1;
+    }
+    printf("lap timer : ok\n");
+    return 0;
+}
@@ -0,0 +1,224 @@
+/*! --------------------------------------------------------------------
+ *	Telemetry System	-	@file nmea_parser_test.c
+ *----------------------------------------------------------------------
+ * HES-SO Valais Wallis 
+ * Systems Engineering
+ * Infotronics
+ * ---------------------------------------------------------------------
+ * @author agent
+ * @date 19.10.2026
+ * ---------------------------------------------------------------------
+ * @brief test of the NMEA parser of the transmitter on the host : values
+ *        of known sentences, rejected sentences and random mutations of
+ *        valid sentences (every accepted sentence must have a correct
+ *        checksum and values in the ranges checked by the parser)
+ *
+ *        usage : nmea_parser_test [mutations]
+ * ---------------------------------------------------------------------
+ * Telemetry system for the Valais Wallis Racing Team.
+ * This file contains code for the base station of the telemetry system.
+ * The base station receives the live measurements sent via Wi-Fi by the
+ * onboard device and stores them for the dashboards.
+ *--------------------------------------------------------------------*/
+
+//includes
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+//project file includes
+#include "check.h"
+#include "nmea_parser.h"
+
+//default number of mutated sentences
+#define NMEA_TEST_MUTATIONS 200000
+
+//sentences of a u-blox module, the checksums are computed by nmea_sentence
+static const char * sentences[] = {
+    "$GNRMC,162134.00,A,4617.63609,N,00731.94398,E,0.006,,170524,,,A,V*",
+    "$GNGLL,4617.63609,N,00731.94398,E,162134.00,A,A*",
+    "$GNGSA,A,3,10,12,,,,,,,,,,,1.5,0.9,1.2,1*",
+    "$GNVTG,,T,,M,0.006,N,0.011,K,A*",
+    "$GNGGA,162134.00,4617.63609,N,00731.94398,E,1,12,0.9,500.0,M,48.0,M,,*",
+};
+#define SENTENCE_COUNT (int)(sizeof(sentences)/sizeof(sentences[0]))
+
+//complete a sentence with its checksum and CR LF
+static void nmea_sentence(char * out, const char * body)
+{
+    uint8_t checksum = 0;
+    for(const char * p = body + 1; *p != '*'; p++)
+        checksum ^= (uint8_t)*p;
+    sprintf(out, "%s%02X\r\n", body, checksum);
+}
+
+//parse a string, return the last sentence completed
+static int nmea_string(tNmeaParser * parser, const char * s, size_t length)
+{
+    int sentence = NMEA_SENTENCE_NONE;
+    for(size_t i = 0; i < length; i++)
+    {
+        int r = nmea_parse(parser, (uint8_t)s[i]);
+        if(r != NMEA_SENTENCE_NONE)
+            sentence = r;
+    }
+    return sentence;
+}
+
+static void test_values(void)
+{
+    tNmeaParser parser;
+    char s[128];
+
+    nmea_parser_init(&parser);
+
+    nmea_sentence(s, sentences[0]);
+    CHECK(nmea_string(&parser, s, strlen(s)) == NMEA_SENTENCE_RMC);
+    CHECK(parser.data.time == 58894000);
+    CHECK(parser.data.lat == 462939348);
+    CHECK(parser.data.lon == 75323997);
+    CHECK(parser.data.speed == 1);
+    CHECK(parser.data.day == 17 && parser.data.month == 5 && parser.data.year == 24);
+    CHECK(parser.data.status);
+
+    nmea_sentence(s, sentences[2]);
+    CHECK(nmea_string(&parser, s, strlen(s)) == NMEA_SENTENCE_GSA);
+    CHECK(parser.data.fixMode == 3 && parser.data.pdop == 150 && parser.data.hdop == 90);
+    CHECK((parser.data.valid & (NMEA_HAS_PDOP | NMEA_HAS_HDOP)) == (NMEA_HAS_PDOP | NMEA_HAS_HDOP));
+
+    nmea_sentence(s, sentences[3]);
+    CHECK(nmea_string(&parser, s, strlen(s)) == NMEA_SENTENCE_VTG);
+    CHECK(parser.data.speed == 1);
+
+    nmea_sentence(s, sentences[4]);
+    CHECK(nmea_string(&parser, s, strlen(s)) == NMEA_SENTENCE_GGA);
+    CHECK(parser.data.quality == 1 && parser.data.satellites == 12 && parser.data.hdop == 90);
+    CHECK(parser.data.lat == 462939348 && parser.data.lon == 75323997);
+
+    CHECK(parser.sentences == 4 && parser.checksumErrors == 0 && parser.formatErrors == 0);
+}
+
+static void test_rejected(void)
+{
+    tNmeaParser parser;
+    char s[256];
+
+    nmea_parser_init(&parser);
+
+    nmea_sentence(s, sentences[1]);         //wrong checksum
+    s[10] = '9';
+    CHECK(nmea_string(&parser, s, strlen(s)) == NMEA_SENTENCE_NONE);
+    CHECK(parser.checksumErrors == 1);
+
+    nmea_sentence(s, sentences[1]);         //truncated, then a complete sentence
+    char twice[256];
+    sprintf(twice, "%.20s%s", s, s);
+    CHECK(nmea_string(&parser, twice, strlen(twice)) == NMEA_SENTENCE_GLL);
+    CHECK(parser.formatErrors == 1);
+
+    nmea_sentence(s, "$GNGGA,1621x4.00,4617.63609,N,00731.94398,E,1,12,0.9,500.0,M,48.0,M,,*");      //invalid character in a number
+    CHECK(nmea_string(&parser, s, strlen(s)) == NMEA_SENTENCE_NONE);
+
+    nmea_sentence(s, "$GNRMC,246134.00,A,4617.63609,N,00731.94398,E,0.006,,170524,,,A,V*");      //hour out of range
+    CHECK(nmea_string(&parser, s, strlen(s)) == NMEA_SENTENCE_NONE);
+
+    char body[200] = "$GNGLL";                //too long
+    while(strlen(body) < NMEA_MAX_LENGTH + 10)
+        strcat(body, ",1");
+    strcat(body, "*");
+    nmea_sentence(s, body);
+    CHECK(nmea_string(&parser, s, strlen(s)) == NMEA_SENTENCE_NONE);
+
+    CHECK(parser.sentences == 1);
+}
+
+//check the sentence accepted at the end of buf (from its '$') and the published values
+static void check_accepted(const tNmeaParser * parser, const char * buf, int end)
+{
+    int start = 0;
+    uint8_t checksum = 0;
+    int i;
+    for(i = start + 1; i < end - 2 && buf[i] != '*'; i++)
+    {
+        CHECK(buf[i] >= 0x20 && buf[i] <= 0x7E);
+        checksum ^= (uint8_t)buf[i];
+    }
+
+    char hex[3] = { buf[end - 1], buf[end], '\0' };
+    CHECK(buf[start] == '$' && buf[i] == '*' && i == end - 2);
+    CHECK(checksum == (uint8_t)strtoul(hex, NULL, 16));
+
+    const tNmeaData * d = &parser->data;
+    if(d->valid & NMEA_HAS_TIME)
+        CHECK(d->time < 86401000);
+    if(d->valid & NMEA_HAS_DATE)
+        CHECK(d->day >= 1 && d->day <= 31 && d->month >= 1 && d->month <= 12);
+    if(d->valid & NMEA_HAS_POSITION)
+        CHECK(d->lat > -910000000 && d->lat < 910000000 && d->lon > -1810000000 && d->lon < 1810000000);
+}
+
+static void test_mutations(long mutations)
+{
+    tNmeaParser parser;
+    char valid[SENTENCE_COUNT][128];
+    char sentence[256];         //characters since the last '$' (a truncated sentence continues in the next buffer if its '$' is mutated)
+    int sentenceLength = 0;
+    long accepted = 0;
+
+    nmea_parser_init(&parser);
+    srand(1);
+
+    for(int i = 0; i < SENTENCE_COUNT; i++)
+        nmea_sentence(valid[i], sentences[i]);
+
+    for(long m = 0; m < mutations; m++)
+    {
+        char buf[128];
+        strcpy(buf, valid[m % SENTENCE_COUNT]);
+        int length = strlen(buf);
+
+        for(int k = rand() % 4; k > 0; k--)          //0 to 3 random bytes
+            buf[rand() % length] = (char)(rand() % 256);
+        if(rand() % 4 == 0)                         //truncated
+            length = rand() % length;
+
+        for(int i = 0; i < length; i++)
+        {
+            if(buf[i] == '$')
+                sentenceLength = 0;
+            if(sentenceLength < (int)sizeof(sentence))
+                sentence[sentenceLength] = buf[i];
+            sentenceLength++;
+
+            if(nmea_parse(&parser, (uint8_t)buf[i]) != NMEA_SENTENCE_NONE)
+            {
+                accepted++;
+                CHECK(sentenceLength <= NMEA_MAX_LENGTH + 3);
+                if(sentenceLength <= (int)sizeof(sentence))
+                    check_accepted(&parser, sentence, sentenceLength - 1);
+            }
+        }
+    }
+
+    CHECK(accepted > 0);
+    CHECK(parser.checksumErrors > 0 && parser.formatErrors > 0);
+    printf("nmea parser : %ld mutations, %ld accepted, %u checksum errors, %u format errors\n",
+           mutations, accepted, parser.checksumErrors, parser.formatErrors);
+}
+
+int main(int argc, char ** argv)
+{
+    long mutations = argc > 1 ? atol(argv[1]) : NMEA_TEST_MUTATIONS;
+
+    test_values();
+    test_rejected();
+    test_mutations(mutations);
+
+    if(failures > 0)
+    {
+        printf("%d failures\n", failures);
+        return 1;
+    }
+    printf("nmea parser : ok\n");
+    return 0;
+}
@@ -0,0 +1,200 @@
+/*! --------------------------------------------------------------------
+ *	Telemetry System	-	@file sequence_tracker_test.cpp
+ *----------------------------------------------------------------------
+ * HES-SO Valais Wallis 
+ * Systems Engineering
+ * Infotronics
+ * ---------------------------------------------------------------------
+ * @author agent
+ * @date 19.10.2026
+ * ---------------------------------------------------------------------
+ * @brief test of the sequence tracker of the base station : gaps,
+ *        retransmissions, backfill after a long outage, restarts of the
+ *        car and samples of the priority classes
+ * ---------------------------------------------------------------------
+ * Telemetry system for the Valais Wallis Racing Team.
+ * This file contains code for the base station of the telemetry system.
+ * The base station receives the live measurements sent via Wi-Fi by the
+ * onboard device and stores them for the dashboards.
+ *--------------------------------------------------------------------*/
+
+//includes
+#include <cstdio>
+
+//project file includes
+#include "check.h"
+#include "receiver.h"
+#include "live_protocol.h"
+
+namespace {
+
+//time of the first sample (µs since 1970)
+const int64_t START = 1760000000000000LL;
+//period of the live samples (µs, 20 samples/second)
+const int64_t PERIOD = 50000;
+
+//sample of the live stream : car time = reception time
+int live(SequenceTracker & tracker, uint32_t sequence, int64_t time, uint32_t * missing)
+{
+    return tracker.add(sequence, time, time, missing, 64);
+}
+
+void testGap()
+{
+    SequenceTracker tracker;
+    uint32_t missing[64];
+
+    for(uint32_t s = 0; s < 10; s++)
+        CHECK(live(tracker, s, START + s * PERIOD, missing) == 0);
+
+    CHECK(live(tracker, 12, START + 12 * PERIOD, missing) == 2);
+    CHECK(missing[0] == 10 && missing[1] == 11);
+    CHECK(tracker.stats().lost == 2);
+
+    CHECK(tracker.add(10, START + 10 * PERIOD, START + 13 * PERIOD, missing, 64) == 0);       //retransmitted
+    CHECK(tracker.add(10, START + 10 * PERIOD, START + 13 * PERIOD, missing, 64) == 0);       //retransmitted twice
+    CHECK(tracker.stats().lost == 1);
+    CHECK(tracker.stats().recovered == 1);
+    CHECK(tracker.stats().duplicates == 1);
+}
+
+//outage of 2000 samples, the spooled samples (one of five) are backfilled between the live samples
+void testBackfill()
+{
+    SequenceTracker tracker;
+    uint32_t missing[64];
+    int nacked = 0;
+
+    for(uint32_t s = 0; s < 100; s++)
+        live(tracker, s, START + s * PERIOD, missing);
+
+    uint32_t backfill = 100;
+    for(uint32_t s = 2100; s < 2600; s++)
+    {
+        nacked += live(tracker, s, START + s * PERIOD, missing);
+
+        for(int i = 0; i < 4 && backfill < 2100; i++, backfill += 5)
+        {
+            CHECK(tracker.add(backfill, START + backfill * PERIOD, START + s * PERIOD, missing, 64) == 0);
+        }
+    }
+
+    CHECK(backfill == 2100);
+    CHECK(nacked == 0);                         //gap longer than the window : not NACKed
+    CHECK(tracker.stats().restarts == 0);
+    CHECK(tracker.stats().lost == 2000 - tracker.stats().recovered);
+    CHECK(tracker.stats().recovered == SEQUENCE_WINDOW / 5);      //backfilled samples in the window
+    CHECK(tracker.stats().late == 400 - SEQUENCE_WINDOW / 5);
+    CHECK(live(tracker, 2600, START + 2600 * PERIOD, missing) == 0);      //next live sample : no new gap
+}
+
+//the first live sample after an outage is lost, a backfilled sample comes first
+void testBackfillFirst()
+{
+    SequenceTracker tracker;
+    uint32_t missing[64];
+
+    for(uint32_t s = 0; s < 3000; s++)
+        live(tracker, s, START + s * PERIOD, missing);
+
+    int64_t now = START + 6000 * PERIOD;
+    CHECK(tracker.add(500, START + 500 * PERIOD, now, missing, 64) == 0);
+    CHECK(tracker.stats().restarts == 0);
+    CHECK(live(tracker, 6000, now, missing) == 0);       //gap longer than the window
+    CHECK(tracker.stats().lost == 3000);
+}
+
+void testRestart()
+{
+    SequenceTracker tracker;
+    uint32_t missing[64];
+
+    for(uint32_t s = 0; s < 5000; s++)
+        live(tracker, s, START + s * PERIOD, missing);
+
+    //car restarted : clock not synchronised
+    int64_t now = START + 5000 * PERIOD + 10000000;
+    CHECK(tracker.add(0, 0, now, missing, 64) == 0);
+    CHECK(tracker.stats().restarts == 1);
+    CHECK(tracker.add(1, 0, now + PERIOD, missing, 64) == 0);
+    CHECK(tracker.stats().lost == 0);
+
+    //retransmitted sample of before the restart : not a restart
+    CHECK(tracker.add(4999, START + 4999 * PERIOD, now + 2 * PERIOD, missing, 64) == 0);
+    CHECK(tracker.stats().restarts == 1);
+
+    //restart after a short session : synchronised time
+    now += 10000000;
+    CHECK(tracker.add(0, now, now, missing, 64) == 0);
+    CHECK(tracker.stats().restarts == 2);
+    CHECK(live(tracker, 1, now + PERIOD, missing) == 0);
+}
+
+void testAnchor()
+{
+    SequenceTracker tracker;
+    uint32_t missing[64];
+
+    live(tracker, 100, START, missing);
+    CHECK(tracker.add(50, START - 50 * PERIOD, START + PERIOD, missing, 64) == 0);     //backfilled before the first sample
+    CHECK(tracker.stats().late == 1);
+    CHECK(tracker.stats().lost == 0);
+    CHECK(live(tracker, 101, START + PERIOD, missing) == 0);
+}
+
+//sample received by a car : number of sequences to NACK
+int receive(Car & car, uint32_t sequence, int64_t time)
+{
+    LiveSample sample{};
+    sample.hasSequence = true;
+    sample.sequence = sequence;
+    sample.time = time;
+
+    car.receiveTime = time * 1000;
+    car.missingCount = 0;
+    car.onSample(sample);
+    return car.missingCount;
+}
+
+//the samples of a priority class skip ahead of the samples queued on the car
+void testPriorityLane()
+{
+    Car car("car", "unused");
+    int nacked = 0;
+
+    for(uint32_t s = 0; s < 10; s++)
+        nacked += receive(car, s, START + s * PERIOD);
+
+    nacked += receive(car, LIVE_SEQUENCE_PRIORITY | 0, START + 12 * PERIOD);
+    nacked += receive(car, 10, START + 10 * PERIOD);
+    nacked += receive(car, LIVE_SEQUENCE_PRIORITY | 1, START + 13 * PERIOD);
+    nacked += receive(car, 11, START + 11 * PERIOD);
+    nacked += receive(car, 12, START + 12 * PERIOD);
+
+    CHECK(nacked == 0);
+    CHECK(car.tracker.stats().lost == 0 && car.tracker.stats().received == 13);
+    CHECK(car.priorityTracker.stats().lost == 0 && car.priorityTracker.stats().received == 2);
+
+    CHECK(receive(car, LIVE_SEQUENCE_PRIORITY | 3, START + 14 * PERIOD) == 1);       //priority sample lost
+    CHECK(car.missing[0] == (LIVE_SEQUENCE_PRIORITY | 2));
+}
+
+} // namespace
+
+int main()
+{
+    testGap();
+    testBackfill();
+    testBackfillFirst();
+    testRestart();
+    testAnchor();
+    testPriorityLane();
+
+    if(failures > 0)
+    {
+        printf("%d failures\n", failures);
+        return 1;
+    }
+    printf("sequence tracker : ok\n");
+    return 0;
+}
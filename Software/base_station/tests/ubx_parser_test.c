@@ -0,0 +1,236 @@
+/*! --------------------------------------------------------------------
+ *	Telemetry System	-	@file ubx_parser_test.c
+ *----------------------------------------------------------------------
+ * HES-SO Valais Wallis 
+ * Systems Engineering
+ * Infotronics
+ * ---------------------------------------------------------------------
+ * @author agent
+ * @date 19.10.2026
+ * ---------------------------------------------------------------------
+ * @brief test of the UBX parser of the transmitter on the host : values
+ *        of a NAV-PVT message, ACK and skipped messages, every single bit
+ *        error of a frame and frames mixed with random bytes
+ *
+ *        usage : ubx_parser_test [frames]
+ * ---------------------------------------------------------------------
+ * Telemetry system for the Valais Wallis Racing Team.
+ * This file contains code for the base station of the telemetry system.
+ * The base station receives the live measurements sent via Wi-Fi by the
+ * onboard device and stores them for the dashboards.
+ *--------------------------------------------------------------------*/
+
+//includes
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+//project file includes
+#include "check.h"
+#include "ubx_parser.h"
+
+//default number of frames mixed with random bytes
+#define UBX_TEST_FRAMES 200000
+
+static void put16(uint8_t * p, uint16_t v) { p[0] = v; p[1] = v >> 8; }
+static void put32(uint8_t * p, uint32_t v) { p[0] = v; p[1] = v >> 8; p[2] = v >> 16; p[3] = v >> 24; }
+
+//NAV-PVT frame : 19.10.2026 13:45:29.998, 3D fix, 14 satellites, 100 km/h heading east
+static int pvt_frame(uint8_t * frame)
+{
+    uint8_t payload[UBX_NAV_PVT_LENGTH] = { 0 };
+
+    put32(payload + 0, 123456);                 //iTOW
+    put16(payload + 4, 2026);
+    payload[6] = 10;
+    payload[7] = 19;
+    payload[8] = 13;
+    payload[9] = 45;
+    payload[10] = 30;
+    payload[11] = 0x03;                         //validDate, validTime
+    put32(payload + 16, (uint32_t)-2000000);    //nano : -2 ms
+    payload[20] = UBX_FIX_3D;
+    payload[21] = 0x01;                         //gnssFixOK
+    payload[23] = 14;
+    put32(payload + 24, 73594210);              //lon
+    put32(payload + 28, (uint32_t)-462270012);  //lat
+    put32(payload + 40, 1500);                  //hAcc
+    put32(payload + 60, 27778);                 //gSpeed (mm/s)
+    put32(payload + 64, 9000000);               //headMot
+    put16(payload + 76, 123);                   //pDOP
+
+    return ubx_frame(frame, UBX_CLASS_NAV, UBX_ID_NAV_PVT, payload, sizeof(payload));
+}
+
+//parse bytes, return the last message completed
+static int ubx_bytes(tUbxParser * parser, const uint8_t * buf, int length)
+{
+    int msg = UBX_MSG_NONE;
+    for(int i = 0; i < length; i++)
+    {
+        int r = ubx_parse(parser, buf[i]);
+        if(r != UBX_MSG_NONE)
+            msg = r;
+    }
+    return msg;
+}
+
+static void test_values(void)
+{
+    tUbxParser parser;
+    uint8_t frame[UBX_NAV_PVT_LENGTH + UBX_FRAME_OVERHEAD];
+
+    ubx_parser_init(&parser);
+    CHECK(ubx_bytes(&parser, frame, pvt_frame(frame)) == UBX_MSG_NAV_PVT);
+
+    const tUbxPvt * pvt = &parser.pvt;
+    CHECK(pvt->valid == (UBX_HAS_DATE | UBX_HAS_TIME | UBX_HAS_FIX_OK));
+    CHECK(pvt->iTow == 123456);
+    CHECK(pvt->time == 49529998);
+    CHECK(pvt->year == 2026 && pvt->month == 10 && pvt->day == 19);
+    CHECK(pvt->fixType == UBX_FIX_3D && pvt->numSv == 14);
+    CHECK(pvt->lat == -462270012 && pvt->lon == 73594210);
+    CHECK(pvt->speed == 10000);
+    CHECK(pvt->heading == 9000000 && pvt->hAcc == 1500 && pvt->pDop == 123);
+    CHECK(parser.messages == 1 && parser.checksumErrors == 0 && parser.formatErrors == 0);
+}
+
+static void test_other_messages(void)
+{
+    tUbxParser parser;
+    uint8_t buf[2048];
+    uint8_t payload[UBX_MAX_LENGTH + 1] = { 0 };
+
+    ubx_parser_init(&parser);
+
+    payload[0] = UBX_CLASS_CFG;
+    payload[1] = UBX_ID_CFG_RATE;
+    CHECK(ubx_bytes(&parser, buf, ubx_frame(buf, UBX_CLASS_ACK, UBX_ID_ACK_ACK, payload, 2)) == UBX_MSG_ACK);
+    CHECK(parser.ackClass == UBX_CLASS_CFG && parser.ackId == UBX_ID_CFG_RATE);
+    CHECK(ubx_bytes(&parser, buf, ubx_frame(buf, UBX_CLASS_ACK, UBX_ID_ACK_NAK, payload, 2)) == UBX_MSG_NAK);
+
+    CHECK(ubx_bytes(&parser, buf, ubx_frame(buf, UBX_CLASS_NAV, 0x03, payload, 16)) == UBX_MSG_NONE);      //NAV-STATUS : skipped
+    CHECK(parser.checksumErrors == 0 && parser.formatErrors == 0);
+
+    int length = ubx_frame(buf, UBX_CLASS_NAV, 0x35, payload, UBX_MAX_LENGTH + 1);        //too long
+    int frameLength = pvt_frame(buf + length);
+    CHECK(ubx_bytes(&parser, buf, length + frameLength) == UBX_MSG_NAV_PVT);                //resynchronised on the next frame
+    CHECK(parser.formatErrors == 1);
+}
+
+static void test_dop(void)
+{
+    tUbxParser parser;
+    uint8_t buf[256];
+    uint8_t payload[UBX_NAV_DOP_LENGTH] = { 0 };
+
+    ubx_parser_init(&parser);
+
+    put32(payload, 345600000);      //iTOW
+    put16(payload + 6, 123);        //pDOP : not used
+    put16(payload + 12, 87);        //hDOP
+    put16(payload + 14, 55);        //nDOP : not used
+    CHECK(ubx_bytes(&parser, buf, ubx_frame(buf, UBX_CLASS_NAV, UBX_ID_NAV_DOP, payload, sizeof(payload))) == UBX_MSG_NAV_DOP);
+    CHECK(parser.dop.iTow == 345600000 && parser.dop.hDop == 87);
+
+    CHECK(ubx_bytes(&parser, buf, pvt_frame(buf)) == UBX_MSG_NAV_PVT);         //NAV-PVT of the same epoch
+    CHECK(parser.pvt.pDop == 123 && parser.dop.hDop == 87);
+
+    put16(payload + 12, 99);
+    CHECK(ubx_bytes(&parser, buf, ubx_frame(buf, UBX_CLASS_NAV, UBX_ID_NAV_DOP, payload, 16)) == UBX_MSG_NONE);    //wrong length : skipped
+    CHECK(parser.dop.hDop == 87 && parser.formatErrors == 0);
+}
+
+//every single bit error of the frame is rejected, the next frame is still read
+static void test_bit_errors(void)
+{
+    tUbxParser parser;
+    uint8_t frame[UBX_NAV_PVT_LENGTH + UBX_FRAME_OVERHEAD];
+    uint8_t buf[2 * sizeof(frame)];
+    int length = pvt_frame(frame);
+    int accepted = 0;
+
+    ubx_parser_init(&parser);
+
+    for(int bit = 0; bit < 8 * length; bit++)
+    {
+        memcpy(buf, frame, length);
+        memcpy(buf + length, frame, length);
+        buf[bit / 8] ^= 1 << (bit % 8);
+
+        for(int i = 0; i < 2 * length; i++)
+        {
+            if(ubx_parse(&parser, buf[i]) != UBX_MSG_NONE)
+            {
+                CHECK(i == 2 * length - 1);         //only the second frame
+                accepted++;
+            }
+        }
+    }
+
+    //a bit error in the length can make the first frame swallow the second one
+    CHECK(accepted >= 8 * length - 16);
+    printf("ubx parser : %d single bit errors, none accepted, next frame read %d times\n", 8 * length, accepted);
+}
+
+static void test_random(long frames)
+{
+    tUbxParser parser;
+    tUbxPvt expected;
+    uint8_t frame[UBX_NAV_PVT_LENGTH + UBX_FRAME_OVERHEAD];
+    uint8_t noise[32];
+    int length = pvt_frame(frame);
+    long accepted = 0;
+
+    ubx_parser_init(&parser);
+    ubx_bytes(&parser, frame, length);
+    expected = parser.pvt;
+
+    srand(1);
+    for(long f = 0; f < frames; f++)
+    {
+        int noiseLength = rand() % sizeof(noise);
+        for(int i = 0; i < noiseLength; i++)
+            noise[i] = rand() % 4 == 0 ? UBX_SYNC1 : (uint8_t)rand();       //many false sync characters
+
+        for(int i = 0; i < noiseLength; i++)
+            CHECK(ubx_parse(&parser, noise[i]) == UBX_MSG_NONE);
+
+        for(int i = 0; i < length; i++)
+        {
+            int r = ubx_parse(&parser, frame[i]);
+            if(r == UBX_MSG_NAV_PVT)
+            {
+                accepted++;
+                CHECK(memcmp(&parser.pvt, &expected, sizeof(expected)) == 0);
+            }
+            else
+            {
+                CHECK(r == UBX_MSG_NONE);
+            }
+        }
+    }
+
+    CHECK(accepted > frames * 9 / 10);
+    printf("ubx parser : %ld frames after random bytes, %ld read, %u checksum errors, %u format errors\n",
+           frames, accepted, parser.checksumErrors, parser.formatErrors);
+}
+
+int main(int argc, char ** argv)
+{
+    long frames = argc > 1 ? atol(argv[1]) : UBX_TEST_FRAMES;
+
+    test_values();
+    test_other_messages();
+    test_dop();
+    test_bit_errors();
+    test_random(frames);
+
+    if(failures > 0)
+    {
+        printf("%d failures\n", failures);
+        return 1;
+    }
+    printf("ubx parser : ok\n");
+    return 0;
+}
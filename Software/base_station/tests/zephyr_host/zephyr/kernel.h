@@ -0,0 +1,57 @@
+/*! --------------------------------------------------------------------
+ *	Telemetry System	-	@file kernel.h
+ *----------------------------------------------------------------------
+ * HES-SO Valais Wallis 
+ * Systems Engineering
+ * Infotronics
+ * ---------------------------------------------------------------------
+ * @author agent
+ * @date 19.10.2026
+ * ---------------------------------------------------------------------
+ * @brief host replacement of the Zephyr kernel header for the tests of
+ *        the onboard modules : only the types of the shared headers and a
+ *        mutex that does nothing (the tests are single threaded)
+ * ---------------------------------------------------------------------
+ * Telemetry system for the Valais Wallis Racing Team.
+ * This file contains code for the base station of the telemetry system.
+ * The base station receives the live measurements sent via Wi-Fi by the
+ * onboard device and stores them for the dashboards.
+ *--------------------------------------------------------------------*/
+
+#ifndef __ZEPHYR_HOST_KERNEL_H
+#define __ZEPHYR_HOST_KERNEL_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+typedef long atomic_t;
+typedef int k_timeout_t;
+
+#define K_FOREVER 0
+#define K_NO_WAIT 0
+
+struct k_mutex{
+    int locked;
+};
+
+//only declared by the shared headers
+struct k_mem_slab;
+struct k_msgq;
+struct k_heap;
+struct k_queue;
+
+static inline int k_mutex_lock(struct k_mutex * mutex, k_timeout_t timeout)
+{
+    (void)timeout;
+    mutex->locked++;
+    return 0;
+}
+
+static inline int k_mutex_unlock(struct k_mutex * mutex)
+{
+    mutex->locked--;
+    return 0;
+}
+
+#endif /*__ZEPHYR_HOST_KERNEL_H*/
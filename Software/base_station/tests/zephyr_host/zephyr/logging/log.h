@@ -0,0 +1,29 @@
+/*! --------------------------------------------------------------------
+ *	Telemetry System	-	@file log.h
+ *----------------------------------------------------------------------
+ * HES-SO Valais Wallis 
+ * Systems Engineering
+ * Infotronics
+ * ---------------------------------------------------------------------
+ * @author agent
+ * @date 19.10.2026
+ * ---------------------------------------------------------------------
+ * @brief host replacement of the Zephyr logging header for the tests of
+ *        the onboard modules : the messages are not printed
+ * ---------------------------------------------------------------------
+ * Telemetry system for the Valais Wallis Racing Team.
+ * This file contains code for the base station of the telemetry system.
+ * The base station receives the live measurements sent via Wi-Fi by the
+ * onboard device and stores them for the dashboards.
+ *--------------------------------------------------------------------*/
+
+#ifndef __ZEPHYR_HOST_LOG_H
+#define __ZEPHYR_HOST_LOG_H
+
+#define LOG_MODULE_REGISTER(name)       extern int log_module_##name
+#define LOG_ERR(...)                    do { } while(0)
+#define LOG_WRN(...)                    do { } while(0)
+#define LOG_INF(...)                    do { } while(0)
+#define LOG_DBG(...)                    do { } while(0)
+
+#endif /*__ZEPHYR_HOST_LOG_H*/
@@ -317,8 +317,9 @@ int read_config(void)
 
 		//initialize gps buffer values
 		gpsBuffer.fix=false;
-		strcpy(gpsBuffer.speed,"0.0");
-		strcpy(gpsBuffer.coord,"0.0 0.0");
+		gpsBuffer.speed=0;
+		gpsBuffer.lat=0;
+		gpsBuffer.lon=0;
 		
 		//initialize gpsbuffer parames with config file values
 		gpsBuffer.LiveCoordEnable=configFile.GPS.Coordinates.LiveEnable;
@@ -109,8 +109,11 @@ void Data_Logger()
 
         k_mutex_lock(&gpsBufferMutex,K_FOREVER);		    //lock gps buffer mutex
 
-        sprintf(str,"%s%s;",str,gpsBuffer.coord);           //print gps data in CSV file
-        sprintf(str,"%s%s;",str,gpsBuffer.speed);
+        uint32_t lat = gpsBuffer.lat < 0 ? -(uint32_t)gpsBuffer.lat : (uint32_t)gpsBuffer.lat;      //1e-7 degree
+        uint32_t lon = gpsBuffer.lon < 0 ? -(uint32_t)gpsBuffer.lon : (uint32_t)gpsBuffer.lon;
+        sprintf(str,"%s%s%u.%07u %s%u.%07u;",str,gpsBuffer.lat < 0 ? "-" : "",lat/10000000,lat%10000000,    //print gps data in CSV file
+                                          gpsBuffer.lon < 0 ? "-" : "",lon/10000000,lon%10000000);
+        sprintf(str,"%s%u.%02u;",str,gpsBuffer.speed/100,gpsBuffer.speed%100);     //km/h
         sprintf(str,"%s%s;",str,gpsBuffer.fix ? "true" : "false");
         
         k_mutex_unlock(&gpsBufferMutex);		            //unlock gps buffer mutex
@@ -333,8 +336,8 @@ void Task_Data_Logger_Init(void)
         lineSize+=(1+strlen(gpsBuffer.NameLiveCoord));      // add string length of name + 1 for the ;
 
     //add size of gps speed
-    if(strlen(gpsBuffer.NameLiveSpeed)<7)                   //if name is shorter than 7
-        lineSize+=8;                                        // add max length of gps speed + 1 for the ;
+    if(strlen(gpsBuffer.NameLiveSpeed)<11)                  //if name is shorter than 11
+        lineSize+=12;                                       // add max length of gps speed (32 bit in hundredths) + 1 for the ;
     else                                                    //else
         lineSize+=(1+strlen(gpsBuffer.NameLiveSpeed));      // add string length of name + 1 for the ;
 
@@ -88,10 +88,15 @@ void Data_Sender()
 			k_mutex_lock(&gpsBufferMutex,K_FOREVER);		//lock gps buffer mutex
 			
 			if(gpsBuffer.LiveCoordEnable)
-				sprintf(memPtr,"%s,\"%s\":\"%s\"",memPtr,gpsBuffer.NameLiveCoord,gpsBuffer.coord);
+			{
+				uint32_t lat = gpsBuffer.lat < 0 ? -(uint32_t)gpsBuffer.lat : (uint32_t)gpsBuffer.lat;		//1e-7 degree
+				uint32_t lon = gpsBuffer.lon < 0 ? -(uint32_t)gpsBuffer.lon : (uint32_t)gpsBuffer.lon;
+				sprintf(memPtr,"%s,\"%s\":\"%s%u.%07u %s%u.%07u\"",memPtr,gpsBuffer.NameLiveCoord,
+						gpsBuffer.lat < 0 ? "-" : "",lat/10000000,lat%10000000,gpsBuffer.lon < 0 ? "-" : "",lon/10000000,lon%10000000);
+			}
 			
 			if(gpsBuffer.LiveSpeedEnable)
-				sprintf(memPtr,"%s,\"%s\":%s",memPtr,gpsBuffer.NameLiveSpeed,gpsBuffer.speed);
+				sprintf(memPtr,"%s,\"%s\":%u.%02u",memPtr,gpsBuffer.NameLiveSpeed,gpsBuffer.speed/100,gpsBuffer.speed%100);		//km/h
 
 			if(gpsBuffer.LiveFixEnable && gpsBuffer.fix)
 				sprintf(memPtr,"%s,\"%s\":true",memPtr,gpsBuffer.NameLiveFix);
@@ -146,7 +151,7 @@ void Task_Data_Sender_Init( void )
 			udpQueueMesLength+=(strlen(gpsBuffer.NameLiveCoord)+6+25);	//name length + 6 bytes for ,:"""" + 25 bytes for data
 	
 	if(gpsBuffer.LiveSpeedEnable)			//if gps coord is used in live telemetry
-			udpQueueMesLength+=(strlen(gpsBuffer.NameLiveSpeed)+4+7);	//name length + 4 bytes for ,:"" + 7 bytes for data
+			udpQueueMesLength+=(strlen(gpsBuffer.NameLiveSpeed)+4+11);	//name length + 4 bytes for ,:"" + 11 bytes for data (32 bits in hundredths)
 
 	if(gpsBuffer.LiveFixEnable)			//if gps coord is used in live telemetry
 			udpQueueMesLength+=(strlen(gpsBuffer.NameLiveFix)+4+5);	//name length + 4 bytes for ,:"" + 5 bytes for data
@@ -37,6 +37,7 @@ LOG_MODULE_REGISTER(gps);
 #include "gps_controller.h"
 #include "memory_management.h"
 #include "config_read.h"
+#include "nmea_parser.h"
 
 
 //! GPS thread priority level
@@ -56,8 +57,9 @@ static struct k_thread gpsControllerThread;
 #define MSG_SIZE 85
 
 /*! @brief gps buffer struct
-    @param speed current gps speed
-    @param coord current gps coords
+    @param speed current gps speed (0.01 km/h)
+    @param lat current latitude (1e-7 degree, north positive)
+    @param lon current longitude (1e-7 degree, east positive)
     @param fix current gps fix status
     @param NameLiveCoord name of the coord field in the live transmission
     @param NameLogCoord name of the coord field in the logs
@@ -82,6 +84,9 @@ static const struct device *const uart_dev = DEVICE_DT_GET(UART_DEVICE_NODE);
 static char rx_buf[MSG_SIZE];
 static int rx_buf_pos;
 
+//parser of the NMEA sentences (shared with the transmitter)
+static tNmeaParser nmeaParser;
+
 //serial callback function prototype
 /*!
  * @brief Read characters from UART until line end is detected. Afterwards push the
@@ -89,6 +94,9 @@ static int rx_buf_pos;
  */
 void serial_cb(const struct device *dev, void *user_data);
 
+/*! @brief copy the values of a valid sentence in the gps buffer */
+static void gps_sentence(int sentence, const tNmeaData * data, bool * gpsFix);
+
 
 //-----------------------------------------------------------------------------------------------------------------------
 /*! GPS_Controller implements the GPS_Controller task
@@ -109,6 +117,9 @@ void GPS_Controller(void)
 		LOG_INF("UART device not found!");
 		return;
 	}
+
+	nmea_parser_init(&nmeaParser);
+
 	// configure interrupt and callback to receive data 
 	uart_irq_callback_user_data_set(uart_dev, serial_cb, NULL);
 	uart_irq_rx_enable(uart_dev);
@@ -116,244 +127,62 @@ void GPS_Controller(void)
 	// indefinitely wait for input from UART
 	while (k_msgq_get(&uart_msgq, &rx_buf, K_FOREVER) == 0) 
 	{
+		//one line of the serial callback, the sentence is complete after its checksum
+		for(int i=0; rx_buf[i] != '\0'; i++)
+		{
+			int sentence = nmea_parse(&nmeaParser, (uint8_t)rx_buf[i]);
+			if(sentence != NMEA_SENTENCE_NONE)
+				gps_sentence(sentence, &nmeaParser.data, &gpsFix);
+		}
+	}
+	
+}
 
-		//-----------------------------------------------------
-		//		NMEA GSA Frame -	GPS receiver operating mod
+//-----------------------------------------------------------------------------------------------------------------------
+/*! @brief copy the values of a valid sentence in the gps buffer. The position
+*		  and the speed are used only while the GPS has a 3D fix
+* @param sentence type of the sentence (NMEA_SENTENCE_x)
+* @param data values of the sentence
+* @param gpsFix current fix state, updated with the GSA sentences
+*/
+static void gps_sentence(int sentence, const tNmeaData * data, bool * gpsFix)
+{
+	//-----------------------------------------------------
+	//		NMEA GSA Frame -	GPS receiver operating mode
 
-		if(strstr(rx_buf,"$GNGSA"))
-		{
-			if(rx_buf[10]=='3')		//detect if gps has fix
-				gpsFix=true;
+	if(sentence == NMEA_SENTENCE_GSA && (data->valid & NMEA_HAS_FIX_MODE))
+	{
+		*gpsFix = data->fixMode == 3;		//3D fix
 
-			else
-				gpsFix=false;
+		k_mutex_lock(&gpsBufferMutex,K_FOREVER);		//lock gps buffer mutex
+		gpsBuffer.fix = *gpsFix;						//copy gps fix value to buffer
+		k_mutex_unlock(&gpsBufferMutex);				//unlock mutex
+	}
 
-			k_mutex_lock(&gpsBufferMutex,K_FOREVER);		//lock gps buffer mutex
-			gpsBuffer.fix = gpsFix;							//copy gps fix value to buffer
-			k_mutex_unlock(&gpsBufferMutex);				//unlock mutex
-		}
+	//analyse other frames only if GPS is fixed
+	if(!*gpsFix)
+		return;
 
-		//analyse other frames only if GPS is fixed
-		if(gpsFix)	
-		{
-			//-----------------------------------------------------
-			//	NMEA GLL Frame - contains latitude and longitude
-
-			if(strstr(rx_buf,"$GNGLL"))
-			{
-				// NMEA frame DMm + sign
-				char latDeg[4];
-				char latMin[12];
-				char latSign[2];
-				char lonDeg[4];
-				char lonMin[12];
-				char lonSign[2];
-				
-				char * saveptr=NULL;			//strtok save pointer
-				char * str = rx_buf;			//string of frame
-				char * token = (char*)strtok_r(str,",",&saveptr);	// get first token
-
-				int i = 0;		//loop index
-
-				//loop for all token of NMEA frame
-				while (token!=NULL) 
-				{  
-					token = (char*)strtok_r(NULL,",",&saveptr);	//get next token
-					switch(i)
-					{
-						case 0: strncpy(latDeg,token,2);				// latitude degree angle
-								latDeg[2] = '\0';
-								strncpy(latMin,token+2,2);				// latitude minutes
-								strcpy(latMin+2,token+5);				// latitude degrees of minutes
-						break;
-						case 1: strcpy(latSign,*token=='N' ? "" : "-");	// latitude sign (north or south)
-						break;
-						case 2: strncpy(lonDeg,token,3);				// longitude degree angle
-								lonDeg[3]='\0';
-								strncpy(lonMin,token+3,2);				// longitude minutes
-								strcpy(lonMin+2,token+6);				// longitude degrees of minutes
-						break;
-						case 3: strcpy(lonSign,*token=='E' ? "" : "-");	// longitude sign (west or east)
-						break;
-					}
-					if(i<3)				//break after 5 loops (other data not intersting)
-						i++;	
-					else
-						break;
-				}
-				
-				//calculate decimal coords from NMEA DM.m
-				uint32_t lat = atoi(latDeg);
-				uint32_t lon = atoi(lonDeg);
-				uint32_t lat_dec = atoi(latMin)/6;
-				uint32_t lon_dec = atoi(lonMin)/6;
-
-				//generate decimal coords string
-				char coord[25];
-				sprintf(coord,"%s%d.%d %s%d.%d",latSign,lat,lat_dec,lonSign,lon,lon_dec);
-
-				k_mutex_lock(&gpsBufferMutex,K_FOREVER);		//lock gps buffer mutex
-				strcpy(gpsBuffer.coord,coord);					//copy coords to gps buffer
-				k_mutex_unlock(&gpsBufferMutex);				//unlock mutex
-			}
-
-			//-----------------------------------------------------
-			//	NMEA RMC Frame - contains latitude and longitude
-
-			if(strstr(rx_buf,"$GNRMC"))
-			{
-				bool frameValid = false;
-
-				// NMEA frame DMm + sign
-				char latDeg[4];
-				char latMin[12];
-				char latSign[2];
-				char lonDeg[4];
-				char lonMin[12];
-				char lonSign[2];
-				
-				char * saveptr=NULL;			//strtok save pointer
-				char * str = rx_buf;			//string of frame
-				char * token = (char*)strtok_r(str,",",&saveptr);	// get first token
-
-				int i = 0;		//loop index
-
-				//loop for all token of NMEA frame
-				while (token!=NULL) 
-				{  
-					token = (char*)strtok_r(NULL,",",&saveptr);	//get next token
-					switch(i)
-					{
-						case 1: frameValid = (*token=='A');				//NMEA RMC valid 
-						break;
-						case 2: strncpy(latDeg,token,2);				// latitude degree angle
-								latDeg[2] = '\0';
-								strncpy(latMin,token+2,2);				// latitude minutes
-								strcpy(latMin+2,token+5);				// latitude degrees of minutes
-						break;
-						case 3: strcpy(latSign,*token=='N' ? "" : "-");	// latitude sign (north or south)
-						break;
-						case 4: strncpy(lonDeg,token,3);				// longitude degree angle
-								lonDeg[3]='\0';
-								strncpy(lonMin,token+3,2);				// longitude minutes
-								strcpy(lonMin+2,token+6);				// longitude degrees of minutes
-						break;
-						case 5: strcpy(lonSign,*token=='E' ? "" : "-");	// longitude sign (west or east)
-						break;
-					}
-					if(i<5)				//break after 5 loops (other data not intersting)
-						i++;	
-					else
-						break;
-				}
-				if(frameValid)			//if frame is valid
-				{
-					//calculate decimal coords from NMEA DM.m
-					uint32_t lat = atoi(latDeg);
-					uint32_t lon = atoi(lonDeg);
-					uint32_t lat_dec = atoi(latMin)/6;
-					uint32_t lon_dec = atoi(lonMin)/6;
-
-					//generate decimal coords string
-					char coord[25];
-					sprintf(coord,"%s%d.%d %s%d.%d",latSign,lat,lat_dec,lonSign,lon,lon_dec);
-
-					
-					k_mutex_lock(&gpsBufferMutex,K_FOREVER);		//lock gps buffer mutex
-					strcpy(gpsBuffer.coord,coord);					//copy coords to gps buffer
-					k_mutex_unlock(&gpsBufferMutex);				//unlock mutex
-				}
-			}
-
-			//-----------------------------------------------------
-			//	NMEA GGA Frame - contains latitude and longitude
-
-			if(strstr(rx_buf,"$GNGGA"))
-			{
-				// NMEA frame DMm + sign
-				char latDeg[4];
-				char latMin[12];
-				char latSign[2];
-				char lonDeg[4];
-				char lonMin[12];
-				char lonSign[2];
-				
-				char * saveptr=NULL;			//strtok save pointer
-				char * str = rx_buf;			//string of frame
-				char * token = (char*)strtok_r(str,",",&saveptr);	// get first token
-
-				int i = 0;		//loop index
-
-				//loop for all token of NMEA frame
-				while (token!=NULL) 
-				{  
-					token = (char*)strtok_r(NULL,",",&saveptr);	//get next token
-					switch(i)
-					{
-						case 1: strncpy(latDeg,token,2);				// latitude degree angle
-								latDeg[2] = '\0';
-								strncpy(latMin,token+2,2);				// latitude minutes
-								strcpy(latMin+2,token+5);				// latitude degrees of minutes
-						break;
-						case 2: strcpy(latSign,*token=='N' ? "" : "-");	// latitude sign (north or south)
-						break;
-						case 3: strncpy(lonDeg,token,3);				// longitude degree angle
-								lonDeg[3]='\0';
-								strncpy(lonMin,token+3,2);				// longitude minutes
-								strcpy(lonMin+2,token+6);				// longitude degrees of minutes
-						break;
-						case 4: strcpy(lonSign,*token=='E' ? "" : "-");	// longitude sign (west or east)
-						break;
-					}
-					if(i<4)				//break after 5 loops (other data not intersting)
-						i++;	
-					else
-						break;
-				}
-				
-				//calculate decimal coords from NMEA DM.m
-				uint32_t lat = atoi(latDeg);
-				uint32_t lon = atoi(lonDeg);
-				uint32_t lat_dec = atoi(latMin)/6;
-				uint32_t lon_dec = atoi(lonMin)/6;
-
-				//generate decimal coords string
-				char coord[25];
-				sprintf(coord,"%s%d.%d %s%d.%d",latSign,lat,lat_dec,lonSign,lon,lon_dec);
-
-				k_mutex_lock(&gpsBufferMutex,K_FOREVER);		//lock gps buffer mutex
-				strcpy(gpsBuffer.coord,coord);					//copy coords to gps buffer
-				k_mutex_unlock(&gpsBufferMutex);				//unlock mutex
-			}
-
-			//-----------------------------------------------------
-			//	NMEA VTG Frame - contains speed
-
-			if(strstr(rx_buf,"$GNVTG"))
-			{
-				char *str = rx_buf;		//string buffer
-				char *saveptr = NULL;	//save pointer for strtok_r
-
-				char * token;			//token of data frame
-				char lastToken[12];		//variable to stock last token
-
-				token = (char*)strtok_r(str,",",&saveptr);			//get first token
-
-				while (token != NULL) 		//loop for all tokens
-				{
-					strcpy(lastToken, token);				//save token for next cycle
-					token = (char*)strtok_r(NULL, ",",&saveptr);	//get next token
-					if(token[0]=='K')		//if current token is 'K'				
-						break;				//speed is last token -> break
-				}
-
-				k_mutex_lock(&gpsBufferMutex,K_FOREVER);		//lock gps buffer mutex
-				strcpy(gpsBuffer.speed,lastToken);				//read speed in frame
-				k_mutex_unlock(&gpsBufferMutex);				//unlock mutex
-			}
-		}
+	//-----------------------------------------------------
+	//	NMEA GLL, RMC and GGA Frames - contain latitude and longitude
+
+	if(data->valid & NMEA_HAS_POSITION)
+	{
+		k_mutex_lock(&gpsBufferMutex,K_FOREVER);		//lock gps buffer mutex
+		gpsBuffer.lat = data->lat;						//1e-7 degree
+		gpsBuffer.lon = data->lon;
+		k_mutex_unlock(&gpsBufferMutex);				//unlock mutex
+	}
+
+	//-----------------------------------------------------
+	//	NMEA VTG and RMC Frames - contain speed
+
+	if(data->valid & NMEA_HAS_SPEED)
+	{
+		k_mutex_lock(&gpsBufferMutex,K_FOREVER);		//lock gps buffer mutex
+		gpsBuffer.speed = data->speed;					//0.01 km/h
+		k_mutex_unlock(&gpsBufferMutex);				//unlock mutex
 	}
-	
 }
 
 
@@ -70,8 +70,9 @@ extern tSensor sensorBuffer[MAX_SENSORS];
 extern struct k_mutex sensorBufferMutex;
 
 /*! @brief gps buffer struct
-    @param speed current gps speed
-    @param coord current gps coords
+    @param speed current gps speed (0.01 km/h)
+    @param lat current latitude (1e-7 degree, north positive)
+    @param lon current longitude (1e-7 degree, east positive)
     @param fix current gps fix status
     @param NameLiveCoord name of the coord field in the live transmission
     @param NameLogCoord name of the coord field in the logs
@@ -84,8 +85,9 @@ extern struct k_mutex sensorBufferMutex;
     @param LiveFixEnable fix status enabled in the live transmission
 */
 typedef struct sGps{
-    char speed[10];
-    char coord[25];
+    uint32_t speed;
+    int32_t lat;
+    int32_t lon;
     bool fix;
     char * NameLiveCoord;
     char * NameLogCoord;
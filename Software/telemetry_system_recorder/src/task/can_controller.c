@@ -38,6 +38,7 @@ LOG_MODULE_REGISTER(can);
 #include "memory_management.h"
 #include "config_read.h"
 #include "data_logger.h"
+#include "time_sync.h"
 
 //! Can controller thread priority level
 #define CAN_CONTROLLER_STACK_SIZE 8192
@@ -79,19 +80,21 @@ CAN_MSGQ_DEFINE(can_msgq, 100);
 
 //can led
 uint32_t canLedId;
-uint32_t canLatId;
-uint32_t canLongId;
+uint32_t canPositionId;
+uint32_t canDateId;
 uint32_t canTimeFixSpeedId;
+uint32_t canSyncTimeId;
+uint32_t canLapId;
 
 
-typedef union{
-	struct{
-		uint16_t sign;
-		uint16_t characteristic;
-		uint32_t mantissa;
-	}fields;
-	uint8_t u8[8];
-}Coord;
+/*
+ * GPS frames of the transmitter (little endian)
+ *  - Position     : latitude (int32, 1e-7 degree) | longitude (int32, 1e-7 degree), each fix
+ *  - Date         : year | month | day | reserved, once per second
+ *  - TimeFixSpeed : UTC time of day (uint32, ms) | speed (uint16, 0.01 km/h) | fix | satellites (0 if unknown), each epoch
+ *  - SyncTime     : synchronised time of the transmitter (int64, µs since 1970), once per second
+ *  - Lap          : event (1 = sector, 2 = lap) | sector (0 = first) | lap (uint16) | duration (uint32, ms)
+ */
 
 //-----------------------------------------------------------------------------------------------------------------------
 /*! CAN_Controller implements the CAN_Controller task
@@ -137,9 +140,13 @@ void CAN_Controller(void)
 
 	//can ids
 	canLedId = (uint32_t)strtol(configFile.CANLed.CanID, NULL, 0);
-	canLatId = (uint32_t)strtol(configFile.GPS.CanIDs.Lat, NULL, 0);
-	canLongId = (uint32_t)strtol(configFile.GPS.CanIDs.Long, NULL, 0);
+	if(configFile.GPS.CanIDs.Position == NULL || configFile.GPS.CanIDs.Date == NULL)		//keys of an old config file
+		LOG_ERR("GPS.CanIDs.Position and GPS.CanIDs.Date not set (they replace Lat and Long)");
+	canPositionId = configFile.GPS.CanIDs.Position != NULL ? (uint32_t)strtol(configFile.GPS.CanIDs.Position, NULL, 0) : 0;
+	canDateId = configFile.GPS.CanIDs.Date != NULL ? (uint32_t)strtol(configFile.GPS.CanIDs.Date, NULL, 0) : 0;
 	canTimeFixSpeedId = (uint32_t)strtol(configFile.GPS.CanIDs.TimeFixSpeed, NULL, 0); 
+	canSyncTimeId = configFile.GPS.CanIDs.SyncTime != NULL ? (uint32_t)strtol(configFile.GPS.CanIDs.SyncTime, NULL, 0) : 0;		//optional
+	canLapId = configFile.GPS.CanIDs.Lap != NULL ? (uint32_t)strtol(configFile.GPS.CanIDs.Lap, NULL, 0) : 0;		//optional
 	
 	//set recording callbacks
 	set_RecordingStatus_callbacks(&recordingON,&recordingOFF);
@@ -175,49 +182,67 @@ void CAN_Controller(void)
 				continue;
 			}
 		}
-		if((frame.id==canLatId) && (frame.dlc == 8))	//if we receive a message from gps - latitude
+		if((canPositionId != 0) && (frame.id==canPositionId) && (frame.dlc == 8))	//if we receive a message from gps - position (latitude | longitude)
 		{
-			Coord latitude;
-			memcpy(latitude.u8,frame.data,8);
-
 			k_mutex_lock(&gpsBufferMutex,K_FOREVER);		    //lock gps buffer mutex
 
-			gpsBuffer.lat_sign = latitude.fields.sign;
-			gpsBuffer.lat_characteristic = latitude.fields.characteristic;
-			gpsBuffer.lat_mantissa = latitude.fields.mantissa;
+			gpsBuffer.lat = (int32_t)sys_get_le32(frame.data);
+			gpsBuffer.lon = (int32_t)sys_get_le32(frame.data+4);
+			gpsBuffer.updates++;								//latitude and longitude of the same fix
 			
 			k_mutex_unlock(&gpsBufferMutex);
 			continue;
 		}
-		if((frame.id==canLongId) && (frame.dlc == 8))	//if we receive a message from gps - longitude
+		if((canDateId != 0) && (frame.id==canDateId) && (frame.dlc == 8))	//if we receive a message from gps - date
 		{
-			Coord longitude;
-			memcpy(longitude.u8,frame.data,8);
-
 			k_mutex_lock(&gpsBufferMutex,K_FOREVER);		    //lock gps buffer mutex
 
-			gpsBuffer.long_sign = longitude.fields.sign;
-			gpsBuffer.long_characteristic = longitude.fields.characteristic;
-			gpsBuffer.long_mantissa = longitude.fields.mantissa;
+			gpsBuffer.year = frame.data[0];
+			gpsBuffer.month = frame.data[1];
+			gpsBuffer.day = frame.data[2];
 			
 			k_mutex_unlock(&gpsBufferMutex);
 			continue;
 		}
 		if((frame.id==canTimeFixSpeedId) && (frame.dlc == 8))	//if we receive a message from gps - TimeFixSpeed
 		{
-			uint8_t data[8];
-			memcpy(data,frame.data,8);
+			uint32_t sec = sys_get_le32(frame.data) / 1000;		//UTC time of day (ms)
 
 			k_mutex_lock(&gpsBufferMutex,K_FOREVER);		    //lock gps buffer mutex
 
-			gpsBuffer.sec = data[7];
-			gpsBuffer.min = data[6];
-			gpsBuffer.hour = data[5];
-			gpsBuffer.year = data[4];
-			gpsBuffer.month = data[3];
-			gpsBuffer.day = data[2];
-			gpsBuffer.speed = data[1];
-			gpsBuffer.fix = (data[0]==1);
+			gpsBuffer.hour = sec/3600 + 2;					//+2 to match center europa time
+			gpsBuffer.min = (sec/60) % 60;
+			gpsBuffer.sec = sec % 60;
+			gpsBuffer.speed = sys_get_le16(frame.data+4);		//0.01 km/h
+			gpsBuffer.fix = (frame.data[6]==1);
+			gpsBuffer.satellites = frame.data[7];
+			k_mutex_unlock(&gpsBufferMutex);
+			continue;
+		}
+		if((canSyncTimeId != 0) && (frame.id==canSyncTimeId) && (frame.dlc == 8))	//if we receive the synchronised time of the transmitter
+		{
+			time_sync_reference(sys_get_le64(frame.data),time_sync_local());
+			continue;
+		}
+		if((canLapId != 0) && (frame.id==canLapId) && (frame.dlc == 8))	//if we receive a lap or sector event of the lap timer
+		{
+			uint16_t lap = sys_get_le16(frame.data+2);
+			uint32_t duration = sys_get_le32(frame.data+4);
+
+			k_mutex_lock(&gpsBufferMutex,K_FOREVER);		    //lock gps buffer mutex
+
+			if(frame.data[0] == 2)		//lap completed, next lap started
+			{
+				gpsBuffer.lap = lap+1;
+				gpsBuffer.lapTime = duration;
+			}
+			else						//sector completed
+			{
+				gpsBuffer.lap = lap;
+				gpsBuffer.sector = frame.data[1]+1;
+				gpsBuffer.sectorTime = duration;
+			}
+
 			k_mutex_unlock(&gpsBufferMutex);
 			continue;
 		}
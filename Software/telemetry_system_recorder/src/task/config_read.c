@@ -55,21 +55,44 @@ static struct fs_mount_t mp = {
 // SD mount name
 static const char *disk_mount_pt = "/SD:";
 
+//size of the chunks read on the SD card and sent to the transmitter
+#define CFG_FILE_CHUNK_SIZE 512
+//end of the config file on the uart
+#define CFG_FILE_END_CHAR 0x14
+//max time to send a chunk to the transmitter
+#define CFG_FILE_CHUNK_TIMEOUT K_SECONDS(1)
+
 //json config file struct
 struct config configFile;
 bool configOK;		//boolean variable for printing state on led
-static uint8_t sd_card_buffer[512];
+
+//text of the config file, parsed in place : the strings of configFile point into it
+static char configText[CFG_FILE_MAX_SIZE];
+//chunk of the config file sent to the transmitter
+static uint8_t sd_card_buffer[CFG_FILE_CHUNK_SIZE];
+static uint32_t chunkLength;		//characters in sd_card_buffer
+static uint32_t chunkSent;			//characters of sd_card_buffer already in the uart
+K_SEM_DEFINE(chunkSentSem, 0, 1);
 
 
 // uart node
 #define UART_DEVICE_NODE_CONFIG DT_CHOSEN(zephyr_shell_uart_config)
 static const struct device *const uart_dev_config = DEVICE_DT_GET(UART_DEVICE_NODE_CONFIG);
-struct Data{
-	uint8_t * readBufPointer;
-	uint16_t size;
-};
-void serial_cb_config(const struct device *dev, struct Data * userData);
-bool sendFinished = false;
+void serial_cb_config(const struct device *dev, void *user_data);
+
+/*! @brief state of the removal of the spaces between the tokens
+    @param string inside a string
+    @param escape after a '\' in a string
+*/
+typedef struct sConfigStrip{
+    bool string;
+    bool escape;
+}tConfigStrip;
+
+/*! @brief remove the spaces between the tokens of a chunk of the config file */
+static uint32_t config_strip(uint8_t * buf, uint32_t length, tConfigStrip * strip);
+/*! @brief send the config file to the transmitter */
+static int config_send(const char * path);
 
 //struct for Wifi router data description
 static const struct json_obj_descr wifi_router_descr[] = {
@@ -125,9 +148,22 @@ static const struct json_obj_descr canled_descr[] = {
 
 //struct for GPS CAN ids description
 static const struct json_obj_descr canids_descr[] = {
-	JSON_OBJ_DESCR_PRIM(struct sGPSCanIds, Lat, JSON_TOK_STRING),
-	JSON_OBJ_DESCR_PRIM(struct sGPSCanIds, Long, JSON_TOK_STRING),
-	JSON_OBJ_DESCR_PRIM(struct sGPSCanIds, TimeFixSpeed, JSON_TOK_STRING)
+	JSON_OBJ_DESCR_PRIM(struct sGPSCanIds, Position, JSON_TOK_STRING),
+	JSON_OBJ_DESCR_PRIM(struct sGPSCanIds, Date, JSON_TOK_STRING),
+	JSON_OBJ_DESCR_PRIM(struct sGPSCanIds, TimeFixSpeed, JSON_TOK_STRING),
+	JSON_OBJ_DESCR_PRIM(struct sGPSCanIds, SyncTime, JSON_TOK_STRING),
+	JSON_OBJ_DESCR_PRIM(struct sGPSCanIds, Lap, JSON_TOK_STRING)
+};
+
+//struct for GPS fusion description
+static const struct json_obj_descr fusion_descr[] = {
+	JSON_OBJ_DESCR_PRIM(struct sFusion, Enabled, JSON_TOK_TRUE),
+	JSON_OBJ_DESCR_PRIM(struct sFusion, WheelSpeed, JSON_TOK_STRING),
+	JSON_OBJ_DESCR_PRIM(struct sFusion, WheelSpeedFactor, JSON_TOK_NUMBER),
+	JSON_OBJ_DESCR_PRIM(struct sFusion, YawRate, JSON_TOK_STRING),
+	JSON_OBJ_DESCR_PRIM(struct sFusion, YawRateFactor, JSON_TOK_NUMBER),
+	JSON_OBJ_DESCR_PRIM(struct sFusion, YawRateOffset, JSON_TOK_NUMBER),
+	JSON_OBJ_DESCR_PRIM(struct sFusion, Gain, JSON_TOK_NUMBER)
 };
 
 //struct for GPS description
@@ -135,7 +171,8 @@ static const struct json_obj_descr gps_descr[] = {
   JSON_OBJ_DESCR_OBJECT(struct sGPS, Coordinates, gpsdata_descr),
   JSON_OBJ_DESCR_OBJECT(struct sGPS, Speed, gpsdata_descr),
   JSON_OBJ_DESCR_OBJECT(struct sGPS, Fix, gpsdata_descr),
-  JSON_OBJ_DESCR_OBJECT(struct sGPS, CanIDs, canids_descr)
+  JSON_OBJ_DESCR_OBJECT(struct sGPS, CanIDs, canids_descr),
+  JSON_OBJ_DESCR_OBJECT(struct sGPS, Fusion, fusion_descr)
 };
 
 //struct for sensors description
@@ -241,33 +278,38 @@ int read_config(void)
 	if (res) 			//return error if open fail
 	{
 		LOG_ERR("Error opening dir /SD: [%d]\n" , res);
+		fs_unmount(&mp);
 		return 2;
 	}
 
-	entry.size*=2; //take some margin (according to some tests the size read could be too small)
-
-	uint8_t readBuf[entry.size];					//buffer for the content
-	memset(readBuf,0x00,sizeof(readBuf));			//initialize array
+	//read the file by chunks until its end, the spaces between the tokens are removed on the way
+	uint32_t length = 0;
+	tConfigStrip strip = { 0 };
+	ssize_t count;
 
-	fs_read(&fs_configFile,readBuf,entry.size);		//read file
+	while((count = fs_read(&fs_configFile,configText+length,MIN(CFG_FILE_CHUNK_SIZE,sizeof(configText)-1-length))) > 0)
+		length += config_strip((uint8_t *)configText+length,count,&strip);
 
 	fs_close(&fs_configFile);					//close file
 
-	fs_unmount(&mp);							//unmount sd disk
+	if(count < 0 || length >= sizeof(configText)-1)		//read error, or file too large (last byte kept free)
+	{
+		LOG_ERR("Error reading config file %s [%d]", path, count < 0 ? (int)count : -EFBIG);
+		fs_unmount(&mp);
+		configOK=false;
+		return count < 0 ? 2 : 3;
+	}
+	LOG_INF("Config file : %u characters without spaces", length);
 
 	//--------------------------------------- parse json string
 
-
-	//create a copy of readBuf for the transmitter (sent by uart at the end of this function)
-	uint8_t readBufCopy[entry.size];					
-	memcpy(readBufCopy,readBuf,sizeof(readBuf));		//copy
-
 	//parse json
-	int ret = json_obj_parse(readBuf,entry.size,config_descr,ARRAY_SIZE(config_descr),&configFile);
+	int ret = json_obj_parse(configText,length,config_descr,ARRAY_SIZE(config_descr),&configFile);
 	
 	if(ret<0)				//if json parse fail
 	{
 		LOG_ERR("Error reading config file");	//print error
+		fs_unmount(&mp);
 		configOK=false;
 		return 1;
 	}
@@ -346,6 +388,8 @@ int read_config(void)
 		//initialize gps buffer values
 		gpsBuffer.fix=false;
 		gpsBuffer.speed=0;
+		gpsBuffer.lat=0;
+		gpsBuffer.lon=0;
 		
 		//initialize gpsbuffer parames with config file values
 		gpsBuffer.LiveCoordEnable=configFile.GPS.Coordinates.LiveEnable;
@@ -365,27 +409,13 @@ int read_config(void)
 		k_sleep(K_MSEC(1000));
 		LOG_INF("Start to send config");
 
-		//check if uart device is ready
-		if (!device_is_ready(uart_dev_config)) 
-		{
-			LOG_INF("UART device not found!");
-			return 4;
-		}
+		ret = config_send(path);		//the parsed text is modified, the file is read again
 
-		// configure interrupt and callback to receive data 
-		memcpy(sd_card_buffer, readBufCopy, sizeof(sd_card_buffer));
-		struct Data data;
-		data.readBufPointer = readBufCopy;
-		data.size = entry.size;
-		uart_irq_callback_user_data_set(uart_dev_config, serial_cb_config, &data);
-		uart_irq_tx_enable(uart_dev_config);
+		fs_unmount(&mp);							//unmount sd disk
+
+		if(ret != 0)
+			return ret;
 
-		
-		while(!sendFinished)
-		{
-			k_sleep(K_MSEC(100));
-		}
-		
 		LOG_INF("Configuration file sent to transmitter");
 	
 		return 0;
@@ -393,49 +423,133 @@ int read_config(void)
 	
 }
 
+//-----------------------------------------------------------------------------------------------------------------------
+/*! @brief remove the spaces between the tokens of a chunk of the config file.
+*		  The chunk is compacted in place, the strings are kept unchanged
+* @param buf characters of the chunk
+* @param length number of characters
+* @param strip state at the end of the previous chunk, updated
+* @retval number of characters kept
+*/
+static uint32_t config_strip(uint8_t * buf, uint32_t length, tConfigStrip * strip)
+{
+	uint32_t kept = 0;
+
+	for(uint32_t i=0; i<length; i++)
+	{
+		uint8_t c = buf[i];
+
+		if(strip->string)
+		{
+			if(strip->escape)
+				strip->escape = false;
+			else if(c == '\\')
+				strip->escape = true;
+			else if(c == '"')
+				strip->string = false;
+		}
+		else if(c == '"')
+		{
+			strip->string = true;
+		}
+		else if(c == ' ' || c == '\t' || c == '\r' || c == '\n')
+		{
+			continue;
+		}
+		buf[kept++] = c;
+	}
+	return kept;
+}
+
+//-----------------------------------------------------------------------------------------------------------------------
+/*! @brief send the config file to the transmitter, by chunks read on the SD
+*		  card without the spaces, followed by the end character
+* @param path path of the config file
+* @retval 0 on success
+* @retval 2 on disk error
+* @retval 4 on uart error
+*/
+static int config_send(const char * path)
+{
+	struct fs_file_t file;
+	tConfigStrip strip = { 0 };
+	ssize_t count;
+	int ret = 0;
+
+	//check if uart device is ready
+	if (!device_is_ready(uart_dev_config)) 
+	{
+		LOG_INF("UART device not found!");
+		return 4;
+	}
+
+	fs_file_t_init(&file);
+	if(fs_open(&file,path,FS_O_READ) != 0)
+		return 2;
+
+	uart_irq_callback_user_data_set(uart_dev_config, serial_cb_config, NULL);
+
+	bool end = false;
+	while(!end)
+	{
+		count = fs_read(&file,sd_card_buffer,sizeof(sd_card_buffer));
+		if(count < 0)
+		{
+			ret = 2;
+			break;
+		}
+		if(count == 0)		//end of the file
+		{
+			sd_card_buffer[0] = CFG_FILE_END_CHAR;
+			count = 1;
+			end = true;
+		}
+		else
+		{
+			count = config_strip(sd_card_buffer,count,&strip);
+			if(count == 0)
+				continue;
+		}
+
+		chunkLength = count;
+		chunkSent = 0;
+		k_sem_reset(&chunkSentSem);
+		uart_irq_tx_enable(uart_dev_config);
+		if(k_sem_take(&chunkSentSem,CFG_FILE_CHUNK_TIMEOUT) != 0)
+		{
+			uart_irq_tx_disable(uart_dev_config);
+			LOG_ERR("Config file not sent to transmitter");
+			ret = 4;
+			break;
+		}
+	}
+
+	fs_close(&file);
+	return ret;
+}
+
 //-----------------------------------------------------------------------------------------------------------------------
 /*!
- * @brief Read characters from UART
+ * @brief Send the characters of the current chunk of the config file
  */
-static int sent = 0;
-static uint16_t totalSent = 0;
-static const int size = 512;
-static int ret;
-
-void serial_cb_config(const struct device *dev, struct Data * userData)
+void serial_cb_config(const struct device *dev, void *user_data)
 {
-	if (!uart_irq_update(uart_dev_config)) {
+	if (!uart_irq_update(dev)) {
 		return;
 	}
 
-	// Sending data
 	if (uart_irq_tx_ready(dev))
 	{
-		if (sent < sizeof(sd_card_buffer))
+		if (chunkSent < chunkLength)
 		{
-			ret = uart_fifo_fill(dev, &sd_card_buffer[sent],size);
-			if (ret > 0 && ret <= size)
-			{
-				//LOG_INF("%d data sent over uart", ret);
-				sent+=ret;
-			}
+			int ret = uart_fifo_fill(dev, &sd_card_buffer[chunkSent], chunkLength - chunkSent);
+			if (ret > 0)
+				chunkSent += ret;
 		}
-		else if (sent == sizeof(sd_card_buffer))
+		else		//chunk in the uart, the next one is read by the thread
 		{
-			// copy next chunck
-			totalSent+=sent;
-			memcpy(sd_card_buffer, userData->readBufPointer+totalSent, sizeof(sd_card_buffer));
-			sent = 0;
-
-			if(totalSent > userData->size/2 )
-			{
-				//end character
-				const uint8_t end = 0x14;
-				uart_fifo_fill(dev, &end, 1);
-				totalSent++;
-				sendFinished = true;
-				uart_irq_tx_disable(dev);	
-			}
+			uart_irq_tx_disable(dev);
+			k_sem_give(&chunkSentSem);
 		}
 	}
-}
\ No newline at end of file
+}
@@ -117,14 +117,37 @@ struct sGPSData{
 };
 
 /*! @brief struct for the CAN datapoint
-* @param Lat Latitude
-* @param Long Longitude
-* @param TimeFixSpeed current Time, Fix information and Speed information
+* @param Position position of each epoch (latitude and longitude)
+* @param Date date (once per second)
+* @param TimeFixSpeed time, fix, speed and number of satellites of each epoch
+* @param SyncTime synchronised time of the transmitter (optional)
+* @param Lap lap and sector events of the lap timer of the transmitter (optional, lap columns in the logs)
 */
 struct sGPSCanIds{
-    char * Lat;
-    char * Long;
+    char * Position;
+    char * Date;
     char * TimeFixSpeed;
+    char * SyncTime;
+    char * Lap;
+};
+
+/*! @brief struct for the fusion of the GPS with the wheel speed and yaw rate sensors
+* @param Enabled fused position and speed columns in the logs
+* @param WheelSpeed NameLog of the wheel speed sensor (GPS speed used if not set)
+* @param WheelSpeedFactor wheel speed (0.01 km/h) = value * WheelSpeedFactor / 1000
+* @param YawRate NameLog of the yaw rate sensor (GPS course used if not set)
+* @param YawRateFactor yaw rate (0.01 deg/s, positive to the left) = (value - YawRateOffset) * YawRateFactor / 1000
+* @param YawRateOffset value of the yaw rate sensor at rest
+* @param Gain share of the GPS error corrected at each fix (%, 30 if not set)
+*/
+struct sFusion{
+    bool Enabled;
+    char * WheelSpeed;
+    int WheelSpeedFactor;
+    char * YawRate;
+    int YawRateFactor;
+    int YawRateOffset;
+    int Gain;
 };
 
 /*! @brief struct for the GPS data
@@ -132,12 +155,14 @@ struct sGPSCanIds{
 * @param Speed GPS speed struct
 * @param Fix GPS fix struct
 * @param CanIds Can ids for the messages
+* @param Fusion position and speed estimated at LogFrameRate between the fixes (optional, fused columns in the logs)
 */
 struct sGPS{
     struct sGPSData Coordinates;
     struct sGPSData Speed;
     struct sGPSData Fix;
     struct sGPSCanIds CanIDs;
+    struct sFusion Fusion;
 };
 
 /*! @brief struct for the CAN datapoint
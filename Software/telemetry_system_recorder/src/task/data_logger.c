@@ -27,6 +27,7 @@ LOG_MODULE_REGISTER(logger);
 #include <zephyr/kernel.h>
 #include <errno.h>
 #include <stdio.h>
+#include <time.h>
 #include <zephyr/data/json.h>
 #include <zephyr/device.h>
 #include <zephyr/storage/disk_access.h>
@@ -42,6 +43,8 @@ LOG_MODULE_REGISTER(logger);
 #include "memory_management.h"
 //#include "deviceInformation.h"
 #include "config_read.h"
+#include "time_sync.h"
+#include "fusion.h"
 
 // Non Volatile Strorage (NVS) defines
 static struct nvs_fs fs;
@@ -79,6 +82,7 @@ struct fs_file_t logFile;
 bool logEnable;             //log is recording variable
 uint32_t timestamp;         //timestamp of the current data
 int lineSize;               //line size in the csv file
+tFusionState fusionState;   //position and speed estimated at the log frame rate
 
 //recording status callback function pointers
 void (*recordON)();
@@ -91,12 +95,15 @@ void (*recordOFF)();
 */
 void Data_Logger() 
 {
+    fusion_step(&fusionState);      //estimation runs also when the log is stopped
+
 	if(logEnable)       //if logging is enabled
     {
         //------------------------------------------------------------  create line of csv file
 
         char str[lineSize];
         sprintf(str,"%d;",timestamp);                       //print timestamp at first column of CSV file
+        sprintf(str,"%s%lld;",str,(long long)time_sync_now());  //print synchronised time (0 if not received from the transmitter)
 
         k_mutex_lock(&sensorBufferMutex,K_FOREVER);		    //lock sensor buffer mutex
 
@@ -110,13 +117,26 @@ void Data_Logger()
         k_mutex_lock(&gpsBufferMutex,K_FOREVER);		    //lock gps buffer mutex
 
         
-        sprintf(str,"%s%s%d.%d %s%d.%d;",str,gpsBuffer.lat_sign==1?"":"-",gpsBuffer.lat_characteristic,gpsBuffer.lat_mantissa,
-                                      gpsBuffer.long_sign==1?"":"-",gpsBuffer.long_characteristic, gpsBuffer.long_mantissa);
-        sprintf(str,"%s%d;",str,gpsBuffer.speed);
+        uint32_t lat = gpsBuffer.lat < 0 ? -(uint32_t)gpsBuffer.lat : (uint32_t)gpsBuffer.lat;      //1e-7 degree
+        uint32_t lon = gpsBuffer.lon < 0 ? -(uint32_t)gpsBuffer.lon : (uint32_t)gpsBuffer.lon;
+        sprintf(str,"%s%s%u.%07u %s%u.%07u;",str,gpsBuffer.lat < 0 ? "-" : "",lat/10000000,lat%10000000,
+                                          gpsBuffer.lon < 0 ? "-" : "",lon/10000000,lon%10000000);
+        sprintf(str,"%s%u.%02u;",str,gpsBuffer.speed/100,gpsBuffer.speed%100);     //km/h
         sprintf(str,"%s%s;",str,gpsBuffer.fix ? "true" : "false");
+        if(configFile.GPS.CanIDs.Lap != NULL)               //lap timer of the transmitter
+            sprintf(str,"%s%u;%u;%u;%u;",str,gpsBuffer.lap,gpsBuffer.sector,gpsBuffer.lapTime,gpsBuffer.sectorTime);
         
         k_mutex_unlock(&gpsBufferMutex);		            //unlock gps buffer mutex
 
+        if(configFile.GPS.Fusion.Enabled)                   //fused position and speed
+        {
+            uint32_t fusedLat = fusionState.lat < 0 ? -(uint32_t)fusionState.lat : (uint32_t)fusionState.lat;
+            uint32_t fusedLon = fusionState.lon < 0 ? -(uint32_t)fusionState.lon : (uint32_t)fusionState.lon;
+            sprintf(str,"%s%s%u.%07u %s%u.%07u;",str,fusionState.lat < 0 ? "-" : "",fusedLat/10000000,fusedLat%10000000,
+                                              fusionState.lon < 0 ? "-" : "",fusedLon/10000000,fusedLon%10000000);
+            sprintf(str,"%s%u.%02u;",str,fusionState.speed/100,fusionState.speed%100);
+        }
+
 
         sprintf(str,"%s\n",str);                            //append \n at end of line of the CSV file
         
@@ -201,15 +221,27 @@ void data_log_start()
     //---------------------------------------------- generate first line of csv file
     char str[2*lineSize];
     //print date and time
-    k_mutex_lock(&gpsBufferMutex,K_FOREVER);		//lock gps buffer mutex
+    int64_t startTime = time_sync_now();
+    if(startTime != 0)          //synchronised clock of the transmitter (GPS or base station, UTC)
+    {
+        time_t sec = (time_t)(startTime / 1000000);
+        struct tm utc;
+        gmtime_r(&sec,&utc);
+        sprintf(str,"Date :;%02d-%02d-%04d;",utc.tm_mday,utc.tm_mon+1,utc.tm_year+1900);
+        sprintf(str,"%sTime :;%02d:%02d:%02d;UTC;\n",str,utc.tm_hour,utc.tm_min,utc.tm_sec);
+    }
+    else
+    {
+        k_mutex_lock(&gpsBufferMutex,K_FOREVER);		//lock gps buffer mutex
 
-    sprintf(str,"Date :;%02d-%02d-20%02d;",gpsBuffer.day,gpsBuffer.month,gpsBuffer.year);        //print gps date
-    sprintf(str,"%sTime :;%02d:%02d:%02d;\n",str,gpsBuffer.hour,gpsBuffer.min,gpsBuffer.sec);        //print gps date
+        sprintf(str,"Date :;%02d-%02d-20%02d;",gpsBuffer.day,gpsBuffer.month,gpsBuffer.year);        //print gps date
+        sprintf(str,"%sTime :;%02d:%02d:%02d;\n",str,gpsBuffer.hour,gpsBuffer.min,gpsBuffer.sec);        //print gps date
 
-    
-    k_mutex_unlock(&gpsBufferMutex);		        //unlock gps buffer mutex
+        k_mutex_unlock(&gpsBufferMutex);		        //unlock gps buffer mutex
+    }
 
     sprintf(str,"%sTimestamp [ms];",str);                 //timestamp at first column
+    sprintf(str,"%sTime [us];",str);                      //synchronised time (us since 1970)
 
     k_mutex_lock(&sensorBufferMutex,K_FOREVER);		//lock sensor buffer mutex
 
@@ -225,6 +257,10 @@ void data_log_start()
     sprintf(str,"%s%s;",str,gpsBuffer.NameLogCoord);        //print gps names
     sprintf(str,"%s%s;",str,gpsBuffer.NameLogSpeed);
     sprintf(str,"%s%s;",str,gpsBuffer.NameLogFix);
+    if(configFile.GPS.CanIDs.Lap != NULL)               //lap timer of the transmitter
+        sprintf(str,"%sLap;Sector;Lap time [ms];Sector time [ms];",str);
+    if(configFile.GPS.Fusion.Enabled)                   //fused position and speed
+        sprintf(str,"%sFused position;Fused speed [km/h];",str);
     
     k_mutex_unlock(&gpsBufferMutex);		        //unlock gps buffer mutex
 
@@ -328,6 +364,7 @@ void Task_Data_Logger_Init(void)
 
     //calculate line size
     lineSize=15;          //size for "Timestamp [ms];"
+    lineSize+=21;         //size for the synchronised time (20 digits + ;)
     for(int i=0;i<configFile.sensorCount;i++)
     {
         if(strlen(sensorBuffer[i].name_log)<10)                 //if name is shorter than 10
@@ -344,8 +381,8 @@ void Task_Data_Logger_Init(void)
         lineSize+=(1+strlen(gpsBuffer.NameLiveCoord));      // add string length of name + 1 for the ;
 
     //add size of gps speed
-    if(strlen(gpsBuffer.NameLiveSpeed)<7)                   //if name is shorter than 7
-        lineSize+=8;                                        // add max length of gps speed + 1 for the ;
+    if(strlen(gpsBuffer.NameLiveSpeed)<11)                  //if name is shorter than 11
+        lineSize+=12;                                       // add max length of gps speed (32 bit in hundredths) + 1 for the ;
     else                                                    //else
         lineSize+=(1+strlen(gpsBuffer.NameLiveSpeed));      // add string length of name + 1 for the ;
 
@@ -355,6 +392,17 @@ void Task_Data_Logger_Init(void)
     else                                                    //else
         lineSize+=(1+strlen(gpsBuffer.NameLiveFix));        // add string length of name + 1 for the ;
 
+    //add size of the lap timer columns
+    if(configFile.GPS.CanIDs.Lap != NULL)
+        lineSize+=6+7+14+17;                                // max length of lap number and names of sector, lap time and sector time + 1 for each ;
+
+    //add size of the fused position and speed
+    if(configFile.GPS.Fusion.Enabled)
+        lineSize+=26+20;                                    // max length of gps coordinates and name of the speed + 1 for each ;
+
+    //position and speed between the gps fixes
+    fusion_init((int)(1000/configFile.LogFrameRate));
+
     //start timer
     k_timer_start(&dataLoggerTimer, K_SECONDS(0), K_MSEC((int)(1000/configFile.LogFrameRate)));
 
@@ -0,0 +1,381 @@
+/*! --------------------------------------------------------------------
+ *	Telemetry System	-	@file fusion.c
+ *----------------------------------------------------------------------
+ * HES-SO Valais Wallis
+ * Systems Engineering
+ * Infotronics
+ * ---------------------------------------------------------------------
+ * @author agent
+ * @date 19.10.2026
+ * ---------------------------------------------------------------------
+ * @brief Fusion estimates the position and the speed of the car at the
+ *        log frame rate. Between the GPS fixes, the position is moved
+ *        with the wheel speed and the yaw rate, each fix corrects a part
+ *        of the error (complementary filter, fixed point math).
+ * ---------------------------------------------------------------------
+ * Telemetry system for the Valais Wallis Racing Team.
+ * This file contains code for the onboard device of the telemetry
+ * system. The system receives the data from the sensors on the CAN bus
+ * and the data from the GPS on a UART port. An SD Card contains a
+ * configuration file with all the system parameters. The measurements
+ * are sent via Wi-Fi to a computer on the base station. The measurements
+ * are also saved in a CSV file on the SD card.
+ *--------------------------------------------------------------------*/
+
+//includes
+#include <zephyr/logging/log.h>
+LOG_MODULE_REGISTER(fusion);
+#include <zephyr/kernel.h>
+#include <zephyr/sys/util.h>
+#include <string.h>
+#include <math.h>
+
+//project file includes
+#include "fusion.h"
+#include "memory_management.h"
+#include "config_read.h"
+
+
+/*
+ * The position is kept in µm east (x) and north (y) of a reference fix,
+ * the heading is a binary angle (2^32 = one turn, counterclockwise from
+ * east) so it wraps without test. The sine comes from a table computed
+ * once at init, the course of the GPS from an octant atan2 approximation
+ * (error below 0.1 degree). Each step is a few 64 bits multiplications.
+ */
+
+//size of 1e-7 degree of latitude (µm)
+#define FUSION_UM_PER_UNIT 11132
+//default share of the GPS error corrected at each fix (%)
+#define FUSION_DEFAULT_GAIN 30
+//error above which the estimation jumps to the fix (µm)
+#define FUSION_RESET_ERROR 50000000LL
+//distance from the reference above which a new reference is taken (µm)
+#define FUSION_MAX_RANGE 20000000000LL
+//min distance between two fixes to use their course (µm)
+#define FUSION_MIN_COURSE_DISTANCE 2000000LL
+//entries of the sine table (one turn)
+#define FUSION_SIN_SIZE 256
+
+//configuration
+static bool fusionEnable;			//fusion enabled in the config file
+static int stepMs;					//period of the estimation (ms)
+static int wheelIndex;				//index of the wheel speed sensor in the sensor buffer (-1 = GPS speed)
+static int yawIndex;				//index of the yaw rate sensor in the sensor buffer (-1 = GPS course)
+static int32_t gain;				//share of the GPS error corrected at each fix (Q8)
+static int16_t sinTable[FUSION_SIN_SIZE+1];		//sine of one turn (Q15)
+
+//reference of the local coordinates
+static bool refValid;				//first fix received
+static int32_t refLat;				//reference fix (1e-7 degree)
+static int32_t refLon;
+static int32_t lonScale;			//cosine of the reference latitude (Q16)
+
+//estimation
+static int64_t posX;				//position east of the reference (µm)
+static int64_t posY;				//position north of the reference (µm)
+static uint32_t heading;			//heading (binary angle)
+static bool headingValid;			//heading known (yaw rate sensor or GPS course)
+static int32_t speed;				//speed (mm/s)
+static int32_t gpsSpeed;			//speed of the last fix (mm/s)
+static int32_t turnRate;			//heading change per step from the GPS courses without yaw rate sensor (binary angle)
+
+//last fix
+static uint32_t lastUpdates;		//position counter of the gps buffer
+static bool lastFixValid;			//a fix was used since the reference
+static int64_t lastFixX;			//position of the last fix (µm)
+static int64_t lastFixY;
+static uint32_t lastFixHeading;		//estimated heading at the last fix (binary angle)
+static uint32_t lastCourse;			//course between the last two fixes (binary angle)
+static bool lastCourseValid;		//lastCourse known
+static int stepsSinceFix;			//steps since the last fix
+
+//static functions prototypes
+
+/*! @brief find a sensor of the sensor buffer by its log name */
+static int fusion_sensor(const char * name);
+/*! @brief take a fix as reference of the local coordinates */
+static void fusion_reference(int32_t lat, int32_t lon);
+/*! @brief apply a GPS fix to the estimation */
+static void fusion_fix(int64_t x, int64_t y);
+/*! @brief sine of a binary angle (Q15) */
+static int32_t fusion_sin(uint32_t angle);
+/*! @brief angle of a vector (binary angle) */
+static uint32_t fusion_atan2(int64_t y, int64_t x);
+
+
+//-----------------------------------------------------------------------------------------------------------------------
+/*! fusion_init finds the sensors of the config file
+* @param period period of the estimation (ms)
+* @retval true if the fusion is enabled
+*/
+bool fusion_init(int period)
+{
+	const struct sFusion * cfg = &configFile.GPS.Fusion;
+
+	fusionEnable = cfg->Enabled && period > 0;
+	refValid = false;
+	headingValid = false;
+	lastFixValid = false;
+
+	if(!fusionEnable)
+		return false;
+
+	stepMs = period;
+	wheelIndex = fusion_sensor(cfg->WheelSpeed);
+	yawIndex = fusion_sensor(cfg->YawRate);
+	gain = (cfg->Gain > 0 ? MIN(cfg->Gain,100) : FUSION_DEFAULT_GAIN) * 256 / 100;
+
+	for(int i=0; i<=FUSION_SIN_SIZE; i++)		//only floating point of the fusion, once at init
+		sinTable[i] = (int16_t)lround(sin(2.0 * M_PI * i / FUSION_SIN_SIZE) * 32767.0);
+
+	LOG_INF("fusion : speed from %s, heading from %s", wheelIndex >= 0 ? "wheel" : "gps", yawIndex >= 0 ? "yaw rate" : "gps course");
+	return true;
+}
+
+//-----------------------------------------------------------------------------------------------------------------------
+/*! fusion_step moves the estimation by one period with the wheel speed and
+*  the yaw rate, then applies the fix received since the previous step
+* @param state estimated position and speed (the GPS values until the first fix)
+*/
+void fusion_step(tFusionState * state)
+{
+	if(!fusionEnable)
+		return;
+
+	//------------------------------------------------------------  inputs
+
+	k_mutex_lock(&gpsBufferMutex,K_FOREVER);		//lock gps buffer mutex
+	int32_t lat = gpsBuffer.lat;
+	int32_t lon = gpsBuffer.lon;
+	uint32_t gpsSpeedCKmh = gpsBuffer.speed;
+	bool fix = gpsBuffer.fix;
+	uint32_t updates = gpsBuffer.updates;
+	k_mutex_unlock(&gpsBufferMutex);				//unlock mutex
+
+	uint32_t wheel = 0, yaw = 0;
+	k_mutex_lock(&sensorBufferMutex,K_FOREVER);		//lock sensor buffer mutex
+	if(wheelIndex >= 0)
+		wheel = sensorBuffer[wheelIndex].value;
+	if(yawIndex >= 0)
+		yaw = sensorBuffer[yawIndex].value;
+	k_mutex_unlock(&sensorBufferMutex);				//unlock mutex
+
+	bool newFix = fix && updates != lastUpdates && (lat != 0 || lon != 0);
+	lastUpdates = updates;
+
+	if(newFix)
+		gpsSpeed = (int32_t)((uint64_t)gpsSpeedCKmh * 1000 / 360);		//0.01 km/h -> mm/s
+
+	if(!refValid)		//no fix yet, GPS values
+	{
+		if(newFix)
+			fusion_reference(lat, lon);
+
+		state->lat = lat;
+		state->lon = lon;
+		state->speed = gpsSpeedCKmh;
+		state->heading = 0;
+		return;
+	}
+
+	//------------------------------------------------------------  prediction
+
+	const struct sFusion * cfg = &configFile.GPS.Fusion;
+
+	if(wheelIndex >= 0)
+		speed = (int32_t)((int64_t)wheel * cfg->WheelSpeedFactor / 360);		//raw -> 0.01 km/h (factor/1000) -> mm/s
+	else
+		speed = gpsSpeed;
+
+	if(yawIndex >= 0)
+	{
+		int64_t yawRate = ((int64_t)yaw - cfg->YawRateOffset) * cfg->YawRateFactor / 1000;		//0.01 deg/s
+		heading += (uint32_t)(yawRate * stepMs * (1LL << 32) / 36000000);
+		headingValid = true;
+	}
+	else
+	{
+		heading += (uint32_t)turnRate;		//turn of the last two courses
+	}
+	stepsSinceFix++;
+
+	if(headingValid)
+	{
+		posX += ((int64_t)speed * fusion_sin(heading + (1u << 30)) * stepMs) >> 15;		//mm/s * ms = µm
+		posY += ((int64_t)speed * fusion_sin(heading) * stepMs) >> 15;
+	}
+
+	//------------------------------------------------------------  correction
+
+	if(newFix)
+	{
+		int64_t x = ((int64_t)(lon - refLon) * FUSION_UM_PER_UNIT * lonScale) >> 16;
+		int64_t y = (int64_t)(lat - refLat) * FUSION_UM_PER_UNIT;
+
+		if(x > FUSION_MAX_RANGE || x < -FUSION_MAX_RANGE || y > FUSION_MAX_RANGE || y < -FUSION_MAX_RANGE)
+			fusion_reference(lat, lon);		//far from the reference, the scale of the longitude changed
+		else
+			fusion_fix(x, y);
+	}
+
+	//------------------------------------------------------------  output
+
+	state->lat = refLat + (int32_t)(posY / FUSION_UM_PER_UNIT);
+	state->lon = refLon + (int32_t)(((posX << 16) / lonScale) / FUSION_UM_PER_UNIT);
+	state->speed = (uint32_t)(MAX(speed,0) * 360 / 1000);		//mm/s -> 0.01 km/h
+	state->heading = (uint32_t)(((uint64_t)heading * 36000) >> 32);
+}
+
+//-----------------------------------------------------------------------------------------------------------------------
+/*! @brief apply a GPS fix to the estimation. A share of the position error
+*		  is corrected, the course between the last two fixes corrects the
+*		  heading at the middle of the interval
+* @param x position of the fix east of the reference (µm)
+* @param y position of the fix north of the reference (µm)
+*/
+static void fusion_fix(int64_t x, int64_t y)
+{
+	int64_t errX = x - posX;
+	int64_t errY = y - posY;
+
+	if(errX > FUSION_RESET_ERROR || errX < -FUSION_RESET_ERROR || errY > FUSION_RESET_ERROR || errY < -FUSION_RESET_ERROR)
+	{
+		posX = x;		//estimation lost (gps outage, wrong sensor), restart at the fix
+		posY = y;
+	}
+	else
+	{
+		posX += (errX * gain) >> 8;
+		posY += (errY * gain) >> 8;
+	}
+
+	if(lastFixValid)
+	{
+		int64_t dx = x - lastFixX;
+		int64_t dy = y - lastFixY;
+
+		if(dx*dx + dy*dy >= FUSION_MIN_COURSE_DISTANCE*FUSION_MIN_COURSE_DISTANCE)		//course meaningful above a few meters
+		{
+			uint32_t course = fusion_atan2(dy, dx);
+
+			if(yawIndex >= 0)		//correct the drift of the yaw rate
+			{
+				uint32_t middle = lastFixHeading + (uint32_t)((int32_t)(heading - lastFixHeading) / 2);
+				heading += (uint32_t)(((int64_t)(int32_t)(course - middle) * gain) >> 8);
+			}
+			else					//course of the middle of the interval, turned at the rate of the last two courses
+			{
+				int steps = MAX(stepsSinceFix,1);
+				turnRate = lastCourseValid ? (int32_t)(course - lastCourse) / steps : 0;
+				heading = course + (uint32_t)(turnRate * (steps / 2));
+				headingValid = true;
+			}
+			lastCourse = course;
+			lastCourseValid = true;
+		}
+		else
+		{
+			turnRate = 0;		//stopped or slow, the course is noise
+			lastCourseValid = false;
+		}
+	}
+	stepsSinceFix = 0;
+
+	lastFixValid = true;
+	lastFixX = x;
+	lastFixY = y;
+	lastFixHeading = heading;
+}
+
+//-----------------------------------------------------------------------------------------------------------------------
+/*! @brief take a fix as reference of the local coordinates, the estimation
+*		  restarts at this fix
+* @param lat latitude of the fix (1e-7 degree)
+* @param lon longitude of the fix (1e-7 degree)
+*/
+static void fusion_reference(int32_t lat, int32_t lon)
+{
+	refLat = lat;
+	refLon = lon;
+	lonScale = MAX((fusion_sin((uint32_t)(((int64_t)lat << 32) / 3600000000LL) + (1u << 30)) * 2), 1);		//cos(lat) Q15 -> Q16
+	posX = 0;
+	posY = 0;
+	lastFixValid = true;
+	lastFixX = 0;
+	lastFixY = 0;
+	lastFixHeading = heading;
+	lastCourseValid = false;
+	turnRate = 0;
+	stepsSinceFix = 0;
+	refValid = true;
+}
+
+//-----------------------------------------------------------------------------------------------------------------------
+/*! @brief find a sensor of the sensor buffer by its log name
+* @param name log name of the sensor (NULL if not set)
+* @retval index in the sensor buffer, -1 if not found
+*/
+static int fusion_sensor(const char * name)
+{
+	if(name == NULL)
+		return -1;
+
+	for(int i=0; i<configFile.sensorCount; i++)
+	{
+		if(sensorBuffer[i].name_log != NULL && strcmp(sensorBuffer[i].name_log,name) == 0)
+			return i;
+	}
+
+	LOG_ERR("fusion : sensor %s not found", name);
+	return -1;
+}
+
+//-----------------------------------------------------------------------------------------------------------------------
+/*! @brief sine of a binary angle, linear interpolation in the table
+* @param angle binary angle (2^32 = one turn)
+* @retval sine (Q15)
+*/
+static int32_t fusion_sin(uint32_t angle)
+{
+	uint32_t index = angle >> 24;
+	int32_t fraction = (angle >> 8) & 0xFFFF;
+	int32_t s0 = sinTable[index];
+	int32_t s1 = sinTable[index+1];
+
+	return s0 + (((s1 - s0) * fraction) >> 16);
+}
+
+//-----------------------------------------------------------------------------------------------------------------------
+/*! @brief angle of a vector. The octant is found with the signs and the
+*		  order of the components, the arc tangent of the ratio (0..1) is
+*		  a polynomial approximation
+* @param y north component
+* @param x east component
+* @retval binary angle (2^32 = one turn, counterclockwise from east)
+*/
+static uint32_t fusion_atan2(int64_t y, int64_t x)
+{
+	int64_t ax = x < 0 ? -x : x;
+	int64_t ay = y < 0 ? -y : y;
+
+	if(ax == 0 && ay == 0)
+		return 0;
+
+	bool swap = ay > ax;
+	int64_t z = swap ? (ax << 15) / ay : (ay << 15) / ax;		//ratio 0..1 (Q15)
+
+	//atan(z) = pi/4 z + z (1 - z) (0.2447 + 0.0663 z), in binary angle
+	int64_t a = (z << 29) >> 15;
+	a += (((z * (32768 - z)) >> 15) * (167268423 + ((45320377 * z) >> 15))) >> 15;
+
+	uint32_t angle = (uint32_t)a;
+	if(swap)
+		angle = (1u << 30) - angle;
+	if(x < 0)
+		angle = (1u << 31) - angle;
+	if(y < 0)
+		angle = -angle;
+
+	return angle;
+}
@@ -0,0 +1,55 @@
+/*! --------------------------------------------------------------------
+ *	Telemetry System	-	@file fusion.h
+ *----------------------------------------------------------------------
+ * HES-SO Valais Wallis
+ * Systems Engineering
+ * Infotronics
+ * ---------------------------------------------------------------------
+ * @author agent
+ * @date 19.10.2026
+ * ---------------------------------------------------------------------
+ * @brief Fusion estimates the position and the speed of the car at the
+ *        log frame rate. Between the GPS fixes, the position is moved
+ *        with the wheel speed and the yaw rate, each fix corrects a part
+ *        of the error (complementary filter, fixed point math).
+ * ---------------------------------------------------------------------
+ * Telemetry system for the Valais Wallis Racing Team.
+ * This file contains code for the onboard device of the telemetry
+ * system. The system receives the data from the sensors on the CAN bus
+ * and the data from the GPS on a UART port. An SD Card contains a
+ * configuration file with all the system parameters. The measurements
+ * are sent via Wi-Fi to a computer on the base station. The measurements
+ * are also saved in a CSV file on the SD card.
+ *--------------------------------------------------------------------*/
+
+#ifndef __FUSION_H
+#define __FUSION_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*! @brief estimated position and speed
+    @param lat latitude (1e-7 degree, north positive)
+    @param lon longitude (1e-7 degree, east positive)
+    @param speed speed (0.01 km/h)
+    @param heading heading (0.01 degree, counterclockwise from east)
+*/
+typedef struct sFusionState{
+    int32_t lat;
+    int32_t lon;
+    uint32_t speed;
+    uint32_t heading;
+}tFusionState;
+
+/*! fusion_init finds the sensors of the config file
+* @param period period of the estimation (ms)
+* @retval true if the fusion is enabled
+*/
+bool fusion_init(int period);
+
+/*! fusion_step moves the estimation by one period and applies the new GPS fix
+* @param state estimated position and speed (the GPS values until the first fix)
+*/
+void fusion_step(tFusionState * state);
+
+#endif /*__FUSION_H*/
@@ -28,6 +28,7 @@
 
 #define MAX_SERVERS 5           //max number of server the system can send data to
 #define MAX_SENSORS 100         //max number of sensors
+#define CFG_FILE_MAX_SIZE 32768  //max size of the config file without the spaces between the tokens (bytes)
 
 //memory heap for udp messages
 extern struct k_heap messageHeap;
@@ -70,13 +71,9 @@ extern tSensor sensorBuffer[MAX_SENSORS];
 extern struct k_mutex sensorBufferMutex;
 
 /*! @brief gps buffer struct
-    @param speed current gps speed
-    @param lat_sign sign of the latitude (0==- ; 1==+)
-    @param lat_characteristic integer part of the latitude
-    @param lat_mantissa fractionnal part of the latitude
-    @param long_sign sign of the longitude (0==- ; 1==+)
-    @param long_characteristic integer part of the longitude
-    @param long_mantissa fractionnal part of the longitude
+    @param speed current gps speed (0.01 km/h)
+    @param lat current latitude (1e-7 degree, north positive)
+    @param lon current longitude (1e-7 degree, east positive)
     @param hour current time
     @param min current time
     @param sec current time
@@ -84,6 +81,12 @@ extern struct k_mutex sensorBufferMutex;
     @param month current date
     @param year current date
     @param fix current gps fix status
+    @param satellites number of satellites used in the solution (0 if unknown)
+    @param updates number of positions received
+    @param lap number of the current lap of the lap timer (0 before the first start/finish crossing)
+    @param sector number of the last completed sector (1 = first sector)
+    @param lapTime time of the last completed lap (ms)
+    @param sectorTime time of the last completed sector (ms)
     @param NameLiveCoord name of the coord field in the live transmission
     @param NameLogCoord name of the coord field in the logs
     @param LiveCoordEnable coords enabled in the live transmission
@@ -95,14 +98,9 @@ extern struct k_mutex sensorBufferMutex;
     @param LiveFixEnable fix status enabled in the live transmission
 */
 typedef struct sGps{
-    int speed;
-    uint8_t ispeed;
-    uint16_t lat_sign;
-    uint16_t lat_characteristic;
-    uint32_t lat_mantissa;
-    uint16_t long_sign;
-    uint16_t long_characteristic;
-    uint32_t long_mantissa;
+    uint32_t speed;
+    int32_t lat;
+    int32_t lon;
     uint8_t hour;
     uint8_t min;
     uint8_t sec;
@@ -110,6 +108,12 @@ typedef struct sGps{
     uint8_t month;
     uint8_t year;
     bool fix;
+    uint8_t satellites;
+    uint32_t updates;
+    uint16_t lap;
+    uint8_t sector;
+    uint32_t lapTime;
+    uint32_t sectorTime;
     char * NameLiveCoord;
     char * NameLogCoord;
     bool LiveCoordEnable;
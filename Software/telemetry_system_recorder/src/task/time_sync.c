@@ -0,0 +1,107 @@
+/*! --------------------------------------------------------------------
+ *	Telemetry System	-	@file time_sync.c
+ *----------------------------------------------------------------------
+ * HES-SO Valais Wallis 
+ * Systems Engineering
+ * Infotronics
+ * ---------------------------------------------------------------------
+ * @author agent
+ * @date 19.10.2026
+ * ---------------------------------------------------------------------
+ * @brief Time sync keeps the clock of the recorder aligned on the 
+ *        synchronised time sent by the transmitter on the CAN bus,
+ *        so the log records and the live data have the same time base
+ * ---------------------------------------------------------------------
+ * Telemetry system for the Valais Wallis Racing Team.
+ * This file contains code for the onboard device of the telemetry
+ * system. The system receives the data from the sensors on the CAN bus 
+ * and the data from the GPS on a UART port. An SD Card contains a 
+ * configuration file with all the system parameters. The measurements 
+ * are sent via Wi-Fi to a computer on the base station. The measurements 
+ * are also saved in a CSV file on the SD card. 
+ *--------------------------------------------------------------------*/
+
+//includes
+#include <zephyr/kernel.h>
+#include <zephyr/sys/util.h>
+
+//project file includes
+#include "time_sync.h"
+
+//! Min time between two drift measurements (µs)
+#define TIME_SYNC_DRIFT_INTERVAL_US 30000000LL
+//! Max drift of the local clock (ppb)
+#define TIME_SYNC_MAX_DRIFT_PPB 500000
+
+//clock estimate (protected by timeSyncMutex)
+K_MUTEX_DEFINE(timeSyncMutex);
+static bool syncValid;				//time received at least once
+static int64_t syncOffset;			//reference - local at syncLocal (µs)
+static int64_t syncLocal;			//local time of the last reference (µs)
+static int32_t syncDrift;			//drift of the local clock (ppb)
+static bool syncDriftValid;			//drift measured at least once
+static int64_t driftLocal;			//local time of the first point of the drift measurement
+static int64_t driftOffset;			//offset of the first point of the drift measurement
+
+//-----------------------------------------------------------------------------------------------------------------------
+/*! time_sync_local
+* @brief local clock (µs since boot)
+*/
+int64_t time_sync_local(void)
+{
+	return k_ticks_to_us_floor64(k_uptime_ticks());
+}
+
+//-----------------------------------------------------------------------------------------------------------------------
+/*! time_sync_now
+* @brief current synchronised time (µs since 1970), 0 if no time was received
+*/
+int64_t time_sync_now(void)
+{
+	int64_t local = time_sync_local();
+	int64_t time = 0;
+
+	k_mutex_lock(&timeSyncMutex,K_FOREVER);		//lock time sync mutex
+
+	if(syncValid)
+		time = local + syncOffset + (local - syncLocal) * syncDrift / 1000000000LL;
+
+	k_mutex_unlock(&timeSyncMutex);				//unlock mutex
+
+	return time;
+}
+
+//-----------------------------------------------------------------------------------------------------------------------
+/*! time_sync_reference sets the synchronised time received from the transmitter
+* @brief the drift of the local clock is measured between references, so
+*        the time stays accurate between two CAN messages
+* @param reference synchronised time (µs since 1970)
+* @param local local time at the reception (µs since boot)
+*/
+void time_sync_reference(int64_t reference, int64_t local)
+{
+	int64_t offset = reference - local;
+
+	k_mutex_lock(&timeSyncMutex,K_FOREVER);		//lock time sync mutex
+
+	if(!syncValid)		//first reference
+	{
+		driftLocal = local;
+		driftOffset = offset;
+	}
+	else if(local - driftLocal >= TIME_SYNC_DRIFT_INTERVAL_US)		//measure the drift on a long interval
+	{
+		int32_t drift = MIN(MAX((offset - driftOffset) * 1000000000LL / (local - driftLocal),-TIME_SYNC_MAX_DRIFT_PPB),TIME_SYNC_MAX_DRIFT_PPB);
+
+		syncDrift = syncDriftValid ? syncDrift + (drift - syncDrift)/4 : drift;		//smooth the measurements
+		syncDriftValid = true;
+		driftLocal = local;
+		driftOffset = offset;
+	}
+
+	syncValid = true;
+	syncOffset = offset;
+	syncLocal = local;
+
+	k_mutex_unlock(&timeSyncMutex);				//unlock mutex
+}
@@ -0,0 +1,45 @@
+/*! --------------------------------------------------------------------
+ *	Telemetry System	-	@file time_sync.h
+ *----------------------------------------------------------------------
+ * HES-SO Valais Wallis 
+ * Systems Engineering
+ * Infotronics
+ * ---------------------------------------------------------------------
+ * @author agent
+ * @date 19.10.2026
+ * ---------------------------------------------------------------------
+ * @brief Time sync keeps the clock of the recorder aligned on the 
+ *        synchronised time sent by the transmitter on the CAN bus,
+ *        so the log records and the live data have the same time base
+ * ---------------------------------------------------------------------
+ * Telemetry system for the Valais Wallis Racing Team.
+ * This file contains code for the onboard device of the telemetry
+ * system. The system receives the data from the sensors on the CAN bus 
+ * and the data from the GPS on a UART port. An SD Card contains a 
+ * configuration file with all the system parameters. The measurements 
+ * are sent via Wi-Fi to a computer on the base station. The measurements 
+ * are also saved in a CSV file on the SD card. 
+ *--------------------------------------------------------------------*/
+
+#ifndef __TIME_SYNC_H
+#define __TIME_SYNC_H
+
+#include <stdint.h>
+
+/*! time_sync_local
+* @brief local clock (µs since boot)
+*/
+int64_t time_sync_local(void);
+
+/*! time_sync_now
+* @brief current synchronised time (µs since 1970), 0 if no time was received
+*/
+int64_t time_sync_now(void);
+
+/*! time_sync_reference sets the synchronised time received from the transmitter
+* @param reference synchronised time (µs since 1970)
+* @param local local time at the reception (µs since boot)
+*/
+void time_sync_reference(int64_t reference, int64_t local);
+
+#endif /*__TIME_SYNC_H*/
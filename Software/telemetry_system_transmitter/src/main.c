@@ -33,13 +33,19 @@
 #include "task/config_read.h"
 #include "task/can_controller.h"
 #include "task/gps_controller.h"
+#include "task/control_server.h"
+#include "task/time_sync.h"
 
 
-//message heap for udp queue
-K_HEAP_DEFINE(messageHeap,32768);
+//memory of the udp message slab (block size is set by the data sender)
+char __aligned(4) messageSlabBuffer[MESSAGE_SLAB_SIZE];
+struct k_mem_slab messageSlab;
 
-//udp queue
-K_QUEUE_DEFINE(udpQueue);
+//udp queue (pointers to the messages in the slab)
+K_MSGQ_DEFINE(udpQueue, sizeof(tUdpMessage *), UDP_QUEUE_MAX_DEPTH, 4);
+
+//udp queue of the priority live classes (read before udpQueue)
+K_MSGQ_DEFINE(udpPriorityQueue, sizeof(tUdpMessage *), UDP_PRIORITY_QUEUE_DEPTH, 4);
 
 
 //--------------------------------------------------------------------------
@@ -61,6 +67,10 @@ int main(void)
 		Task_Data_Sender_Init();		// start data sender
 
 		Task_CAN_Controller_Init();		//start can controller thread
+
+		Task_Control_Server_Init();		//start control server thread
+
+		Task_Time_Sync_Init();			//start time sync thread
 	}
 
 	k_sleep( K_FOREVER );
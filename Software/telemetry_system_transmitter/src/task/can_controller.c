@@ -32,11 +32,13 @@ LOG_MODULE_REGISTER(can);
 #include <zephyr/drivers/can.h>
 #include <zephyr/drivers/gpio.h>
 #include <zephyr/sys/byteorder.h>
+#include <errno.h>
 
 //project files includes
 #include "can_controller.h"
 #include "memory_management.h"
 #include "config_read.h"
+#include "time_sync.h"
 //#include "data_logger.h"
 
 //! Can controller thread priority level
@@ -80,11 +82,24 @@ const struct device *const can_dev = DEVICE_DT_GET(DT_CHOSEN(zephyr_canbus));
 CAN_MSGQ_DEFINE(can_msgq, 100);
 
 //can ids
-uint32_t canLatId;
-uint32_t canLongId;
+uint32_t canPositionId;
+uint32_t canDateId;
 uint32_t canTimeFixSpeedId;
+uint32_t canSyncTimeId;
+uint32_t canLapId;
+uint32_t canQualityId;
 uint32_t canLedId;
 
+//gps frames not sent (tx queue full) and sent with an error, counted by the tx callback
+static atomic_t canGpsDropped;
+static atomic_t canGpsErrors;
+//epochs sent since the last run of the 1 Hz work
+static atomic_t canGpsEpochs;
+
+/*! @brief queue a gps frame without waiting for the bus */
+static void can_send_gps(const struct can_frame * frame);
+/*! @brief tx callback of the gps frames */
+static void can_gps_tx_done(const struct device *dev, int error, void *user_data);
 
 //-----------------------------------------------------------------------------------------------------------------------
 /*! canGPS_timer_handler is called by the timer interrupt
@@ -126,9 +141,14 @@ void CAN_Controller(void)
 	can_add_rx_filter_msgq(can_dev, &can_msgq, &filter);
 
 	//can ids
-	canLatId = (uint32_t)strtol(configFile.GPS.CanIDs.Lat, NULL, 0);
-	canLongId = (uint32_t)strtol(configFile.GPS.CanIDs.Long, NULL, 0);
+	if(configFile.GPS.CanIDs.Position == NULL || configFile.GPS.CanIDs.Date == NULL)		//keys of an old config file
+		LOG_ERR("GPS.CanIDs.Position and GPS.CanIDs.Date not set (they replace Lat and Long)");
+	canPositionId = configFile.GPS.CanIDs.Position != NULL ? (uint32_t)strtol(configFile.GPS.CanIDs.Position, NULL, 0) : 0;
+	canDateId = configFile.GPS.CanIDs.Date != NULL ? (uint32_t)strtol(configFile.GPS.CanIDs.Date, NULL, 0) : 0;
 	canTimeFixSpeedId = (uint32_t)strtol(configFile.GPS.CanIDs.TimeFixSpeed, NULL, 0); 
+	canSyncTimeId = configFile.GPS.CanIDs.SyncTime != NULL ? (uint32_t)strtol(configFile.GPS.CanIDs.SyncTime, NULL, 0) : 0;		//optional
+	canLapId = configFile.GPS.CanIDs.Lap != NULL ? (uint32_t)strtol(configFile.GPS.CanIDs.Lap, NULL, 0) : 0;		//optional
+	canQualityId = configFile.GPS.CanIDs.Quality != NULL ? (uint32_t)strtol(configFile.GPS.CanIDs.Quality, NULL, 0) : 0;		//optional
 	canLedId = (uint32_t)strtol(configFile.CANLed.CanID, NULL, 0);
 
 	//variable to monitor the input buffer
@@ -208,69 +228,208 @@ void CAN_Controller(void)
 }
 
 //-----------------------------------------------------------------------------------------------------------------------
-/*! sendLat
-* @brief send Latitude
-*      
+/*! sendGpsFix
+* @brief send the solution of a navigation epoch, called by the gps thread at
+*        the update rate of the GPS. The position is sent only with a fix.
+*        Frames (little endian) :
+*         - Position     : latitude (int32, 1e-7 degree) | longitude (int32, 1e-7 degree)
+*         - TimeFixSpeed : UTC time of day (uint32, ms) | speed (uint16, 0.01 km/h) | fix | satellites (0 if unknown)
+*/
+void sendGpsFix( void )
+{
+	struct can_frame position = {
+		.flags = 0,
+		.id = canPositionId,
+		.dlc = 8
+	};
+	struct can_frame timeFixSpeed = {
+		.flags = 0,
+		.id = canTimeFixSpeedId,
+		.dlc = 8
+	};
+
+	if(canPositionId == 0)		//can controller not started
+		return;
+
+	atomic_inc(&canGpsEpochs);
+
+	k_mutex_lock(&gpsBufferMutex,K_FOREVER);		//lock gps buffer mutex
+	bool fix = gpsBuffer.fix;
+	sys_put_le32((uint32_t)gpsBuffer.lat,position.data);
+	sys_put_le32((uint32_t)gpsBuffer.lon,position.data+4);
+	sys_put_le32(gpsBuffer.time,timeFixSpeed.data);
+	sys_put_le16(MIN(gpsBuffer.speed,UINT16_MAX),timeFixSpeed.data+4);
+	timeFixSpeed.data[6] = fix ? 1 : 0;
+	timeFixSpeed.data[7] = gpsBuffer.satellites;
+	k_mutex_unlock(&gpsBufferMutex);				//unlock gps buffer mutex
+
+	if(fix)
+		can_send_gps(&position);
+	can_send_gps(&timeFixSpeed);
+
+	sendGpsQuality();
+}
+
+//-----------------------------------------------------------------------------------------------------------------------
+/*! sendGpsQuality
+* @brief send the quality of the GPS solution. The frame is also put in the
+*        receive queue, so the sensors of the config file on this CAN id are
+*        live channels of the transmitter and log columns of the recorder like
+*        any CAN sensor. Frame (little endian) : satellites | fix type |
+*        HDOP (uint16, 0.01) | PDOP (uint16, 0.01) | age of the fix (uint16, 0.1 s, 0xFFFF if none)
 */
-void sendLat( uint8_t * data )
+void sendGpsQuality( void )
 {
 	struct can_frame frame = {
-        .flags = 0,
-        .id = canLatId,
-        .dlc = 8,
-        .data = {data[0],data[1],data[2],data[3],data[4],data[5],data[6],data[7]}
+		.flags = 0,
+		.id = canQualityId,
+		.dlc = 8
 	};
 
-	int ret;
+	if(canQualityId == 0)		//not configured or can controller not started
+		return;
 
-	ret = can_send(can_dev, &frame, K_FOREVER, NULL, NULL);
-	if (ret != 0) 
-		LOG_ERR("Sending failed [%d]", ret);
+	int64_t now = time_sync_local() / 1000;		//ms since boot
+
+	k_mutex_lock(&gpsBufferMutex,K_FOREVER);		//lock gps buffer mutex
+	frame.data[0] = gpsBuffer.satellites;
+	frame.data[1] = gpsBuffer.fixType;
+	sys_put_le16(gpsBuffer.hdop,frame.data+2);
+	sys_put_le16(gpsBuffer.pdop,frame.data+4);
+	sys_put_le16(gpsBuffer.fixLocal == 0 ? UINT16_MAX : (uint16_t)MIN((now - gpsBuffer.fixLocal) / 100,UINT16_MAX - 1),frame.data+6);
+	k_mutex_unlock(&gpsBufferMutex);				//unlock gps buffer mutex
+
+	can_send_gps(&frame);
+	k_msgq_put(&can_msgq, &frame, K_NO_WAIT);		//own sensors, the controller does not receive its own frames
 }
 
 //-----------------------------------------------------------------------------------------------------------------------
-/*! sendLong
-* @brief send Longitude
-*      
+/*! sendGpsDate
+* @brief send the date of the GPS, once per second. Frame : year | month | day
 */
-void sendLong( uint8_t * data )
+void sendGpsDate( void )
 {
 	struct can_frame frame = {
 		.flags = 0,
-		.id = canLongId,
-		.dlc = 8,
-        .data = {data[0],data[1],data[2],data[3],data[4],data[5],data[6],data[7]}
+		.id = canDateId,
+		.dlc = 8
 	};
 
-	int ret;
+	if(canDateId == 0)		//not configured or can controller not started
+		return;
 
-	ret = can_send(can_dev, &frame, K_FOREVER, NULL, NULL);
-	if (ret != 0) 
-		LOG_ERR("Sending failed [%d]", ret);
+	k_mutex_lock(&gpsBufferMutex,K_FOREVER);		//lock gps buffer mutex
+	frame.data[0] = gpsBuffer.year;
+	frame.data[1] = gpsBuffer.month;
+	frame.data[2] = gpsBuffer.day;
+	k_mutex_unlock(&gpsBufferMutex);				//unlock gps buffer mutex
+
+	can_send_gps(&frame);
 }
 
 //-----------------------------------------------------------------------------------------------------------------------
-/*! sendTimeFixSpeed
-* @brief send Time/date Fix info and speed
-*      
+/*! @brief queue a gps frame without waiting for the bus. The gps thread and
+*		  the system workqueue are never blocked by a busy or an off bus, a
+*		  frame that does not find a free tx buffer is dropped and counted,
+*		  the next epoch or second replaces it
+* @param frame frame to send
+*/
+static void can_send_gps(const struct can_frame * frame)
+{
+	int ret = can_send(can_dev, frame, K_NO_WAIT, can_gps_tx_done, NULL);
+	if(ret != 0)
+		atomic_inc(&canGpsDropped);
+}
+
+//-----------------------------------------------------------------------------------------------------------------------
+/*! @brief tx callback of the gps frames (interrupt context)
+* @param dev can device
+* @param error 0 if the frame is sent, negative error code otherwise
+* @param user_data not used
 */
-void sendTimeFixSpeed( uint8_t * data )
+static void can_gps_tx_done(const struct device *dev, int error, void *user_data)
+{
+	if(error != 0)
+		atomic_inc(&canGpsErrors);
+}
+
+//-----------------------------------------------------------------------------------------------------------------------
+/*! sendSyncTime
+* @brief send the synchronised time (µs since 1970, little endian), so the 
+*        recorder timestamps the logs with the clock of the live data.
+*        Nothing is sent while the clock is not synchronised
+*/
+void sendSyncTime( void )
 {
 	struct can_frame frame = {
 		.flags = 0,
-		.id = canTimeFixSpeedId,
-		.dlc = 8,
-        .data = {data[0],data[1],data[2],data[3],data[4],data[5],data[6],data[7]}
+		.id = canSyncTimeId,
+		.dlc = 8
+	};
+
+	int64_t time = time_sync_now();		//read just before sending, the bus delay is below 1 ms
+	if(time == 0)
+		return;
+	sys_put_le64(time,frame.data);
+
+	can_send_gps(&frame);		//system workqueue, never blocked by the bus
+}
+
+//-----------------------------------------------------------------------------------------------------------------------
+/*! sendLapEvent
+* @brief send a lap or sector event of the lap timer, so the recorder writes
+*        it in the logs. Frame (little endian) : event type | sector |
+*        lap (uint16) | duration (uint32, ms)
+* @param event event of the lap timer
+*/
+void sendLapEvent( const tLapEvent * event )
+{
+	struct can_frame frame = {
+		.flags = 0,
+		.id = canLapId,
+		.dlc = 8
+	};
+
+	if(canLapId == 0)		//not configured or can controller not started
+		return;
+
+	frame.data[0] = event->type;
+	frame.data[1] = event->sector;
+	sys_put_le16(event->lap,frame.data+2);
+	sys_put_le32(event->duration,frame.data+4);
+
+	can_send_gps(&frame);		//called by the gps thread, the event is also in the lap packet of the live data
+}
+
+//-----------------------------------------------------------------------------------------------------------------------
+/*! sendLogButton
+* @brief send the frame of the start or stop log button, so the recorder
+*        starts or stops the logs as if the button was pressed
+* @param start true for the start button, false for the stop button
+* @retval 0 on success, negative error code otherwise
+*/
+int sendLogButton( bool start )
+{
+	struct sCANButtonData * button = start ? &configFile.CANButton.StartLog : &configFile.CANButton.StopLog;
+
+	if(button->dlc <= 0 || button->dlc > 8 || button->index < 0 || button->index >= button->dlc)		//button not configured
+		return -EINVAL;
+
+	struct can_frame frame = {
+		.flags = 0,
+		.id = (uint32_t)strtol(button->CanID, NULL, 0),
+		.dlc = button->dlc
 	};
+	frame.data[button->index] = (uint8_t)strtol(button->match, NULL, 0);		//matched value of the button
 
 	int ret;
 
-	ret = can_send(can_dev, &frame, K_FOREVER, NULL, NULL);
+	ret = can_send(can_dev, &frame, K_MSEC(100), NULL, NULL);
 	if (ret != 0) 
 		LOG_ERR("Sending failed [%d]", ret);
-}
-
 
+	return ret;
+}
 
 //-----------------------------------------------------------------------------------------------------------------------
 /*! Task_CAN_Controller_Init implements the CAN_Controller task initialization
@@ -300,38 +459,29 @@ void Task_CAN_Controller_Init( void )
 * @brief canGPS_timer_handler execute the work submitted by the interrupt   
 */
 
-typedef union{
-	struct{
-		uint16_t sign;
-		uint16_t characteristic;
-		uint32_t mantissa;
-	}fields;
-	uint8_t u8[8];
-}Coord;
-
+/*
+ * The position, the time, the fix and the speed are sent by the gps thread
+ * at each epoch (sendGpsFix), only the date and the synchronised time are
+ * sent by this work
+ */
 void can_gps_sender()
 {
-	Coord latitude,longitude;
-	uint8_t timeFixSpeed[8];
-	k_mutex_lock(&gpsBufferMutex,K_FOREVER);		//lock gps buffer mutex
-	latitude.fields.sign = gpsBuffer.lat_sign;
-	latitude.fields.characteristic = gpsBuffer.lat_characteristic;
-	latitude.fields.mantissa = gpsBuffer.lat_mantissa;
-	longitude.fields.sign = gpsBuffer.long_sign;
-	longitude.fields.characteristic = gpsBuffer.long_characteristic;
-	longitude.fields.mantissa = gpsBuffer.long_mantissa;
-	timeFixSpeed[0]=gpsBuffer.fix?1:0;
-	timeFixSpeed[1]=gpsBuffer.ispeed;
-	timeFixSpeed[2]=gpsBuffer.year;
-	timeFixSpeed[3]=gpsBuffer.month;
-	timeFixSpeed[4]=gpsBuffer.day;
-	timeFixSpeed[5]=gpsBuffer.hour;
-	timeFixSpeed[6]=gpsBuffer.min;
-	timeFixSpeed[7]=gpsBuffer.sec;
-	k_mutex_unlock(&gpsBufferMutex);				//unlock gps buffer mutex
-	
+	static atomic_val_t dropped, errors;		//counters of the last report
 
-	sendLat(latitude.u8);
-	sendLong(longitude.u8);
-	sendTimeFixSpeed(timeFixSpeed);
+	sendGpsDate();
+
+	if(atomic_clear(&canGpsEpochs) == 0)		//no epoch in the last second, the age of the fix still grows
+		sendGpsQuality();
+
+	if(canSyncTimeId != 0)
+		sendSyncTime();
+
+	atomic_val_t newDropped = atomic_get(&canGpsDropped);
+	atomic_val_t newErrors = atomic_get(&canGpsErrors);
+	if(newDropped != dropped || newErrors != errors)
+	{
+		LOG_WRN("GPS frames : %ld dropped, %ld tx errors", (long)newDropped, (long)newErrors);
+		dropped = newDropped;
+		errors = newErrors;
+	}
 }
@@ -23,6 +23,10 @@
 #ifndef __CAN_CONTROLLER_H
 #define __CAN_CONTROLLER_H
 
+#include <stdbool.h>
+#include <stdint.h>
+#include "lap_timer.h"
+
 /*! CAN_Controller implements the CAN_Controller task
 * @brief CAN_Controller read the CAN Bus and fill the sensorBuffer array 
 *        
@@ -45,23 +49,44 @@ void canGPS_timer_handler();
 */
 void can_gps_sender();
 
-/*! sendLat
-* @brief send Latitude
-*      
+/*! sendGpsFix
+* @brief send the position, the time, the fix and the speed of a navigation
+*        epoch without waiting for the bus, called at the update rate of the GPS
+*/
+void sendGpsFix( void );
+
+/*! sendGpsQuality
+* @brief send the satellites, the fix type, the dilutions of precision and
+*        the age of the fix, also decoded by the sensors of this device
 */
-void sendLat( uint8_t * data );
+void sendGpsQuality( void );
 
-/*! sendLong
-* @brief send Longitude
+/*! sendGpsDate
+* @brief send the date of the GPS
 *      
 */
-void sendLong( uint8_t * data );
+void sendGpsDate( void );
 
-/*! sendTimeFixSpeed
-* @brief send Time/date Fix info and speed
+/*! sendSyncTime
+* @brief send the synchronised time for the timestamps of the recorder
 *      
 */
-void sendTimeFixSpeed( uint8_t * data );
+void sendSyncTime( void );
+
+/*! sendLapEvent
+* @brief send a lap or sector event of the lap timer, so the recorder writes
+*        it in the logs
+* @param event event of the lap timer
+*/
+void sendLapEvent( const tLapEvent * event );
+
+/*! sendLogButton
+* @brief send the frame of the start or stop log button, so the recorder
+*        starts or stops the logs as if the button was pressed
+* @param start true for the start button, false for the stop button
+* @retval 0 on success, negative error code otherwise
+*/
+int sendLogButton( bool start );
 
 
 #endif /*__CAN_CONTROLLER_H*/
\ No newline at end of file
@@ -44,8 +44,14 @@ LOG_MODULE_REGISTER(config, 4);
 #define UART_DEVICE_NODE_CONFIG DT_CHOSEN(zephyr_shell_uart_config)
 static const struct device *const uart_dev_config = DEVICE_DT_GET(UART_DEVICE_NODE_CONFIG);
 
-static char readBuf[60000];
+//end of the config file on the uart
+#define CFG_FILE_END_CHAR 0x14
+
+//text of the config file, parsed in place : the strings of configFile point into it
+static char readBuf[CFG_FILE_MAX_SIZE];
 static int rx_buf_pos = 0;
+static volatile bool configReceived = false;	//end character received
+static volatile bool configOverflow = false;	//characters dropped, config file too large
 static int size = 0;
 bool uartReadOK = false;
 
@@ -71,7 +77,10 @@ static const struct json_obj_descr wifi_router_red_descr[] = {
 //struct for udp servers description
 static const struct json_obj_descr server_descr[] = {
 	JSON_OBJ_DESCR_PRIM(struct sServer, address, JSON_TOK_STRING),
-	JSON_OBJ_DESCR_PRIM(struct sServer, port, JSON_TOK_NUMBER)
+	JSON_OBJ_DESCR_PRIM(struct sServer, port, JSON_TOK_NUMBER),
+	JSON_OBJ_DESCR_PRIM(struct sServer, MTU, JSON_TOK_NUMBER),
+	JSON_OBJ_DESCR_PRIM(struct sServer, BatchDelay, JSON_TOK_NUMBER),
+	JSON_OBJ_DESCR_PRIM(struct sServer, Mode, JSON_TOK_STRING)
 };
 
 //struct for GPS data description
@@ -79,6 +88,8 @@ static const struct json_obj_descr gpsdata_descr[] = {
 	JSON_OBJ_DESCR_PRIM(struct sGPSData, NameLive, JSON_TOK_STRING),
 	JSON_OBJ_DESCR_PRIM(struct sGPSData, NameLog, JSON_TOK_STRING),
 	JSON_OBJ_DESCR_PRIM(struct sGPSData, LiveEnable, JSON_TOK_TRUE),
+	JSON_OBJ_DESCR_PRIM(struct sGPSData, Unit, JSON_TOK_STRING),
+	JSON_OBJ_DESCR_PRIM(struct sGPSData, Class, JSON_TOK_STRING),
 };
 
 //struct for CAN filter description
@@ -109,9 +120,27 @@ static const struct json_obj_descr canled_descr[] = {
 
 //struct for sensors description
 static const struct json_obj_descr canids_descr[] = {
-	JSON_OBJ_DESCR_PRIM(struct sGPSCanIds, Lat, JSON_TOK_STRING),
-	JSON_OBJ_DESCR_PRIM(struct sGPSCanIds, Long, JSON_TOK_STRING),
-	JSON_OBJ_DESCR_PRIM(struct sGPSCanIds, TimeFixSpeed, JSON_TOK_STRING)
+	JSON_OBJ_DESCR_PRIM(struct sGPSCanIds, Position, JSON_TOK_STRING),
+	JSON_OBJ_DESCR_PRIM(struct sGPSCanIds, Date, JSON_TOK_STRING),
+	JSON_OBJ_DESCR_PRIM(struct sGPSCanIds, TimeFixSpeed, JSON_TOK_STRING),
+	JSON_OBJ_DESCR_PRIM(struct sGPSCanIds, SyncTime, JSON_TOK_STRING),
+	JSON_OBJ_DESCR_PRIM(struct sGPSCanIds, Lap, JSON_TOK_STRING),
+	JSON_OBJ_DESCR_PRIM(struct sGPSCanIds, Quality, JSON_TOK_STRING)
+};
+
+//struct for track lines description
+static const struct json_obj_descr trackline_descr[] = {
+	JSON_OBJ_DESCR_PRIM(struct sTrackLine, Lat1, JSON_TOK_NUMBER),
+	JSON_OBJ_DESCR_PRIM(struct sTrackLine, Lon1, JSON_TOK_NUMBER),
+	JSON_OBJ_DESCR_PRIM(struct sTrackLine, Lat2, JSON_TOK_NUMBER),
+	JSON_OBJ_DESCR_PRIM(struct sTrackLine, Lon2, JSON_TOK_NUMBER)
+};
+
+//struct for track description
+static const struct json_obj_descr track_descr[] = {
+	JSON_OBJ_DESCR_OBJECT(struct sTrack, StartFinish, trackline_descr),
+	JSON_OBJ_DESCR_OBJ_ARRAY(struct sTrack, Sectors, MAX_TRACK_SECTORS, sectorCount, trackline_descr,ARRAY_SIZE(trackline_descr)),
+	JSON_OBJ_DESCR_PRIM(struct sTrack, MinLapTime, JSON_TOK_NUMBER)
 };
 
 //struct for GPS description
@@ -119,7 +148,11 @@ static const struct json_obj_descr gps_descr[] = {
   JSON_OBJ_DESCR_OBJECT(struct sGPS, Coordinates, gpsdata_descr),
   JSON_OBJ_DESCR_OBJECT(struct sGPS, Speed, gpsdata_descr),
   JSON_OBJ_DESCR_OBJECT(struct sGPS, Fix, gpsdata_descr),
-  JSON_OBJ_DESCR_OBJECT(struct sGPS, CanIDs, canids_descr)
+  JSON_OBJ_DESCR_OBJECT(struct sGPS, CanIDs, canids_descr),
+  JSON_OBJ_DESCR_PRIM(struct sGPS, Protocol, JSON_TOK_STRING),
+  JSON_OBJ_DESCR_PRIM(struct sGPS, Rate, JSON_TOK_NUMBER),
+  JSON_OBJ_DESCR_PRIM(struct sGPS, Baudrate, JSON_TOK_NUMBER),
+  JSON_OBJ_DESCR_OBJECT(struct sGPS, Track, track_descr)
 };
 
 //struct for sensors description
@@ -129,14 +162,42 @@ static const struct json_obj_descr sensors_descr[] = {
 	JSON_OBJ_DESCR_PRIM(struct sSensors, LiveEnable, JSON_TOK_TRUE),
 	JSON_OBJ_DESCR_PRIM(struct sSensors, CanID, JSON_TOK_STRING),
 	JSON_OBJ_DESCR_PRIM(struct sSensors, CanFrame, JSON_TOK_STRING),
+	JSON_OBJ_DESCR_PRIM(struct sSensors, Unit, JSON_TOK_STRING),
+	JSON_OBJ_DESCR_PRIM(struct sSensors, Class, JSON_TOK_STRING),
+};
+
+//struct for live classes description
+static const struct json_obj_descr liveclass_descr[] = {
+	JSON_OBJ_DESCR_PRIM(struct sLiveClass, Name, JSON_TOK_STRING),
+	JSON_OBJ_DESCR_PRIM(struct sLiveClass, Period, JSON_TOK_NUMBER),
+	JSON_OBJ_DESCR_PRIM(struct sLiveClass, Priority, JSON_TOK_TRUE)
 };
 
 //main config struct description
 static const struct json_obj_descr config_descr[] = {
   JSON_OBJ_DESCR_OBJECT(struct config, WiFiRouter, wifi_router_descr),
   JSON_OBJ_DESCR_OBJECT(struct config, WiFiRouterRedundancy, wifi_router_red_descr),
+  JSON_OBJ_DESCR_PRIM(struct config, WiFiRoamRssi, JSON_TOK_NUMBER),
+  JSON_OBJ_DESCR_PRIM(struct config, WiFiRoamHysteresis, JSON_TOK_NUMBER),
   JSON_OBJ_DESCR_OBJ_ARRAY(struct config, Server, MAX_SERVERS, serverCount, server_descr,ARRAY_SIZE(server_descr)),
   JSON_OBJ_DESCR_PRIM(struct config, LiveFrameRate, JSON_TOK_NUMBER),
+  JSON_OBJ_DESCR_PRIM(struct config, LiveFormat, JSON_TOK_STRING),
+  JSON_OBJ_DESCR_PRIM(struct config, LiveSchemaPeriod, JSON_TOK_NUMBER),
+  JSON_OBJ_DESCR_PRIM(struct config, LiveKeyframePeriod, JSON_TOK_NUMBER),
+  JSON_OBJ_DESCR_PRIM(struct config, LiveQueueDepth, JSON_TOK_NUMBER),
+  JSON_OBJ_DESCR_PRIM(struct config, LiveSpoolRate, JSON_TOK_NUMBER),
+  JSON_OBJ_DESCR_PRIM(struct config, LiveBackfillRate, JSON_TOK_NUMBER),
+  JSON_OBJ_DESCR_PRIM(struct config, LiveHistoryDepth, JSON_TOK_NUMBER),
+  JSON_OBJ_DESCR_PRIM(struct config, LiveRetransmitDeadline, JSON_TOK_NUMBER),
+  JSON_OBJ_DESCR_PRIM(struct config, ControlPort, JSON_TOK_NUMBER),
+  JSON_OBJ_DESCR_PRIM(struct config, ControlKey, JSON_TOK_STRING),
+  JSON_OBJ_DESCR_PRIM(struct config, LiveAdaptRssi, JSON_TOK_NUMBER),
+  JSON_OBJ_DESCR_PRIM(struct config, LiveAdaptLoss, JSON_TOK_NUMBER),
+  JSON_OBJ_DESCR_PRIM(struct config, LiveAdaptRate, JSON_TOK_NUMBER),
+  JSON_OBJ_DESCR_ARRAY(struct config, LivePriority, MAX_LIVE_PRIORITY, livePriorityCount, JSON_TOK_STRING),
+  JSON_OBJ_DESCR_OBJ_ARRAY(struct config, LiveClasses, MAX_LIVE_CLASSES, liveClassCount, liveclass_descr,ARRAY_SIZE(liveclass_descr)),
+  JSON_OBJ_DESCR_PRIM(struct config, TimeSyncPeriod, JSON_TOK_NUMBER),
+  JSON_OBJ_DESCR_PRIM(struct config, TimeSyncGps, JSON_TOK_TRUE),
   JSON_OBJ_DESCR_PRIM(struct config, LogFrameRate, JSON_TOK_NUMBER),
   JSON_OBJ_DESCR_PRIM(struct config, RecordOnStart, JSON_TOK_TRUE),
   JSON_OBJ_DESCR_OBJECT(struct config, CANFilter, canfilter_descr),
@@ -169,16 +230,23 @@ int read_config(void)
 	uart_irq_callback_user_data_set(uart_dev_config, serial_cb_config, NULL);
 	uart_irq_rx_enable(uart_dev_config);
 
-	while(readBuf[rx_buf_pos-1] != 0x14)
+	while(!configReceived)
 	{
 		k_sleep(K_MSEC(100));
 	}
 	
-	size = rx_buf_pos;
+	size = rx_buf_pos - 1;		//without the end character
 	LOG_INF("Received : %d",size);
 
 	uart_irq_rx_disable(uart_dev_config);			//disable uart interrupt (not anymore used)
 
+	if(configOverflow)
+	{
+		LOG_ERR("Config file too large (max %d characters)", CFG_FILE_MAX_SIZE - 1);
+		configOK=false;
+		return 3;
+	}
+
 	
 	//--------------------------------------- parse json string
 
@@ -265,8 +333,9 @@ int read_config(void)
 
 		//initialize gps buffer values
 		gpsBuffer.fix=false;
-		strcpy(gpsBuffer.speed,"0.0");
-		strcpy(gpsBuffer.coord,"0.0 0.0");
+		gpsBuffer.speed=0;
+		gpsBuffer.lat=0;
+		gpsBuffer.lon=0;
 		
 		//initialize gpsbuffer parames with config file values
 		gpsBuffer.LiveCoordEnable=configFile.GPS.Coordinates.LiveEnable;
@@ -289,7 +358,6 @@ int read_config(void)
  * @brief Read characters from UART (config file)
  */
 static uint8_t uart_read[64];
-static char* rBuf = &readBuf[0];
 
 void serial_cb_config(const struct device *dev, void *user_data)
 {
@@ -303,11 +371,22 @@ void serial_cb_config(const struct device *dev, void *user_data)
 
 		int ret = uart_fifo_read(dev, uart_read, 64);		//read buffer
 
-		if (ret > 0)
+		if (ret > 0 && !configReceived)
 		{
-			memcpy(rBuf, uart_read, ret);					//append chars to read array
-			rBuf += ret;
-			rx_buf_pos+= ret;
+			int count = MIN(ret, (int)sizeof(readBuf) - rx_buf_pos);
+
+			if (count < ret)			//full, the end character is kept at the end of the buffer
+			{
+				configOverflow = true;
+				count = 0;
+				rx_buf_pos = sizeof(readBuf) - 1;
+				readBuf[rx_buf_pos++] = uart_read[ret-1];
+			}
+			memcpy(&readBuf[rx_buf_pos], uart_read, count);		//append chars to read array
+			rx_buf_pos += count;
+
+			if (readBuf[rx_buf_pos-1] == CFG_FILE_END_CHAR)
+				configReceived = true;
 		}
 	}
 
@@ -60,10 +60,18 @@ struct sWiFiRouterRedundancy{
 /*! @brief struct for the Server configuration
 * @param address IP address of Server
 * @param port port of server
+* @param MTU max size of the datagrams, several live messages are packed in one datagram (0 = one message per datagram)
+* @param BatchDelay max time a message waits in a batch (ms)
+* @param Mode "unicast", "multicast" or "broadcast" (detected from the address if not set).
+*             A multicast or broadcast server is sent once for all the laptops listening
+*             on the pit wall network, the unicast servers are still sent separately
 */
 struct sServer{
     char* address;
     int port;
+    int MTU;
+    int BatchDelay;
+    char* Mode;
 };
 
 /*! @brief struct for the can filter configuration
@@ -109,22 +117,58 @@ struct sCANLed{
 * @param NameLive Name of the datapoint on the live data transmission
 * @param NameLog Name of the datapoint on the logs
 * @param LiveEnable Enable datapoint on the live data transmisson
+* @param Unit Unit of the datapoint announced in the live schema (optional)
+* @param Class name of the live class of the datapoint (optional, default stream if not set)
 */
 struct sGPSData{
     char* NameLive;
     char* NameLog;
     bool LiveEnable;
+    char* Unit;
+    char* Class;
 };
 
 /*! @brief struct for the CAN datapoint
-* @param Lat Latitude
-* @param Long Longitude
-* @param TimeFixSpeed current Time, Fix information and Speed information
+* @param Position position of each epoch (latitude and longitude)
+* @param Date date (once per second)
+* @param TimeFixSpeed time, fix, speed and number of satellites of each epoch
+* @param SyncTime synchronised time of the transmitter (optional)
+* @param Lap lap and sector events of the lap timer (optional)
+* @param Quality satellites, fix type, HDOP, PDOP and age of the fix (optional, read by sensors on this id)
 */
 struct sGPSCanIds{
-    char * Lat;
-    char * Long;
+    char * Position;
+    char * Date;
     char * TimeFixSpeed;
+    char * SyncTime;
+    char * Lap;
+    char * Quality;
+};
+
+/*! @brief struct for a timing line of the track (two points on both sides of the track)
+* @param Lat1 latitude of the first point (1e-7 degree)
+* @param Lon1 longitude of the first point (1e-7 degree)
+* @param Lat2 latitude of the second point (1e-7 degree)
+* @param Lon2 longitude of the second point (1e-7 degree)
+*/
+struct sTrackLine{
+    int Lat1;
+    int Lon1;
+    int Lat2;
+    int Lon2;
+};
+
+/*! @brief struct for the lap timer
+* @param StartFinish start/finish line (lap timer disabled if not set)
+* @param Sectors sector lines in the order they are crossed, the last sector ends on the start/finish line
+* @param sectorCount number of sector lines
+* @param MinLapTime min time between two start/finish crossings (ms, 10 s if not set)
+*/
+struct sTrack{
+    struct sTrackLine StartFinish;
+    struct sTrackLine Sectors[MAX_TRACK_SECTORS];
+    int sectorCount;
+    int MinLapTime;
 };
 
 /*! @brief struct for the GPS data
@@ -132,12 +176,20 @@ struct sGPSCanIds{
 * @param Speed GPS speed struct
 * @param Fix GPS fix struct
 * @param CanIds Can ids for the messages
+* @param Protocol "nmea" (default rate of the module) or "ubx" (NAV-PVT messages at Rate, u-blox modules only), nmea if not set
+* @param Rate navigation rate in the ubx protocol (fixes/second, 1..25)
+* @param Baudrate uart baudrate in the ubx protocol (the module starts at the baudrate of the devicetree)
+* @param Track lines of the lap timer (optional)
 */
 struct sGPS{
     struct sGPSData Coordinates;
     struct sGPSData Speed;
     struct sGPSData Fix;
     struct sGPSCanIds CanIDs;
+    char * Protocol;
+    int Rate;
+    int Baudrate;
+    struct sTrack Track;
 };
 
 /*! @brief struct for the CAN datapoint
@@ -146,6 +198,8 @@ struct sGPS{
 * @param LiveEnable Enable datapoint on the live data transmisson
 * @param CanID CAN id of the message containing the datapoint value
 * @param CanFram Config frame of the can message containing the datapoint value
+* @param Unit Unit of the datapoint announced in the live schema (optional)
+* @param Class name of the live class of the datapoint (optional, default stream if not set)
 */
 struct sSensors{
     char* NameLive;
@@ -153,14 +207,50 @@ struct sSensors{
     bool LiveEnable;
     char * CanID;
     char * CanFrame;
+    char * Unit;
+    char * Class;
+};
+
+/*! @brief struct for a live class (channels sent together with their own period)
+* @param Name name of the class, used in the Class field of the datapoints
+* @param Period send period of the channels of the class (ms)
+* @param Priority messages of the class skip ahead of the other messages in the udp queue and are not batched
+*/
+struct sLiveClass{
+    char* Name;
+    int Period;
+    bool Priority;
 };
 
 /*! @brief main config struct
 * @param WiFiRouter WiFi router struct
 * @param WiFiRouterRedundancy Redundancy WiFi router struct
+* @param WiFiRoamRssi rssi below which the other router is scanned to switch to it (dBm, 0 = disabled)
+* @param WiFiRoamHysteresis min rssi difference to switch to the other router (dB)
 * @param Server Server struct array
 * @param serverCount number of servers
 * @param LiveFrameRate Live send frequency (sends/second)
+* @param LiveFormat Live data format ("json", "binary" or "delta", json if not set)
+* @param LiveSchemaPeriod Period of the schema announcement in the binary format (seconds)
+* @param LiveKeyframePeriod Number of packets between two keyframes in the delta format
+* @param LiveQueueDepth Max number of live messages waiting to be sent (oldest dropped when full)
+* @param LiveSpoolRate Live samples kept per second while the Wi-Fi is lost (0 = disabled)
+* @param LiveBackfillRate Kept samples sent per second when the Wi-Fi is back
+* @param LiveHistoryDepth Number of sent samples kept for retransmission on NACK
+* @param LiveRetransmitDeadline Max age of a sample sent again on NACK (ms)
+* @param ControlPort UDP port of the control server (0 = disabled)
+* @param ControlKey Shared key used to authenticate the control commands
+* @param LiveAdaptRssi rssi below which the live transmission is reduced (dBm, 0 = rssi not used)
+* @param LiveAdaptLoss loss above which the live transmission is reduced (% of the messages dropped, NACKed or in error, 0 = loss not used)
+* @param LiveAdaptRate Live send frequency of the reduced transmission (sends/second, LiveFrameRate/2 if not set)
+* @param LivePriority names of the live channels kept when the link is poor, most important first
+* @param livePriorityCount number of names in LivePriority
+* @param LiveClasses live classes, the channels without class are sent in the default stream at LiveFrameRate.
+*                    The diagnostic channels (link, clock, servers, wifi, gps, live level) are sent only
+*                    if a class is named "Diagnostics", in that class
+* @param liveClassCount number of live classes
+* @param TimeSyncPeriod Period of the time sync with the first unicast server (seconds, 0 = disabled)
+* @param TimeSyncGps Use the GPS time when the base station does not answer (and the PPS pulse of the GPS before the base station if it is wired)
 * @param LogFrameRate Log record frequency (records/second)
 * @param CANFilter Can filter
 * @param GPS GPS config struct
@@ -170,9 +260,30 @@ struct sSensors{
 struct config {
 	struct sWiFiRouter WiFiRouter;
     struct sWiFiRouterRedundancy WiFiRouterRedundancy;
+    int WiFiRoamRssi;
+    int WiFiRoamHysteresis;
     struct sServer Server[MAX_SERVERS];
 	int serverCount;
     int LiveFrameRate;
+    char * LiveFormat;
+    int LiveSchemaPeriod;
+    int LiveKeyframePeriod;
+    int LiveQueueDepth;
+    int LiveSpoolRate;
+    int LiveBackfillRate;
+    int LiveHistoryDepth;
+    int LiveRetransmitDeadline;
+    int ControlPort;
+    char * ControlKey;
+    int LiveAdaptRssi;
+    int LiveAdaptLoss;
+    int LiveAdaptRate;
+    char * LivePriority[MAX_LIVE_PRIORITY];
+    int livePriorityCount;
+    struct sLiveClass LiveClasses[MAX_LIVE_CLASSES];
+    int liveClassCount;
+    int TimeSyncPeriod;
+    bool TimeSyncGps;
     int LogFrameRate;
     bool RecordOnStart;
     struct sCANFilter CANFilter;
@@ -0,0 +1,392 @@
+/*! --------------------------------------------------------------------
+ *	Telemetry System	-	@file control_server.c
+ *----------------------------------------------------------------------
+ * HES-SO Valais Wallis 
+ * Systems Engineering
+ * Infotronics
+ * ---------------------------------------------------------------------
+ * @author agent
+ * @date 19.10.2026
+ * ---------------------------------------------------------------------
+ * @brief Control server task receives the commands of the base station
+ *        on a UDP port and changes the live configuration at runtime
+ * ---------------------------------------------------------------------
+ * Telemetry system for the Valais Wallis Racing Team.
+ * This file contains code for the onboard device of the telemetry
+ * system. The system receives the data from the sensors on the CAN bus 
+ * and the data from the GPS on a UART port. An SD Card contains a 
+ * configuration file with all the system parameters. The measurements 
+ * are sent via Wi-Fi to a computer on the base station. The measurements 
+ * are also saved in a CSV file on the SD card. 
+ *--------------------------------------------------------------------*/
+
+//includes
+#include <zephyr/logging/log.h>
+LOG_MODULE_REGISTER(control);
+#include <zephyr/kernel.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <zephyr/posix/sys/socket.h>
+#include <zephyr/posix/arpa/inet.h>
+#include <zephyr/net/socket.h>
+#include <unistd.h>
+#include <zephyr/drivers/flash.h>
+#include <zephyr/storage/flash_map.h>
+#include <zephyr/fs/nvs.h>
+#include <tinycrypt/hmac.h>
+#include <tinycrypt/constants.h>
+
+//project file includes
+#include "control_server.h"
+#include "deviceInformation.h"
+#include "memory_management.h"
+#include "config_read.h"
+#include "data_sender.h"
+#include "can_controller.h"
+
+//! Stack size for the CONTROL_SERVER thread
+#define CONTROL_SERVER_STACK_SIZE 4096
+//! CONTROL_SERVER thread priority level (lower than the can controller and udp client)
+#define CONTROL_SERVER_PRIORITY 8
+//! Max size of a command datagram
+#define CONTROL_COMMAND_MAX_SIZE 160
+//! Time in miliseconds between two checks of the wifi connection
+#define CONTROL_SERVER_WAIT_IP_MS 500
+//! Flash partition of the NVS file system keeping the counter
+#define CONTROL_NVS_PARTITION storage_partition
+//! Number of flash sectors of the NVS file system
+#define CONTROL_NVS_SECTOR_COUNT 3
+//! NVS id of the counter of the last accepted command
+#define CONTROL_NVS_COUNTER_ID 1
+
+//control command types
+#define CONTROL_CMD_LIVE	1		//live <channel> on|off
+#define CONTROL_CMD_RATE	2		//rate <frames per second>
+#define CONTROL_CMD_LOG		3		//log start|stop
+#define CONTROL_CMD_SCHEMA	4		//schema
+
+/*! @brief command of the base station, checked before its counter is stored
+    @param type type of command (CONTROL_CMD_x)
+    @param start start the logs (CONTROL_CMD_LOG)
+    @param live live configuration change (CONTROL_CMD_LIVE and CONTROL_CMD_RATE)
+*/
+typedef struct sControlCommand{
+    uint8_t type;
+    bool start;
+    tLiveControl live;
+}tControlCommand;
+
+//! Control Server stack definition
+K_THREAD_STACK_DEFINE(CONTROL_SERVER_STACK, CONTROL_SERVER_STACK_SIZE);
+//! Variable to identify the Control Server thread
+static struct k_thread controlServerThread;
+
+//! counter of the last accepted command (kept in NVS across reboots)
+static uint64_t lastCounter;
+//! NVS file system of the counter
+static struct nvs_fs controlNvs;
+
+//static functions prototypes
+
+/*! @brief check the authentication of a command */
+static bool control_authenticate(const char * hmacHex, const char * body);
+/*! @brief parse and check a command */
+static int control_parse(char * command, tControlCommand * cmd);
+/*! @brief execute a command */
+static int control_execute(const tControlCommand * cmd, const char ** reason);
+/*! @brief mount the NVS and read the counter of the last accepted command */
+static int control_counter_init(void);
+
+
+//-----------------------------------------------------------------------------------------------------------------------
+/*! Control_Server implements the Control Server task
+* @brief Control_Server receives the commands of the base station, checks
+*        their authentication and applies them
+*/
+void Control_Server()
+{
+	// stop the thread until a DHCP IP is assigned to the board 
+	while(!context.ip_assigned)
+		k_msleep(CONTROL_SERVER_WAIT_IP_MS);
+
+	//server socket creation
+	int controlSocket = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+	if(controlSocket < 0)
+	{
+		LOG_ERR("Control server error: socket: %d\n", errno);
+		return;
+	}
+
+	struct sockaddr_in localAddress = {
+		.sin_family = AF_INET,
+		.sin_port = htons(configFile.ControlPort),
+		.sin_addr.s_addr = htonl(INADDR_ANY)
+	};
+
+	if(bind(controlSocket, (struct sockaddr *)&localAddress, sizeof(localAddress)) < 0)
+	{
+		LOG_ERR("Control server error: bind: %d\n", errno);
+		close(controlSocket);
+		return;
+	}
+	LOG_INF("Control server listening on port %d", configFile.ControlPort);
+
+	while(true)	// --------------------------------------------------------------------Thread infinite loop
+	{
+		char command[CONTROL_COMMAND_MAX_SIZE+1];		//received command
+		char reply[64];									//reply to the base station
+		struct sockaddr_in clientAddress;
+		socklen_t clientAddressLength = sizeof(clientAddress);
+
+		int len = recvfrom(controlSocket, command, CONTROL_COMMAND_MAX_SIZE, 0, (struct sockaddr *)&clientAddress, &clientAddressLength);
+		if(len <= 0)
+			continue;
+		command[len] = '\0';
+
+		//split "<hmac> <counter> <command>"
+		char * body = strchr(command,' ');
+		if(body == NULL)
+			continue;
+		*body++ = '\0';
+
+		uint64_t counter = strtoull(body, NULL, 10);
+		char * text = strchr(body,' ');
+		tControlCommand cmd = {0};
+		const char * reason = NULL;
+
+		if(!control_authenticate(command, body))		//wrong key or modified command
+		{
+			LOG_ERR("Control server : authentication failed");
+			reason = "auth";
+		}
+		else if(counter <= lastCounter)			//replayed command
+		{
+			reason = "counter";
+		}
+		else if(text == NULL || control_parse(text+1, &cmd) != 0)		//unknown command, the counter is not used
+		{
+			reason = "command";
+		}
+		else if(nvs_write(&controlNvs, CONTROL_NVS_COUNTER_ID, &counter, sizeof(counter)) < 0)		//stored before the command is applied
+		{
+			LOG_ERR("Control server : counter not stored");
+			reason = "store";
+		}
+		else
+		{
+			lastCounter = counter;
+
+			if(control_execute(&cmd, &reason) != 0)
+				reason = reason != NULL ? reason : "command";
+		}
+
+		if(reason == NULL)
+			snprintf(reply, sizeof(reply), "OK %llu", (unsigned long long)counter);
+		else
+			snprintf(reply, sizeof(reply), "ERR %llu %s", (unsigned long long)counter, reason);
+
+		sendto(controlSocket, reply, strlen(reply), 0, (struct sockaddr *)&clientAddress, clientAddressLength);
+	}	// ------------------------------------------------------------------------------  end of thread infinite loop
+}
+
+//-----------------------------------------------------------------------------------------------------------------------
+/*! @brief check the HMAC-SHA256 of a command with the key of the config file
+*   @param hmacHex received HMAC (hex string)
+*   @param body authenticated part of the command
+*   @retval true if the command is authentic
+*/
+static bool control_authenticate(const char * hmacHex, const char * body)
+{
+	struct tc_hmac_state_struct hmac;
+	uint8_t digest[TC_SHA256_DIGEST_SIZE];
+
+	if(strlen(hmacHex) != 2*TC_SHA256_DIGEST_SIZE)
+		return false;
+
+	if(tc_hmac_set_key(&hmac, (const uint8_t *)configFile.ControlKey, strlen(configFile.ControlKey)) != TC_CRYPTO_SUCCESS ||
+	   tc_hmac_init(&hmac) != TC_CRYPTO_SUCCESS ||
+	   tc_hmac_update(&hmac, body, strlen(body)) != TC_CRYPTO_SUCCESS ||
+	   tc_hmac_final(digest, sizeof(digest), &hmac) != TC_CRYPTO_SUCCESS)
+		return false;
+
+	uint8_t diff = 0;
+	for(int i=0; i<TC_SHA256_DIGEST_SIZE; i++)		//compare all bytes (constant time)
+	{
+		char byteHex[3] = { hmacHex[2*i], hmacHex[2*i+1], '\0' };
+		diff |= digest[i] ^ (uint8_t)strtoul(byteHex, NULL, 16);
+	}
+
+	return diff == 0;
+}
+
+//-----------------------------------------------------------------------------------------------------------------------
+/*! @brief parse and check a command, only the exact arguments are accepted
+*   @param command command and arguments (split in place)
+*   @param cmd parsed command (set on success)
+*   @retval 0 on success
+*   @retval -EINVAL unknown command or wrong arguments
+*/
+static int control_parse(char * command, tControlCommand * cmd)
+{
+	char * save;
+	char * name = strtok_r(command, " ", &save);
+	char * arg1 = strtok_r(NULL, " ", &save);
+	char * arg2 = strtok_r(NULL, " ", &save);
+
+	if(name == NULL || strtok_r(NULL, " ", &save) != NULL)		//no command or too many arguments
+		return -EINVAL;
+
+	if(strcmp(name,"live") == 0 && arg1 != NULL && arg2 != NULL)		//live <channel> on|off
+	{
+		if(strcmp(arg2,"on") != 0 && strcmp(arg2,"off") != 0)
+			return -EINVAL;
+		cmd->type = CONTROL_CMD_LIVE;
+		cmd->live.type = LIVE_CTRL_CHANNEL;
+		cmd->live.enable = strcmp(arg2,"on") == 0;
+		strncpy(cmd->live.name, arg1, sizeof(cmd->live.name)-1);
+		return 0;
+	}
+
+	if(strcmp(name,"rate") == 0 && arg1 != NULL && arg2 == NULL)		//rate <frames per second>
+	{
+		char * end;
+		long rate = strtol(arg1, &end, 10);
+		if(*end != '\0')
+			return -EINVAL;
+		cmd->type = CONTROL_CMD_RATE;
+		cmd->live.type = LIVE_CTRL_RATE;
+		cmd->live.value = (int)rate;
+		return 0;
+	}
+
+	if(strcmp(name,"log") == 0 && arg1 != NULL && arg2 == NULL)		//log start|stop
+	{
+		if(strcmp(arg1,"start") != 0 && strcmp(arg1,"stop") != 0)
+			return -EINVAL;
+		cmd->type = CONTROL_CMD_LOG;
+		cmd->start = strcmp(arg1,"start") == 0;
+		return 0;
+	}
+
+	if(strcmp(name,"schema") == 0 && arg1 == NULL)					//schema
+	{
+		cmd->type = CONTROL_CMD_SCHEMA;
+		return 0;
+	}
+
+	return -EINVAL;
+}
+
+//-----------------------------------------------------------------------------------------------------------------------
+/*! @brief execute a command
+*   @param cmd command checked by control_parse
+*   @param reason reason of the error (set on error)
+*   @retval 0 on success
+*/
+static int control_execute(const tControlCommand * cmd, const char ** reason)
+{
+	int ret;
+
+	switch(cmd->type)
+	{
+	case CONTROL_CMD_LIVE:
+		ret = data_Sender_control(&cmd->live);
+		if(ret == -ENOENT)
+			*reason = "channel";
+		return ret;
+
+	case CONTROL_CMD_RATE:
+		ret = data_Sender_control(&cmd->live);
+		if(ret == -EINVAL)
+			*reason = "rate";
+		return ret;
+
+	case CONTROL_CMD_LOG:
+		ret = sendLogButton(cmd->start);
+		if(ret != 0)
+			*reason = "can";
+		return ret;
+
+	case CONTROL_CMD_SCHEMA:
+		data_Sender_schema_request();
+		return 0;
+
+	default:
+		return -EINVAL;
+	}
+}
+
+//-----------------------------------------------------------------------------------------------------------------------
+/*! @brief mount the NVS file system and read the counter of the last
+*		  accepted command, so that the commands captured before a reboot
+*		  cannot be replayed
+*   @retval 0 on success (counter 0 if no command was ever accepted)
+*/
+static int control_counter_init(void)
+{
+	struct flash_pages_info info;
+	int ret;
+
+	controlNvs.flash_device = FIXED_PARTITION_DEVICE(CONTROL_NVS_PARTITION);
+	if(!device_is_ready(controlNvs.flash_device))
+		return -ENODEV;
+
+	controlNvs.offset = FIXED_PARTITION_OFFSET(CONTROL_NVS_PARTITION);
+	ret = flash_get_page_info_by_offs(controlNvs.flash_device, controlNvs.offset, &info);
+	if(ret != 0)
+		return ret;
+
+	controlNvs.sector_size = info.size;
+	controlNvs.sector_count = CONTROL_NVS_SECTOR_COUNT;
+
+	ret = nvs_mount(&controlNvs);
+	if(ret != 0)
+		return ret;
+
+	lastCounter = 0;
+	ret = nvs_read(&controlNvs, CONTROL_NVS_COUNTER_ID, &lastCounter, sizeof(lastCounter));
+	if(ret == -ENOENT)		//no command accepted yet
+		return 0;
+
+	return ret == sizeof(lastCounter) ? 0 : -EIO;
+}
+
+//-----------------------------------------------------------------------------------------------------------------------
+/*! Task_Control_Server_Init initializes the task Control Server
+*
+* @brief Control Server initialization. The task is not started if no
+*        control port is set in the config file, or if the counter of
+*        the replay protection cannot be kept in the flash
+*/
+void Task_Control_Server_Init( void )
+{
+	if(configFile.ControlPort <= 0 || configFile.ControlKey == NULL || strlen(configFile.ControlKey) == 0)
+	{
+		LOG_INF("Control server disabled");
+		return;
+	}
+
+	int ret = control_counter_init();
+	if(ret != 0)
+	{
+		LOG_ERR("Control server disabled : counter storage error %d", ret);
+		return;
+	}
+	LOG_INF("Control server : last counter %llu", (unsigned long long)lastCounter);
+
+	k_thread_create	(&controlServerThread,
+					CONTROL_SERVER_STACK,
+					CONTROL_SERVER_STACK_SIZE,
+					(k_thread_entry_t)Control_Server,
+					NULL,
+					NULL,
+					NULL,
+					CONTROL_SERVER_PRIORITY,
+					0,
+					K_NO_WAIT);
+
+	 k_thread_name_set(&controlServerThread, "controlServer");
+	 k_thread_start(&controlServerThread);
+}
@@ -0,0 +1,63 @@
+/*! --------------------------------------------------------------------
+ *	Telemetry System	-	@file control_server.h
+ *----------------------------------------------------------------------
+ * HES-SO Valais Wallis 
+ * Systems Engineering
+ * Infotronics
+ * ---------------------------------------------------------------------
+ * @author agent
+ * @date 19.10.2026
+ * ---------------------------------------------------------------------
+ * @brief Control server task receives the commands of the base station
+ *        on a UDP port and changes the live configuration at runtime
+ * ---------------------------------------------------------------------
+ * Telemetry system for the Valais Wallis Racing Team.
+ * This file contains code for the onboard device of the telemetry
+ * system. The system receives the data from the sensors on the CAN bus 
+ * and the data from the GPS on a UART port. An SD Card contains a 
+ * configuration file with all the system parameters. The measurements 
+ * are sent via Wi-Fi to a computer on the base station. The measurements 
+ * are also saved in a CSV file on the SD card. 
+ *--------------------------------------------------------------------*/
+
+#ifndef __CONTROL_SERVER_H
+#define __CONTROL_SERVER_H
+
+/*
+ * Command datagram (text) :  <hmac> <counter> <command> [arguments]
+ *
+ *  - hmac     : HMAC-SHA256 of "<counter> <command> [arguments]" with the
+ *               ControlKey of the config file, 64 hex characters
+ *  - counter  : decimal number, must be higher than the counter of the 
+ *               last accepted command (replay protection). The device
+ *               keeps this counter in the flash, it is not reset by a
+ *               reboot of the car, so the base station must never reuse
+ *               or lower its counter, also across its own restarts : the
+ *               current time in milliseconds since 1970 is a valid counter
+ *  - commands : live <channel name> on|off   enable or disable a live channel
+ *               rate <frames per second>      change the live frame rate
+ *               log start|stop                start or stop the logs
+ *               schema                        send the schema and a keyframe
+ *
+ * Reply datagram : "OK <counter>" or "ERR <counter> <reason>"
+ *                  reason = auth, counter (not higher than the last one),
+ *                  store (counter not saved, command not applied),
+ *                  channel, rate, can or command (unknown command
+ *                  or arguments other than exactly on/off or start/stop,
+ *                  the counter is not used and can be sent again)
+ */
+
+/*! Control_Server implements the Control Server task
+* @brief Control_Server receives the commands of the base station, checks
+*        their authentication and applies them
+*/
+void Control_Server();
+
+/*! Task_Control_Server_Init initializes the task Control Server
+*
+* @brief Control Server initialization. The task is not started if no
+*        control port is set in the config file
+*/
+void Task_Control_Server_Init( void );
+
+#endif /*__CONTROL_SERVER_H*/
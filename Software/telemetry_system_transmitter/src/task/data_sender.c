@@ -26,7 +26,10 @@ LOG_MODULE_REGISTER(sender);
 #include <zephyr/kernel.h>
 #include <errno.h>
 #include <stdio.h>
+#include <string.h>
 #include <zephyr/data/json.h>
+#include <zephyr/sys/crc.h>
+#include <zephyr/sys/byteorder.h>
 
 //project file includes
 #include "data_sender.h"
@@ -34,6 +37,9 @@ LOG_MODULE_REGISTER(sender);
 #include "config_read.h"
 //#include "data_logger.h"
 #include "deviceInformation.h"
+#include "live_protocol.h"
+#include "live_spool.h"
+#include "time_sync.h"
 
 //periodic timer that reads the measurements 
 K_TIMER_DEFINE(dataSenderTimer, data_Sender_timer_handler,NULL);
@@ -41,11 +47,214 @@ K_TIMER_DEFINE(dataSenderTimer, data_Sender_timer_handler,NULL);
 //work for process triggerd by timer interruption
 K_WORK_DEFINE(dataSendWork, Data_Sender);		//dataSendWork -> called by timer to send data
 
-int udpQueueMesLength;		//max length of the json string
+//live configuration changes requested by the control server
+K_MSGQ_DEFINE(liveControlQueue, sizeof(tLiveControl), 8, 4);
+
+//events of the lap timer waiting to be sent
+K_MSGQ_DEFINE(lapEventQueue, sizeof(tLapEvent), 4, 8);
+
+//name of the live class of the diagnostic channels (not sent if the config file has no class of this name)
+#define LIVE_DIAGNOSTIC_CLASS "Diagnostics"
+//number of link statistics channels
+#define LIVE_LINK_CHANNEL_COUNT 7
+//number of clock synchronisation channels
+#define LIVE_CLOCK_CHANNEL_COUNT 4
+//number of statistics channels per server
+#define LIVE_SERVER_CHANNEL_COUNT 3
+//number of wifi channels
+#define LIVE_WIFI_CHANNEL_COUNT 5
+//number of gps statistics channels
+#define LIVE_GPS_CHANNEL_COUNT 4
+//max number of channels in the live transmission (sensors + gps coord, speed, fix + log recording + link statistics + clock + servers + wifi + gps statistics + live level)
+#define MAX_LIVE_CHANNELS (MAX_SENSORS+4+LIVE_LINK_CHANNEL_COUNT+LIVE_CLOCK_CHANNEL_COUNT+LIVE_SERVER_CHANNEL_COUNT*MAX_SERVERS+LIVE_WIFI_CHANNEL_COUNT+LIVE_GPS_CHANNEL_COUNT+1)
+//max number of fragments of the live schema
+#define MAX_SCHEMA_FRAGMENTS 64
+//default period of the schema announcement (seconds)
+#define DEFAULT_SCHEMA_PERIOD 5
+//default depth of the udp queue
+#define DEFAULT_QUEUE_DEPTH 8
+//default depth of the retransmit history
+#define DEFAULT_HISTORY_DEPTH 8
+//default number of spooled messages sent per second on reconnection
+#define DEFAULT_BACKFILL_RATE 10
+//default number of packets between two keyframes in the delta format
+#define DEFAULT_KEYFRAME_PERIOD 20
+//evaluation period of the link quality
+#define LIVE_ADAPT_PERIOD_MS 1000
+//consecutive bad periods before the live transmission is reduced
+#define LIVE_ADAPT_DEGRADE_COUNT 2
+//consecutive good periods before the live transmission is restored
+#define LIVE_ADAPT_RESTORE_COUNT 5
+//rssi above LiveAdaptRssi needed to restore the live transmission (dB)
+#define LIVE_ADAPT_RSSI_HYSTERESIS 5
+//min period of the data sender timer with live classes (ms)
+#define LIVE_TICK_MIN_MS 5
+//all channels of the sample (full packet)
+#define LIVE_CLASS_ALL -1
+//max size of the values of all channels in a binary packet
+#define MAX_LIVE_VALUES_SIZE (MAX_LIVE_CHANNELS*4 + 4)		//coordinates are 8 bytes
+
+//sources of the live channel values
+#define LIVE_SRC_SENSOR			0
+#define LIVE_SRC_GPS_COORD		1
+#define LIVE_SRC_GPS_SPEED		2
+#define LIVE_SRC_GPS_FIX		3
+#define LIVE_SRC_LOG_RECORDING	4
+#define LIVE_SRC_LINK_ENQUEUED	5
+#define LIVE_SRC_LINK_SENT		6
+#define LIVE_SRC_LINK_DROPPED	7
+#define LIVE_SRC_LINK_LATENCY	8
+#define LIVE_SRC_LINK_SPOOL		9
+#define LIVE_SRC_LINK_RETRANSMIT	10
+#define LIVE_SRC_LINK_RETRANSMIT_MISSED	11
+#define LIVE_SRC_CLOCK_SOURCE		12
+#define LIVE_SRC_CLOCK_DELAY		13
+#define LIVE_SRC_CLOCK_CORRECTION	14
+#define LIVE_SRC_CLOCK_DRIFT		15
+#define LIVE_SRC_SERVER_UP			16
+#define LIVE_SRC_SERVER_ERRORS		17
+#define LIVE_SRC_SERVER_LATENCY		18
+#define LIVE_SRC_WIFI_RSSI			19
+#define LIVE_SRC_WIFI_NETWORK		20
+#define LIVE_SRC_WIFI_ROAMS			21
+#define LIVE_SRC_WIFI_OUTAGE		22
+#define LIVE_SRC_WIFI_RECONNECT		23
+#define LIVE_SRC_LIVE_LEVEL			24
+#define LIVE_SRC_GPS_RATE			25
+#define LIVE_SRC_GPS_CPU			26
+#define LIVE_SRC_GPS_ERRORS			27
+#define LIVE_SRC_GPS_OVERRUNS		28
+
+/*! @brief live channel struct
+    @param name name of the channel in the live transmission
+    @param unit unit of the channel (empty string if not set)
+    @param type type of the value (LIVE_CH_x)
+    @param source source of the value (LIVE_SRC_x)
+    @param index index in the sensor buffer (LIVE_SRC_SENSOR) or index of the server (LIVE_SRC_SERVER_x)
+    @param liveClass index of the live class of the channel (LIVE_CLASS_DEFAULT for the default stream)
+*/
+typedef struct sLiveChannel{
+    const char * name;
+    const char * unit;
+    uint8_t type;
+    uint8_t source;
+    uint16_t index;
+    uint8_t liveClass;
+}tLiveChannel;
+
+static tLiveChannel liveChannels[MAX_LIVE_CHANNELS];	//channels of the live transmission
+static char serverChannelNames[MAX_SERVERS][LIVE_SERVER_CHANNEL_COUNT][20];	//names of the server statistics channels
+static int liveChannelCount;							//number of channels
+static int classChannelCount[MAX_LIVE_CLASSES];			//number of channels of each live class
+
+static uint32_t schemaHash;									//CRC32 of the channel descriptors
+static uint16_t schemaFragmentFirst[MAX_SCHEMA_FRAGMENTS+1];	//first channel of each schema fragment
+static int schemaFragmentCount;								//number of schema fragments
+
+static bool liveBinary;				//binary live format selected
+static bool liveDelta;				//delta frames in the binary format
+static atomic_t schemaRequest;		//schema announcement requested by the udp client
+static int schemaPeriodTicks;		//schema period in number of sends
+static int schemaTickCounter;		//sends since last schema announcement
+
+static int udpQueueDepth;			//max number of messages in the udp queue
+
+static bool spoolEnable;			//keep samples while the wifi is lost
+static int spoolPeriodTicks;		//spool period in number of sends
+static int spoolTickCounter;		//sends since last spooled sample
+static int backfillTicks;			//sends between two backfill bursts
+static int backfillBurst;			//spooled messages sent per burst
+static int backfillTickCounter;		//sends since last backfill burst
+
+static int liveRate;				//current frame rate (LiveFrameRate, LiveAdaptRate when the link is poor)
+static int liveTick;				//period of the timer (ms), divisor of the default stream and class periods
+static int mainTicks;				//default stream period in number of ticks
+static int mainTickCounter;			//ticks since last default stream sample
+static int classTicks[MAX_LIVE_CLASSES];		//class periods in number of ticks
+static int classTickCounter[MAX_LIVE_CLASSES];	//ticks since last sample of each class
+static int liveLevel;				//reduction of the live transmission (0 = full, 1 = reduced rate, 2.. = reduced rate and priority channels)
+static int liveLevelMax;			//max reduction level (0 = adaptation disabled)
+static int64_t adaptLast;			//uptime of the last link quality evaluation
+static int adaptBadCount;			//consecutive periods with a bad link
+static int adaptGoodCount;			//consecutive periods with a good link
+static uint32_t adaptEnqueued;		//enqueued messages at the last evaluation
+static uint32_t adaptLost;			//lost messages at the last evaluation
+
+static uint32_t liveSequence;		//sequence number of the current sample
+static uint32_t prioritySequence;	//sequence number of the next sample of the priority classes (without LIVE_SEQUENCE_PRIORITY)
+static int64_t liveTime;			//synchronised time of the current sample (µs since 1970, 0 if not synchronised)
+
+static atomic_t keyframeRequest;		//keyframe requested by the udp client
+static int keyframePeriodTicks;			//keyframe period in number of sends
+static int keyframeTickCounter;			//sends since last keyframe
+static uint32_t keyframeSequence;		//sequence number of the last keyframe
+static uint8_t keyframeValues[MAX_LIVE_VALUES_SIZE];				//values of the last keyframe
+static uint16_t keyframeOffset[MAX_LIVE_CHANNELS+1];				//position of the channels in keyframeValues
+static uint8_t currentValues[MAX_LIVE_VALUES_SIZE];					//values of the current sample
+static uint16_t currentOffset[MAX_LIVE_CHANNELS+1];					//position of the channels in currentValues
+
+int udpQueueMesLength;		//max length of the live messages
+int udpHistoryDepth;		//number of sent messages kept for retransmission
+tLinkStats linkStats;		//live link statistics
 uint8_t keepAliveCounter;	//keepalive counter
 
 bool logEnable;
 
+//static functions prototypes
+
+/*! @brief fill the live channel table and compute the schema hash and fragments */
+static void live_schema_init(void);
+/*! @brief add the diagnostic channels to the live channel table */
+static void live_diagnostics_init(void);
+/*! @brief size of the descriptor of a channel in the schema */
+static int live_descriptor_size(const tLiveChannel * ch);
+/*! @brief put the schema fragments in the udp queue */
+static void live_send_schema(void);
+/*! @brief write the live json string of the current values */
+static int live_encode_json(char * buf, int size, int liveClass);
+/*! @brief write the header of a binary packet */
+static int live_encode_header(uint8_t * buf, uint8_t type);
+/*! @brief write the binary values of all channels or of one class */
+static int live_encode_values(uint8_t * buf, uint16_t * offset, int liveClass);
+/*! @brief write the binary data packet of the current values */
+static int live_encode_binary(uint8_t * buf);
+/*! @brief write the keyframe or the delta packet of the current values */
+static int live_encode_delta(uint8_t * buf);
+/*! @brief write the class packet of the current values */
+static int live_encode_class(uint8_t * buf, int liveClass);
+/*! @brief put the samples of the live classes that are due in the udp queue */
+static void live_classes_send(void);
+/*! @brief index of a live class in the config file */
+static uint8_t live_class(const char * name);
+/*! @brief send period of a live class at the current level */
+static int live_class_period(int liveClass);
+/*! @brief get a message block from the slab */
+static tUdpMessage * live_message_alloc(void);
+/*! @brief put a message in the udp queue */
+static void live_message_put(tUdpMessage * msg);
+/*! @brief drop the oldest message of a udp queue */
+static bool live_message_drop_oldest(struct k_msgq * queue);
+/*! @brief compute the periods that depend on the frame rate */
+static void live_rates_init(void);
+/*! @brief set the frame rate of the current level and restart the timer */
+static void live_rate_apply(void);
+/*! @brief evaluate the link quality and adapt the live transmission */
+static void live_adapt(void);
+/*! @brief change the reduction level of the live transmission */
+static void live_level_set(int level, int rssi, int loss);
+/*! @brief position of a channel in the priority order */
+static int live_priority(const char * name);
+/*! @brief apply the pending live configuration changes */
+static void live_control_apply(void);
+/*! @brief send the pending events of the lap timer */
+static void live_send_laps(void);
+/*! @brief put the current sample in the spool */
+static void live_spool_sample(void);
+/*! @brief put spooled messages back in the udp queue */
+static void live_backfill(void);
+/*! @brief value of a link statistics or clock channel */
+static uint32_t live_link_value(uint8_t source, int index);
+
 //-----------------------------------------------------------------------------------------------------------------------
 /*! data_Sender_timer_handler is called by the timer interrupt
 * @brief data_Sender_timer_handler submit a new work that call Data_Sender task     
@@ -55,80 +264,1110 @@ void data_Sender_timer_handler()
     k_work_submit(&dataSendWork);
 }
 
+//-----------------------------------------------------------------------------------------------------------------------
+/*! data_Sender_schema_request is called by the udp client
+* @brief data_Sender_schema_request sends the live schema and a keyframe 
+*        with the next data packet
+*/
+void data_Sender_schema_request()
+{
+	atomic_set(&schemaRequest,1);
+	atomic_set(&keyframeRequest,1);
+}
+
+//-----------------------------------------------------------------------------------------------------------------------
+/*! data_Sender_spool is called by the udp client while the wifi is lost
+* @brief data_Sender_spool keeps a message of the udp queue in the spool
+*        and releases its block. Only the messages that are decoded alone
+*        are kept : json samples, data, class and lap packets. A delta
+*        frame needs its keyframe and a schema fragment is announced again
+*        after the outage, they would only use the spool and the backfill
+* @param msg message taken from the udp queue
+*/
+void data_Sender_spool(tUdpMessage * msg)
+{
+	const tLiveHeader * header = (const tLiveHeader *)msg->data;
+	bool binary = msg->length >= sizeof(tLiveHeader) && sys_le16_to_cpu(header->magic) == LIVE_MAGIC;
+	bool alone = !binary || header->type == LIVE_PKT_DATA || header->type == LIVE_PKT_CLASS || header->type == LIVE_PKT_LAP;
+
+	if(spoolEnable && alone)
+		atomic_add(&linkStats.dropped,live_spool_put(msg->data,msg->length));		//oldest spooled messages dropped if spool is full
+	else
+		atomic_inc(&linkStats.dropped);		//message lost
+
+	k_mem_slab_free(&messageSlab,(void **)&msg);		//release the block allocated in data sender
+}
+
+//-----------------------------------------------------------------------------------------------------------------------
+/*! data_Sender_control is called by the control server
+* @brief data_Sender_control queues a live configuration change. The change
+*        is applied by the data sender before the next sample, so the
+*        schema of a packet is always consistent
+* @param ctrl requested change
+* @retval 0 on success, -ENOENT if the channel is unknown, -EINVAL if the 
+*         rate is invalid, -EAGAIN if too many changes are pending
+*/
+int data_Sender_control(const tLiveControl * ctrl)
+{
+	if(ctrl->type == LIVE_CTRL_CHANNEL)		//check that the channel exists (names are not modified after init)
+	{
+		bool found = false;
+
+		for(int i=0; i<configFile.sensorCount; i++)
+			found |= (sensorBuffer[i].name_wifi != NULL) && (strcmp(sensorBuffer[i].name_wifi,ctrl->name) == 0);
+
+		found |= (gpsBuffer.NameLiveCoord != NULL) && (strcmp(gpsBuffer.NameLiveCoord,ctrl->name) == 0);
+		found |= (gpsBuffer.NameLiveSpeed != NULL) && (strcmp(gpsBuffer.NameLiveSpeed,ctrl->name) == 0);
+		found |= (gpsBuffer.NameLiveFix != NULL) && (strcmp(gpsBuffer.NameLiveFix,ctrl->name) == 0);
+
+		if(!found)
+			return -ENOENT;
+	}
+	else if(ctrl->type == LIVE_CTRL_RATE)
+	{
+		if(ctrl->value <= 0 || ctrl->value > 1000)
+			return -EINVAL;
+	}
+	else
+	{
+		return -EINVAL;
+	}
+
+	return k_msgq_put(&liveControlQueue,ctrl,K_NO_WAIT) == 0 ? 0 : -EAGAIN;
+}
+
+//-----------------------------------------------------------------------------------------------------------------------
+/*! data_Sender_lap_event is called by the gps controller
+* @brief data_Sender_lap_event queues an event of the lap timer, it is sent
+*        in a priority message at the next tick of the data sender. While
+*        the wifi is lost, the first events are kept until it is back
+* @param event event of the lap timer
+*/
+void data_Sender_lap_event(const tLapEvent * event)
+{
+	if(k_msgq_put(&lapEventQueue,event,K_NO_WAIT) != 0)
+		LOG_WRN("lap event dropped");
+}
+
 //-----------------------------------------------------------------------------------------------------------------------
 /*! Data_Sender implements the Data_Sender task
 * @brief Data_Sender reads the data in the sensor buffer array and
-*        creates the json string to send via Wi-Fi to the base 
-*        station. This string is placed in the UDP_Client queue.
+*        creates the json string or the binary packet to send via 
+*        Wi-Fi to the base station. This message is placed in the 
+*        UDP_Client queue. With live classes, the timer runs at a common
+*        divisor of the periods and every class is sent when it is due, 
+*        the channels without class are sent in the default stream.
 */
 void Data_Sender() 
 {
+	live_control_apply();		//runtime configuration changes
+
+	liveTime = time_sync_now();		//timestamp of the sample
+
+	bool mainDue = mainTickCounter==0;		//default stream sample (every tick without live classes)
+	mainTickCounter = mainTickCounter<(mainTicks-1) ? mainTickCounter+1 : 0;
+
 	if(context.ip_assigned)
 	{
-		char * memPtr = k_heap_alloc(&messageHeap,udpQueueMesLength,K_NO_WAIT);		//memory allocation for message string
+		live_adapt();		//reduce or restore the live transmission with the link quality
 
-		if(memPtr != NULL)			//memory alloc success
+		if(liveBinary)		//announce the schema on request and periodically
 		{
-			sprintf(memPtr,"{");	// open json section
+			if(atomic_cas(&schemaRequest,1,0) || (mainDue && schemaTickCounter==0))
+				live_send_schema();
+
+			if(mainDue)
+				schemaTickCounter = schemaTickCounter<(schemaPeriodTicks-1) ? schemaTickCounter+1 : 0;
+		}
 
-			k_mutex_lock(&sensorBufferMutex,K_FOREVER);		//lock sensor buffer mutex
+		live_send_laps();			//lap events first, they are sent once
+		live_classes_send();		//classes that are due, before the default stream
 
-			for(int i=0; i<configFile.sensorCount;i++)	//loop for every sensor
+		if(mainDue)
+		{
+			tUdpMessage * msg = live_message_alloc();		//message block from the slab
+
+			if(msg != NULL)			//memory alloc success
 			{
-				if(sensorBuffer[i].wifi_enable)
-				{
-					//print name and value in json string
-					if(i==0)
-						sprintf(memPtr,"%s\"%s\":%u",memPtr,sensorBuffer[i].name_wifi,sensorBuffer[i].value);		
-					else
-						sprintf(memPtr,"%s,\"%s\":%u",memPtr,sensorBuffer[i].name_wifi,sensorBuffer[i].value);
-				}
+				if(configFile.liveClassCount > 0)
+					msg->length = liveBinary ? live_encode_class(msg->data,LIVE_CLASS_DEFAULT) : live_encode_json((char*)msg->data,udpQueueMesLength,LIVE_CLASS_DEFAULT);
+				else if(liveDelta)
+					msg->length = live_encode_delta(msg->data);
+				else if(liveBinary)
+					msg->length = live_encode_binary(msg->data);
+				else
+					msg->length = live_encode_json((char*)msg->data,udpQueueMesLength,LIVE_CLASS_ALL);
+
+				msg->flags = UDP_MSG_RETRANSMIT;		//sample can be sent again on NACK
+				live_message_put(msg);		//add message to the queue
 			}
+			else					 //memory alloc fail
+			{
+				LOG_ERR("data sender memory allocation failed");	//print error
+			}	
 
-			k_mutex_unlock(&sensorBufferMutex);				//unlock sensor buffer mutex
+			live_backfill();		//send spooled messages after the current sample
+		}
+	}
+	else if(spoolEnable && mainDue)		//keep some samples while the wifi is lost
+	{
+		if(spoolTickCounter==0)
+			live_spool_sample();
 
-			k_mutex_lock(&gpsBufferMutex,K_FOREVER);		//lock gps buffer mutex
-			
-			if(gpsBuffer.LiveCoordEnable)
-				sprintf(memPtr,"%s,\"%s\":\"%s\"",memPtr,gpsBuffer.NameLiveCoord,gpsBuffer.coord);
-			
-			if(gpsBuffer.LiveSpeedEnable)
-				sprintf(memPtr,"%s,\"%s\":%s",memPtr,gpsBuffer.NameLiveSpeed,gpsBuffer.speed);
+		spoolTickCounter = spoolTickCounter<(spoolPeriodTicks-1) ? spoolTickCounter+1 : 0;
+	}
+	
+	if(mainDue)
+	{
+		liveSequence++;		//next sample
 
-			if(gpsBuffer.LiveFixEnable && gpsBuffer.fix)
-				sprintf(memPtr,"%s,\"%s\":true",memPtr,gpsBuffer.NameLiveFix);
+		keepAliveCounter = keepAliveCounter<99 ? keepAliveCounter+1 : 0 ;		//increment keepalive
+	}
+}
 
-			if(gpsBuffer.LiveFixEnable && !gpsBuffer.fix)
-				sprintf(memPtr,"%s,\"%s\":false",memPtr,gpsBuffer.NameLiveFix);
+//-----------------------------------------------------------------------------------------------------------------------
+/*! @brief put the samples of the live classes that are due in the udp queue.
+*		  Every class sample has its own sequence number, the samples of 
+*		  the priority classes go to the priority queue. They skip ahead of
+*		  the queued samples, so they are numbered in their own sequence
+*		  space and do not make gaps in the sequence of the other samples
+*/
+static void live_classes_send(void)
+{
+	for(int c=0; c<configFile.liveClassCount; c++)		//loop for every class
+	{
+		bool due = classTickCounter[c]==0;
+		classTickCounter[c] = classTickCounter[c]<(classTicks[c]-1) ? classTickCounter[c]+1 : 0;
 
-			k_mutex_unlock(&gpsBufferMutex);				//unlock gps buffer mutex
+		if(!due || classChannelCount[c]==0)		//not due or no channel enabled in the class
+			continue;
 
+		bool priority = configFile.LiveClasses[c].Priority;
+		uint32_t sequence = liveSequence;		//sequence of the other samples
 
-			sprintf(memPtr,"%s,\"KeepAliveCounter\":%d",memPtr,keepAliveCounter);		//print keepalive counter in json
-			
-			
-			if(logEnable)													//print log recording variable in json
-				sprintf(memPtr,"%s,\"LogRecordingSD\":true",memPtr);
-			else
-				sprintf(memPtr,"%s,\"LogRecordingSD\":false",memPtr) ;	
+		if(priority)		//current sample numbered in the priority sequence space
+			liveSequence = LIVE_SEQUENCE_PRIORITY | prioritySequence;
 
-			
+		tUdpMessage * msg = live_message_alloc();		//message block from the slab
 
-			strcat(memPtr,"}");		//close json section
-			
-			k_queue_append(&udpQueue,memPtr);		//add message to the queue
+		if(msg == NULL)			//memory alloc fail
+		{
+			liveSequence = sequence;
+			LOG_ERR("class memory allocation failed");
+			return;
+		}
+
+		msg->length = liveBinary ? live_encode_class(msg->data,c) : live_encode_json((char*)msg->data,udpQueueMesLength,c);
+		msg->flags = UDP_MSG_RETRANSMIT;		//sample can be sent again on NACK
+		if(priority)
+			msg->flags |= UDP_MSG_PRIORITY;
+		live_message_put(msg);		//add message to the queue
+
+		if(priority)		//next sample
+		{
+			liveSequence = sequence;
+			prioritySequence = (prioritySequence+1) & ~LIVE_SEQUENCE_PRIORITY;
 		}
-		else					 //memory alloc fail
+		else
 		{
-			LOG_ERR("data sender memory allocation failed");	//print error
-		}	
+			liveSequence++;
+		}
 	}
-	
+}
 
-	keepAliveCounter = keepAliveCounter<99 ? keepAliveCounter+1 : 0 ;		//increment keepalive
+//-----------------------------------------------------------------------------------------------------------------------
+/*! @brief put the pending events of the lap timer in the priority queue. The
+*		  packet carries the synchronised time of the line crossing, it is
+*		  binary in all the live formats
+*/
+static void live_send_laps(void)
+{
+	tLapEvent event;
+
+	while(k_msgq_get(&lapEventQueue,&event,K_NO_WAIT) == 0)		//loop for every pending event
+	{
+		tUdpMessage * msg = live_message_alloc();		//message block from the slab
+
+		if(msg == NULL)			//memory alloc fail
+		{
+			LOG_ERR("lap memory allocation failed");
+			return;
+		}
+
+		int len = live_encode_header(msg->data,LIVE_PKT_LAP);
+		((tLiveHeader *)msg->data)->time = sys_cpu_to_le64(time_sync_convert(event.local));
+
+		tLiveLap * lap = (tLiveLap *)(msg->data + len);
+		lap->event = event.type == LAP_EVENT_LAP ? LIVE_LAP_LAP : LIVE_LAP_SECTOR;
+		lap->sector = event.sector;
+		lap->lap = sys_cpu_to_le16(event.lap);
+		lap->duration = sys_cpu_to_le32(event.duration);
+
+		msg->length = len + sizeof(tLiveLap);
+		msg->flags = UDP_MSG_PRIORITY;		//sent before the samples, not kept for retransmission
+		live_message_put(msg);
+	}
 }
 
+//-----------------------------------------------------------------------------------------------------------------------
+/*! @brief get a message block from the slab. If all blocks are used, the oldest
+*		  message of the queue is dropped to free a block
+* @retval message block or NULL if no block is available
+*/
+static tUdpMessage * live_message_alloc(void)
+{
+	tUdpMessage * msg;
+
+	if(k_mem_slab_alloc(&messageSlab,(void **)&msg,K_NO_WAIT) != 0 &&
+	   (!live_message_drop_oldest(&udpQueue) || k_mem_slab_alloc(&messageSlab,(void **)&msg,K_NO_WAIT) != 0))		//retry with the block of the oldest message
+		return NULL;
 
+	msg->flags = 0;
+	msg->sequence = liveSequence;
+	return msg;
+}
+
+//-----------------------------------------------------------------------------------------------------------------------
+/*! @brief put a message in the udp queue. If the queue is full, the oldest
+*		  message is dropped so that the newest data is always sent. The
+*		  messages of the priority classes go to the priority queue, which
+*		  the udp client reads first
+* @param msg message block from the message slab
+*/
+static void live_message_put(tUdpMessage * msg)
+{
+	struct k_msgq * queue = &udpQueue;
+	int depth = udpQueueDepth;
+
+	msg->timestamp = k_uptime_get_32();		//time stamp for the queue latency
+
+	if(msg->flags & UDP_MSG_PRIORITY)		//skips ahead of the other messages
+	{
+		queue = &udpPriorityQueue;
+		depth = UDP_PRIORITY_QUEUE_DEPTH;
+	}
+
+	if(k_msgq_num_used_get(queue) >= depth)		//queue full
+		live_message_drop_oldest(queue);
+
+	if(k_msgq_put(queue,&msg,K_NO_WAIT) == 0)
+	{
+		atomic_inc(&linkStats.enqueued);
+	}
+	else		//udp client removed nothing in the meantime
+	{
+		k_mem_slab_free(&messageSlab,(void **)&msg);	//release the block
+		atomic_inc(&linkStats.dropped);
+	}
+}
+
+//-----------------------------------------------------------------------------------------------------------------------
+/*! @brief drop the oldest message of a udp queue
+* @param queue udpQueue or udpPriorityQueue
+* @retval true if a message was dropped
+*/
+static bool live_message_drop_oldest(struct k_msgq * queue)
+{
+	tUdpMessage * old;
+
+	if(k_msgq_get(queue,&old,K_NO_WAIT) != 0)		//queue empty (blocks are owned by the udp client)
+		return false;
+
+	k_mem_slab_free(&messageSlab,(void **)&old);	//release the block
+	atomic_inc(&linkStats.dropped);
+	return true;
+}
+
+//-----------------------------------------------------------------------------------------------------------------------
+/*! @brief apply the pending live configuration changes. Called in the data
+*		  sender work, so the channel table never changes while a packet
+*		  is encoded. The schema is rebuilt and announced if channels changed
+*/
+static void live_control_apply(void)
+{
+	tLiveControl ctrl;
+	bool schemaChanged = false;
+	bool rateChanged = false;
+
+	while(k_msgq_get(&liveControlQueue,&ctrl,K_NO_WAIT) == 0)		//loop for every pending change
+	{
+		if(ctrl.type == LIVE_CTRL_CHANNEL)
+		{
+			for(int i=0; i<configFile.sensorCount; i++)
+			{
+				if(sensorBuffer[i].name_wifi != NULL && strcmp(sensorBuffer[i].name_wifi,ctrl.name) == 0)
+					sensorBuffer[i].wifi_enable = ctrl.enable;
+			}
+
+			if(gpsBuffer.NameLiveCoord != NULL && strcmp(gpsBuffer.NameLiveCoord,ctrl.name) == 0)
+				gpsBuffer.LiveCoordEnable = ctrl.enable;
+			if(gpsBuffer.NameLiveSpeed != NULL && strcmp(gpsBuffer.NameLiveSpeed,ctrl.name) == 0)
+				gpsBuffer.LiveSpeedEnable = ctrl.enable;
+			if(gpsBuffer.NameLiveFix != NULL && strcmp(gpsBuffer.NameLiveFix,ctrl.name) == 0)
+				gpsBuffer.LiveFixEnable = ctrl.enable;
+
+			LOG_INF("live channel %s %s",ctrl.name,ctrl.enable ? "enabled" : "disabled");
+			schemaChanged = true;
+		}
+		else if(ctrl.type == LIVE_CTRL_RATE)
+		{
+			configFile.LiveFrameRate = ctrl.value;		//full rate, the reduced rate still applies while the link is poor
+			LOG_INF("live frame rate %d",ctrl.value);
+			rateChanged = true;
+		}
+	}
+
+	if(schemaChanged)
+	{
+		live_schema_init();
+		data_Sender_schema_request();		//announce the new schema with a keyframe
+	}
+
+	if(rateChanged)
+		live_rate_apply();
+}
+
+//-----------------------------------------------------------------------------------------------------------------------
+/*! @brief compute the periods that depend on the frame rate
+*/
+static void live_rates_init(void)
+{
+	int schemaPeriod = configFile.LiveSchemaPeriod > 0 ? configFile.LiveSchemaPeriod : DEFAULT_SCHEMA_PERIOD;
+	schemaPeriodTicks = MAX(schemaPeriod*liveRate,1);
+	schemaTickCounter = 0;
+
+	spoolEnable = configFile.LiveSpoolRate > 0;
+	spoolPeriodTicks = spoolEnable ? MAX(liveRate/configFile.LiveSpoolRate,1) : 1;
+	spoolTickCounter = 0;
+
+	int backfillRate = configFile.LiveBackfillRate > 0 ? configFile.LiveBackfillRate : DEFAULT_BACKFILL_RATE;
+	backfillTicks = MAX(liveRate/backfillRate,1);									//backfill rate lower than frame rate
+	backfillBurst = MAX(backfillRate/MAX(liveRate,1),1);							//backfill rate higher than frame rate
+	backfillTickCounter = 0;
+
+	//timer period : greatest common divisor of the default stream and class periods
+	int mainPeriod = MAX(1000/liveRate,1);
+	int tick = mainPeriod;
+
+	for(int c=0; c<configFile.liveClassCount; c++)
+	{
+		int a = tick, b = live_class_period(c);
+		while(b != 0)
+		{
+			int r = a%b;
+			a = b;
+			b = r;
+		}
+		tick = a;
+	}
+	liveTick = MIN(MAX(tick,LIVE_TICK_MIN_MS),mainPeriod);		//periods are rounded to the tick if the divisor is too small
+
+	mainTicks = MAX(mainPeriod/liveTick,1);
+	mainTickCounter = 0;
+
+	for(int c=0; c<configFile.liveClassCount; c++)
+	{
+		classTicks[c] = MAX(live_class_period(c)/liveTick,1);
+		classTickCounter[c] = 0;
+	}
+}
+
+//-----------------------------------------------------------------------------------------------------------------------
+/*! @brief send period of a live class. When the transmission is reduced, the
+*		  classes without priority are slowed down as the default stream
+* @param liveClass index of the class in the config file
+* @retval period (ms)
+*/
+static int live_class_period(int liveClass)
+{
+	const struct sLiveClass * cls = &configFile.LiveClasses[liveClass];
+	int period = cls->Period > 0 ? cls->Period : MAX(1000/configFile.LiveFrameRate,1);
+
+	if(liveLevel > 0 && !cls->Priority)
+		period = period*configFile.LiveFrameRate/liveRate;
+
+	return period;
+}
+
+//-----------------------------------------------------------------------------------------------------------------------
+/*! @brief index of a live class in the config file
+* @param name name of the class (NULL if not set)
+* @retval index of the class, LIVE_CLASS_DEFAULT if not set or unknown
+*/
+static uint8_t live_class(const char * name)
+{
+	for(int c=0; name!=NULL && c<configFile.liveClassCount; c++)
+	{
+		if(configFile.LiveClasses[c].Name != NULL && strcmp(configFile.LiveClasses[c].Name,name) == 0)
+			return c;
+	}
+	return LIVE_CLASS_DEFAULT;
+}
+
+//-----------------------------------------------------------------------------------------------------------------------
+/*! @brief set the frame rate of the current level (LiveFrameRate, or LiveAdaptRate
+*		  when the transmission is reduced) and restart the timer if it changed
+*/
+static void live_rate_apply(void)
+{
+	int rate = configFile.LiveFrameRate;
+
+	if(liveLevel > 0)		//reduced transmission
+		rate = configFile.LiveAdaptRate > 0 ? MIN(configFile.LiveAdaptRate,configFile.LiveFrameRate) : MAX(configFile.LiveFrameRate/2,1);
+
+	if(rate == liveRate)
+		return;
+
+	liveRate = rate;
+	live_rates_init();
+	k_timer_start(&dataSenderTimer, K_MSEC(liveTick), K_MSEC(liveTick));
+}
+
+//-----------------------------------------------------------------------------------------------------------------------
+/*! @brief evaluate the link quality every LIVE_ADAPT_PERIOD_MS with the rssi and
+*		  the messages lost on the current connection (NACKed live samples still
+*		  in the history or in send error). The spool drops and the NACKs of the
+*		  samples spooled or skipped during an outage do not measure the link
+*		  and are not counted. The transmission is reduced by one level after LIVE_ADAPT_DEGRADE_COUNT
+*		  bad periods and restored by one level after LIVE_ADAPT_RESTORE_COUNT
+*		  good periods. Between the bad and good thresholds the level is kept
+*/
+static void live_adapt(void)
+{
+	if(liveLevelMax == 0 || k_uptime_get() - adaptLast < LIVE_ADAPT_PERIOD_MS)
+		return;
+	adaptLast = k_uptime_get();
+
+	uint32_t enqueued = atomic_get(&linkStats.enqueued);
+	uint32_t lost = atomic_get(&linkStats.nackLive);
+
+	for(int i=0;i<configFile.serverCount;i++)
+		lost += atomic_get(&serverStats[i].errors);
+
+	uint32_t enqueuedPeriod = enqueued - adaptEnqueued;
+	uint32_t lostPeriod = lost - adaptLost;
+	adaptEnqueued = enqueued;
+	adaptLost = lost;
+
+	if(enqueuedPeriod == 0)		//nothing sent, no measurement
+		return;
+
+	int loss = MIN(lostPeriod*100/enqueuedPeriod,100);		//% of the messages of the period
+	int rssi = atomic_get(&wifiStats.rssi);					//0 if unknown
+
+	bool rssiBad = configFile.LiveAdaptRssi != 0 && rssi != 0 && rssi < configFile.LiveAdaptRssi;
+	bool rssiGood = configFile.LiveAdaptRssi == 0 || rssi == 0 || rssi >= configFile.LiveAdaptRssi + LIVE_ADAPT_RSSI_HYSTERESIS;
+	bool lossBad = configFile.LiveAdaptLoss > 0 && loss >= configFile.LiveAdaptLoss;
+	bool lossGood = configFile.LiveAdaptLoss <= 0 || 2*loss <= configFile.LiveAdaptLoss;
+
+	if(rssiBad || lossBad)
+	{
+		adaptBadCount++;
+		adaptGoodCount = 0;
+	}
+	else if(rssiGood && lossGood)
+	{
+		adaptGoodCount++;
+		adaptBadCount = 0;
+	}
+	else		//between the thresholds : keep the level
+	{
+		adaptBadCount = 0;
+		adaptGoodCount = 0;
+	}
+
+	if(adaptBadCount >= LIVE_ADAPT_DEGRADE_COUNT && liveLevel < liveLevelMax)
+		live_level_set(liveLevel+1,rssi,loss);
+	else if(adaptGoodCount >= LIVE_ADAPT_RESTORE_COUNT && liveLevel > 0)
+		live_level_set(liveLevel-1,rssi,loss);
+}
+
+//-----------------------------------------------------------------------------------------------------------------------
+/*! @brief change the reduction level of the live transmission. The schema is
+*		  rebuilt when the set of priority channels changes
+* @param level new level
+* @param rssi rssi of the evaluation (dBm)
+* @param loss loss of the evaluation (%)
+*/
+static void live_level_set(int level, int rssi, int loss)
+{
+	bool schemaChanged = level >= 2 || liveLevel >= 2;
+
+	LOG_INF("live level %d -> %d (rssi %d dBm, loss %d%%)",liveLevel,level,rssi,loss);
+
+	liveLevel = level;
+	adaptBadCount = 0;
+	adaptGoodCount = 0;
+
+	live_rate_apply();
+
+	if(schemaChanged)
+	{
+		live_schema_init();
+		data_Sender_schema_request();		//announce the new schema with a keyframe
+	}
+}
+
+//-----------------------------------------------------------------------------------------------------------------------
+/*! @brief position of a channel in the priority order of the config file
+* @param name name of the channel in the live transmission
+* @retval position (0 = most important), -1 if the channel is not in the list
+*/
+static int live_priority(const char * name)
+{
+	for(int i=0;i<configFile.livePriorityCount;i++)
+	{
+		if(configFile.LivePriority[i] != NULL && strcmp(configFile.LivePriority[i],name) == 0)
+			return i;
+	}
+	return -1;
+}
+
+//-----------------------------------------------------------------------------------------------------------------------
+/*! @brief put the current sample in the spool
+*/
+static void live_spool_sample(void)
+{
+	tUdpMessage * msg;		//message block used as encode buffer
+
+	if(k_mem_slab_alloc(&messageSlab,(void **)&msg,K_NO_WAIT) != 0)		//no block free (udp client still holds the queue)
+		return;
+
+	if(liveBinary)
+		msg->length = live_encode_binary(msg->data);
+	else
+		msg->length = live_encode_json((char*)msg->data,udpQueueMesLength,LIVE_CLASS_ALL);
+
+	atomic_add(&linkStats.dropped,live_spool_put(msg->data,msg->length));		//oldest spooled messages dropped if spool is full
+
+	k_mem_slab_free(&messageSlab,(void **)&msg);		//release the block
+}
+
+//-----------------------------------------------------------------------------------------------------------------------
+/*! @brief put spooled messages back in the udp queue. A burst is sent every
+*		  backfillTicks sends and only while the queue is less than half full,
+*		  so the current samples are never dropped for old ones
+*/
+static void live_backfill(void)
+{
+	if(backfillTickCounter>0 || live_spool_count()==0)
+	{
+		backfillTickCounter = backfillTickCounter>0 ? backfillTickCounter-1 : 0;
+		return;
+	}
+	backfillTickCounter = backfillTicks-1;
+
+	for(int i=0; i<backfillBurst && live_spool_count()>0; i++)
+	{
+		if(k_msgq_num_used_get(&udpQueue) >= (udpQueueDepth+1)/2)		//keep room for the current samples
+			return;
+
+		tUdpMessage * msg;		//message block from the slab
+
+		if(k_mem_slab_alloc(&messageSlab,(void **)&msg,K_NO_WAIT) != 0)
+			return;
+
+		msg->length = live_spool_get(msg->data,udpQueueMesLength);
+		msg->flags = 0;							//block of a previous message : not kept for retransmission, not a priority
+		msg->sequence = UDP_MSG_NO_SEQUENCE;	//never matches a NACK
+
+		if(msg->length > 0)
+			live_message_put(msg);			//add message to the queue
+		else
+			k_mem_slab_free(&messageSlab,(void **)&msg);		//release the block
+	}
+}
+
+//-----------------------------------------------------------------------------------------------------------------------
+/*! @brief value of a link statistics, clock, server, wifi or gps statistics channel. The max
+*		  latencies are reset at each report
+* @param source source of the channel (LIVE_SRC_LINK_x, LIVE_SRC_CLOCK_x, LIVE_SRC_SERVER_x, LIVE_SRC_WIFI_x or LIVE_SRC_GPS_RATE/CPU/ERRORS/OVERRUNS)
+* @param index index of the server (LIVE_SRC_SERVER_x only)
+* @retval value of the channel (signed values of LIVE_CH_I32 channels are cast)
+*/
+static uint32_t live_link_value(uint8_t source, int index)
+{
+	tTimeSyncStatus clock;
+
+	if(source >= LIVE_SRC_CLOCK_SOURCE && source <= LIVE_SRC_CLOCK_DRIFT)
+		time_sync_status(&clock);
+
+	switch(source)
+	{
+		case LIVE_SRC_LINK_ENQUEUED:	return atomic_get(&linkStats.enqueued);
+		case LIVE_SRC_LINK_SENT:		return atomic_get(&linkStats.sent);
+		case LIVE_SRC_LINK_DROPPED:		return atomic_get(&linkStats.dropped);
+		case LIVE_SRC_LINK_LATENCY:		return atomic_clear(&linkStats.latencyMax);
+		case LIVE_SRC_LINK_SPOOL:		return live_spool_count();
+		case LIVE_SRC_LINK_RETRANSMIT:	return atomic_get(&linkStats.retransmitted);
+		case LIVE_SRC_LINK_RETRANSMIT_MISSED:	return atomic_get(&linkStats.retransmitMissed);
+		case LIVE_SRC_CLOCK_SOURCE:		return clock.source;
+		case LIVE_SRC_CLOCK_DELAY:		return clock.delay;
+		case LIVE_SRC_CLOCK_CORRECTION:	return (uint32_t)clock.correction;
+		case LIVE_SRC_CLOCK_DRIFT:		return (uint32_t)clock.drift;
+		case LIVE_SRC_SERVER_UP:		return atomic_get(&serverStats[index].healthy);
+		case LIVE_SRC_SERVER_ERRORS:	return atomic_get(&serverStats[index].errors);
+		case LIVE_SRC_SERVER_LATENCY:	return atomic_clear(&serverStats[index].latencyMax);
+		case LIVE_SRC_WIFI_RSSI:		return (uint32_t)atomic_get(&wifiStats.rssi);
+		case LIVE_SRC_WIFI_NETWORK:		return atomic_get(&wifiStats.network);
+		case LIVE_SRC_WIFI_ROAMS:		return atomic_get(&wifiStats.roams);
+		case LIVE_SRC_WIFI_OUTAGE:		return atomic_get(&wifiStats.outageTime);
+		case LIVE_SRC_WIFI_RECONNECT:	return atomic_get(&wifiStats.reconnectTime);
+		case LIVE_SRC_LIVE_LEVEL:		return liveLevel;
+		case LIVE_SRC_GPS_RATE:			return atomic_get(&gpsStats.rate);
+		case LIVE_SRC_GPS_CPU:			return atomic_get(&gpsStats.cpuPerFix);
+		case LIVE_SRC_GPS_ERRORS:		return atomic_get(&gpsStats.errors);
+		case LIVE_SRC_GPS_OVERRUNS:		return atomic_get(&gpsStats.overruns);
+	}
+	return 0;
+}
+
+//-----------------------------------------------------------------------------------------------------------------------
+/*! @brief write fixed point gps coordinates as text ("lat lon" in degree with 7 decimals)
+* @param buf buffer for the string
+* @param size size of the buffer
+* @param lat latitude (1e-7 degree)
+* @param lon longitude (1e-7 degree)
+* @retval length of the string
+*/
+static int live_format_coord(char * buf, int size, int32_t lat, int32_t lon)
+{
+	uint32_t absLat = lat < 0 ? -(uint32_t)lat : (uint32_t)lat;
+	uint32_t absLon = lon < 0 ? -(uint32_t)lon : (uint32_t)lon;
+
+	return snprintf(buf,size,"%s%u.%07u %s%u.%07u",lat < 0 ? "-" : "",absLat/LIVE_COORD_SCALE,absLat%LIVE_COORD_SCALE,
+												   lon < 0 ? "-" : "",absLon/LIVE_COORD_SCALE,absLon%LIVE_COORD_SCALE);
+}
+
+//-----------------------------------------------------------------------------------------------------------------------
+/*! @brief write the live json string of the current values. A class packet
+*		  starts with the "Class" key and contains only the channels of the class
+* @param buf buffer for the string
+* @param size size of the buffer
+* @param liveClass index of the class, LIVE_CLASS_DEFAULT or LIVE_CLASS_ALL for all the channels
+* @retval length of the string
+*/
+static int live_encode_json(char * buf, int size, int liveClass)
+{
+	int len = 0;
+	char sep = '{';			//separator before the next field
+
+	if(liveClass != LIVE_CLASS_ALL)
+	{
+		len += snprintf(buf+len,size-len,"{\"Class\":%d",liveClass);
+		sep = ',';
+	}
+
+	k_mutex_lock(&sensorBufferMutex,K_FOREVER);		//lock sensor buffer mutex
+	k_mutex_lock(&gpsBufferMutex,K_FOREVER);		//lock gps buffer mutex
+
+	for(int i=0; i<liveChannelCount; i++)		//loop for every channel
+	{
+		const tLiveChannel * ch = &liveChannels[i];
+
+		if(liveClass != LIVE_CLASS_ALL && ch->liveClass != liveClass)		//channel of another class
+			continue;
+
+		switch(ch->source)
+		{
+			case LIVE_SRC_SENSOR:		len += snprintf(buf+len,size-len,"%c\"%s\":%u",sep,ch->name,sensorBuffer[ch->index].value);
+			break;
+			case LIVE_SRC_GPS_COORD:	len += snprintf(buf+len,size-len,"%c\"%s\":\"",sep,ch->name);
+										len += live_format_coord(buf+len,size-len,gpsBuffer.lat,gpsBuffer.lon);
+										len += snprintf(buf+len,size-len,"\"");
+			break;
+			case LIVE_SRC_GPS_SPEED:	len += snprintf(buf+len,size-len,"%c\"%s\":%u.%02u",sep,ch->name,gpsBuffer.speed/LIVE_CENTI_SCALE,gpsBuffer.speed%LIVE_CENTI_SCALE);
+			break;
+			case LIVE_SRC_GPS_FIX:		len += snprintf(buf+len,size-len,"%c\"%s\":%s",sep,ch->name,gpsBuffer.fix ? "true" : "false");
+			break;
+			case LIVE_SRC_LOG_RECORDING:len += snprintf(buf+len,size-len,"%c\"%s\":%s",sep,ch->name,logEnable ? "true" : "false");
+			break;
+			default:					len += snprintf(buf+len,size-len,ch->type==LIVE_CH_I32 ? "%c\"%s\":%d" : "%c\"%s\":%u",sep,ch->name,live_link_value(ch->source,ch->index));
+			break;
+		}
+		sep = ',';
+	}
+
+	k_mutex_unlock(&gpsBufferMutex);				//unlock gps buffer mutex
+	k_mutex_unlock(&sensorBufferMutex);				//unlock sensor buffer mutex
+
+	len += snprintf(buf+len,size-len,"%c\"Time\":%lld",sep,(long long)liveTime);						//print synchronised time
+	len += snprintf(buf+len,size-len,",\"Seq\":%u",liveSequence);								//print sequence number
+	len += snprintf(buf+len,size-len,",\"KeepAliveCounter\":%d}",keepAliveCounter);		//print keepalive counter and close json section
+
+	return MIN(len,size);
+}
+
+//-----------------------------------------------------------------------------------------------------------------------
+/*! @brief write the header of a binary packet
+* @param buf buffer for the packet
+* @param type packet type (LIVE_PKT_x)
+* @retval length of the header
+*/
+static int live_encode_header(uint8_t * buf, uint8_t type)
+{
+	tLiveHeader * header = (tLiveHeader *)buf;
+	header->magic = sys_cpu_to_le16(LIVE_MAGIC);
+	header->version = LIVE_PROTOCOL_VERSION;
+	header->type = type;
+	header->keepAlive = keepAliveCounter;
+	header->sequence = sys_cpu_to_le32(liveSequence);
+	header->schemaHash = sys_cpu_to_le32(schemaHash);
+	header->time = sys_cpu_to_le64(liveTime);
+
+	return sizeof(tLiveHeader);
+}
+
+//-----------------------------------------------------------------------------------------------------------------------
+/*! @brief write the binary data packet of the current values
+* @param buf buffer for the packet (udpQueueMesLength bytes)
+* @retval length of the packet
+*/
+static int live_encode_binary(uint8_t * buf)
+{
+	int len = live_encode_header(buf,LIVE_PKT_DATA);
+	return len + live_encode_values(buf+len,NULL,LIVE_CLASS_ALL);
+}
+
+//-----------------------------------------------------------------------------------------------------------------------
+/*! @brief write the class packet of the current values. The bitmap marks the
+*		  channels of the class, the other channels are not part of the sample
+* @param buf buffer for the packet (udpQueueMesLength bytes)
+* @param liveClass index of the class or LIVE_CLASS_DEFAULT
+* @retval length of the packet
+*/
+static int live_encode_class(uint8_t * buf, int liveClass)
+{
+	uint8_t * ptr = buf + live_encode_header(buf,LIVE_PKT_CLASS);
+
+	tLiveClassHeader * header = (tLiveClassHeader *)ptr;
+	header->liveClass = liveClass;
+	ptr += sizeof(tLiveClassHeader);
+
+	uint8_t * bitmap = ptr;				//bit i set = channel i in the class
+	int bitmapLen = (liveChannelCount+7)/8;
+	memset(bitmap,0,bitmapLen);
+	ptr += bitmapLen;
+
+	for(int i=0; i<liveChannelCount; i++)
+	{
+		if(liveChannels[i].liveClass == liveClass)
+			bitmap[i/8] |= BIT(i%8);
+	}
+
+	ptr += live_encode_values(ptr,NULL,liveClass);
+	return ptr-buf;
+}
+
+//-----------------------------------------------------------------------------------------------------------------------
+/*! @brief write the keyframe or the delta packet of the current values. The
+*		  delta packet contains only the channels that changed since the last
+*		  keyframe, so a lost delta packet does not affect the next ones
+* @param buf buffer for the packet (udpQueueMesLength bytes)
+* @retval length of the packet
+*/
+static int live_encode_delta(uint8_t * buf)
+{
+	int valuesLen = live_encode_values(currentValues,currentOffset,LIVE_CLASS_ALL);
+
+	if(atomic_cas(&keyframeRequest,1,0) || keyframeTickCounter==0)		//keyframe on request and periodically
+	{
+		memcpy(keyframeValues,currentValues,valuesLen);
+		memcpy(keyframeOffset,currentOffset,sizeof(currentOffset));
+		keyframeSequence = liveSequence;
+		keyframeTickCounter = keyframePeriodTicks>1 ? 1 : 0;
+
+		int len = live_encode_header(buf,LIVE_PKT_DATA);
+		memcpy(buf+len,currentValues,valuesLen);
+		return len+valuesLen;
+	}
+	keyframeTickCounter = keyframeTickCounter<(keyframePeriodTicks-1) ? keyframeTickCounter+1 : 0;
+
+	uint8_t * ptr = buf + live_encode_header(buf,LIVE_PKT_DELTA);
+
+	tLiveDeltaHeader * delta = (tLiveDeltaHeader *)ptr;
+	delta->keyframeSequence = sys_cpu_to_le32(keyframeSequence);
+	ptr += sizeof(tLiveDeltaHeader);
+
+	uint8_t * bitmap = ptr;				//bit i set = channel i changed
+	int bitmapLen = (liveChannelCount+7)/8;
+	memset(bitmap,0,bitmapLen);
+	ptr += bitmapLen;
+
+	for(int i=0; i<liveChannelCount; i++)		//loop for every channel in schema order
+	{
+		int size = currentOffset[i+1]-currentOffset[i];
+
+		if(size != keyframeOffset[i+1]-keyframeOffset[i] ||
+		   memcmp(&currentValues[currentOffset[i]],&keyframeValues[keyframeOffset[i]],size) != 0)		//value changed
+		{
+			bitmap[i/8] |= BIT(i%8);
+			memcpy(ptr,&currentValues[currentOffset[i]],size);
+			ptr += size;
+		}
+	}
+
+	return ptr-buf;
+}
+
+//-----------------------------------------------------------------------------------------------------------------------
+/*! @brief write the binary values of all channels or of one class in schema order
+* @param buf buffer for the values
+* @param offset position of each channel in buf (liveChannelCount+1 entries, NULL if not needed, LIVE_CLASS_ALL only)
+* @param liveClass index of the class, LIVE_CLASS_DEFAULT or LIVE_CLASS_ALL for all the channels
+* @retval length of the values
+*/
+static int live_encode_values(uint8_t * buf, uint16_t * offset, int liveClass)
+{
+	uint8_t * ptr = buf;
+
+	k_mutex_lock(&sensorBufferMutex,K_FOREVER);		//lock sensor buffer mutex
+	k_mutex_lock(&gpsBufferMutex,K_FOREVER);		//lock gps buffer mutex
+
+	for(int i=0; i<liveChannelCount; i++)		//loop for every channel in schema order
+	{
+		const tLiveChannel * ch = &liveChannels[i];
+
+		if(liveClass != LIVE_CLASS_ALL && ch->liveClass != liveClass)		//channel of another class
+			continue;
+
+		if(offset != NULL)
+			offset[i] = ptr-buf;
+
+		switch(ch->source)
+		{
+			case LIVE_SRC_SENSOR:		sys_put_le32(sensorBuffer[ch->index].value,ptr);
+										ptr+=4;
+			break;
+			case LIVE_SRC_GPS_COORD:	sys_put_le32((uint32_t)gpsBuffer.lat,ptr);
+										sys_put_le32((uint32_t)gpsBuffer.lon,ptr+4);
+										ptr+=8;
+			break;
+			case LIVE_SRC_GPS_SPEED:	sys_put_le32(gpsBuffer.speed,ptr);
+										ptr+=4;
+			break;
+			case LIVE_SRC_GPS_FIX:		*ptr++ = gpsBuffer.fix ? 1 : 0;
+			break;
+			case LIVE_SRC_LOG_RECORDING:*ptr++ = logEnable ? 1 : 0;
+			break;
+			default:					sys_put_le32(live_link_value(ch->source,ch->index),ptr);
+										ptr+=4;
+			break;
+		}
+	}
+
+	k_mutex_unlock(&gpsBufferMutex);				//unlock gps buffer mutex
+	k_mutex_unlock(&sensorBufferMutex);				//unlock sensor buffer mutex
+
+	if(offset != NULL)
+		offset[liveChannelCount] = ptr-buf;
+
+	return ptr-buf;
+}
+
+//-----------------------------------------------------------------------------------------------------------------------
+/*! @brief put the schema fragments in the udp queue
+*/
+static void live_send_schema(void)
+{
+	for(int f=0; f<schemaFragmentCount; f++)		//loop for every fragment
+	{
+		tUdpMessage * msg = live_message_alloc();		//message block from the slab
+
+		if(msg == NULL)			//memory alloc fail
+		{
+			LOG_ERR("schema memory allocation failed");
+			return;
+		}
+
+		live_encode_header(msg->data,LIVE_PKT_SCHEMA);
+
+		tLiveSchemaHeader * fragment = (tLiveSchemaHeader *)(msg->data + sizeof(tLiveHeader));
+		fragment->fragmentIndex = f;
+		fragment->fragmentCount = schemaFragmentCount;
+		fragment->firstChannel = sys_cpu_to_le16(schemaFragmentFirst[f]);
+		fragment->channelCount = sys_cpu_to_le16(schemaFragmentFirst[f+1]-schemaFragmentFirst[f]);
+
+		uint8_t * ptr = msg->data + sizeof(tLiveHeader) + sizeof(tLiveSchemaHeader);
+
+		for(int i=schemaFragmentFirst[f]; i<schemaFragmentFirst[f+1]; i++)		//write descriptors of the fragment
+		{
+			const tLiveChannel * ch = &liveChannels[i];
+			int nameLen = MIN(strlen(ch->name),255);
+			int unitLen = MIN(strlen(ch->unit),255);
+
+			*ptr++ = ch->type;
+			*ptr++ = nameLen;
+			memcpy(ptr,ch->name,nameLen);
+			ptr+=nameLen;
+			*ptr++ = unitLen;
+			memcpy(ptr,ch->unit,unitLen);
+			ptr+=unitLen;
+		}
+
+		msg->length = ptr - msg->data;
+		live_message_put(msg);		//add fragment to the queue
+	}
+}
+
+//-----------------------------------------------------------------------------------------------------------------------
+/*! @brief size of the descriptor of a channel in the schema
+* @param ch channel
+* @retval size in bytes
+*/
+static int live_descriptor_size(const tLiveChannel * ch)
+{
+	return 3 + MIN(strlen(ch->name),255) + MIN(strlen(ch->unit),255);		//type + name length + name + unit length + unit
+}
+
+//-----------------------------------------------------------------------------------------------------------------------
+/*! @brief add the diagnostic channels (link, clock, servers, wifi, gps and
+*		  live level) to the live channel table. They are sent in their own
+*		  class, usually slow (1 s) : the config file enables them with a
+*		  live class named LIVE_DIAGNOSTIC_CLASS, without it they are not sent
+*/
+static void live_diagnostics_init(void)
+{
+	uint8_t diagnosticClass = live_class(LIVE_DIAGNOSTIC_CLASS);
+
+	if(diagnosticClass == LIVE_CLASS_DEFAULT)		//no diagnostics class in the config file
+		return;
+
+	//link statistics
+	liveChannels[liveChannelCount++] = (tLiveChannel){ .name = "LinkEnqueued", .type = LIVE_CH_U32, .source = LIVE_SRC_LINK_ENQUEUED, .liveClass = diagnosticClass };
+	liveChannels[liveChannelCount++] = (tLiveChannel){ .name = "LinkSent", .type = LIVE_CH_U32, .source = LIVE_SRC_LINK_SENT, .liveClass = diagnosticClass };
+	liveChannels[liveChannelCount++] = (tLiveChannel){ .name = "LinkDropped", .type = LIVE_CH_U32, .source = LIVE_SRC_LINK_DROPPED, .liveClass = diagnosticClass };
+	liveChannels[liveChannelCount++] = (tLiveChannel){ .name = "LinkLatencyMax", .unit = "ms", .type = LIVE_CH_U32, .source = LIVE_SRC_LINK_LATENCY, .liveClass = diagnosticClass };
+	liveChannels[liveChannelCount++] = (tLiveChannel){ .name = "LinkSpool", .type = LIVE_CH_U32, .source = LIVE_SRC_LINK_SPOOL, .liveClass = diagnosticClass };
+	liveChannels[liveChannelCount++] = (tLiveChannel){ .name = "LinkRetransmit", .type = LIVE_CH_U32, .source = LIVE_SRC_LINK_RETRANSMIT, .liveClass = diagnosticClass };
+	liveChannels[liveChannelCount++] = (tLiveChannel){ .name = "LinkRetransmitMissed", .type = LIVE_CH_U32, .source = LIVE_SRC_LINK_RETRANSMIT_MISSED, .liveClass = diagnosticClass };
+
+	//clock synchronisation
+	liveChannels[liveChannelCount++] = (tLiveChannel){ .name = "ClockSource", .type = LIVE_CH_U32, .source = LIVE_SRC_CLOCK_SOURCE, .liveClass = diagnosticClass };
+	liveChannels[liveChannelCount++] = (tLiveChannel){ .name = "ClockDelay", .unit = "us", .type = LIVE_CH_U32, .source = LIVE_SRC_CLOCK_DELAY, .liveClass = diagnosticClass };
+	liveChannels[liveChannelCount++] = (tLiveChannel){ .name = "ClockCorrection", .unit = "us", .type = LIVE_CH_I32, .source = LIVE_SRC_CLOCK_CORRECTION, .liveClass = diagnosticClass };
+	liveChannels[liveChannelCount++] = (tLiveChannel){ .name = "ClockDrift", .unit = "ppb", .type = LIVE_CH_I32, .source = LIVE_SRC_CLOCK_DRIFT, .liveClass = diagnosticClass };
+
+	//server statistics
+	for(int i=0;i<configFile.serverCount;i++)
+	{
+		snprintf(serverChannelNames[i][0],sizeof(serverChannelNames[i][0]),"Server%dUp",i);
+		snprintf(serverChannelNames[i][1],sizeof(serverChannelNames[i][1]),"Server%dErrors",i);
+		snprintf(serverChannelNames[i][2],sizeof(serverChannelNames[i][2]),"Server%dSendLatency",i);
+		liveChannels[liveChannelCount++] = (tLiveChannel){ .name = serverChannelNames[i][0], .type = LIVE_CH_U32, .source = LIVE_SRC_SERVER_UP, .index = i, .liveClass = diagnosticClass };
+		liveChannels[liveChannelCount++] = (tLiveChannel){ .name = serverChannelNames[i][1], .type = LIVE_CH_U32, .source = LIVE_SRC_SERVER_ERRORS, .index = i, .liveClass = diagnosticClass };
+		liveChannels[liveChannelCount++] = (tLiveChannel){ .name = serverChannelNames[i][2], .unit = "us", .type = LIVE_CH_U32, .source = LIVE_SRC_SERVER_LATENCY, .index = i, .liveClass = diagnosticClass };
+	}
+
+	//wifi
+	liveChannels[liveChannelCount++] = (tLiveChannel){ .name = "WifiRssi", .unit = "dBm", .type = LIVE_CH_I32, .source = LIVE_SRC_WIFI_RSSI, .liveClass = diagnosticClass };
+	liveChannels[liveChannelCount++] = (tLiveChannel){ .name = "WifiNetwork", .type = LIVE_CH_U32, .source = LIVE_SRC_WIFI_NETWORK, .liveClass = diagnosticClass };
+	liveChannels[liveChannelCount++] = (tLiveChannel){ .name = "WifiRoams", .type = LIVE_CH_U32, .source = LIVE_SRC_WIFI_ROAMS, .liveClass = diagnosticClass };
+	liveChannels[liveChannelCount++] = (tLiveChannel){ .name = "WifiOutage", .unit = "ms", .type = LIVE_CH_U32, .source = LIVE_SRC_WIFI_OUTAGE, .liveClass = diagnosticClass };
+	liveChannels[liveChannelCount++] = (tLiveChannel){ .name = "WifiReconnect", .unit = "ms", .type = LIVE_CH_U32, .source = LIVE_SRC_WIFI_RECONNECT, .liveClass = diagnosticClass };
+
+	//gps receiver
+	liveChannels[liveChannelCount++] = (tLiveChannel){ .name = "GpsRate", .unit = "Hz", .type = LIVE_CH_U32, .source = LIVE_SRC_GPS_RATE, .liveClass = diagnosticClass };
+	liveChannels[liveChannelCount++] = (tLiveChannel){ .name = "GpsCpuPerFix", .unit = "ns", .type = LIVE_CH_U32, .source = LIVE_SRC_GPS_CPU, .liveClass = diagnosticClass };
+	liveChannels[liveChannelCount++] = (tLiveChannel){ .name = "GpsErrors", .type = LIVE_CH_U32, .source = LIVE_SRC_GPS_ERRORS, .liveClass = diagnosticClass };
+	liveChannels[liveChannelCount++] = (tLiveChannel){ .name = "GpsOverruns", .type = LIVE_CH_U32, .source = LIVE_SRC_GPS_OVERRUNS, .liveClass = diagnosticClass };
+
+	//reduction of the live transmission
+	liveChannels[liveChannelCount++] = (tLiveChannel){ .name = "LiveLevel", .type = LIVE_CH_U32, .source = LIVE_SRC_LIVE_LEVEL, .liveClass = diagnosticClass };
+}
+
+//-----------------------------------------------------------------------------------------------------------------------
+/*! @brief fill the live channel table and compute the schema hash and fragments
+*/
+static void live_schema_init(void)
+{
+	liveChannelCount = 0;
+
+	for(int i=0; i<configFile.sensorCount;i++)		//loop for every sensor
+	{
+		if(sensorBuffer[i].wifi_enable)			//if sensor is used in live telemetry
+		{
+			liveChannels[liveChannelCount++] = (tLiveChannel){ .name = sensorBuffer[i].name_wifi, .unit = configFile.Sensors[i].Unit,
+																.type = LIVE_CH_U32, .source = LIVE_SRC_SENSOR, .index = i,
+																.liveClass = live_class(configFile.Sensors[i].Class) };
+		}
+	}
+
+	if(gpsBuffer.LiveCoordEnable)			//if gps coord is used in live telemetry
+		liveChannels[liveChannelCount++] = (tLiveChannel){ .name = gpsBuffer.NameLiveCoord, .unit = configFile.GPS.Coordinates.Unit,
+															.type = LIVE_CH_COORD, .source = LIVE_SRC_GPS_COORD,
+															.liveClass = live_class(configFile.GPS.Coordinates.Class) };
+
+	if(gpsBuffer.LiveSpeedEnable)			//if gps speed is used in live telemetry
+		liveChannels[liveChannelCount++] = (tLiveChannel){ .name = gpsBuffer.NameLiveSpeed, .unit = configFile.GPS.Speed.Unit,
+															.type = LIVE_CH_CENTI, .source = LIVE_SRC_GPS_SPEED,
+															.liveClass = live_class(configFile.GPS.Speed.Class) };
+
+	if(gpsBuffer.LiveFixEnable)				//if gps fix is used in live telemetry
+		liveChannels[liveChannelCount++] = (tLiveChannel){ .name = gpsBuffer.NameLiveFix, .unit = configFile.GPS.Fix.Unit,
+															.type = LIVE_CH_BOOL, .source = LIVE_SRC_GPS_FIX,
+															.liveClass = live_class(configFile.GPS.Fix.Class) };
+
+	liveChannels[liveChannelCount++] = (tLiveChannel){ .name = "LogRecordingSD", .type = LIVE_CH_BOOL, .source = LIVE_SRC_LOG_RECORDING,
+														.liveClass = LIVE_CLASS_DEFAULT };
+
+	live_diagnostics_init();
+
+	if(liveLevel >= 2)		//poor link : only the first priority channels and the level
+	{
+		int kept = MAX(configFile.livePriorityCount-(liveLevel-2),1);
+		int count = 0;
+
+		for(int i=0; i<liveChannelCount; i++)
+		{
+			int priority = live_priority(liveChannels[i].name);
+
+			if(liveChannels[i].source == LIVE_SRC_LIVE_LEVEL || (priority >= 0 && priority < kept))
+				liveChannels[count++] = liveChannels[i];
+		}
+		liveChannelCount = count;
+	}
+
+	//number of channels of each class (a class without channel is not sent)
+	memset(classChannelCount,0,sizeof(classChannelCount));
+	for(int i=0; i<liveChannelCount; i++)
+	{
+		if(liveChannels[i].liveClass != LIVE_CLASS_DEFAULT)
+			classChannelCount[liveChannels[i].liveClass]++;
+	}
+
+	//compute schema hash and split the descriptors in fragments
+	schemaHash = 0;
+	schemaFragmentCount = 0;
+	int fragmentSize = LIVE_SCHEMA_FRAGMENT_SIZE;		//force a new fragment for the first channel
+
+	for(int i=0; i<liveChannelCount; i++)
+	{
+		tLiveChannel * ch = &liveChannels[i];
+		if(ch->unit == NULL)			//unit is optional in the config file
+			ch->unit = "";
+
+		int size = live_descriptor_size(ch);
+		if(fragmentSize + size > LIVE_SCHEMA_FRAGMENT_SIZE && schemaFragmentCount < MAX_SCHEMA_FRAGMENTS)		//start a new fragment
+		{
+			schemaFragmentFirst[schemaFragmentCount++] = i;
+			fragmentSize = 0;
+		}
+		fragmentSize += size;
+
+		uint8_t type = ch->type;
+		uint8_t nameLen = MIN(strlen(ch->name),255);
+		uint8_t unitLen = MIN(strlen(ch->unit),255);
+		schemaHash = crc32_ieee_update(schemaHash,&type,1);
+		schemaHash = crc32_ieee_update(schemaHash,&nameLen,1);
+		schemaHash = crc32_ieee_update(schemaHash,(const uint8_t *)ch->name,nameLen);
+		schemaHash = crc32_ieee_update(schemaHash,&unitLen,1);
+		schemaHash = crc32_ieee_update(schemaHash,(const uint8_t *)ch->unit,unitLen);
+	}
+	schemaFragmentFirst[schemaFragmentCount] = liveChannelCount;
+
+	LOG_INF("live schema : %d channels, %d fragments, hash %08x",liveChannelCount,schemaFragmentCount,schemaHash);
+}
 
 //-----------------------------------------------------------------------------------------------------------------------
 /*! Task_Data_Sender_Init initializes the task Data_Sender
@@ -142,24 +1381,117 @@ void Task_Data_Sender_Init( void )
 
 	logEnable = configFile.RecordOnStart; //initialize logEnable variable
 
+	//live format and schema
+	liveDelta = (configFile.LiveFormat != NULL) && (strcmp(configFile.LiveFormat,"delta") == 0);
+	liveBinary = liveDelta || ((configFile.LiveFormat != NULL) && (strcmp(configFile.LiveFormat,"binary") == 0));
+	if(liveDelta && configFile.liveClassCount > 0)		//class packets replace the delta frames
+	{
+		LOG_WRN("delta frames are not used with live classes");
+		liveDelta = false;
+	}
+	live_schema_init();
+
+	//adaptation to the link quality (reduced rate, then priority channels removed one by one)
+	liveLevel = 0;
+	liveLevelMax = 0;
+	if(configFile.LiveAdaptRssi != 0 || configFile.LiveAdaptLoss > 0)
+		liveLevelMax = configFile.livePriorityCount > 0 ? 1+configFile.livePriorityCount : 1;
+
+	liveRate = configFile.LiveFrameRate;
+	live_rates_init();
+	atomic_set(&schemaRequest,0);
+
+	keyframePeriodTicks = configFile.LiveKeyframePeriod > 0 ? configFile.LiveKeyframePeriod : DEFAULT_KEYFRAME_PERIOD;
+	keyframeTickCounter = 0;
+	atomic_set(&keyframeRequest,0);
+
+	atomic_clear(&linkStats.enqueued);		//reset link statistics
+	atomic_clear(&linkStats.sent);
+	atomic_clear(&linkStats.dropped);
+	atomic_clear(&linkStats.latencyMax);
+	atomic_clear(&linkStats.retransmitted);
+	atomic_clear(&linkStats.retransmitMissed);
+	atomic_clear(&linkStats.nackLive);
+
+	liveSequence = 0;
+	prioritySequence = 0;
+
 	//calculate max length of json message for memory allocation
+	//(all channels are counted, they can be enabled at runtime by the control server)
 	for(int i=0; i<configFile.sensorCount;i++)		//loop for every sensor
 	{
-		if(sensorBuffer[i].wifi_enable)			//if sensor is used in live telemetry
+		if(sensorBuffer[i].name_wifi != NULL)
 			udpQueueMesLength+=(strlen(sensorBuffer[i].name_wifi)+4+10);	//name length + 4 bytes for ,:"" + 10 bytes for number (32bits in decimal)
 	}
 
-	if(gpsBuffer.LiveCoordEnable)			//if gps coord is used in live telemetry
+	if(gpsBuffer.NameLiveCoord != NULL)
 			udpQueueMesLength+=(strlen(gpsBuffer.NameLiveCoord)+6+25);	//name length + 6 bytes for ,:"""" + 25 bytes for data
 	
-	if(gpsBuffer.LiveSpeedEnable)			//if gps coord is used in live telemetry
-			udpQueueMesLength+=(strlen(gpsBuffer.NameLiveSpeed)+4+7);	//name length + 4 bytes for ,:"" + 7 bytes for data
+	if(gpsBuffer.NameLiveSpeed != NULL)
+			udpQueueMesLength+=(strlen(gpsBuffer.NameLiveSpeed)+4+11);	//name length + 4 bytes for ,:"" + 11 bytes for data (32bits in hundredths)
 
-	if(gpsBuffer.LiveFixEnable)			//if gps coord is used in live telemetry
+	if(gpsBuffer.NameLiveFix != NULL)
 			udpQueueMesLength+=(strlen(gpsBuffer.NameLiveFix)+4+5);	//name length + 4 bytes for ,:"" + 5 bytes for data
 
 	udpQueueMesLength+=50;		// space for {} , logRecording and keepalive
+	udpQueueMesLength+=LIVE_LINK_CHANNEL_COUNT*(20+4+10);		// link statistics (name + ,:"" + number)
+	udpQueueMesLength+=LIVE_CLOCK_CHANNEL_COUNT*(20+4+11);		// clock synchronisation (name + ,:"" + signed number)
+	udpQueueMesLength+=configFile.serverCount*LIVE_SERVER_CHANNEL_COUNT*(20+4+10);		// server statistics (name + ,:"" + number)
+	udpQueueMesLength+=LIVE_WIFI_CHANNEL_COUNT*(20+4+11);		// wifi (name + ,:"" + signed number)
+	udpQueueMesLength+=LIVE_GPS_CHANNEL_COUNT*(20+4+10);		// gps statistics (name + ,:"" + number)
+	udpQueueMesLength+=(9+4+10);		// live level
+	udpQueueMesLength+=(3+4+10);		// sequence number
+	udpQueueMesLength+=(4+4+20);		// synchronised time
+	udpQueueMesLength+=(5+4+3);			// live class
+
+	if(liveBinary)		//binary packets and schema fragments must also fit in the message
+	{
+		int binaryLength = sizeof(tLiveHeader);
+		binaryLength+=configFile.sensorCount*4;										//sensors
+		binaryLength+=8+4;															//gps coord and speed
+		binaryLength+=2;															//gps fix and log recording
+		binaryLength+=LIVE_LINK_CHANNEL_COUNT*4;									//link statistics
+		binaryLength+=LIVE_CLOCK_CHANNEL_COUNT*4;									//clock synchronisation
+		binaryLength+=configFile.serverCount*LIVE_SERVER_CHANNEL_COUNT*4;			//server statistics
+		binaryLength+=LIVE_WIFI_CHANNEL_COUNT*4;									//wifi
+		binaryLength+=LIVE_GPS_CHANNEL_COUNT*4;										//gps statistics
+		binaryLength+=4;															//live level
+		if(liveDelta)		//delta packet : keyframe sequence + bitmap
+			binaryLength+=sizeof(tLiveDeltaHeader)+(MAX_LIVE_CHANNELS+7)/8;
+		if(configFile.liveClassCount > 0)		//class packet : class + bitmap
+			binaryLength+=sizeof(tLiveClassHeader)+(MAX_LIVE_CHANNELS+7)/8;
+		udpQueueMesLength = MAX(udpQueueMesLength,binaryLength);
+		udpQueueMesLength = MAX(udpQueueMesLength,sizeof(tLiveHeader)+sizeof(tLiveSchemaHeader)+LIVE_SCHEMA_FRAGMENT_SIZE);
+	}
+
+	//split the slab memory in blocks of the max message size
+	int blockSize = ROUND_UP(sizeof(tUdpMessage)+udpQueueMesLength,4);
+	int ret = k_mem_slab_init(&messageSlab,messageSlabBuffer,blockSize,MESSAGE_SLAB_SIZE/blockSize);
+	if(ret != 0)
+	{
+		LOG_ERR("message slab initialization failed (%d)",ret);
+		return;
+	}
+	LOG_INF("message slab : %d blocks of %d bytes",MESSAGE_SLAB_SIZE/blockSize,blockSize);
+
+	//retransmit history depth (blocks kept by the udp client after sending)
+	udpHistoryDepth = configFile.LiveHistoryDepth > 0 ? configFile.LiveHistoryDepth : DEFAULT_HISTORY_DEPTH;
+	udpHistoryDepth = MIN(udpHistoryDepth,UDP_HISTORY_MAX_DEPTH);
+	udpHistoryDepth = MAX(MIN(udpHistoryDepth,MESSAGE_SLAB_SIZE/blockSize/2-1),0);
+
+	//blocks of the priority queue
+	int priorityDepth = 0;
+	for(int c=0; c<configFile.liveClassCount; c++)
+	{
+		if(configFile.LiveClasses[c].Priority)
+			priorityDepth = UDP_PRIORITY_QUEUE_DEPTH;
+	}
 
+	//udp queue depth (one block is kept for the message being sent and one for the message being built)
+	udpQueueDepth = configFile.LiveQueueDepth > 0 ? configFile.LiveQueueDepth : DEFAULT_QUEUE_DEPTH;
+	udpQueueDepth = MIN(udpQueueDepth,UDP_QUEUE_MAX_DEPTH);
+	udpQueueDepth = MAX(MIN(udpQueueDepth,MESSAGE_SLAB_SIZE/blockSize-udpHistoryDepth-priorityDepth-2),1);
+	LOG_INF("udp queue depth : %d, history depth : %d",udpQueueDepth,udpHistoryDepth);
 	
-	k_timer_start(&dataSenderTimer, K_SECONDS(0), K_MSEC((int)(1000/configFile.LiveFrameRate)));
+	k_timer_start(&dataSenderTimer, K_SECONDS(0), K_MSEC(liveTick));
 }
@@ -23,10 +23,31 @@
 #ifndef __DATA_SENDER_H
 #define __DATA_SENDER_H
 
+#include "memory_management.h"
+#include "lap_timer.h"
+
+//live control types
+#define LIVE_CTRL_CHANNEL	1		//enable or disable a live channel
+#define LIVE_CTRL_RATE		2		//change the live frame rate
+
+/*! @brief live configuration change requested at runtime
+    @param type type of change (LIVE_CTRL_x)
+    @param enable channel enabled (LIVE_CTRL_CHANNEL)
+    @param value new frame rate (LIVE_CTRL_RATE)
+    @param name name of the channel in the live transmission (LIVE_CTRL_CHANNEL)
+*/
+typedef struct sLiveControl{
+    uint8_t type;
+    bool enable;
+    int value;
+    char name[32];
+}tLiveControl;
+
 /*! Data_Sender implements the Data_Sender task
 * @brief Data_Sender reads the data in the sensor buffer array and
-*        creates the json string to send via Wi-Fi to the base 
-*        station. This string is placed in the UDP_Client queue.
+*        creates the json string or the binary packet to send via 
+*        Wi-Fi to the base station. This message is placed in the 
+*        UDP_Client queue.
 */
 void Data_Sender();
 
@@ -42,5 +63,35 @@ void Task_Data_Sender_Init( void );
 */
 void data_Sender_timer_handler();
 
+/*! data_Sender_schema_request is called by the udp client
+* @brief data_Sender_schema_request sends the live schema and a keyframe 
+*        with the next data packet
+*/
+void data_Sender_schema_request();
+
+/*! data_Sender_spool is called by the udp client while the wifi is lost
+* @brief data_Sender_spool keeps a message of the udp queue in the spool
+*        and releases its block
+* @param msg message taken from the udp queue
+*/
+void data_Sender_spool(tUdpMessage * msg);
+
+/*! data_Sender_control is called by the control server
+* @brief data_Sender_control queues a live configuration change. The change
+*        is applied by the data sender before the next sample, so the
+*        schema of a packet is always consistent
+* @param ctrl requested change
+* @retval 0 on success, -ENOENT if the channel is unknown, -EINVAL if the 
+*         rate is invalid, -EAGAIN if too many changes are pending
+*/
+int data_Sender_control(const tLiveControl * ctrl);
+
+/*! data_Sender_lap_event is called by the gps controller
+* @brief data_Sender_lap_event queues an event of the lap timer, it is sent
+*        in a priority message at the next tick of the data sender
+* @param event event of the lap timer
+*/
+void data_Sender_lap_event(const tLapEvent * event);
+
 
 #endif /*__DATA_SENDER_H*/
\ No newline at end of file
@@ -29,7 +29,7 @@ LOG_MODULE_REGISTER(gps);
 #include <zephyr/device.h>
 #include <zephyr/sys/util.h>
 #include <zephyr/drivers/uart.h>
-#include <stdlib.h>
+#include <stdio.h>
 #include <zephyr/toolchain.h>
 #include <string.h>
 
@@ -37,6 +37,12 @@ LOG_MODULE_REGISTER(gps);
 #include "gps_controller.h"
 #include "memory_management.h"
 #include "config_read.h"
+#include "time_sync.h"
+#include "nmea_parser.h"
+#include "ubx_parser.h"
+#include "lap_timer.h"
+#include "can_controller.h"
+#include "data_sender.h"
 
 
 //! GPS thread priority level
@@ -52,43 +58,124 @@ static struct k_thread gpsControllerThread;
 // uart node
 #define UART_DEVICE_NODE_GPS DT_CHOSEN(zephyr_shell_uart_gps)
 
-//max size of NMEA message
-#define MSG_SIZE 85
+//size of a DMA receive buffer of the uart (several NMEA sentences or UBX messages)
+#define GPS_RX_BUF_SIZE 256
+//number of DMA receive buffers (two in the uart, the others wait for the parser)
+#define GPS_RX_BUF_COUNT 4
+//max number of received chunks waiting for the parser
+#define GPS_RX_CHUNK_COUNT 32
+//idle time of the line that ends a chunk (number of characters)
+#define GPS_RX_IDLE_CHARS 4
+
+//default navigation rate in the ubx protocol (fixes/second)
+#define GPS_UBX_DEFAULT_RATE 10
+//max navigation rate in the ubx protocol (fixes/second)
+#define GPS_UBX_MAX_RATE 25
+//default uart baudrate in the ubx protocol
+#define GPS_UBX_DEFAULT_BAUDRATE 115200
+//time for the module to apply a port configuration (ms)
+#define GPS_UBX_CONFIG_DELAY_MS 100
+//period of the gps statistics (ms)
+#define GPS_STATS_PERIOD_MS 5000
+
+//PPS output of the GPS module (optional, alias gps-pps in the devicetree)
+#define GPS_PPS_NODE DT_ALIAS(gps_pps)
+//max distance of a navigation epoch to the whole second to be paired with a pulse (ms)
+#define GPS_PPS_EPOCH_TOLERANCE_MS 5
+//uncertainty of the time of a pulse (interrupt latency, µs)
+#define GPS_PPS_UNCERTAINTY_US 10
 
 
 tGps gpsBuffer;
 K_MUTEX_DEFINE(gpsBufferMutex);
 
-// queue to store up to 10 messages (aligned to 4-byte boundary) 
-K_MSGQ_DEFINE(uart_msgq, MSG_SIZE, 10, 4);
+/*! @brief bytes received by the uart
+    @param data first byte in a DMA buffer, or DMA buffer released by the uart (length 0, NULL when the reception stopped)
+    @param length number of bytes
+    @param local local time of the last byte (µs since boot)
+*/
+typedef struct sGpsChunk{
+    uint8_t * data;
+    uint32_t length;
+    int64_t local;
+}tGpsChunk;
+
+// DMA buffers of the uart, a buffer is freed once all its bytes are parsed
+K_MEM_SLAB_DEFINE(gpsRxSlab, GPS_RX_BUF_SIZE, GPS_RX_BUF_COUNT, 4);
+// chunks received, written by the uart callback and read by the gps thread
+K_MSGQ_DEFINE(gpsChunkQueue, sizeof(tGpsChunk), GPS_RX_CHUNK_COUNT, 8);
+// reception stopped (no free buffer), restarted by the gps thread
+static atomic_t gpsRxStopped;
+// duration of a character at the current baudrate (µs)
+static uint32_t gpsCharUs;
 
 //uart device declaration
 static const struct device *const uart_dev_gps = DEVICE_DT_GET(UART_DEVICE_NODE_GPS);
 
-// receive buffer used in UART ISR callback 
-static char rx_buf[MSG_SIZE];
-static int rx_buf_pos;
-
-//serial callback function prototype
-/*!
- * @brief Read characters from UART until line end is detected. Afterwards push the
- * 		  data to the message queue.
- */
-void serial_cb(const struct device *dev, void *user_data);
+//NMEA parser of the gps thread
+static tNmeaParser nmeaParser;
+//UBX parser of the gps thread (GPS.Protocol = "ubx")
+static tUbxParser ubxParser;
+//the module sends UBX NAV-PVT messages instead of NMEA sentences
+static bool gpsUbx;
+//lap timer enabled (track lines in the config file)
+static bool gpsLap;
+
+//gps statistics
+tGpsStats gpsStats;
+
+#if DT_NODE_EXISTS(GPS_PPS_NODE)
+//PPS input, the pulse marks the start of each UTC second
+static const struct gpio_dt_spec gpsPps = GPIO_DT_SPEC_GET(GPS_PPS_NODE, gpios);
+static struct gpio_callback gpsPpsCallback;
+#endif
+//local time of the last pulse not yet paired with a gps time (µs since boot, 0 if none)
+static int64_t ppsLocal;
+static struct k_spinlock ppsLock;
+
+//static functions prototypes
+
+/*! @brief uart callback : pass the received chunks to the gps thread */
+static void gps_uart_cb(const struct device *dev, struct uart_event *evt, void *user_data);
+/*! @brief start the reception in a free DMA buffer */
+static int gps_rx_start(void);
+
+/*! @brief copy the values of a valid sentence in the gps buffer */
+static void gps_sentence(int sentence, const tNmeaData * data, int64_t frameLocal, bool * gpsFix);
+/*! @brief copy the values of a NAV-PVT message in the gps buffer */
+static void gps_pvt(const tUbxPvt * pvt, int64_t frameLocal);
+/*! @brief parse the received characters with the NMEA parser */
+static uint32_t gps_read_nmea(const uint8_t * data, uint32_t length, int64_t local, bool * gpsFix);
+/*! @brief parse the received bytes with the UBX parser */
+static uint32_t gps_read_ubx(const uint8_t * data, uint32_t length, int64_t local);
+/*! @brief configure the module for the NAV-PVT messages */
+static int gps_ubx_configure(void);
+/*! @brief send a UBX message to the module */
+static void gps_ubx_send(uint8_t msgClass, uint8_t msgId, const uint8_t * payload, uint16_t length);
+/*! @brief update the gps statistics */
+static void gps_stats(uint32_t fixes, uint64_t cycles, int64_t duration);
+/*! @brief use the gps time (and the last pulse) as reference of the synchronised clock */
+static void gps_time_reference(int year, int month, int day, uint32_t time, int64_t frameLocal);
+/*! @brief configure the PPS input */
+static void gps_pps_init(void);
+/*! @brief run the lap timer on a fix and send its events */
+static void gps_lap(int32_t lat, int32_t lon, uint32_t time, int64_t frameLocal);
 
 
 //-----------------------------------------------------------------------------------------------------------------------
 /*! GPS_Controller implements the GPS_Controller task
-* @brief GPS_Controller read the UART form GPS and fill the sensorBuffer array 
-*        
+* @brief GPS_Controller reads the characters received from the GPS one by
+*        one with the NMEA or UBX parser and fills the gps buffer with the
+*        values of the messages with a correct checksum
 */
 void GPS_Controller(void)
 {
 	//gps fix
 	bool gpsFix = false;
-	
-	//rx buffer
-	char rx_buf[MSG_SIZE];
+	//navigation solutions and cpu time since the last statistics
+	uint32_t statsFixes = 0;
+	uint64_t statsCycles = 0;
+	int64_t statsStart = k_uptime_get();
 
 	//check if uart device is ready
 	if (!device_is_ready(uart_dev_gps)) 
@@ -96,205 +183,456 @@ void GPS_Controller(void)
 		LOG_INF("UART device not found!");
 		return;
 	}
-	// configure interrupt and callback to receive data 
-	uart_irq_callback_user_data_set(uart_dev_gps, serial_cb, NULL);
-	uart_irq_rx_enable(uart_dev_gps);
 
-	// indefinitely wait for input from UART
-	while (k_msgq_get(&uart_msgq, &rx_buf, K_FOREVER) == 0) 
+	nmea_parser_init(&nmeaParser);
+	ubx_parser_init(&ubxParser);
+	gps_pps_init();
+	gpsLap = lap_timer_init();
+
+	gpsUbx = configFile.GPS.Protocol != NULL && strcmp(configFile.GPS.Protocol,"ubx") == 0;
+	if(gpsUbx && gps_ubx_configure() != 0)
 	{
+		LOG_ERR("GPS ubx configuration failed, nmea used");
+		gpsUbx = false;
+	}
 
-		//-----------------------------------------------------
-		//		NMEA GSA Frame -	GPS receiver operating mod
+	// receive with DMA, the uart reports a chunk when the line is idle or a buffer is full
+	struct uart_config uartConfig;
+	if(uart_config_get(uart_dev_gps, &uartConfig) != 0 || uartConfig.baudrate == 0)
+		uartConfig.baudrate = 9600;
+	gpsCharUs = 10000000 / uartConfig.baudrate;		//start, 8 data and stop bits
 
-		if(strstr(rx_buf,"$GNGSA"))
-		{
-			if(rx_buf[10]=='3')		//detect if gps has fix
-				gpsFix=true;
+	uart_callback_set(uart_dev_gps, gps_uart_cb, NULL);
+	if(gps_rx_start() != 0)
+	{
+		LOG_ERR("GPS uart reception not started");
+		return;
+	}
+
+	if(gpsUbx)		//rate and messages configured once the answers can be received
+	{
+		int rate = configFile.GPS.Rate > 0 ? MIN(configFile.GPS.Rate,GPS_UBX_MAX_RATE) : GPS_UBX_DEFAULT_RATE;
+		uint16_t measRate = 1000/rate;
+		uint8_t cfgRate[6] = { measRate & 0xFF, measRate >> 8, 1, 0, 0, 0 };		//measurement period (ms), 1 measurement per solution, UTC
+		uint8_t cfgMsg[3] = { UBX_CLASS_NAV, UBX_ID_NAV_PVT, 1 };				//NAV-PVT at every solution
+		uint8_t cfgMsgDop[3] = { UBX_CLASS_NAV, UBX_ID_NAV_DOP, 1 };			//NAV-DOP at every solution (HDOP)
+
+		gps_ubx_send(UBX_CLASS_CFG, UBX_ID_CFG_RATE, cfgRate, sizeof(cfgRate));
+		gps_ubx_send(UBX_CLASS_CFG, UBX_ID_CFG_MSG, cfgMsg, sizeof(cfgMsg));
+		gps_ubx_send(UBX_CLASS_CFG, UBX_ID_CFG_MSG, cfgMsgDop, sizeof(cfgMsgDop));
+		LOG_INF("GPS ubx NAV-PVT and NAV-DOP at %d Hz", rate);
+	}
+
+	// indefinitely wait for input from UART
+	tGpsChunk chunk;
+	while (k_msgq_get(&gpsChunkQueue, &chunk, K_FOREVER) == 0) 
+	{
+		uint32_t start = k_cycle_get_32();
 
+		if(chunk.length > 0)		//bytes parsed in place in the DMA buffer
+		{
+			if(gpsUbx)
+				statsFixes += gps_read_ubx(chunk.data, chunk.length, chunk.local);
 			else
-				gpsFix=false;
+				statsFixes += gps_read_nmea(chunk.data, chunk.length, chunk.local, &gpsFix);
+		}
+		else if(chunk.data != NULL)		//buffer released by the uart, all its bytes are parsed
+		{
+			k_mem_slab_free(&gpsRxSlab, (void **)&chunk.data);
+		}
+
+		if(atomic_cas(&gpsRxStopped, 1, 0) && gps_rx_start() != 0)		//restart once a buffer is free
+			atomic_set(&gpsRxStopped, 1);
+
+		statsCycles += k_cycle_get_32() - start;
 
-			k_mutex_lock(&gpsBufferMutex,K_FOREVER);		//lock gps buffer mutex
-			gpsBuffer.fix = gpsFix;							//copy gps fix value to buffer
-			k_mutex_unlock(&gpsBufferMutex);				//unlock mutex
+		int64_t now = k_uptime_get();
+		if(now - statsStart >= GPS_STATS_PERIOD_MS)
+		{
+			gps_stats(statsFixes, statsCycles, now - statsStart);
+			statsFixes = 0;
+			statsCycles = 0;
+			statsStart = now;
 		}
+	}
+}
 
-		//-----------------------------------------------------
-		//	NMEA RMC Frame - contains time and date
+//-----------------------------------------------------------------------------------------------------------------------
+/*! @brief parse the received characters with the NMEA parser
+* @param data characters received
+* @param length number of characters
+* @param local local time of the reception of the last character (µs since boot)
+* @param gpsFix current fix state, updated with the GSA sentences
+* @retval number of navigation solutions (RMC sentences) completed
+*/
+static uint32_t gps_read_nmea(const uint8_t * data, uint32_t length, int64_t local, bool * gpsFix)
+{
+	uint32_t fixes = 0;
 
-		//different parsing because the frame could contain empty items
-		// $GNRMC,162134.00,A,4617.63609,N,00731.94398,E,0.006,,170524,,,A,V*10
+	for(uint32_t i=0; i<length; i++)
+	{
+		int sentence = nmea_parse(&nmeaParser, data[i]);
 
-		if(strstr(rx_buf,"$GNRMC"))
+		if(sentence != NMEA_SENTENCE_NONE)		//valid sentence complete
 		{
-			// time and date buffers
-			char utcHour[3];
-			char utcMin[3];
-			char utcSec[3];
-			char cday[3];
-			char cmonth[3];
-			char cyear[3];
-			
-			char * ptr = rx_buf;
-
-			char * timePtr;
-			char * datePtr;
-
-			int i = 0;		//loop index
-
-			while(i<9)
-			{
-				if(*ptr==',')
-				{
-					i++;
-					if(i==1)
-					{
-						timePtr = ptr+1;
-					}
-					if(i==9)
-					{
-						datePtr = ptr+1;
-					}
-				}
-				ptr++;
-			}
+			int64_t frameLocal = local - (int64_t)(length - 1 - i) * gpsCharUs;		//reception of the end of the sentence (reference of the gps time)
 
-			strncpy(utcHour,timePtr,2);				// utc time
-			utcHour[2] = '\0';
-			strncpy(utcMin,timePtr+2,2);
-			utcMin[2] = '\0';
-			strncpy(utcSec,timePtr+4,2);
-			utcSec[2] = '\0';
-
-			strncpy(cyear,datePtr,2);				// date
-			cyear[2] = '\0';
-			strncpy(cmonth,datePtr+2,2);
-			cmonth[2] = '\0';
-			strncpy(cday,datePtr+4,2);
-			cday[2] = '\0';
-			
-			//calculate values
-			uint8_t hour = atoi(utcHour)+2;		//+2 to match center europa time
-			uint8_t min = atoi(utcMin);
-			uint8_t sec = atoi(utcSec);
-			
-			uint8_t day = atoi(cday);
-			uint8_t month = atoi(cmonth);
-			uint8_t year = atoi(cyear);
-
-			k_mutex_lock(&gpsBufferMutex,K_FOREVER);		//lock gps buffer mutex
-			gpsBuffer.hour=hour;
-			gpsBuffer.min=min;
-			gpsBuffer.sec=sec;
-			gpsBuffer.day=day;
-			gpsBuffer.month=month;
-			gpsBuffer.year=year;
-			k_mutex_unlock(&gpsBufferMutex);				//unlock mutex
+			gps_sentence(sentence, &nmeaParser.data, frameLocal, gpsFix);
+			if(sentence == NMEA_SENTENCE_RMC)
+				fixes++;
 		}
-	
+	}
+	return fixes;
+}
 
-		//analyse other frames only if GPS is fixed
-		if(gpsFix)	
+//-----------------------------------------------------------------------------------------------------------------------
+/*! @brief parse the received bytes with the UBX parser
+* @param data bytes received
+* @param length number of bytes
+* @param local local time of the reception of the last byte (µs since boot)
+* @retval number of navigation solutions (NAV-PVT messages) completed
+*/
+static uint32_t gps_read_ubx(const uint8_t * data, uint32_t length, int64_t local)
+{
+	uint32_t fixes = 0;
+
+	for(uint32_t i=0; i<length; i++)
+	{
+		switch(ubx_parse(&ubxParser, data[i]))
 		{
-			//-----------------------------------------------------
-			//	NMEA GLL Frame - contains latitude and longitude
+			case UBX_MSG_NAV_PVT:
+				gps_pvt(&ubxParser.pvt, local - (int64_t)(length - 1 - i) * gpsCharUs);		//reception of the end of the message
+				fixes++;
+			break;
+			case UBX_MSG_NAV_DOP:		//sent before NAV-PVT in each epoch
+				k_mutex_lock(&gpsBufferMutex,K_FOREVER);
+				gpsBuffer.hdop = ubxParser.dop.hDop;			//0.01
+				k_mutex_unlock(&gpsBufferMutex);
+			break;
+			case UBX_MSG_ACK:
+				LOG_INF("GPS ubx configuration 0x%02x 0x%02x accepted", ubxParser.ackClass, ubxParser.ackId);
+			break;
+			case UBX_MSG_NAK:
+				LOG_ERR("GPS ubx configuration 0x%02x 0x%02x rejected", ubxParser.ackClass, ubxParser.ackId);
+			break;
+		}
+	}
+	return fixes;
+}
 
-			if(strstr(rx_buf,"$GNGLL"))
-			{
-				// NMEA frame DMm + sign
-				char latDeg[4];
-				char latMin[12];
-				char latSign[2];
-				char lonDeg[4];
-				char lonMin[12];
-				char lonSign[2];
-				
-				char * saveptr=NULL;			//strtok save pointer
-				char * str = rx_buf;			//string of frame
-				char * token = (char*)strtok_r(str,",",&saveptr);	// get first token
-
-				int i = 0;		//loop index
-
-				//loop for all token of NMEA frame
-				while (token!=NULL) 
-				{  
-					token = (char*)strtok_r(NULL,",",&saveptr);	//get next token
-					switch(i)
-					{
-						case 0: strncpy(latDeg,token,2);				// latitude degree angle
-								latDeg[2] = '\0';
-								strncpy(latMin,token+2,2);				// latitude minutes
-								strcpy(latMin+2,token+5);				// latitude degrees of minutes
-						break;
-						case 1: strcpy(latSign,*token=='N' ? "" : "-");	// latitude sign (north or south)
-						break;
-						case 2: strncpy(lonDeg,token,3);				// longitude degree angle
-								lonDeg[3]='\0';
-								strncpy(lonMin,token+3,2);				// longitude minutes
-								strcpy(lonMin+2,token+6);				// longitude degrees of minutes
-						break;
-						case 3: strcpy(lonSign,*token=='E' ? "" : "-");	// longitude sign (west or east)
-						break;
-					}
-					if(i<3)				//break after 3 loops (other data not intersting)
-						i++;	
-					else
-						break;
-				}
-				
-				//calculate decimal coords from NMEA DM.m
-				uint32_t lat = atoi(latDeg);
-				uint32_t lon = atoi(lonDeg);
-				uint32_t lat_dec = atoi(latMin)/6;
-				uint32_t lon_dec = atoi(lonMin)/6;
-
-				//generate decimal coords string
-				char coord[25];
-				sprintf(coord,"%s%d.%d %s%d.%d",latSign,lat,lat_dec,lonSign,lon,lon_dec);
-
-				k_mutex_lock(&gpsBufferMutex,K_FOREVER);		//lock gps buffer mutex
-				strcpy(gpsBuffer.coord,coord);					//copy coords to gps buffer
-				gpsBuffer.lat_sign=latSign=='-'?0:1;
-				gpsBuffer.lat_characteristic=lat;
-				gpsBuffer.lat_mantissa=lat_dec;
-				gpsBuffer.long_sign=lonSign=='-'?0:1;
-				gpsBuffer.long_characteristic=lon;
-				gpsBuffer.long_mantissa=lon_dec;
-				k_mutex_unlock(&gpsBufferMutex);				//unlock mutex
-			}
+//-----------------------------------------------------------------------------------------------------------------------
+/*! @brief copy the values of a valid sentence in the gps buffer. The position
+*		  and the speed are used only while the GPS has a 3D fix
+* @param sentence type of the sentence (NMEA_SENTENCE_x)
+* @param data values of the sentence
+* @param frameLocal local time of the reception of the sentence (µs since boot)
+* @param gpsFix current fix state, updated with the GSA sentences
+*/
+static void gps_sentence(int sentence, const tNmeaData * data, int64_t frameLocal, bool * gpsFix)
+{
+	//-----------------------------------------------------
+	//		NMEA GSA Frame -	GPS receiver operating mode
+
+	if(sentence == NMEA_SENTENCE_GSA && (data->valid & NMEA_HAS_FIX_MODE))
+	{
+		*gpsFix = data->fixMode == 3;		//3D fix
+
+		k_mutex_lock(&gpsBufferMutex,K_FOREVER);		//lock gps buffer mutex
+		gpsBuffer.fix = *gpsFix;						//copy gps fix value to buffer
+		gpsBuffer.fixType = data->fixMode >= 2 ? data->fixMode : 0;
+		if(data->valid & NMEA_HAS_PDOP)
+			gpsBuffer.pdop = data->pdop;				//0.01
+		if(data->valid & NMEA_HAS_HDOP)
+			gpsBuffer.hdop = data->hdop;
+		k_mutex_unlock(&gpsBufferMutex);				//unlock mutex
+	}
 
+	//-----------------------------------------------------
+	//	NMEA GGA Frame - contains the satellites and the HDOP
 
-			//-----------------------------------------------------
-			//	NMEA VTG Frame - contains speed
+	if(sentence == NMEA_SENTENCE_GGA)
+	{
+		k_mutex_lock(&gpsBufferMutex,K_FOREVER);		//lock gps buffer mutex
+		if(data->valid & NMEA_HAS_SATELLITES)
+			gpsBuffer.satellites = data->satellites;
+		if(data->valid & NMEA_HAS_HDOP)
+			gpsBuffer.hdop = data->hdop;				//0.01
+		k_mutex_unlock(&gpsBufferMutex);				//unlock mutex
+	}
 
-			if(strstr(rx_buf,"$GNVTG"))
-			{
-				char *str = rx_buf;		//string buffer
-				char *saveptr = NULL;	//save pointer for strtok_r
-
-				char * token;			//token of data frame
-				char lastToken[12];		//variable to stock last token
-
-				token = (char*)strtok_r(str,",",&saveptr);			//get first token
-
-				while (token != NULL) 		//loop for all tokens
-				{
-					strcpy(lastToken, token);				//save token for next cycle
-					token = (char*)strtok_r(NULL, ",",&saveptr);	//get next token
-					if(token[0]=='K')		//if current token is 'K'				
-						break;				//speed is last token -> break
-				}
-
-				k_mutex_lock(&gpsBufferMutex,K_FOREVER);		//lock gps buffer mutex
-				strcpy(gpsBuffer.speed,lastToken);				//read speed in frame
-				float fspeed = atof(lastToken);
-				gpsBuffer.ispeed = (uint8_t) fspeed;
-				k_mutex_unlock(&gpsBufferMutex);				//unlock mutex
-			}
-		}
+	//-----------------------------------------------------
+	//	NMEA RMC Frame - contains time and date
+
+	if(sentence == NMEA_SENTENCE_RMC && (data->valid & NMEA_HAS_TIME) && (data->valid & NMEA_HAS_DATE))
+	{
+		uint32_t sec = data->time / 1000;
+
+		if(configFile.TimeSyncGps && *gpsFix && data->year > 0)		//gps time as reference of the synchronised clock
+			gps_time_reference(data->year, data->month, data->day, data->time, frameLocal);
+
+		k_mutex_lock(&gpsBufferMutex,K_FOREVER);		//lock gps buffer mutex
+		gpsBuffer.time = data->time;
+		gpsBuffer.hour = sec/3600 + 2;					//+2 to match center europa time
+		gpsBuffer.min = (sec/60) % 60;
+		gpsBuffer.sec = sec % 60;
+		gpsBuffer.day = data->day;
+		gpsBuffer.month = data->month;
+		gpsBuffer.year = data->year;
+		k_mutex_unlock(&gpsBufferMutex);				//unlock mutex
 	}
-	
+
+	//analyse other frames only if GPS is fixed
+	if(!*gpsFix)
+	{
+		if(sentence == NMEA_SENTENCE_RMC && (data->valid & NMEA_HAS_TIME))
+			sendGpsFix();		//time and fix state of the epoch on the CAN bus
+		return;
+	}
+
+	//-----------------------------------------------------
+	//	NMEA GLL, RMC and GGA Frames - contain latitude and longitude
+
+	if(data->valid & NMEA_HAS_POSITION)
+	{
+		k_mutex_lock(&gpsBufferMutex,K_FOREVER);		//lock gps buffer mutex
+		gpsBuffer.lat = data->lat;						//1e-7 degree
+		gpsBuffer.lon = data->lon;
+		gpsBuffer.fixLocal = frameLocal / 1000;			//age of the fix
+		k_mutex_unlock(&gpsBufferMutex);				//unlock mutex
+
+		if(data->valid & NMEA_HAS_TIME)		//GGA, GLL and RMC of the same epoch are one fix for the lap timer
+			gps_lap(data->lat, data->lon, data->time, frameLocal);
+	}
+
+	//-----------------------------------------------------
+	//	NMEA VTG and RMC Frames - contain speed
+
+	if(data->valid & NMEA_HAS_SPEED)
+	{
+		k_mutex_lock(&gpsBufferMutex,K_FOREVER);		//lock gps buffer mutex
+		gpsBuffer.speed = data->speed;					//0.01 km/h
+		k_mutex_unlock(&gpsBufferMutex);				//unlock mutex
+	}
+
+	//RMC contains the whole solution, one CAN update per epoch
+	if(sentence == NMEA_SENTENCE_RMC && (data->valid & NMEA_HAS_TIME))
+		sendGpsFix();
+}
+
+//-----------------------------------------------------------------------------------------------------------------------
+/*! @brief copy the values of a NAV-PVT message in the gps buffer. The message
+*		  contains the whole solution, the position and the speed are used
+*		  only with a valid 3D fix
+* @param pvt values of the message
+* @param frameLocal local time of the reception of the message (µs since boot)
+*/
+static void gps_pvt(const tUbxPvt * pvt, int64_t frameLocal)
+{
+	bool fix = (pvt->valid & UBX_HAS_FIX_OK) && (pvt->fixType == UBX_FIX_3D || pvt->fixType == UBX_FIX_GNSS_DR);
+	bool dateTime = (pvt->valid & UBX_HAS_DATE) && (pvt->valid & UBX_HAS_TIME);
+	uint32_t sec = pvt->time / 1000;
+
+	if(configFile.TimeSyncGps && fix && dateTime)		//gps time as reference of the synchronised clock
+		gps_time_reference(pvt->year, pvt->month, pvt->day, pvt->time, frameLocal);
+
+	k_mutex_lock(&gpsBufferMutex,K_FOREVER);		//lock gps buffer mutex
+	gpsBuffer.fix = fix;
+	gpsBuffer.satellites = pvt->numSv;
+	gpsBuffer.fixType = fix ? pvt->fixType : (pvt->fixType == UBX_FIX_2D ? UBX_FIX_2D : UBX_FIX_NONE);
+	gpsBuffer.pdop = pvt->pDop;						//0.01, HDOP from NAV-DOP
+	if(dateTime)
+	{
+		gpsBuffer.time = pvt->time;
+		gpsBuffer.hour = sec/3600 + 2;					//+2 to match center europa time
+		gpsBuffer.min = (sec/60) % 60;
+		gpsBuffer.sec = sec % 60;
+		gpsBuffer.day = pvt->day;
+		gpsBuffer.month = pvt->month;
+		gpsBuffer.year = pvt->year % 100;
+	}
+	if(fix)
+	{
+		gpsBuffer.lat = pvt->lat;						//1e-7 degree
+		gpsBuffer.lon = pvt->lon;
+		gpsBuffer.speed = pvt->speed;					//0.01 km/h
+		gpsBuffer.fixLocal = frameLocal / 1000;			//age of the fix
+	}
+	k_mutex_unlock(&gpsBufferMutex);				//unlock mutex
+
+	sendGpsFix();		//position, time and speed of the epoch on the CAN bus
+
+	if(fix && (pvt->valid & UBX_HAS_TIME))
+		gps_lap(pvt->lat, pvt->lon, pvt->time, frameLocal);
+}
+
+//-----------------------------------------------------------------------------------------------------------------------
+/*! @brief run the lap timer on a fix and send its events on the CAN bus (logs
+*		  of the recorder) and in the live transmission
+* @param lat latitude of the fix (1e-7 degree)
+* @param lon longitude of the fix (1e-7 degree)
+* @param time UTC time of day of the fix (ms)
+* @param frameLocal local time of the reception of the fix (µs since boot)
+*/
+static void gps_lap(int32_t lat, int32_t lon, uint32_t time, int64_t frameLocal)
+{
+	tLapEvent events[LAP_TIMER_MAX_EVENTS];
+
+	if(!gpsLap)
+		return;
+
+	int count = lap_timer_fix(lat, lon, time, frameLocal, events);
+
+	for(int i=0; i<count; i++)
+	{
+		if(events[i].type == LAP_EVENT_LAP)
+			LOG_INF("lap %u : %u.%03u s", events[i].lap, events[i].duration/1000, events[i].duration%1000);
+		else
+			LOG_INF("lap %u sector %u : %u.%03u s", events[i].lap, events[i].sector+1, events[i].duration/1000, events[i].duration%1000);
+
+		sendLapEvent(&events[i]);
+		data_Sender_lap_event(&events[i]);
+	}
+}
+
+//-----------------------------------------------------------------------------------------------------------------------
+/*! @brief use the gps time as reference of the synchronised clock. The time
+*		  of a message is late by the computation and the transmission of the
+*		  solution (some tens of ms), so the pulse of the PPS output is used
+*		  when it is wired : the epoch on a whole second that follows a pulse
+*		  gives the UTC time of the pulse
+* @param year date of the epoch (2000..2099 or 0..99)
+* @param month date of the epoch
+* @param day date of the epoch
+* @param time UTC time of day of the epoch (ms)
+* @param frameLocal local time of the reception of the message (µs since boot)
+*/
+static void gps_time_reference(int year, int month, int day, uint32_t time, int64_t frameLocal)
+{
+	int64_t date = time_sync_utc(year, month, day, 0, 0, 0);
+	uint32_t fraction = time % 1000;
+
+	k_spinlock_key_t key = k_spin_lock(&ppsLock);
+	int64_t pulse = ppsLocal;
+	if(pulse != 0 && frameLocal - pulse >= 1000000LL)		//pulse without message in its second
+		ppsLocal = pulse = 0;
+	if(pulse != 0 && (fraction <= GPS_PPS_EPOCH_TOLERANCE_MS || fraction >= 1000 - GPS_PPS_EPOCH_TOLERANCE_MS))
+		ppsLocal = 0;		//paired with this epoch
+	else
+		pulse = 0;
+	k_spin_unlock(&ppsLock, key);
+
+	if(pulse != 0 && frameLocal > pulse)
+		time_sync_reference(date + ((time + 500) / 1000) * 1000000LL, pulse, TIME_SYNC_PPS, GPS_PPS_UNCERTAINTY_US);
+	else
+		time_sync_reference(date + (int64_t)time*1000, frameLocal, TIME_SYNC_GPS, 0);
+}
+
+//-----------------------------------------------------------------------------------------------------------------------
+/*! @brief PPS interrupt : record the local time of the pulse
+*/
+static void gps_pps_isr(const struct device *dev, struct gpio_callback *cb, uint32_t pins)
+{
+	int64_t local = time_sync_local();
+
+	k_spinlock_key_t key = k_spin_lock(&ppsLock);
+	ppsLocal = local;
+	k_spin_unlock(&ppsLock, key);
+}
+
+//-----------------------------------------------------------------------------------------------------------------------
+/*! @brief configure the PPS input (rising edge), nothing is done if the
+*		  gps-pps alias is not in the devicetree
+*/
+static void gps_pps_init(void)
+{
+#if DT_NODE_EXISTS(GPS_PPS_NODE)
+	if(!device_is_ready(gpsPps.port))
+	{
+		LOG_ERR("GPS PPS gpio not ready");
+		return;
+	}
+
+	gpio_pin_configure_dt(&gpsPps, GPIO_INPUT);
+	gpio_init_callback(&gpsPpsCallback, gps_pps_isr, BIT(gpsPps.pin));
+	gpio_add_callback(gpsPps.port, &gpsPpsCallback);
+	gpio_pin_interrupt_configure_dt(&gpsPps, GPIO_INT_EDGE_TO_ACTIVE);
+	LOG_INF("GPS PPS enabled");
+#else
+	ARG_UNUSED(gps_pps_isr);
+#endif
+}
+
+//-----------------------------------------------------------------------------------------------------------------------
+/*! @brief configure the port of the module : UBX output at GPS.Baudrate. The
+*		  configuration is sent at the devicetree baudrate (module after
+*		  power on) and again at the new baudrate (module already configured
+*		  before a reset of the device), it is not saved in the module
+* @retval 0 on success, -1 if the uart cannot be configured
+*/
+static int gps_ubx_configure(void)
+{
+	struct uart_config uartConfig;
+	uint32_t baudrate = configFile.GPS.Baudrate > 0 ? configFile.GPS.Baudrate : GPS_UBX_DEFAULT_BAUDRATE;
+
+	if(uart_config_get(uart_dev_gps, &uartConfig) != 0)
+		return -1;
+
+	//CFG-PRT : UART1, 8N1, baudrate, UBX and NMEA input, UBX output
+	uint8_t cfgPrt[20] = { 1, 0, 0, 0, 0xD0, 0x08, 0, 0,
+						   baudrate & 0xFF, (baudrate >> 8) & 0xFF, (baudrate >> 16) & 0xFF, baudrate >> 24,
+						   0x03, 0x00, 0x01, 0x00, 0, 0, 0, 0 };
+
+	gps_ubx_send(UBX_CLASS_CFG, UBX_ID_CFG_PRT, cfgPrt, sizeof(cfgPrt));
+	k_msleep(GPS_UBX_CONFIG_DELAY_MS);
+
+	uartConfig.baudrate = baudrate;
+	if(uart_configure(uart_dev_gps, &uartConfig) != 0)
+		return -1;
+
+	gps_ubx_send(UBX_CLASS_CFG, UBX_ID_CFG_PRT, cfgPrt, sizeof(cfgPrt));
+	k_msleep(GPS_UBX_CONFIG_DELAY_MS);
+
+	return 0;
+}
+
+//-----------------------------------------------------------------------------------------------------------------------
+/*! @brief send a UBX message to the module
+* @param msgClass class of the message
+* @param msgId id of the message
+* @param payload payload of the message
+* @param length payload length
+*/
+static void gps_ubx_send(uint8_t msgClass, uint8_t msgId, const uint8_t * payload, uint16_t length)
+{
+	uint8_t frame[UBX_FRAME_OVERHEAD + 20];		//largest configuration message (CFG-PRT)
+
+	if(length > sizeof(frame) - UBX_FRAME_OVERHEAD)
+		return;
+
+	int frameLength = ubx_frame(frame, msgClass, msgId, payload, length);
+	for(int i=0; i<frameLength; i++)
+		uart_poll_out(uart_dev_gps, frame[i]);
+}
+
+//-----------------------------------------------------------------------------------------------------------------------
+/*! @brief update the gps statistics of the last period. The cpu time per
+*		  fix covers the parsing of all the characters and the update of the
+*		  gps buffer, so the nmea and ubx paths can be compared
+* @param fixes navigation solutions received
+* @param cycles cpu cycles of the gps thread
+* @param duration duration of the period (ms)
+*/
+static void gps_stats(uint32_t fixes, uint64_t cycles, int64_t duration)
+{
+	uint32_t cpuPerFix = fixes > 0 ? (uint32_t)(k_cyc_to_ns_floor64(cycles) / fixes) : 0;
+	uint32_t errors = gpsUbx ? ubxParser.checksumErrors + ubxParser.formatErrors
+							 : nmeaParser.checksumErrors + nmeaParser.formatErrors;
+
+	atomic_set(&gpsStats.rate, (atomic_val_t)(fixes*1000 / duration));
+	atomic_set(&gpsStats.cpuPerFix, cpuPerFix);
+	atomic_set(&gpsStats.errors, errors);
+
+	LOG_DBG("GPS %s : %u fixes, %u ns cpu per fix, %u errors, %u overruns", gpsUbx ? "ubx" : "nmea", fixes, cpuPerFix, errors, (uint32_t)atomic_get(&gpsStats.overruns));
 }
 
 
@@ -323,35 +661,78 @@ void Task_GPS_Controller_Init( void )
 
 
 
+//-----------------------------------------------------------------------------------------------------------------------
+/*! @brief start the reception in a free DMA buffer, the second buffer is
+*		  given when the uart requests it
+* @retval 0 on success, negative error code otherwise
+*/
+static int gps_rx_start(void)
+{
+	uint8_t * buf;
+
+	int ret = k_mem_slab_alloc(&gpsRxSlab, (void **)&buf, K_NO_WAIT);
+	if(ret != 0)
+		return ret;
+
+	ret = uart_rx_enable(uart_dev_gps, buf, GPS_RX_BUF_SIZE, GPS_RX_IDLE_CHARS * gpsCharUs);
+	if(ret != 0)
+		k_mem_slab_free(&gpsRxSlab, (void **)&buf);
+	return ret;
+}
+
 //-----------------------------------------------------------------------------------------------------------------------
 /*!
- * @brief Read characters from UART until line end is detected. Afterwards push the
- * 		  data to the message queue.
+ * @brief uart callback (interrupt context) : pass the chunks received in
+ * 		  the DMA buffers to the gps thread, which parses them in place. There
+ * 		  is no interrupt per character, only one per chunk (idle line or
+ * 		  full buffer) and per buffer.
  */
-void serial_cb(const struct device *dev, void *user_data)
+static void gps_uart_cb(const struct device *dev, struct uart_event *evt, void *user_data)
 {
-	uint8_t c;
+	tGpsChunk chunk;
+	uint8_t * buf;
 
-	if (!uart_irq_update(uart_dev_gps)) {
-		return;
-	}
-
-	while (uart_irq_rx_ready(uart_dev_gps)) {
+	switch(evt->type)
+	{
+		case UART_RX_RDY:		//bytes received
+			chunk.data = evt->data.rx.buf + evt->data.rx.offset;
+			chunk.length = evt->data.rx.len;
+			chunk.local = time_sync_local();
+			if(evt->data.rx.offset + evt->data.rx.len < GPS_RX_BUF_SIZE)		//idle line : last byte received before the idle time
+				chunk.local -= GPS_RX_IDLE_CHARS * gpsCharUs;
+			if(k_msgq_put(&gpsChunkQueue, &chunk, K_NO_WAIT) != 0)
+				atomic_inc(&gpsStats.overruns);
+		break;
+
+		case UART_RX_BUF_REQUEST:		//second buffer of the double buffering
+			if(k_mem_slab_alloc(&gpsRxSlab, (void **)&buf, K_NO_WAIT) == 0)
+				uart_rx_buf_rsp(dev, buf, GPS_RX_BUF_SIZE);
+			else
+				atomic_inc(&gpsStats.overruns);		//no free buffer : the reception stops at the end of the current buffer
+		break;
 
-		uart_fifo_read(uart_dev_gps, &c, 1);
+		case UART_RX_BUF_RELEASED:		//freed by the gps thread after the chunks of the buffer
+			chunk.data = evt->data.rx_buf.buf;
+			chunk.length = 0;
+			if(k_msgq_put(&gpsChunkQueue, &chunk, K_NO_WAIT) != 0)
+			{
+				k_mem_slab_free(&gpsRxSlab, (void **)&chunk.data);		//the bytes still queued may be overwritten, the parser rejects them
+				atomic_inc(&gpsStats.overruns);
+			}
+		break;
 
-		if ((c == '\n' || c == '\r') && rx_buf_pos > 0) {
-			// terminate string 
-			rx_buf[rx_buf_pos] = '\0';
+		case UART_RX_STOPPED:		//line error (overrun, framing), followed by UART_RX_DISABLED
+			atomic_inc(&gpsStats.overruns);
+		break;
 
-			// if queue is full, message is silently dropped 
-			k_msgq_put(&uart_msgq, &rx_buf, K_NO_WAIT);
+		case UART_RX_DISABLED:		//restarted by the gps thread once a buffer is free
+			atomic_set(&gpsRxStopped, 1);
+			chunk.data = NULL;
+			chunk.length = 0;
+			k_msgq_put(&gpsChunkQueue, &chunk, K_NO_WAIT);		//wakes up the thread (already awake if the queue is full)
+		break;
 
-			// reset the buffer (it was copied to the msgq) 
-			rx_buf_pos = 0;
-		} else if (rx_buf_pos < (sizeof(rx_buf) - 1)) {
-			rx_buf[rx_buf_pos++] = c;
-		}
-		// else: characters beyond buffer size are dropped 
+		default:
+		break;
 	}
-}
\ No newline at end of file
+}
@@ -0,0 +1,293 @@
+/*! --------------------------------------------------------------------
+ *	Telemetry System	-	@file lap_timer.c
+ *----------------------------------------------------------------------
+ * HES-SO Valais Wallis
+ * Systems Engineering
+ * Infotronics
+ * ---------------------------------------------------------------------
+ * @author agent
+ * @date 19.10.2026
+ * ---------------------------------------------------------------------
+ * @brief Lap timer detects the crossings of the start/finish and sector
+ *        lines of the track between two GPS fixes. The time of a crossing
+ *        is interpolated between the times of the two fixes.
+ * ---------------------------------------------------------------------
+ * Telemetry system for the Valais Wallis Racing Team.
+ * This file contains code for the onboard device of the telemetry
+ * system. The system receives the data from the sensors on the CAN bus
+ * and the data from the GPS on a UART port. An SD Card contains a
+ * configuration file with all the system parameters. The measurements
+ * are sent via Wi-Fi to a computer on the base station. The measurements
+ * are also saved in a CSV file on the SD card.
+ *--------------------------------------------------------------------*/
+
+//includes
+#include <zephyr/logging/log.h>
+LOG_MODULE_REGISTER(lap);
+#include <zephyr/kernel.h>
+#include <zephyr/sys/util.h>
+#include <math.h>
+
+//project file includes
+#include "lap_timer.h"
+#include "config_read.h"
+
+
+//duration of a day (µs)
+#define LAP_DAY_US (86400LL*1000000LL)
+//max time between two fixes to interpolate a crossing (µs)
+#define LAP_MAX_GAP_US 2000000LL
+//max distance of a fix to the first point of a line (1e-7 degree, about 11 km)
+#define LAP_MAX_DISTANCE 1000000
+//max length of a line (1e-7 degree, about 1 km)
+#define LAP_MAX_LINE_LENGTH 100000
+//default min time between two start/finish crossings (ms)
+#define LAP_DEFAULT_MIN_LAP_TIME 10000
+
+/*! @brief timing line in local coordinates
+    @param lat latitude of the first point (1e-7 degree)
+    @param lon longitude of the first point (1e-7 degree)
+    @param dx east component of the line (1e-7 degree of latitude)
+    @param dy north component of the line (1e-7 degree)
+    @param direction side the line is crossed to (+1 or -1, 0 until the first crossing)
+*/
+typedef struct sLapLine{
+    int32_t lat;
+    int32_t lon;
+    int32_t dx;
+    int32_t dy;
+    int8_t direction;
+}tLapLine;
+
+static tLapLine startLine;						//start/finish line
+static tLapLine sectorLines[MAX_TRACK_SECTORS];	//sector lines in the order they are crossed
+static int sectorCount;							//number of sector lines
+static int32_t lonScale;						//cosine of the latitude of the track (Q16), converts the longitude to the latitude scale
+static int64_t minLapTime;						//min time between two start/finish crossings (µs)
+static bool lapEnable;							//start/finish line set
+
+static bool prevValid;			//previous fix received
+static int32_t prevLat;			//previous fix (1e-7 degree)
+static int32_t prevLon;
+static int64_t prevTime;		//UTC time of day of the previous fix (µs)
+
+static uint16_t lap;			//number of the current lap (0 until the first start/finish crossing)
+static int nextSector;			//index of the next sector line (sectorCount : start/finish line)
+static int64_t lapStart;		//UTC time of day of the start of the lap (µs)
+static int64_t sectorStart;		//UTC time of day of the start of the sector (µs)
+
+//static functions prototypes
+
+/*! @brief convert a line of the config file */
+static bool lap_line_init(tLapLine * line, const struct sTrackLine * config);
+/*! @brief test the crossing of a line between the previous and the current fix */
+static bool lap_line_cross(tLapLine * line, int32_t lat, int32_t lon, int64_t * fraction, int64_t * range);
+/*! @brief write an event */
+static void lap_event(tLapEvent * event, uint8_t type, uint8_t sector, int64_t duration, int64_t local);
+
+
+//-----------------------------------------------------------------------------------------------------------------------
+/*! lap_timer_init reads the lines of the track in the config file. The
+*  longitude scale is computed once for the latitude of the start/finish
+*  line, the fixes are then compared to the lines with integer math only
+* @retval true if the lap timer is enabled (start/finish line set)
+*/
+bool lap_timer_init(void)
+{
+	const struct sTrack * track = &configFile.GPS.Track;
+
+	lapEnable = false;
+	prevValid = false;
+	lap = 0;
+	nextSector = 0;
+
+	if(track->StartFinish.Lat1 == 0 && track->StartFinish.Lon1 == 0)		//no track in the config file
+		return false;
+
+	lonScale = (int32_t)(cos(track->StartFinish.Lat1 * (M_PI / 180.0 / 1e7)) * 65536.0);
+	minLapTime = (int64_t)(track->MinLapTime > 0 ? track->MinLapTime : LAP_DEFAULT_MIN_LAP_TIME) * 1000;
+
+	if(!lap_line_init(&startLine, &track->StartFinish))
+	{
+		LOG_ERR("lap timer : invalid start/finish line");
+		return false;
+	}
+
+	sectorCount = 0;
+	for(int i=0; i<MIN(track->sectorCount,MAX_TRACK_SECTORS); i++)
+	{
+		if(!lap_line_init(&sectorLines[sectorCount], &track->Sectors[i]))
+		{
+			LOG_ERR("lap timer : invalid sector line %d ignored", i+1);
+			continue;
+		}
+		sectorCount++;
+	}
+
+	lapEnable = true;
+	LOG_INF("lap timer : start/finish line and %d sector lines", sectorCount);
+	return true;
+}
+
+//-----------------------------------------------------------------------------------------------------------------------
+/*! lap_timer_fix tests the lines crossed since the previous fix. Only the
+*  start/finish line and the next sector line are tested, each test is a
+*  few 64 bits multiplications, so the time per fix is bounded
+* @param lat latitude of the fix (1e-7 degree)
+* @param lon longitude of the fix (1e-7 degree)
+* @param time UTC time of day of the fix (ms)
+* @param frameLocal local time of the reception of the fix (µs since boot)
+* @param events events of the crossings (LAP_TIMER_MAX_EVENTS)
+* @retval number of events written to events
+*/
+int lap_timer_fix(int32_t lat, int32_t lon, uint32_t time, int64_t frameLocal, tLapEvent * events)
+{
+	int count = 0;
+	int64_t now = (int64_t)time * 1000;
+
+	if(!lapEnable)
+		return 0;
+
+	int64_t elapsed = (now - prevTime + LAP_DAY_US) % LAP_DAY_US;		//time since the previous fix (midnight wrap)
+
+	if(prevValid && elapsed == 0)		//same epoch (several NMEA sentences of one fix)
+		return 0;
+
+	if(prevValid && elapsed <= LAP_MAX_GAP_US)
+	{
+		int64_t fraction, range;
+
+		//next sector line
+		if(lap > 0 && nextSector < sectorCount && lap_line_cross(&sectorLines[nextSector], lat, lon, &fraction, &range))
+		{
+			int64_t cross = prevTime + elapsed * fraction / range;		//interpolated time of the crossing
+
+			lap_event(&events[count++], LAP_EVENT_SECTOR, nextSector, cross - sectorStart, frameLocal - (prevTime + elapsed - cross));
+			sectorStart = cross;
+			nextSector++;
+		}
+
+		//start/finish line
+		if(lap_line_cross(&startLine, lat, lon, &fraction, &range))
+		{
+			int64_t cross = prevTime + elapsed * fraction / range;
+			int64_t local = frameLocal - (prevTime + elapsed - cross);
+
+			if(lap == 0)		//first crossing, start of the first lap
+			{
+				lap = 1;
+				lapStart = sectorStart = cross;
+				nextSector = 0;
+				LOG_INF("lap timer : lap 1 started");
+			}
+			else if((cross - lapStart + LAP_DAY_US) % LAP_DAY_US >= minLapTime)		//crossings closer to the start of the lap are ignored
+			{
+				if(nextSector == sectorCount && sectorCount > 0)		//last sector ends on the start/finish line
+					lap_event(&events[count++], LAP_EVENT_SECTOR, sectorCount, cross - sectorStart, local);
+				lap_event(&events[count++], LAP_EVENT_LAP, 0, cross - lapStart, local);
+				lap++;
+				lapStart = sectorStart = cross;
+				nextSector = 0;
+			}
+		}
+	}
+
+	prevValid = true;
+	prevLat = lat;
+	prevLon = lon;
+	prevTime = now;
+
+	return count;
+}
+
+//-----------------------------------------------------------------------------------------------------------------------
+/*! @brief write an event
+* @param event event
+* @param type event type (LAP_EVENT_x)
+* @param sector index of the completed sector
+* @param duration time of the sector or of the lap (µs, midnight wrap)
+* @param local local time of the crossing (µs since boot)
+*/
+static void lap_event(tLapEvent * event, uint8_t type, uint8_t sector, int64_t duration, int64_t local)
+{
+	event->type = type;
+	event->sector = sector;
+	event->lap = lap;
+	event->duration = (uint32_t)(((duration + LAP_DAY_US) % LAP_DAY_US + 500) / 1000);
+	event->local = local;
+}
+
+//-----------------------------------------------------------------------------------------------------------------------
+/*! @brief convert a line of the config file to the local coordinates. The
+*		  longitude is scaled to the latitude unit so that the distances are
+*		  the same in both directions
+* @param line converted line
+* @param config line of the config file
+* @retval false if the line is empty or too long
+*/
+static bool lap_line_init(tLapLine * line, const struct sTrackLine * config)
+{
+	line->lat = config->Lat1;
+	line->lon = config->Lon1;
+	line->dx = (int32_t)(((int64_t)(config->Lon2 - config->Lon1) * lonScale) >> 16);
+	line->dy = config->Lat2 - config->Lat1;
+	line->direction = 0;
+
+	if(line->dx == 0 && line->dy == 0)
+		return false;
+
+	return line->dx >= -LAP_MAX_LINE_LENGTH && line->dx <= LAP_MAX_LINE_LENGTH &&
+		   line->dy >= -LAP_MAX_LINE_LENGTH && line->dy <= LAP_MAX_LINE_LENGTH;
+}
+
+//-----------------------------------------------------------------------------------------------------------------------
+/*! @brief test the crossing of a line between the previous and the current
+*		  fix. The two fixes must be on both sides of the line and the path
+*		  between them must cross the line between its two points. A line
+*		  is only crossed in the direction of its first crossing
+* @param line line
+* @param lat latitude of the current fix (1e-7 degree)
+* @param lon longitude of the current fix (1e-7 degree)
+* @param fraction position of the crossing on the path (fraction / range, 0..1)
+* @param range denominator of fraction (> 0)
+* @retval true if the line is crossed
+*/
+static bool lap_line_cross(tLapLine * line, int32_t lat, int32_t lon, int64_t * fraction, int64_t * range)
+{
+	//fixes relative to the first point of the line, in the latitude unit
+	int32_t px = (int32_t)(((int64_t)(prevLon - line->lon) * lonScale) >> 16);
+	int32_t py = prevLat - line->lat;
+	int32_t cx = (int32_t)(((int64_t)(lon - line->lon) * lonScale) >> 16);
+	int32_t cy = lat - line->lat;
+
+	if(cx < -LAP_MAX_DISTANCE || cx > LAP_MAX_DISTANCE || cy < -LAP_MAX_DISTANCE || cy > LAP_MAX_DISTANCE ||
+	   px < -LAP_MAX_DISTANCE || px > LAP_MAX_DISTANCE || py < -LAP_MAX_DISTANCE || py > LAP_MAX_DISTANCE)
+		return false;		//far from the line
+
+	//side of the fixes (cross product with the line)
+	int64_t sidePrev = (int64_t)line->dx * py - (int64_t)line->dy * px;
+	int64_t sideCur = (int64_t)line->dx * cy - (int64_t)line->dy * cx;
+
+	if((sidePrev < 0) == (sideCur < 0))		//same side
+		return false;
+
+	int8_t direction = sideCur < 0 ? -1 : 1;
+	if(line->direction != 0 && line->direction != direction)		//crossed backwards
+		return false;
+
+	//position of the crossing on the line (0..1 between its two points)
+	int64_t den = sideCur - sidePrev;
+	int64_t num = (int64_t)px * (cy - py) - (int64_t)py * (cx - px);
+	if(den < 0)
+	{
+		den = -den;
+		num = -num;
+	}
+	if(num < 0 || num > den)		//path passes beside the line
+		return false;
+
+	line->direction = direction;
+	*fraction = sidePrev < 0 ? -sidePrev : sidePrev;
+	*range = den;
+	return true;
+}
@@ -0,0 +1,76 @@
+/*! --------------------------------------------------------------------
+ *	Telemetry System	-	@file lap_timer.h
+ *----------------------------------------------------------------------
+ * HES-SO Valais Wallis
+ * Systems Engineering
+ * Infotronics
+ * ---------------------------------------------------------------------
+ * @author agent
+ * @date 19.10.2026
+ * ---------------------------------------------------------------------
+ * @brief Lap timer detects the crossings of the start/finish and sector
+ *        lines of the track between two GPS fixes. The time of a crossing
+ *        is interpolated between the times of the two fixes.
+ * ---------------------------------------------------------------------
+ * Telemetry system for the Valais Wallis Racing Team.
+ * This file contains code for the onboard device of the telemetry
+ * system. The system receives the data from the sensors on the CAN bus
+ * and the data from the GPS on a UART port. An SD Card contains a
+ * configuration file with all the system parameters. The measurements
+ * are sent via Wi-Fi to a computer on the base station. The measurements
+ * are also saved in a CSV file on the SD card.
+ *--------------------------------------------------------------------*/
+
+#ifndef __LAP_TIMER_H
+#define __LAP_TIMER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * The lines are defined in the config file by two points (1e-7 degree).
+ * The first crossing of the start/finish line starts lap 1, the sectors
+ * end on the sector lines in the config order and the last sector ends on
+ * the start/finish line. Only the start/finish line and the next sector
+ * line are tested at each fix, so the work per fix does not depend on the
+ * number of sectors.
+ */
+
+//event types
+#define LAP_EVENT_SECTOR        1       //sector completed
+#define LAP_EVENT_LAP           2       //lap completed
+
+//max number of events of one fix (sector, last sector and lap)
+#define LAP_TIMER_MAX_EVENTS    3
+
+/*! @brief lap timer event
+    @param type event type (LAP_EVENT_x)
+    @param sector index of the completed sector (0 = first sector)
+    @param lap number of the lap of the event (1 = first lap)
+    @param duration time of the sector or of the lap (ms)
+    @param local local time of the crossing (µs since boot)
+*/
+typedef struct sLapEvent{
+    uint8_t type;
+    uint8_t sector;
+    uint16_t lap;
+    uint32_t duration;
+    int64_t local;
+}tLapEvent;
+
+/*! lap_timer_init reads the lines of the track in the config file
+* @retval true if the lap timer is enabled (start/finish line set)
+*/
+bool lap_timer_init(void);
+
+/*! lap_timer_fix tests the lines crossed since the previous fix
+* @param lat latitude of the fix (1e-7 degree)
+* @param lon longitude of the fix (1e-7 degree)
+* @param time UTC time of day of the fix (ms)
+* @param frameLocal local time of the reception of the fix (µs since boot)
+* @param events events of the crossings (LAP_TIMER_MAX_EVENTS)
+* @retval number of events written to events
+*/
+int lap_timer_fix(int32_t lat, int32_t lon, uint32_t time, int64_t frameLocal, tLapEvent * events);
+
+#endif /*__LAP_TIMER_H*/
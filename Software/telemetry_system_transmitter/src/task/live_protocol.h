@@ -0,0 +1,235 @@
+/*! --------------------------------------------------------------------
+ *	Telemetry System	-	@file live_protocol.h
+ *----------------------------------------------------------------------
+ * HES-SO Valais Wallis
+ * Systems Engineering
+ * Infotronics
+ * ---------------------------------------------------------------------
+ * @author agent
+ * @date 19.10.2026
+ * ---------------------------------------------------------------------
+ * @brief live protocol file contains the description of the binary
+ * 		  live telemetry format sent to the base station
+ * ---------------------------------------------------------------------
+ * Telemetry system for the Valais Wallis Racing Team.
+ * This file contains code for the onboard device of the telemetry
+ * system. The system receives the data from the sensors on the CAN bus
+ * and the data from the GPS on a UART port. An SD Card contains a
+ * configuration file with all the system parameters. The measurements
+ * are sent via Wi-Fi to a computer on the base station. The measurements
+ * are also saved in a CSV file on the SD card.
+ *--------------------------------------------------------------------*/
+
+#ifndef __LIVE_PROTOCOL_H
+#define __LIVE_PROTOCOL_H
+
+#include <stdint.h>
+
+/*
+ * Binary live format (all fields little endian)
+ *
+ *  - schema packet : header + schema fragment header + channel descriptors
+ *                    channel descriptor = type (1) | name length (1) | name |
+ *                                         unit length (1) | unit
+ *  - data packet   : header + values of all channels in schema order
+ *
+ * The gps values are fixed point (LIVE_CH_COORD, LIVE_CH_CENTI), they are
+ * formatted with all their decimals in json ("46.2270012 7.3594210", 12.34).
+ *
+ * Every sample has a sequence number (also sent as "Seq" in json). Samples
+ * kept during a Wi-Fi outage are sent later with their original sequence
+ * number, the base station merges them in order.
+ *
+ *  - delta packet  : header + delta header + bitmap (1 bit per channel,
+ *                    LSB first) + values of the changed channels. The
+ *                    values are compared to the keyframe (data packet)
+ *                    with the sequence number keyframeSequence, the base
+ *                    station drops the delta if it missed this keyframe.
+ *
+ *  - class packet  : header + class header + bitmap (1 bit per channel,
+ *                    LSB first) + values of the channels of one live
+ *                    class. Each class is sent with its own period, the
+ *                    channels of the other classes are not part of the
+ *                    sample. JSON class packets start with a "Class" key
+ *                    and contain only the channels of the class.
+ *                    The samples of the priority classes skip ahead of
+ *                    the queued samples, they have their own sequence
+ *                    numbers with LIVE_SEQUENCE_PRIORITY set, so the base
+ *                    station tracks them apart from the other samples.
+ *
+ *  - lap packet    : header + lap event, sent by the lap timer at each
+ *                    sector and lap with the time of the line crossing.
+ *                    Lap packets are binary in all the formats (the
+ *                    base station tells them from json by the first byte).
+ *
+ *  - batch packet  : batch header + entries, entry = time delta (2) |
+ *                    length (2) | packet (json string or binary packet)
+ *                    time delta = ms since the first packet of the batch
+ *
+ * The schema is split in fragments so that every packet fits in one
+ * datagram. The schema hash is the CRC32 of all the channel descriptors,
+ * the base station decodes a data packet only if it holds the complete
+ * schema with the same hash. JSON packets always start with '{' so both
+ * formats can be received on the same port.
+ *
+ * Every sample carries the synchronised time of the device (also sent as
+ * "Time" in json), 0 until the clock is synchronised. The device sends
+ * sync requests from a separate port, the base station answers to this
+ * port with its receive and transmit times.
+ */
+
+#define LIVE_MAGIC                  0x5456      //"VT" -> first bytes of every binary live packet
+#define LIVE_PROTOCOL_VERSION       4           //version of the binary live format
+
+//packet types
+#define LIVE_PKT_SCHEMA             1           //schema fragment
+#define LIVE_PKT_DATA               2           //values of all channels
+#define LIVE_PKT_BATCH              3           //several packets in one datagram
+#define LIVE_PKT_DELTA              4           //values of the channels changed since a keyframe
+#define LIVE_PKT_NACK               5           //missing sequences (base station -> device)
+#define LIVE_PKT_SYNC_REQUEST       6           //time sync request (device -> base station)
+#define LIVE_PKT_SYNC_RESPONSE      7           //time sync answer (base station -> device)
+#define LIVE_PKT_CLASS              8           //values of the channels of one live class
+#define LIVE_PKT_LAP                9           //lap or sector event of the lap timer
+
+//lap events
+#define LIVE_LAP_SECTOR             1           //sector completed
+#define LIVE_LAP_LAP                2           //lap completed
+
+//class of the channels that are not in a configured live class
+#define LIVE_CLASS_DEFAULT          0xFF
+
+//sequence space of the samples of the priority classes (bit set in their sequence number)
+#define LIVE_SEQUENCE_PRIORITY      0x80000000
+
+//max number of sequences in a NACK packet
+#define LIVE_NACK_MAX_COUNT         64
+
+//channel value types
+#define LIVE_CH_U32                 1           //unsigned 32 bits value (4 bytes)
+#define LIVE_CH_BOOL                2           //boolean value (1 byte)
+#define LIVE_CH_STRING              3           //text value (1 byte length + characters)
+#define LIVE_CH_I32                 4           //signed 32 bits value (4 bytes)
+#define LIVE_CH_COORD               5           //latitude and longitude (2 x signed 32 bits, 1e-7 degree)
+#define LIVE_CH_CENTI               6           //unsigned 32 bits value in hundredths (4 bytes, e.g. speed in 0.01 km/h)
+
+//scale of the fixed point channel values
+#define LIVE_COORD_SCALE            10000000    //LIVE_CH_COORD units per degree
+#define LIVE_CENTI_SCALE            100         //LIVE_CH_CENTI units per unit
+
+//max size of the channel descriptors in one schema fragment
+#define LIVE_SCHEMA_FRAGMENT_SIZE   1024
+
+/*! @brief header of all binary live packets
+    @param magic LIVE_MAGIC
+    @param version LIVE_PROTOCOL_VERSION
+    @param type packet type (LIVE_PKT_x)
+    @param keepAlive keep alive counter (same as KeepAliveCounter in json)
+    @param sequence sequence number of the sample (same as Seq in json)
+    @param schemaHash CRC32 of the channel descriptors
+    @param time synchronised time of the sample (µs since 1970, 0 if not synchronised)
+*/
+typedef struct __attribute__((packed)) sLiveHeader{
+    uint16_t magic;
+    uint8_t version;
+    uint8_t type;
+    uint8_t keepAlive;
+    uint32_t sequence;
+    uint32_t schemaHash;
+    uint64_t time;
+}tLiveHeader;
+
+/*! @brief header of a schema fragment (follows tLiveHeader)
+    @param fragmentIndex index of this fragment
+    @param fragmentCount number of fragments of the schema
+    @param firstChannel id of the first channel described in this fragment
+    @param channelCount number of channels described in this fragment
+*/
+typedef struct __attribute__((packed)) sLiveSchemaHeader{
+    uint8_t fragmentIndex;
+    uint8_t fragmentCount;
+    uint16_t firstChannel;
+    uint16_t channelCount;
+}tLiveSchemaHeader;
+
+/*! @brief header of a delta packet (follows tLiveHeader)
+    @param keyframeSequence sequence number of the keyframe the values are compared to
+*/
+typedef struct __attribute__((packed)) sLiveDeltaHeader{
+    uint32_t keyframeSequence;
+}tLiveDeltaHeader;
+
+/*! @brief header of a class packet (follows tLiveHeader)
+    @param liveClass index of the class in the config file (LIVE_CLASS_DEFAULT for the default stream)
+*/
+typedef struct __attribute__((packed)) sLiveClassHeader{
+    uint8_t liveClass;
+}tLiveClassHeader;
+
+/*! @brief lap event (follows tLiveHeader, the time of the header is the time of the line crossing)
+    @param event event type (LIVE_LAP_x)
+    @param sector index of the completed sector (0 = first sector)
+    @param lap number of the lap of the event (1 = first lap)
+    @param duration time of the sector or of the lap (ms)
+*/
+typedef struct __attribute__((packed)) sLiveLap{
+    uint8_t event;
+    uint8_t sector;
+    uint16_t lap;
+    uint32_t duration;
+}tLiveLap;
+
+/*! @brief header of a batch packet (replaces tLiveHeader)
+    @param magic LIVE_MAGIC
+    @param version LIVE_PROTOCOL_VERSION
+    @param type LIVE_PKT_BATCH
+    @param count number of entries in the batch
+*/
+typedef struct __attribute__((packed)) sLiveBatchHeader{
+    uint16_t magic;
+    uint8_t version;
+    uint8_t type;
+    uint8_t count;
+}tLiveBatchHeader;
+
+/*! @brief header of a batch entry (followed by the packet)
+    @param timeDelta time since the first packet of the batch (ms)
+    @param length length of the packet
+*/
+typedef struct __attribute__((packed)) sLiveBatchEntry{
+    uint16_t timeDelta;
+    uint16_t length;
+}tLiveBatchEntry;
+
+/*! @brief header of a NACK packet sent by the base station to the port the
+    live packets come from (followed by count sequence numbers of 4 bytes)
+    @param magic LIVE_MAGIC
+    @param version LIVE_PROTOCOL_VERSION
+    @param type LIVE_PKT_NACK
+    @param count number of missing sequences
+*/
+typedef struct __attribute__((packed)) sLiveNackHeader{
+    uint16_t magic;
+    uint8_t version;
+    uint8_t type;
+    uint8_t count;
+}tLiveNackHeader;
+
+/*! @brief time sync packet (request and answer)
+    @param magic LIVE_MAGIC
+    @param version LIVE_PROTOCOL_VERSION
+    @param type LIVE_PKT_SYNC_REQUEST or LIVE_PKT_SYNC_RESPONSE
+    @param originTime local time of the device when the request was sent (µs, copied in the answer)
+    @param receiveTime time of the base station when the request was received (µs since 1970)
+    @param transmitTime time of the base station when the answer was sent (µs since 1970)
+*/
+typedef struct __attribute__((packed)) sLiveSync{
+    uint16_t magic;
+    uint8_t version;
+    uint8_t type;
+    uint64_t originTime;
+    uint64_t receiveTime;
+    uint64_t transmitTime;
+}tLiveSync;
+
+#endif /*__LIVE_PROTOCOL_H*/
@@ -0,0 +1,126 @@
+/*! --------------------------------------------------------------------
+ *	Telemetry System	-	@file live_spool.c
+ *----------------------------------------------------------------------
+ * HES-SO Valais Wallis 
+ * Systems Engineering
+ * Infotronics
+ * ---------------------------------------------------------------------
+ * @author agent
+ * @date 19.10.2026
+ * ---------------------------------------------------------------------
+ * @brief Live spool keeps the live messages in RAM while the Wi-Fi
+ *        connection is lost. The messages are sent back to the base 
+ *        station when the connection is restored (backfill).
+ * ---------------------------------------------------------------------
+ * Telemetry system for the Valais Wallis Racing Team.
+ * This file contains code for the onboard device of the telemetry
+ * system. The system receives the data from the sensors on the CAN bus 
+ * and the data from the GPS on a UART port. An SD Card contains a 
+ * configuration file with all the system parameters. The measurements 
+ * are sent via Wi-Fi to a computer on the base station. The measurements 
+ * are also saved in a CSV file on the SD card. 
+ *--------------------------------------------------------------------*/
+
+//includes
+#include <zephyr/kernel.h>
+#include <zephyr/sys/ring_buffer.h>
+
+//project file includes
+#include "live_spool.h"
+
+//spool memory : records of 2 bytes length + message
+RING_BUF_DECLARE(spoolRing, LIVE_SPOOL_SIZE);
+K_MUTEX_DEFINE(spoolMutex);
+
+static int spoolCount;		//number of messages in the spool
+
+//static functions prototypes
+
+/*! @brief remove the oldest record of the spool (mutex must be locked) */
+static void live_spool_drop_oldest(void);
+
+//-----------------------------------------------------------------------------------------------------------------------
+/*! live_spool_put stores a message in the spool
+* @brief the oldest messages are dropped if the spool is full
+* @param data content of the message
+* @param length length of the message
+* @retval number of old messages dropped to store this one
+*/
+int live_spool_put(const uint8_t * data, uint16_t length)
+{
+	int dropped = 0;
+
+	if(length + sizeof(length) > LIVE_SPOOL_SIZE)		//message can never fit
+		return 0;
+
+	k_mutex_lock(&spoolMutex,K_FOREVER);		//lock spool mutex
+
+	while(ring_buf_space_get(&spoolRing) < length + sizeof(length))		//make room for the message
+	{
+		live_spool_drop_oldest();
+		dropped++;
+	}
+
+	ring_buf_put(&spoolRing,(uint8_t *)&length,sizeof(length));		//record length
+	ring_buf_put(&spoolRing,data,length);								//record content
+	spoolCount++;
+
+	k_mutex_unlock(&spoolMutex);				//unlock spool mutex
+
+	return dropped;
+}
+
+//-----------------------------------------------------------------------------------------------------------------------
+/*! live_spool_get removes the oldest message from the spool
+* @brief the message is dropped if it does not fit in the buffer
+* @param data buffer for the message
+* @param size size of the buffer
+* @retval length of the message, 0 if the spool is empty
+*/
+int live_spool_get(uint8_t * data, int size)
+{
+	uint16_t length = 0;
+
+	k_mutex_lock(&spoolMutex,K_FOREVER);		//lock spool mutex
+
+	if(spoolCount > 0)
+	{
+		ring_buf_get(&spoolRing,(uint8_t *)&length,sizeof(length));		//record length
+
+		if(length <= size)
+		{
+			ring_buf_get(&spoolRing,data,length);			//record content
+		}
+		else
+		{
+			ring_buf_get(&spoolRing,NULL,length);			//discard record
+			length = 0;
+		}
+		spoolCount--;
+	}
+
+	k_mutex_unlock(&spoolMutex);				//unlock spool mutex
+
+	return length;
+}
+
+//-----------------------------------------------------------------------------------------------------------------------
+/*! live_spool_count 
+* @brief number of messages in the spool
+*/
+int live_spool_count(void)
+{
+	return spoolCount;
+}
+
+//-----------------------------------------------------------------------------------------------------------------------
+/*! @brief remove the oldest record of the spool (mutex must be locked)
+*/
+static void live_spool_drop_oldest(void)
+{
+	uint16_t length;
+
+	ring_buf_get(&spoolRing,(uint8_t *)&length,sizeof(length));		//record length
+	ring_buf_get(&spoolRing,NULL,length);							//discard record
+	spoolCount--;
+}
@@ -0,0 +1,51 @@
+/*! --------------------------------------------------------------------
+ *	Telemetry System	-	@file live_spool.h
+ *----------------------------------------------------------------------
+ * HES-SO Valais Wallis 
+ * Systems Engineering
+ * Infotronics
+ * ---------------------------------------------------------------------
+ * @author agent
+ * @date 19.10.2026
+ * ---------------------------------------------------------------------
+ * @brief Live spool keeps the live messages in RAM while the Wi-Fi
+ *        connection is lost. The messages are sent back to the base 
+ *        station when the connection is restored (backfill).
+ * ---------------------------------------------------------------------
+ * Telemetry system for the Valais Wallis Racing Team.
+ * This file contains code for the onboard device of the telemetry
+ * system. The system receives the data from the sensors on the CAN bus 
+ * and the data from the GPS on a UART port. An SD Card contains a 
+ * configuration file with all the system parameters. The measurements 
+ * are sent via Wi-Fi to a computer on the base station. The measurements 
+ * are also saved in a CSV file on the SD card. 
+ *--------------------------------------------------------------------*/
+#ifndef __LIVE_SPOOL_H
+#define __LIVE_SPOOL_H
+
+#include <stdint.h>
+
+#define LIVE_SPOOL_SIZE 32768		//memory of the spool (bytes)
+
+/*! live_spool_put stores a message in the spool
+* @brief the oldest messages are dropped if the spool is full
+* @param data content of the message
+* @param length length of the message
+* @retval number of old messages dropped to store this one
+*/
+int live_spool_put(const uint8_t * data, uint16_t length);
+
+/*! live_spool_get removes the oldest message from the spool
+* @brief the message is dropped if it does not fit in the buffer
+* @param data buffer for the message
+* @param size size of the buffer
+* @retval length of the message, 0 if the spool is empty
+*/
+int live_spool_get(uint8_t * data, int size);
+
+/*! live_spool_count 
+* @brief number of messages in the spool
+*/
+int live_spool_count(void);
+
+#endif /*__LIVE_SPOOL_H*/
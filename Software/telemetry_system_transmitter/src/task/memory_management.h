@@ -28,14 +28,46 @@
 
 #define MAX_SERVERS 5           //max number of server the system can send data to
 #define MAX_SENSORS 100         //max number of sensors
+#define CFG_FILE_MAX_SIZE 32768  //max size of the config file without the spaces between the tokens (bytes)
+#define MAX_LIVE_PRIORITY 16    //max number of channels in the live priority order
+#define MAX_LIVE_CLASSES 4      //max number of live classes
+#define MAX_TRACK_SECTORS 8     //max number of sector lines of the lap timer
 
-//memory heap for udp messages
-extern struct k_heap messageHeap;
+#define MESSAGE_SLAB_SIZE 32768     //memory for the udp messages (bytes)
+#define UDP_QUEUE_MAX_DEPTH 64      //size of the udp queue (the used depth is set in the config file)
+#define UDP_HISTORY_MAX_DEPTH 32    //max number of sent messages kept for retransmission
+#define UDP_PRIORITY_QUEUE_DEPTH 4  //size of the udp queue of the priority classes
+
+//memory slab for udp messages (fixed size blocks of udpQueueMesLength bytes)
+extern char messageSlabBuffer[MESSAGE_SLAB_SIZE];
+extern struct k_mem_slab messageSlab;
 
 
 //queues
-extern struct k_queue udpQueue;
+extern struct k_msgq udpQueue;
+extern struct k_msgq udpPriorityQueue;
 extern int udpQueueMesLength;
+extern int udpHistoryDepth;
+
+#define UDP_MSG_RETRANSMIT BIT(0)  //message kept in the retransmit history after sending
+#define UDP_MSG_PRIORITY BIT(1)    //message of a priority class (priority queue, sent without batching)
+#define UDP_MSG_GROUP_NACKED BIT(2) //NACK of the message already handled for a multicast or broadcast server (once for all the laptops)
+#define UDP_MSG_NO_SEQUENCE 0xFFFFFFFF  //sequence of the messages that are never kept in the history (backfilled samples)
+
+/*! @brief udp message struct (block of the message slab, passed by pointer in the udp queue)
+    @param timestamp uptime when the message was queued (ms)
+    @param sequence sequence number of the sample in the message
+    @param flags message flags (UDP_MSG_x)
+    @param length length of the message in bytes
+    @param data content of the message (json string or binary packet)
+*/
+typedef struct sUdpMessage{
+    uint32_t timestamp;
+    uint32_t sequence;
+    uint8_t flags;
+    uint16_t length;
+    uint8_t data[];
+}tUdpMessage;
 
 /*! @brief sensor buffer struct
     @param name_wifi name of the sensor in the live transmission
@@ -71,15 +103,76 @@ extern struct k_mutex sensorBufferMutex;
 
 extern bool logEnable;
 
+/*! @brief live link statistics (reported in the live transmission)
+    @param enqueued messages put in the udp queue
+    @param sent messages sent to the server(s)
+    @param dropped messages dropped (queue or spool full, no connection)
+    @param latencyMax max time spent in the queue since the last report (ms)
+    @param retransmitted messages sent again after a NACK of the base station
+    @param retransmitMissed NACKed messages no longer in the history or too old
+    @param nackLive NACKed messages found in the history (live samples lost on the current connection)
+*/
+typedef struct sLinkStats{
+    atomic_t enqueued;
+    atomic_t sent;
+    atomic_t dropped;
+    atomic_t latencyMax;
+    atomic_t retransmitted;
+    atomic_t retransmitMissed;
+    atomic_t nackLive;
+}tLinkStats;
+extern tLinkStats linkStats;
+
+/*! @brief statistics of a server (reported in the live transmission)
+    @param healthy server reachable
+    @param sent datagrams sent to the server
+    @param errors send errors (datagrams dropped for this server)
+    @param reconnects reconnections after an error
+    @param latencyMax max duration of a send call (us)
+*/
+typedef struct sServerStats{
+    atomic_t healthy;
+    atomic_t sent;
+    atomic_t errors;
+    atomic_t reconnects;
+    atomic_t latencyMax;
+}tServerStats;
+extern tServerStats serverStats[MAX_SERVERS];
+
+/*! @brief wifi statistics (reported in the live transmission)
+    @param rssi rssi of the current connection (dBm)
+    @param network router of the current connection (0 = WiFiRouter, 1 = WiFiRouterRedundancy)
+    @param roams switches to the other router because of a weak signal
+    @param outageTime duration of the last outage, from the connection loss to the ip (ms)
+    @param reconnectTime duration of the last connection, from the request to the ip (ms)
+*/
+typedef struct sWifiStats{
+    atomic_t rssi;
+    atomic_t network;
+    atomic_t roams;
+    atomic_t outageTime;
+    atomic_t reconnectTime;
+}tWifiStats;
+extern tWifiStats wifiStats;
+
+/*! @brief gps statistics (reported in the live transmission)
+    @param rate navigation solutions received per second (fixes/s)
+    @param cpuPerFix cpu time of the gps thread per navigation solution (ns, nmea or ubx path)
+    @param errors messages dropped because of the checksum or the format
+    @param overruns receptions lost by the uart (no free DMA buffer, chunk queue full or line error)
+*/
+typedef struct sGpsStats{
+    atomic_t rate;
+    atomic_t cpuPerFix;
+    atomic_t errors;
+    atomic_t overruns;
+}tGpsStats;
+extern tGpsStats gpsStats;
+
 /*! @brief gps buffer struct
-    @param speed current gps speed
-    @param coord current gps coords
-    @param lat_sign sign of the latitude (0==- ; 1==+)
-    @param lat_characteristic integer part of the latitude
-    @param lat_mantissa fractionnal part of the latitude
-    @param long_sign sign of the longitude (0==- ; 1==+)
-    @param long_characteristic integer part of the longitude
-    @param long_mantissa fractionnal part of the longitude
+    @param speed current gps speed (0.01 km/h)
+    @param lat current latitude (1e-7 degree, north positive)
+    @param lon current longitude (1e-7 degree, east positive)
     @param hour current time
     @param min current time
     @param sec current time
@@ -87,6 +180,12 @@ extern bool logEnable;
     @param month current date
     @param year current date
     @param fix current gps fix status
+    @param time UTC time of day of the last epoch (ms)
+    @param satellites number of satellites used in the solution (0 if unknown)
+    @param fixType fix type (0 = no fix, 2 = 2D, 3 = 3D, 4 = GNSS and dead reckoning)
+    @param hdop horizontal dilution of precision (0.01, 0 if unknown)
+    @param pdop position dilution of precision (0.01, 0 if unknown)
+    @param fixLocal local time of the last epoch with a fix (ms since boot, 0 if none)
     @param NameLiveCoord name of the coord field in the live transmission
     @param NameLogCoord name of the coord field in the logs
     @param LiveCoordEnable coords enabled in the live transmission
@@ -98,15 +197,9 @@ extern bool logEnable;
     @param LiveFixEnable fix status enabled in the live transmission
 */
 typedef struct sGps{
-    char speed[10];
-    uint8_t ispeed;
-    char coord[25];
-    uint16_t lat_sign;
-    uint16_t lat_characteristic;
-    uint32_t lat_mantissa;
-    uint16_t long_sign;
-    uint16_t long_characteristic;
-    uint32_t long_mantissa;
+    uint32_t speed;
+    int32_t lat;
+    int32_t lon;
     uint8_t hour;
     uint8_t min;
     uint8_t sec;
@@ -114,6 +207,12 @@ typedef struct sGps{
     uint8_t month;
     uint8_t year;
     bool fix;
+    uint32_t time;
+    uint8_t satellites;
+    uint8_t fixType;
+    uint16_t hdop;
+    uint16_t pdop;
+    int64_t fixLocal;
     char * NameLiveCoord;
     char * NameLogCoord;
     bool LiveCoordEnable;
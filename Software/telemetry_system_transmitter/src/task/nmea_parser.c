@@ -0,0 +1,425 @@
+/*! --------------------------------------------------------------------
+ *	Telemetry System	-	@file nmea_parser.c
+ *----------------------------------------------------------------------
+ * HES-SO Valais Wallis
+ * Systems Engineering
+ * Infotronics
+ * ---------------------------------------------------------------------
+ * @author agent
+ * @date 19.10.2026
+ * ---------------------------------------------------------------------
+ * @brief NMEA parser reads the sentences of the GPS module one byte at
+ *        a time. The fields are converted while they are received (no
+ *        copy of the sentence) and the values are published only if
+ *        the checksum of the sentence is correct.
+ * ---------------------------------------------------------------------
+ * Telemetry system for the Valais Wallis Racing Team.
+ * This file contains code for the onboard device of the telemetry
+ * system. The system receives the data from the sensors on the CAN bus
+ * and the data from the GPS on a UART port. An SD Card contains a
+ * configuration file with all the system parameters. The measurements
+ * are sent via Wi-Fi to a computer on the base station. The measurements
+ * are also saved in a CSV file on the SD card.
+ *--------------------------------------------------------------------*/
+
+//includes
+#include <stddef.h>
+#include <stdint.h>
+
+//project file includes
+#include "nmea_parser.h"
+
+//states of the parser
+#define NMEA_STATE_WAIT         0       //waiting for '$'
+#define NMEA_STATE_BODY         1       //address and fields
+#define NMEA_STATE_CHECKSUM1    2       //first checksum digit
+#define NMEA_STATE_CHECKSUM2    3       //second checksum digit
+
+//max number of digits kept after '.' in a numeric field
+#define NMEA_MAX_DECIMALS       7
+//max number of fields read in a sentence (the next ones are ignored, HDOP is field 16 of GSA)
+#define NMEA_MAX_FIELDS         17
+
+//parts of the position received in the current sentence (internal flags of tNmeaData.valid)
+#define NMEA_PART_LAT           (1u << 16)
+#define NMEA_PART_NS            (1u << 17)
+#define NMEA_PART_LON           (1u << 18)
+#define NMEA_PARTS              (NMEA_PART_LAT | NMEA_PART_NS | NMEA_PART_LON)
+
+//kinds of fields
+#define NMEA_F_SKIP             0
+#define NMEA_F_TIME             1       //hhmmss.ss
+#define NMEA_F_LAT              2       //ddmm.mmmm
+#define NMEA_F_NS               3       //N or S
+#define NMEA_F_LON              4       //dddmm.mmmm
+#define NMEA_F_EW               5       //E or W
+#define NMEA_F_QUALITY          6       //fix quality
+#define NMEA_F_STATUS           7       //A (valid) or V
+#define NMEA_F_FIX_MODE         8       //1, 2 or 3
+#define NMEA_F_KNOTS            9       //speed in knots
+#define NMEA_F_KMH              10      //speed in km/h
+#define NMEA_F_DATE             11      //ddmmyy
+#define NMEA_F_SATELLITES       12      //number of satellites used
+#define NMEA_F_HDOP             13      //horizontal dilution of precision
+#define NMEA_F_PDOP             14      //position dilution of precision
+
+//id of a sentence from the last 3 characters of its address
+#define NMEA_ID(a,b,c)          (((uint32_t)(a) << 16) | ((uint32_t)(b) << 8) | (uint32_t)(c))
+
+//fields of each sentence (index 0 = address)
+static const uint8_t nmeaFields[][NMEA_MAX_FIELDS] = {
+	[NMEA_SENTENCE_GGA] = { NMEA_F_SKIP, NMEA_F_TIME, NMEA_F_LAT, NMEA_F_NS, NMEA_F_LON, NMEA_F_EW, NMEA_F_QUALITY, NMEA_F_SATELLITES, NMEA_F_HDOP },
+	[NMEA_SENTENCE_GLL] = { NMEA_F_SKIP, NMEA_F_LAT, NMEA_F_NS, NMEA_F_LON, NMEA_F_EW, NMEA_F_TIME, NMEA_F_STATUS },
+	[NMEA_SENTENCE_GSA] = { NMEA_F_SKIP, NMEA_F_SKIP, NMEA_F_FIX_MODE, [15] = NMEA_F_PDOP, [16] = NMEA_F_HDOP },
+	[NMEA_SENTENCE_RMC] = { NMEA_F_SKIP, NMEA_F_TIME, NMEA_F_STATUS, NMEA_F_LAT, NMEA_F_NS, NMEA_F_LON, NMEA_F_EW, NMEA_F_KNOTS, NMEA_F_SKIP, NMEA_F_DATE },
+	[NMEA_SENTENCE_VTG] = { NMEA_F_SKIP, NMEA_F_SKIP, NMEA_F_SKIP, NMEA_F_SKIP, NMEA_F_SKIP, NMEA_F_SKIP, NMEA_F_SKIP, NMEA_F_KMH },
+};
+
+//static functions prototypes
+
+/*! @brief reset the conversion of the current field */
+static void nmea_field_start(tNmeaParser * parser);
+/*! @brief add a character to the current field */
+static void nmea_field_char(tNmeaParser * parser, uint8_t c);
+/*! @brief convert the current field into the pending values */
+static int nmea_field_end(tNmeaParser * parser);
+/*! @brief value of the current numeric field with a fixed number of decimals */
+static uint64_t nmea_fixed(const tNmeaParser * parser, int decimals);
+/*! @brief value of a hexadecimal digit */
+static int nmea_hex(uint8_t c);
+/*! @brief drop the current sentence */
+static int nmea_error(tNmeaParser * parser);
+
+//-----------------------------------------------------------------------------------------------------------------------
+/*! nmea_parser_init resets a parser
+* @param parser parser to reset
+*/
+void nmea_parser_init(tNmeaParser * parser)
+{
+	*parser = (tNmeaParser){ .state = NMEA_STATE_WAIT };
+}
+
+//-----------------------------------------------------------------------------------------------------------------------
+/*! nmea_parse reads one character. A '$' always starts a new sentence, so the
+*		  parser resynchronises after a truncated sentence
+* @param parser parser
+* @param c character received from the GPS module
+* @retval NMEA_SENTENCE_x when the character completes a valid sentence (the
+*         values are in parser->data), NMEA_SENTENCE_NONE otherwise
+*/
+int nmea_parse(tNmeaParser * parser, uint8_t c)
+{
+	int digit;
+
+	if(c == '$')		//start of a sentence
+	{
+		if(parser->state != NMEA_STATE_WAIT)		//previous sentence not complete
+			parser->formatErrors++;
+
+		parser->state = NMEA_STATE_BODY;
+		parser->sentence = NMEA_SENTENCE_NONE;
+		parser->field = 0;
+		parser->length = 0;
+		parser->checksum = 0;
+		parser->address = 0;
+		parser->pending.valid = 0;
+		nmea_field_start(parser);
+		return NMEA_SENTENCE_NONE;
+	}
+
+	switch(parser->state)
+	{
+		case NMEA_STATE_BODY:
+			if(++parser->length > NMEA_MAX_LENGTH || c < 0x20 || c > 0x7E)		//too long, or end of line without checksum
+				return nmea_error(parser);
+
+			if(c == '*')		//end of the fields
+			{
+				if(nmea_field_end(parser) != 0)
+					return nmea_error(parser);
+				parser->state = NMEA_STATE_CHECKSUM1;
+				return NMEA_SENTENCE_NONE;
+			}
+
+			parser->checksum ^= c;
+
+			if(c != ',')
+			{
+				nmea_field_char(parser,c);
+				return NMEA_SENTENCE_NONE;
+			}
+
+			if(nmea_field_end(parser) != 0)
+				return nmea_error(parser);
+
+			if(parser->sentence == NMEA_SENTENCE_NONE)		//sentence not used : skip up to the next '$'
+			{
+				parser->state = NMEA_STATE_WAIT;
+				return NMEA_SENTENCE_NONE;
+			}
+
+			parser->field++;
+			nmea_field_start(parser);
+			return NMEA_SENTENCE_NONE;
+
+		case NMEA_STATE_CHECKSUM1:
+			digit = nmea_hex(c);
+			if(digit < 0)
+				return nmea_error(parser);
+			parser->received = digit << 4;
+			parser->state = NMEA_STATE_CHECKSUM2;
+			return NMEA_SENTENCE_NONE;
+
+		case NMEA_STATE_CHECKSUM2:
+			digit = nmea_hex(c);
+			if(digit < 0)
+				return nmea_error(parser);
+			parser->state = NMEA_STATE_WAIT;
+
+			if((parser->received | digit) != parser->checksum)
+			{
+				parser->checksumErrors++;
+				return NMEA_SENTENCE_NONE;
+			}
+
+			parser->data = parser->pending;		//publish the values of the sentence
+			parser->data.valid &= ~NMEA_PARTS;
+			parser->sentences++;
+			return parser->sentence;
+
+		default:		//waiting for '$'
+			return NMEA_SENTENCE_NONE;
+	}
+}
+
+//-----------------------------------------------------------------------------------------------------------------------
+/*! @brief reset the conversion of the current field
+* @param parser parser
+*/
+static void nmea_field_start(tNmeaParser * parser)
+{
+	parser->value = 0;
+	parser->decimals = -1;
+	parser->first = 0;
+	parser->invalid = false;
+}
+
+//-----------------------------------------------------------------------------------------------------------------------
+/*! @brief add a character to the current field. The digits are accumulated
+*		  as they come, the other characters only make a numeric field invalid
+* @param parser parser
+* @param c character of the field
+*/
+static void nmea_field_char(tNmeaParser * parser, uint8_t c)
+{
+	if(parser->first == 0)
+		parser->first = c;
+
+	if(parser->field == 0)		//address : keep the last characters (sentence id)
+	{
+		parser->address = (parser->address << 8) | c;
+		return;
+	}
+
+	if(c >= '0' && c <= '9')
+	{
+		if(parser->decimals >= NMEA_MAX_DECIMALS)		//precision beyond the fixed-point values
+			return;
+		if(parser->value > (UINT64_MAX - 9) / 10)
+			parser->invalid = true;
+		parser->value = parser->value*10 + (c - '0');
+		if(parser->decimals >= 0)
+			parser->decimals++;
+	}
+	else if(c == '.' && parser->decimals < 0)
+	{
+		parser->decimals = 0;
+	}
+	else
+	{
+		parser->invalid = true;
+	}
+}
+
+//-----------------------------------------------------------------------------------------------------------------------
+/*! @brief convert the current field into the pending values of the sentence
+* @param parser parser
+* @retval 0 on success, -1 if a numeric field is malformed or out of range
+*/
+static int nmea_field_end(tNmeaParser * parser)
+{
+	tNmeaData * pending = &parser->pending;
+
+	if(parser->field == 0)		//address : identify the sentence
+	{
+		switch(parser->address & 0xFFFFFF)
+		{
+			case NMEA_ID('G','G','A'):	parser->sentence = NMEA_SENTENCE_GGA;	break;
+			case NMEA_ID('G','L','L'):	parser->sentence = NMEA_SENTENCE_GLL;	break;
+			case NMEA_ID('G','S','A'):	parser->sentence = NMEA_SENTENCE_GSA;	break;
+			case NMEA_ID('R','M','C'):	parser->sentence = NMEA_SENTENCE_RMC;	break;
+			case NMEA_ID('V','T','G'):	parser->sentence = NMEA_SENTENCE_VTG;	break;
+			default:					parser->sentence = NMEA_SENTENCE_NONE;	break;
+		}
+		return 0;
+	}
+
+	if(parser->field >= NMEA_MAX_FIELDS || parser->first == 0)		//field not used or empty
+		return 0;
+
+	uint8_t kind = nmeaFields[parser->sentence][parser->field];
+	bool numeric = kind != NMEA_F_SKIP && kind != NMEA_F_NS && kind != NMEA_F_EW && kind != NMEA_F_STATUS;
+
+	if(numeric && parser->invalid)
+		return -1;
+
+	uint64_t value;
+
+	switch(kind)
+	{
+		case NMEA_F_TIME:		//hhmmss.sss -> ms of the day
+			value = nmea_fixed(parser,3);
+			if(value / 10000000 >= 24 || (value / 100000) % 100 >= 60 || value % 100000 >= 61000)
+				return -1;
+			pending->time = (value / 10000000)*3600000 + ((value / 100000) % 100)*60000 + value % 100000;
+			pending->valid |= NMEA_HAS_TIME;
+		break;
+
+		case NMEA_F_LAT:		//(d)ddmm.mmmmmmm -> 1e-7 degree
+		case NMEA_F_LON:
+			value = nmea_fixed(parser,NMEA_MAX_DECIMALS);
+			if(value / 1000000000 > (kind == NMEA_F_LAT ? 90 : 180) || value % 1000000000 >= 600000000)
+				return -1;
+			value = (value / 1000000000)*10000000 + (value % 1000000000 + 30) / 60;
+			if(kind == NMEA_F_LAT)
+			{
+				pending->lat = (int32_t)value;
+				pending->valid |= NMEA_PART_LAT;
+			}
+			else
+			{
+				pending->lon = (int32_t)value;
+				pending->valid |= NMEA_PART_LON;
+			}
+		break;
+
+		case NMEA_F_NS:
+			if((pending->valid & NMEA_PART_LAT) && (parser->first == 'N' || parser->first == 'S'))
+			{
+				pending->lat = parser->first == 'S' ? -pending->lat : pending->lat;
+				pending->valid |= NMEA_PART_NS;
+			}
+		break;
+
+		case NMEA_F_EW:
+			if((pending->valid & NMEA_PARTS) == NMEA_PARTS && (parser->first == 'E' || parser->first == 'W'))
+			{
+				pending->lon = parser->first == 'W' ? -pending->lon : pending->lon;
+				pending->valid |= NMEA_HAS_POSITION;
+			}
+		break;
+
+		case NMEA_F_QUALITY:
+			pending->quality = (uint8_t)parser->value;
+			pending->valid |= NMEA_HAS_QUALITY;
+		break;
+
+		case NMEA_F_STATUS:
+			pending->status = parser->first == 'A';
+			pending->valid |= NMEA_HAS_STATUS;
+		break;
+
+		case NMEA_F_FIX_MODE:
+			pending->fixMode = (uint8_t)parser->value;
+			pending->valid |= NMEA_HAS_FIX_MODE;
+		break;
+
+		case NMEA_F_KNOTS:		//1e-3 knots -> 0.01 km/h
+			pending->speed = (uint32_t)((nmea_fixed(parser,3)*1852 + 5000) / 10000);
+			pending->valid |= NMEA_HAS_SPEED;
+		break;
+
+		case NMEA_F_KMH:
+			pending->speed = (uint32_t)nmea_fixed(parser,2);
+			pending->valid |= NMEA_HAS_SPEED;
+		break;
+
+		case NMEA_F_SATELLITES:
+			pending->satellites = parser->value > UINT8_MAX ? UINT8_MAX : (uint8_t)parser->value;
+			pending->valid |= NMEA_HAS_SATELLITES;
+		break;
+
+		case NMEA_F_HDOP:		//0.01
+		case NMEA_F_PDOP:
+			value = nmea_fixed(parser,2);
+			value = value > UINT16_MAX ? UINT16_MAX : value;
+			if(kind == NMEA_F_HDOP)
+			{
+				pending->hdop = (uint16_t)value;
+				pending->valid |= NMEA_HAS_HDOP;
+			}
+			else
+			{
+				pending->pdop = (uint16_t)value;
+				pending->valid |= NMEA_HAS_PDOP;
+			}
+		break;
+
+		case NMEA_F_DATE:		//ddmmyy
+			value = nmea_fixed(parser,0);
+			if(value / 10000 < 1 || value / 10000 > 31 || (value / 100) % 100 < 1 || (value / 100) % 100 > 12)
+				return -1;
+			pending->day = value / 10000;
+			pending->month = (value / 100) % 100;
+			pending->year = value % 100;
+			pending->valid |= NMEA_HAS_DATE;
+		break;
+	}
+	return 0;
+}
+
+//-----------------------------------------------------------------------------------------------------------------------
+/*! @brief value of the current numeric field with a fixed number of decimals
+* @param parser parser
+* @param decimals number of decimals of the result (missing digits are 0, extra digits are truncated)
+* @retval value * 10^decimals
+*/
+static uint64_t nmea_fixed(const tNmeaParser * parser, int decimals)
+{
+	uint64_t value = parser->value;
+
+	for(int i = parser->decimals < 0 ? 0 : parser->decimals; i < decimals; i++)
+		value *= 10;
+	for(int i = decimals; i < parser->decimals; i++)
+		value /= 10;
+
+	return value;
+}
+
+//-----------------------------------------------------------------------------------------------------------------------
+/*! @brief value of a hexadecimal digit
+* @param c character
+* @retval 0..15, -1 if not a hexadecimal digit
+*/
+static int nmea_hex(uint8_t c)
+{
+	if(c >= '0' && c <= '9')
+		return c - '0';
+	if(c >= 'A' && c <= 'F')
+		return c - 'A' + 10;
+	if(c >= 'a' && c <= 'f')
+		return c - 'a' + 10;
+	return -1;
+}
+
+//-----------------------------------------------------------------------------------------------------------------------
+/*! @brief drop the current sentence and wait for the next '$'
+* @param parser parser
+* @retval NMEA_SENTENCE_NONE
+*/
+static int nmea_error(tNmeaParser * parser)
+{
+	parser->formatErrors++;
+	parser->state = NMEA_STATE_WAIT;
+	return NMEA_SENTENCE_NONE;
+}
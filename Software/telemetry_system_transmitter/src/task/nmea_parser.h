@@ -0,0 +1,147 @@
+/*! --------------------------------------------------------------------
+ *	Telemetry System	-	@file nmea_parser.h
+ *----------------------------------------------------------------------
+ * HES-SO Valais Wallis
+ * Systems Engineering
+ * Infotronics
+ * ---------------------------------------------------------------------
+ * @author agent
+ * @date 19.10.2026
+ * ---------------------------------------------------------------------
+ * @brief NMEA parser reads the sentences of the GPS module one byte at
+ *        a time. The fields are converted while they are received (no
+ *        copy of the sentence) and the values are published only if
+ *        the checksum of the sentence is correct.
+ * ---------------------------------------------------------------------
+ * Telemetry system for the Valais Wallis Racing Team.
+ * This file contains code for the onboard device of the telemetry
+ * system. The system receives the data from the sensors on the CAN bus
+ * and the data from the GPS on a UART port. An SD Card contains a
+ * configuration file with all the system parameters. The measurements
+ * are sent via Wi-Fi to a computer on the base station. The measurements
+ * are also saved in a CSV file on the SD card.
+ *--------------------------------------------------------------------*/
+
+#ifndef __NMEA_PARSER_H
+#define __NMEA_PARSER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * Sentence = $<talker><id>,<field>,...,<field>*<checksum><CR><LF>
+ *
+ * The sentence is identified by its id (the talker GP, GN, GL... is
+ * ignored), the sentences not listed below are skipped up to the next '$'.
+ * The checksum (XOR of the characters between '$' and '*') is mandatory.
+ * A sentence longer than NMEA_MAX_LENGTH or with an invalid character in
+ * a numeric field is dropped.
+ */
+
+//sentences read by the parser
+#define NMEA_SENTENCE_NONE      0
+#define NMEA_SENTENCE_GGA       1       //fix data : time, position, fix quality, satellites, HDOP
+#define NMEA_SENTENCE_GLL       2       //position and time
+#define NMEA_SENTENCE_GSA       3       //fix mode, PDOP, HDOP
+#define NMEA_SENTENCE_RMC       4       //time, date, position and speed
+#define NMEA_SENTENCE_VTG       5       //speed
+
+//values present in the last sentence (tNmeaData.valid)
+#define NMEA_HAS_TIME           (1u << 0)
+#define NMEA_HAS_DATE           (1u << 1)
+#define NMEA_HAS_POSITION       (1u << 2)
+#define NMEA_HAS_SPEED          (1u << 3)
+#define NMEA_HAS_FIX_MODE       (1u << 4)
+#define NMEA_HAS_QUALITY        (1u << 5)
+#define NMEA_HAS_STATUS         (1u << 6)
+#define NMEA_HAS_SATELLITES     (1u << 7)
+#define NMEA_HAS_HDOP           (1u << 8)
+#define NMEA_HAS_PDOP           (1u << 9)
+
+//max length of a sentence ('$' to checksum, NMEA 0183 allows 82 characters with CR LF)
+#define NMEA_MAX_LENGTH         96
+
+/*! @brief values of a sentence
+    @param valid values present in the sentence (NMEA_HAS_x)
+    @param time UTC time of day (ms)
+    @param day date (1..31)
+    @param month date (1..12)
+    @param year date (0..99)
+    @param lat latitude (1e-7 degree, north positive)
+    @param lon longitude (1e-7 degree, east positive)
+    @param speed speed over ground (0.01 km/h)
+    @param fixMode fix mode of GSA (1 = no fix, 2 = 2D, 3 = 3D)
+    @param quality fix quality of GGA (0 = no fix)
+    @param status data valid ('A' in RMC and GLL)
+    @param satellites number of satellites used (GGA)
+    @param hdop horizontal dilution of precision (0.01, GGA and GSA)
+    @param pdop position dilution of precision (0.01, GSA)
+*/
+typedef struct sNmeaData{
+    uint32_t valid;
+    uint32_t time;
+    uint8_t day;
+    uint8_t month;
+    uint8_t year;
+    int32_t lat;
+    int32_t lon;
+    uint32_t speed;
+    uint8_t fixMode;
+    uint8_t quality;
+    bool status;
+    uint8_t satellites;
+    uint16_t hdop;
+    uint16_t pdop;
+}tNmeaData;
+
+/*! @brief parser state
+    @param data values of the last valid sentence
+    @param pending values of the sentence being received
+    @param state position in the sentence
+    @param sentence id of the sentence being received (NMEA_SENTENCE_x)
+    @param field index of the current field (0 = address field)
+    @param length number of characters of the sentence
+    @param checksum XOR of the characters of the sentence
+    @param received checksum read after '*'
+    @param address last characters of the address field
+    @param value digits of the current field
+    @param decimals number of digits after '.' (-1 if no '.')
+    @param first first character of the current field (0 if empty)
+    @param invalid the current field contains a character that is not a number
+    @param sentences valid sentences read
+    @param checksumErrors sentences dropped because of the checksum
+    @param formatErrors sentences dropped because they are too long or malformed
+*/
+typedef struct sNmeaParser{
+    tNmeaData data;
+    tNmeaData pending;
+    uint8_t state;
+    uint8_t sentence;
+    uint8_t field;
+    uint8_t length;
+    uint8_t checksum;
+    uint8_t received;
+    uint32_t address;
+    uint64_t value;
+    int8_t decimals;
+    char first;
+    bool invalid;
+    uint32_t sentences;
+    uint32_t checksumErrors;
+    uint32_t formatErrors;
+}tNmeaParser;
+
+/*! nmea_parser_init resets a parser
+* @param parser parser to reset
+*/
+void nmea_parser_init(tNmeaParser * parser);
+
+/*! nmea_parse reads one character
+* @param parser parser
+* @param c character received from the GPS module
+* @retval NMEA_SENTENCE_x when the character completes a valid sentence (the
+*         values are in parser->data), NMEA_SENTENCE_NONE otherwise
+*/
+int nmea_parse(tNmeaParser * parser, uint8_t c);
+
+#endif /*__NMEA_PARSER_H*/
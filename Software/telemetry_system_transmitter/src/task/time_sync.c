@@ -0,0 +1,422 @@
+/*! --------------------------------------------------------------------
+ *	Telemetry System	-	@file time_sync.c
+ *----------------------------------------------------------------------
+ * HES-SO Valais Wallis
+ * Systems Engineering
+ * Infotronics
+ * ---------------------------------------------------------------------
+ * @author agent
+ * @date 19.10.2026
+ * ---------------------------------------------------------------------
+ * @brief Time Sync task synchronises the clock of the device with the
+ *        clock of the base station (NTP like exchange on the live link)
+ *        or with the GPS time, so that every live packet and log
+ *        record carries an absolute timestamp.
+ * ---------------------------------------------------------------------
+ * Telemetry system for the Valais Wallis Racing Team.
+ * This file contains code for the onboard device of the telemetry
+ * system. The system receives the data from the sensors on the CAN bus
+ * and the data from the GPS on a UART port. An SD Card contains a
+ * configuration file with all the system parameters. The measurements
+ * are sent via Wi-Fi to a computer on the base station. The measurements
+ * are also saved in a CSV file on the SD card.
+ *--------------------------------------------------------------------*/
+
+//includes
+#include <zephyr/logging/log.h>
+LOG_MODULE_REGISTER(timesync);
+#include <zephyr/kernel.h>
+#include <errno.h>
+#include <stdio.h>
+#include <zephyr/posix/sys/socket.h>
+#include <zephyr/posix/arpa/inet.h>
+#include <zephyr/net/socket.h>
+#include <unistd.h>
+#include <zephyr/sys/byteorder.h>
+
+//project file includes
+#include "time_sync.h"
+#include "deviceInformation.h"
+#include "memory_management.h"
+#include "config_read.h"
+#include "live_protocol.h"
+#include "udp_client.h"
+
+//! Stack size for the TIME_SYNC thread
+#define TIME_SYNC_STACK_SIZE 2048
+//! TIME_SYNC thread priority level (higher than the udp client, the answer is timestamped on reception)
+#define TIME_SYNC_PRIORITY 2
+//! Time in miliseconds between two checks of the wifi connection
+#define TIME_SYNC_WAIT_IP_MS 500
+//! Max round trip of an exchange
+#define TIME_SYNC_TIMEOUT_MS 200
+//! Number of fast exchanges after the connection
+#define TIME_SYNC_BURST_COUNT 8
+//! Time between two exchanges of the burst
+#define TIME_SYNC_BURST_INTERVAL_MS 125
+//! Number of exchanges in the filter (the one with the shortest round trip is used)
+#define TIME_SYNC_FILTER_SIZE 8
+//! Min time between two drift measurements (µs)
+#define TIME_SYNC_DRIFT_INTERVAL_US 30000000LL
+//! Max drift of the local clock (ppb)
+#define TIME_SYNC_MAX_DRIFT_PPB 500000
+//! Time a worse source is ignored after an update of a better one (s)
+#define TIME_SYNC_SOURCE_HOLD_S 30
+
+/*! @brief result of a sync exchange
+    @param offset reference time - local time (µs)
+    @param local local time in the middle of the exchange (µs)
+    @param delay round trip without the processing time of the base station (µs)
+*/
+typedef struct sTimeSyncSample{
+    int64_t offset;
+    int64_t local;
+    uint32_t delay;
+}tTimeSyncSample;
+
+//! Time Sync stack definition
+K_THREAD_STACK_DEFINE(TIME_SYNC_STACK, TIME_SYNC_STACK_SIZE);
+//! Variable to identify the Time Sync thread
+static struct k_thread timeSyncThread;
+
+//clock estimate (protected by timeSyncMutex)
+K_MUTEX_DEFINE(timeSyncMutex);
+static uint8_t syncSource;			//source of the estimate (TIME_SYNC_x)
+static int64_t syncOffset;			//reference - local at syncLocal (µs)
+static int64_t syncLocal;			//local time of the last update (µs)
+static int32_t syncDrift;			//drift of the local clock (ppb)
+static bool syncDriftValid;			//drift measured at least once
+static int64_t driftLocal;			//local time of the first point of the drift measurement
+static int64_t driftOffset;			//offset of the first point of the drift measurement
+static int32_t syncCorrection;		//last correction of the offset (µs)
+static uint32_t syncDelay;			//round trip of the last reference (µs)
+
+//exchanges with the base station (used by the time sync thread only)
+static tTimeSyncSample syncSamples[TIME_SYNC_FILTER_SIZE];
+static int syncSampleCount;
+static int syncSampleHead;
+static int64_t syncLastUsed;		//local time of the last exchange used
+static int syncServer;				//index of the server answering the sync requests (first unicast server)
+
+//static functions prototypes
+
+/*! @brief do one exchange with the base station */
+static int time_sync_exchange(int syncSocket);
+/*! @brief add an exchange to the filter and use the best one */
+static void time_sync_filter(const tTimeSyncSample * sample);
+/*! @brief open the socket to the first unicast server */
+static int time_sync_connect(void);
+
+
+//-----------------------------------------------------------------------------------------------------------------------
+/*! time_sync_local
+* @brief local clock (µs since boot)
+*/
+int64_t time_sync_local(void)
+{
+	return k_ticks_to_us_floor64(k_uptime_ticks());
+}
+
+//-----------------------------------------------------------------------------------------------------------------------
+/*! time_sync_convert converts a local time in synchronised time
+* @param local local time (µs since boot)
+* @retval synchronised time (µs since 1970), 0 if the clock is not synchronised
+*/
+int64_t time_sync_convert(int64_t local)
+{
+	int64_t time = 0;
+
+	k_mutex_lock(&timeSyncMutex,K_FOREVER);		//lock time sync mutex
+
+	if(syncSource != TIME_SYNC_NONE)
+		time = local + syncOffset + (local - syncLocal) * syncDrift / 1000000000LL;
+
+	k_mutex_unlock(&timeSyncMutex);				//unlock mutex
+
+	return time;
+}
+
+//-----------------------------------------------------------------------------------------------------------------------
+/*! time_sync_now
+* @brief current synchronised time (µs since 1970), 0 if the clock is not synchronised
+*/
+int64_t time_sync_now(void)
+{
+	return time_sync_convert(time_sync_local());
+}
+
+//-----------------------------------------------------------------------------------------------------------------------
+/*! time_sync_reference sets the time of a reference clock
+* @brief the reference is ignored if a better source was used recently
+* @param reference time of the reference (µs since 1970)
+* @param local local time at the same instant (µs since boot)
+* @param source source of the reference (TIME_SYNC_x)
+* @param delay uncertainty of the reference (round trip in µs, 0 if unknown)
+*/
+void time_sync_reference(int64_t reference, int64_t local, uint8_t source, uint32_t delay)
+{
+	int64_t offset = reference - local;
+
+	k_mutex_lock(&timeSyncMutex,K_FOREVER);		//lock time sync mutex
+
+	if(source < syncSource && local - syncLocal < TIME_SYNC_SOURCE_HOLD_S*1000000LL)		//better source still alive
+	{
+		k_mutex_unlock(&timeSyncMutex);
+		return;
+	}
+
+	if(source != syncSource)		//first reference of this source : set the clock
+	{
+		LOG_INF("clock synchronised on %s",source == TIME_SYNC_PPS ? "GPS PPS" : source == TIME_SYNC_SERVER ? "base station" : "GPS");
+		syncCorrection = 0;
+		syncDrift = 0;
+		syncDriftValid = false;
+		driftLocal = local;
+		driftOffset = offset;
+	}
+	else
+	{
+		int64_t predicted = syncOffset + (local - syncLocal) * syncDrift / 1000000000LL;
+		syncCorrection = MIN(MAX(offset - predicted,INT32_MIN),INT32_MAX);
+
+		if(local - driftLocal >= TIME_SYNC_DRIFT_INTERVAL_US)		//measure the drift on a long interval
+		{
+			int32_t drift = MIN(MAX((offset - driftOffset) * 1000000000LL / (local - driftLocal),-TIME_SYNC_MAX_DRIFT_PPB),TIME_SYNC_MAX_DRIFT_PPB);
+
+			syncDrift = syncDriftValid ? syncDrift + (drift - syncDrift)/4 : drift;		//smooth the measurements
+			syncDriftValid = true;
+			driftLocal = local;
+			driftOffset = offset;
+		}
+	}
+
+	syncSource = source;
+	syncOffset = offset;
+	syncLocal = local;
+	syncDelay = delay;
+
+	k_mutex_unlock(&timeSyncMutex);				//unlock mutex
+}
+
+//-----------------------------------------------------------------------------------------------------------------------
+/*! time_sync_utc converts a UTC date and time
+* @param year year (2000..2099 or 0..99)
+* @param month month (1..12)
+* @param day day (1..31)
+* @param hour hour (0..23)
+* @param min minutes
+* @param sec seconds
+* @retval µs since 1970
+*/
+int64_t time_sync_utc(int year, int month, int day, int hour, int min, int sec)
+{
+	if(year < 100)
+		year += 2000;
+
+	//days since 1970 (civil calendar, march based year)
+	year -= month <= 2;
+	int era = year / 400;
+	int yearOfEra = year - era * 400;
+	int dayOfYear = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+	int dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+	int64_t days = (int64_t)era * 146097 + dayOfEra - 719468;
+
+	return ((days * 24 + hour) * 3600 + min * 60 + sec) * 1000000LL;
+}
+
+//-----------------------------------------------------------------------------------------------------------------------
+/*! time_sync_status
+* @brief copy the synchronisation status
+* @param status status struct to fill
+*/
+void time_sync_status(tTimeSyncStatus * status)
+{
+	k_mutex_lock(&timeSyncMutex,K_FOREVER);		//lock time sync mutex
+
+	status->source = syncSource;
+	status->delay = syncDelay;
+	status->correction = syncCorrection;
+	status->drift = syncDrift;
+
+	k_mutex_unlock(&timeSyncMutex);				//unlock mutex
+}
+
+//-----------------------------------------------------------------------------------------------------------------------
+/*! Time_Sync implements the Time Sync task
+* @brief Time_Sync sends the sync requests to the base station and
+*        updates the clock offset with the answers
+*/
+void Time_Sync()
+{
+	while(true)	// --------------------------------------------------------------------Thread infinite loop
+	{
+		// stop the thread until a DHCP IP is assigned to the board
+		while(!context.ip_assigned)
+			k_msleep(TIME_SYNC_WAIT_IP_MS);
+
+		int syncSocket = time_sync_connect();
+		if(syncSocket < 0)
+		{
+			k_msleep(TIME_SYNC_WAIT_IP_MS);
+			continue;
+		}
+
+		int burst = TIME_SYNC_BURST_COUNT;		//fast exchanges after the connection
+
+		while(context.ip_assigned)
+		{
+			time_sync_exchange(syncSocket);
+
+			if(burst > 0)
+			{
+				burst--;
+				k_msleep(TIME_SYNC_BURST_INTERVAL_MS);
+			}
+			else
+			{
+				k_sleep(K_SECONDS(configFile.TimeSyncPeriod));
+			}
+		}
+
+		close(syncSocket);		//wifi lost
+	}
+}
+
+//-----------------------------------------------------------------------------------------------------------------------
+/*! @brief open the socket to the first unicast server. The answers come back
+*          on this socket, so they do not disturb the udp client
+* @retval socket, negative on error
+*/
+static int time_sync_connect(void)
+{
+	struct sockaddr_in serverAddress = {
+		.sin_family = AF_INET,
+		.sin_port = htons(configFile.Server[syncServer].port)
+	};
+	inet_pton(AF_INET, configFile.Server[syncServer].address, &serverAddress.sin_addr);
+
+	int syncSocket = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+	if(syncSocket < 0)
+	{
+		LOG_ERR("Time sync error: socket: %d\n", errno);
+		return -errno;
+	}
+
+	if(connect(syncSocket, (struct sockaddr *)&serverAddress, sizeof(serverAddress)) < 0)
+	{
+		LOG_ERR("Time sync error: connect: %d\n", errno);
+		close(syncSocket);
+		return -errno;
+	}
+
+	struct timeval timeout = {
+		.tv_sec = 0,
+		.tv_usec = TIME_SYNC_TIMEOUT_MS*1000
+	};
+	setsockopt(syncSocket, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+	return syncSocket;
+}
+
+//-----------------------------------------------------------------------------------------------------------------------
+/*! @brief do one exchange with the base station
+* @param syncSocket socket connected to the first unicast server
+* @retval 0 on success, negative error code otherwise
+*/
+static int time_sync_exchange(int syncSocket)
+{
+	tLiveSync request = {
+		.magic = sys_cpu_to_le16(LIVE_MAGIC),
+		.version = LIVE_PROTOCOL_VERSION,
+		.type = LIVE_PKT_SYNC_REQUEST
+	};
+	tLiveSync answer;
+
+	int64_t t1 = time_sync_local();		//request sent
+	request.originTime = sys_cpu_to_le64(t1);
+
+	if(send(syncSocket, &request, sizeof(request), 0) < 0)
+		return -errno;
+
+	while(true)		//skip the late answers of previous requests
+	{
+		int len = recv(syncSocket, &answer, sizeof(answer), 0);
+		int64_t t4 = time_sync_local();		//answer received
+
+		if(len < 0)			//timeout
+			return -EAGAIN;
+
+		if(len != sizeof(answer) || sys_le16_to_cpu(answer.magic) != LIVE_MAGIC ||
+		   answer.type != LIVE_PKT_SYNC_RESPONSE || sys_le64_to_cpu(answer.originTime) != t1)
+			continue;
+
+		int64_t t2 = sys_le64_to_cpu(answer.receiveTime);		//request received by the base station
+		int64_t t3 = sys_le64_to_cpu(answer.transmitTime);		//answer sent by the base station
+
+		tTimeSyncSample sample = {
+			.offset = ((t2 - t1) + (t3 - t4)) / 2,
+			.local = (t1 + t4) / 2,
+			.delay = MAX((t4 - t1) - (t3 - t2),0)
+		};
+		time_sync_filter(&sample);
+		return 0;
+	}
+}
+
+//-----------------------------------------------------------------------------------------------------------------------
+/*! @brief add an exchange to the filter and use the exchange with the
+*		   shortest round trip (smallest error) if it was not used yet
+* @param sample result of the exchange
+*/
+static void time_sync_filter(const tTimeSyncSample * sample)
+{
+	syncSamples[syncSampleHead] = *sample;
+	syncSampleHead = (syncSampleHead+1) % TIME_SYNC_FILTER_SIZE;
+	syncSampleCount = MIN(syncSampleCount+1,TIME_SYNC_FILTER_SIZE);
+
+	const tTimeSyncSample * best = &syncSamples[0];
+	for(int i=1; i<syncSampleCount; i++)
+	{
+		if(syncSamples[i].delay < best->delay)
+			best = &syncSamples[i];
+	}
+
+	if(best->local > syncLastUsed)
+	{
+		syncLastUsed = best->local;
+		time_sync_reference(best->local + best->offset,best->local,TIME_SYNC_SERVER,best->delay);
+	}
+}
+
+//-----------------------------------------------------------------------------------------------------------------------
+/*! Task_Time_Sync_Init initializes the task Time Sync
+*
+* @brief Time Sync initialization. The task is not started if no
+*        sync period is set in the config file
+*/
+void Task_Time_Sync_Init( void )
+{
+	syncServer = 0;
+	while(syncServer < configFile.serverCount && udp_server_is_group(syncServer))		//a group address cannot answer
+		syncServer++;
+
+	if(configFile.TimeSyncPeriod <= 0 || syncServer == configFile.serverCount)
+	{
+		LOG_INF("Time sync with the base station disabled");
+		return;
+	}
+
+	k_thread_create	(&timeSyncThread,
+					TIME_SYNC_STACK,
+					TIME_SYNC_STACK_SIZE,
+					(k_thread_entry_t)Time_Sync,
+					NULL,
+					NULL,
+					NULL,
+					TIME_SYNC_PRIORITY,
+					0,
+					K_NO_WAIT);
+
+	 k_thread_name_set(&timeSyncThread, "timeSync");
+	 k_thread_start(&timeSyncThread);
+}
@@ -0,0 +1,127 @@
+/*! --------------------------------------------------------------------
+ *	Telemetry System	-	@file time_sync.h
+ *----------------------------------------------------------------------
+ * HES-SO Valais Wallis
+ * Systems Engineering
+ * Infotronics
+ * ---------------------------------------------------------------------
+ * @author agent
+ * @date 19.10.2026
+ * ---------------------------------------------------------------------
+ * @brief Time Sync task synchronises the clock of the device with the
+ *        clock of the base station (NTP like exchange on the live link)
+ *        or with the GPS time, so that every live packet and log
+ *        record carries an absolute timestamp.
+ * ---------------------------------------------------------------------
+ * Telemetry system for the Valais Wallis Racing Team.
+ * This file contains code for the onboard device of the telemetry
+ * system. The system receives the data from the sensors on the CAN bus
+ * and the data from the GPS on a UART port. An SD Card contains a
+ * configuration file with all the system parameters. The measurements
+ * are sent via Wi-Fi to a computer on the base station. The measurements
+ * are also saved in a CSV file on the SD card.
+ *--------------------------------------------------------------------*/
+
+#ifndef __TIME_SYNC_H
+#define __TIME_SYNC_H
+
+#include <stdint.h>
+
+/*
+ * Synchronised time = µs since 1970-01-01 UTC.
+ *
+ * The device sends a sync request to the first unicast server every TimeSyncPeriod
+ * seconds (a burst at connection). The base station answers with its
+ * receive and transmit times, the offset is computed from the exchange with
+ * the shortest round trip of the last ones. The drift of the local clock is
+ * estimated from the offsets and used between two exchanges.
+ *
+ * The GPS time (TimeSyncGps) is used only when no base station answered
+ * for TIME_SYNC_SOURCE_HOLD_S seconds, its precision is limited by the
+ * delay of the NMEA frames (some tens of ms).
+ *
+ * When the PPS output of the GPS module is wired (gps-pps alias in the
+ * devicetree), each pulse is paired with the GPS time of its second and
+ * disciplines the clock every second (precision of the interrupt latency).
+ * It is the best source : all the cars and the base station (on UTC) are
+ * then on the same time scale without any alignment.
+ *
+ * The synchronised time is sent on the CAN bus (GPS.CanIDs.SyncTime) so the
+ * recorder timestamps the log records with the same clock.
+ */
+
+//sources of the synchronised time (higher is better)
+#define TIME_SYNC_NONE      0       //clock not synchronised
+#define TIME_SYNC_GPS       1       //GPS time
+#define TIME_SYNC_SERVER    2       //base station
+#define TIME_SYNC_PPS       3       //GPS time at the PPS pulse
+
+/*! @brief time synchronisation status (reported in the live transmission)
+    @param source source of the current time (TIME_SYNC_x)
+    @param delay round trip of the last exchange used (µs)
+    @param correction difference between the last measured offset and the estimated one (µs)
+    @param drift estimated drift of the local clock (ppb)
+*/
+typedef struct sTimeSyncStatus{
+    uint8_t source;
+    uint32_t delay;
+    int32_t correction;
+    int32_t drift;
+}tTimeSyncStatus;
+
+/*! time_sync_local
+* @brief local clock (µs since boot)
+*/
+int64_t time_sync_local(void);
+
+/*! time_sync_convert converts a local time in synchronised time
+* @param local local time (µs since boot)
+* @retval synchronised time (µs since 1970), 0 if the clock is not synchronised
+*/
+int64_t time_sync_convert(int64_t local);
+
+/*! time_sync_now
+* @brief current synchronised time (µs since 1970), 0 if the clock is not synchronised
+*/
+int64_t time_sync_now(void);
+
+/*! time_sync_reference sets the time of a reference clock
+* @brief the reference is ignored if a better source was used recently
+* @param reference time of the reference (µs since 1970)
+* @param local local time at the same instant (µs since boot)
+* @param source source of the reference (TIME_SYNC_x)
+* @param delay uncertainty of the reference (round trip in µs, 0 if unknown)
+*/
+void time_sync_reference(int64_t reference, int64_t local, uint8_t source, uint32_t delay);
+
+/*! time_sync_utc converts a UTC date and time
+* @param year year (2000..2099 or 0..99)
+* @param month month (1..12)
+* @param day day (1..31)
+* @param hour hour (0..23)
+* @param min minutes
+* @param sec seconds
+* @retval µs since 1970
+*/
+int64_t time_sync_utc(int year, int month, int day, int hour, int min, int sec);
+
+/*! time_sync_status
+* @brief copy the synchronisation status
+* @param status status struct to fill
+*/
+void time_sync_status(tTimeSyncStatus * status);
+
+/*! Time_Sync implements the Time Sync task
+* @brief Time_Sync sends the sync requests to the base station and
+*        updates the clock offset with the answers
+*/
+void Time_Sync();
+
+/*! Task_Time_Sync_Init initializes the task Time Sync
+*
+* @brief Time Sync initialization. The task is not started if no
+*        sync period is set in the config file
+*/
+void Task_Time_Sync_Init( void );
+
+#endif /*__TIME_SYNC_H*/
@@ -0,0 +1,395 @@
+/*! --------------------------------------------------------------------
+ *	Telemetry System	-	@file ubx_parser.c
+ *----------------------------------------------------------------------
+ * HES-SO Valais Wallis
+ * Systems Engineering
+ * Infotronics
+ * ---------------------------------------------------------------------
+ * @author agent
+ * @date 19.10.2026
+ * ---------------------------------------------------------------------
+ * @brief UBX parser reads the binary messages of the u-blox GPS module
+ *        one byte at a time. The fields of the NAV-PVT and NAV-DOP
+ *        messages are decoded while they are received (no copy of the payload) and
+ *        the values are published only if the checksum is correct.
+ * ---------------------------------------------------------------------
+ * Telemetry system for the Valais Wallis Racing Team.
+ * This file contains code for the onboard device of the telemetry
+ * system. The system receives the data from the sensors on the CAN bus
+ * and the data from the GPS on a UART port. An SD Card contains a
+ * configuration file with all the system parameters. The measurements
+ * are sent via Wi-Fi to a computer on the base station. The measurements
+ * are also saved in a CSV file on the SD card.
+ *--------------------------------------------------------------------*/
+
+//includes
+#include <stddef.h>
+#include <stdint.h>
+
+//project file includes
+#include "ubx_parser.h"
+
+//states of the parser
+#define UBX_STATE_SYNC1         0       //waiting for 0xB5
+#define UBX_STATE_SYNC2         1       //waiting for 0x62
+#define UBX_STATE_CLASS         2
+#define UBX_STATE_ID            3
+#define UBX_STATE_LENGTH1       4
+#define UBX_STATE_LENGTH2       5
+#define UBX_STATE_PAYLOAD       6
+#define UBX_STATE_CK_A          7
+#define UBX_STATE_CK_B          8
+
+//kinds of fields of NAV-PVT and NAV-DOP
+#define UBX_F_ITOW              0
+#define UBX_F_YEAR              1
+#define UBX_F_MONTH             2
+#define UBX_F_DAY               3
+#define UBX_F_HOUR              4
+#define UBX_F_MIN               5
+#define UBX_F_SEC               6
+#define UBX_F_VALID             7       //validDate (bit 0), validTime (bit 1)
+#define UBX_F_NANO              8
+#define UBX_F_FIX_TYPE          9
+#define UBX_F_FLAGS             10      //gnssFixOK (bit 0)
+#define UBX_F_NUM_SV            11
+#define UBX_F_LON               12
+#define UBX_F_LAT               13
+#define UBX_F_HACC              14
+#define UBX_F_GSPEED            15      //ground speed (mm/s)
+#define UBX_F_HEADING           16      //heading of motion (1e-5 degree)
+#define UBX_F_PDOP              17      //position dilution of precision (0.01)
+#define UBX_F_DOP_ITOW          18      //time of week of NAV-DOP
+#define UBX_F_HDOP              19      //horizontal dilution of precision (0.01)
+
+/*! @brief field of a payload
+    @param offset position in the payload
+    @param size number of bytes
+    @param kind kind of field (UBX_F_x)
+*/
+typedef struct sUbxField{
+    uint8_t offset;
+    uint8_t size;
+    uint8_t kind;
+}tUbxField;
+
+//fields of NAV-PVT used, in payload order (the other bytes are skipped)
+static const tUbxField ubxPvtFields[] = {
+	{ 0, 4, UBX_F_ITOW },
+	{ 4, 2, UBX_F_YEAR },
+	{ 6, 1, UBX_F_MONTH },
+	{ 7, 1, UBX_F_DAY },
+	{ 8, 1, UBX_F_HOUR },
+	{ 9, 1, UBX_F_MIN },
+	{ 10, 1, UBX_F_SEC },
+	{ 11, 1, UBX_F_VALID },
+	{ 16, 4, UBX_F_NANO },
+	{ 20, 1, UBX_F_FIX_TYPE },
+	{ 21, 1, UBX_F_FLAGS },
+	{ 23, 1, UBX_F_NUM_SV },
+	{ 24, 4, UBX_F_LON },
+	{ 28, 4, UBX_F_LAT },
+	{ 40, 4, UBX_F_HACC },
+	{ 60, 4, UBX_F_GSPEED },
+	{ 64, 4, UBX_F_HEADING },
+	{ 76, 2, UBX_F_PDOP },
+};
+
+//fields of NAV-DOP used, in payload order
+static const tUbxField ubxDopFields[] = {
+	{ 0, 4, UBX_F_DOP_ITOW },
+	{ 12, 2, UBX_F_HDOP },
+};
+
+//static functions prototypes
+
+/*! @brief decode a byte of the payload */
+static void ubx_payload_byte(tUbxParser * parser, uint8_t c);
+/*! @brief store a complete field of NAV-PVT or NAV-DOP into the pending values */
+static void ubx_pvt_field(tUbxParser * parser, uint8_t kind, uint32_t value);
+/*! @brief publish the message after a correct checksum */
+static int ubx_publish(tUbxParser * parser);
+/*! @brief the current message is decoded (NAV-PVT, NAV-DOP, ACK or NAK) */
+static bool ubx_used(const tUbxParser * parser);
+
+//-----------------------------------------------------------------------------------------------------------------------
+/*! ubx_parser_init resets a parser
+* @param parser parser to reset
+*/
+void ubx_parser_init(tUbxParser * parser)
+{
+	*parser = (tUbxParser){ .state = UBX_STATE_SYNC1 };
+}
+
+//-----------------------------------------------------------------------------------------------------------------------
+/*! ubx_parse reads one byte. After an error the parser waits for the next
+*		  sync characters, so it resynchronises after a truncated message
+* @param parser parser
+* @param c byte received from the GPS module
+* @retval UBX_MSG_x when the byte completes a valid message, UBX_MSG_NONE otherwise
+*/
+int ubx_parse(tUbxParser * parser, uint8_t c)
+{
+	if(parser->state >= UBX_STATE_CLASS && parser->state <= UBX_STATE_PAYLOAD)		//checksum of class, id, length and payload
+	{
+		parser->ckA += c;
+		parser->ckB += parser->ckA;
+	}
+
+	switch(parser->state)
+	{
+		case UBX_STATE_SYNC1:
+			if(c == UBX_SYNC1)
+				parser->state = UBX_STATE_SYNC2;
+			return UBX_MSG_NONE;
+
+		case UBX_STATE_SYNC2:
+			if(c == UBX_SYNC2)
+			{
+				parser->state = UBX_STATE_CLASS;
+				parser->ckA = 0;
+				parser->ckB = 0;
+			}
+			else if(c != UBX_SYNC1)
+			{
+				parser->state = UBX_STATE_SYNC1;
+			}
+			return UBX_MSG_NONE;
+
+		case UBX_STATE_CLASS:
+			parser->msgClass = c;
+			parser->state = UBX_STATE_ID;
+			return UBX_MSG_NONE;
+
+		case UBX_STATE_ID:
+			parser->msgId = c;
+			parser->state = UBX_STATE_LENGTH1;
+			return UBX_MSG_NONE;
+
+		case UBX_STATE_LENGTH1:
+			parser->length = c;
+			parser->state = UBX_STATE_LENGTH2;
+			return UBX_MSG_NONE;
+
+		case UBX_STATE_LENGTH2:
+			parser->length |= (uint16_t)c << 8;
+			if(parser->length > UBX_MAX_LENGTH)
+			{
+				parser->formatErrors++;
+				parser->state = UBX_STATE_SYNC1;
+				return UBX_MSG_NONE;
+			}
+			parser->index = 0;
+			parser->field = 0;
+			parser->value = 0;
+			parser->pending.valid = 0;
+			parser->state = parser->length > 0 ? UBX_STATE_PAYLOAD : UBX_STATE_CK_A;
+			return UBX_MSG_NONE;
+
+		case UBX_STATE_PAYLOAD:
+			if(ubx_used(parser))
+				ubx_payload_byte(parser,c);
+			if(++parser->index >= parser->length)
+				parser->state = UBX_STATE_CK_A;
+			return UBX_MSG_NONE;
+
+		case UBX_STATE_CK_A:
+			if(c != parser->ckA)
+			{
+				parser->checksumErrors++;
+				parser->state = c == UBX_SYNC1 ? UBX_STATE_SYNC2 : UBX_STATE_SYNC1;
+				return UBX_MSG_NONE;
+			}
+			parser->state = UBX_STATE_CK_B;
+			return UBX_MSG_NONE;
+
+		case UBX_STATE_CK_B:
+			if(c != parser->ckB)
+			{
+				parser->checksumErrors++;
+				parser->state = c == UBX_SYNC1 ? UBX_STATE_SYNC2 : UBX_STATE_SYNC1;
+				return UBX_MSG_NONE;
+			}
+			parser->state = UBX_STATE_SYNC1;
+			parser->messages++;
+			return ubx_used(parser) ? ubx_publish(parser) : UBX_MSG_NONE;
+
+		default:
+			parser->state = UBX_STATE_SYNC1;
+			return UBX_MSG_NONE;
+	}
+}
+
+//-----------------------------------------------------------------------------------------------------------------------
+/*! ubx_frame writes a message with its sync characters and checksum
+* @param buf buffer for the message (length + UBX_FRAME_OVERHEAD bytes)
+* @param msgClass class of the message
+* @param msgId id of the message
+* @param payload payload of the message
+* @param length payload length
+* @retval length of the message
+*/
+int ubx_frame(uint8_t * buf, uint8_t msgClass, uint8_t msgId, const uint8_t * payload, uint16_t length)
+{
+	uint8_t ckA = 0;
+	uint8_t ckB = 0;
+
+	buf[0] = UBX_SYNC1;
+	buf[1] = UBX_SYNC2;
+	buf[2] = msgClass;
+	buf[3] = msgId;
+	buf[4] = length & 0xFF;
+	buf[5] = length >> 8;
+	for(uint16_t i=0; i<length; i++)
+		buf[6+i] = payload[i];
+
+	for(int i=2; i<6+length; i++)		//checksum of class, id, length and payload
+	{
+		ckA += buf[i];
+		ckB += ckA;
+	}
+	buf[6+length] = ckA;
+	buf[7+length] = ckB;
+
+	return length + UBX_FRAME_OVERHEAD;
+}
+
+//-----------------------------------------------------------------------------------------------------------------------
+/*! @brief the current message is decoded, the other messages are only checked
+* @param parser parser
+* @retval true for NAV-PVT, NAV-DOP, ACK-ACK and ACK-NAK
+*/
+static bool ubx_used(const tUbxParser * parser)
+{
+	if(parser->msgClass == UBX_CLASS_NAV && parser->msgId == UBX_ID_NAV_PVT)
+		return parser->length == UBX_NAV_PVT_LENGTH;
+
+	if(parser->msgClass == UBX_CLASS_NAV && parser->msgId == UBX_ID_NAV_DOP)
+		return parser->length == UBX_NAV_DOP_LENGTH;
+
+	if(parser->msgClass == UBX_CLASS_ACK && (parser->msgId == UBX_ID_ACK_ACK || parser->msgId == UBX_ID_ACK_NAK))
+		return parser->length == 2;
+
+	return false;
+}
+
+//-----------------------------------------------------------------------------------------------------------------------
+/*! @brief decode a byte of the payload. The bytes of a field are shifted in
+*		  as they come (little endian), the field is stored when complete
+* @param parser parser
+* @param c byte of the payload
+*/
+static void ubx_payload_byte(tUbxParser * parser, uint8_t c)
+{
+	if(parser->msgClass == UBX_CLASS_ACK)		//acknowledged class and id
+	{
+		parser->value |= (uint32_t)c << (8*parser->index);
+		return;
+	}
+
+	bool dop = parser->msgId == UBX_ID_NAV_DOP;
+	const tUbxField * fields = dop ? ubxDopFields : ubxPvtFields;
+	uint8_t count = dop ? sizeof(ubxDopFields)/sizeof(ubxDopFields[0]) : sizeof(ubxPvtFields)/sizeof(ubxPvtFields[0]);
+
+	if(parser->field >= count)
+		return;
+
+	const tUbxField * field = &fields[parser->field];
+
+	if(parser->index < field->offset)		//byte not used
+		return;
+
+	parser->value |= (uint32_t)c << (8*(parser->index - field->offset));
+
+	if(parser->index == field->offset + field->size - 1)		//last byte of the field
+	{
+		ubx_pvt_field(parser,field->kind,parser->value);
+		parser->value = 0;
+		parser->field++;
+	}
+}
+
+//-----------------------------------------------------------------------------------------------------------------------
+/*! @brief store a complete field of NAV-PVT or NAV-DOP into the pending values
+* @param parser parser
+* @param kind kind of field (UBX_F_x)
+* @param value raw value of the field
+*/
+static void ubx_pvt_field(tUbxParser * parser, uint8_t kind, uint32_t value)
+{
+	tUbxPvt * pending = &parser->pending;
+
+	switch(kind)
+	{
+		case UBX_F_ITOW:		pending->iTow = value;						break;
+		case UBX_F_YEAR:		pending->year = (uint16_t)value;			break;
+		case UBX_F_MONTH:		pending->month = (uint8_t)value;			break;
+		case UBX_F_DAY:			pending->day = (uint8_t)value;				break;
+		case UBX_F_HOUR:		parser->hour = (uint8_t)value;				break;
+		case UBX_F_MIN:			parser->min = (uint8_t)value;				break;
+		case UBX_F_SEC:			parser->sec = (uint8_t)value;				break;
+		case UBX_F_NANO:		parser->nano = (int32_t)value;				break;
+		case UBX_F_FIX_TYPE:	pending->fixType = (uint8_t)value;			break;
+		case UBX_F_NUM_SV:		pending->numSv = (uint8_t)value;			break;
+		case UBX_F_LON:			pending->lon = (int32_t)value;				break;
+		case UBX_F_LAT:			pending->lat = (int32_t)value;				break;
+		case UBX_F_HACC:		pending->hAcc = value;						break;
+		case UBX_F_HEADING:		pending->heading = (int32_t)value;			break;
+		case UBX_F_PDOP:		pending->pDop = (uint16_t)value;			break;
+		case UBX_F_DOP_ITOW:	parser->pendingDop.iTow = value;			break;
+		case UBX_F_HDOP:		parser->pendingDop.hDop = (uint16_t)value;	break;
+
+		case UBX_F_VALID:
+			if(value & 0x01)
+				pending->valid |= UBX_HAS_DATE;
+			if(value & 0x02)
+				pending->valid |= UBX_HAS_TIME;
+		break;
+
+		case UBX_F_FLAGS:
+			if(value & 0x01)
+				pending->valid |= UBX_HAS_FIX_OK;
+		break;
+
+		case UBX_F_GSPEED:		//mm/s -> 0.01 km/h
+			pending->speed = (int32_t)value > 0 ? (uint32_t)(((uint64_t)value*36 + 50) / 100) : 0;
+		break;
+	}
+}
+
+//-----------------------------------------------------------------------------------------------------------------------
+/*! @brief publish the message after a correct checksum
+* @param parser parser
+* @retval UBX_MSG_x
+*/
+static int ubx_publish(tUbxParser * parser)
+{
+	if(parser->msgClass == UBX_CLASS_ACK)
+	{
+		parser->ackClass = parser->value & 0xFF;
+		parser->ackId = (parser->value >> 8) & 0xFF;
+		return parser->msgId == UBX_ID_ACK_ACK ? UBX_MSG_ACK : UBX_MSG_NAK;
+	}
+
+	if(parser->msgId == UBX_ID_NAV_DOP)
+	{
+		parser->dop = parser->pendingDop;		//publish the values of the message
+		return UBX_MSG_NAV_DOP;
+	}
+
+	tUbxPvt * pending = &parser->pending;
+
+	if(parser->hour >= 24 || parser->min >= 60 || parser->sec > 60)		//time out of range
+		pending->valid &= ~UBX_HAS_TIME;
+	if(pending->month < 1 || pending->month > 12 || pending->day < 1 || pending->day > 31)
+		pending->valid &= ~UBX_HAS_DATE;
+
+	if(pending->valid & UBX_HAS_TIME)		//hh:mm:ss + nano -> ms of the day (nano is signed)
+	{
+		int64_t ns = (((int64_t)parser->hour*60 + parser->min)*60 + parser->sec)*1000000000LL + parser->nano;
+		pending->time = ns > 0 ? (uint32_t)(ns / 1000000) : 0;
+	}
+
+	parser->pvt = *pending;		//publish the values of the message
+	return UBX_MSG_NAV_PVT;
+}
@@ -0,0 +1,200 @@
+/*! --------------------------------------------------------------------
+ *	Telemetry System	-	@file ubx_parser.h
+ *----------------------------------------------------------------------
+ * HES-SO Valais Wallis
+ * Systems Engineering
+ * Infotronics
+ * ---------------------------------------------------------------------
+ * @author agent
+ * @date 19.10.2026
+ * ---------------------------------------------------------------------
+ * @brief UBX parser reads the binary messages of the u-blox GPS module
+ *        one byte at a time. The fields of the NAV-PVT and NAV-DOP
+ *        messages are decoded while they are received (no copy of the payload) and
+ *        the values are published only if the checksum is correct.
+ * ---------------------------------------------------------------------
+ * Telemetry system for the Valais Wallis Racing Team.
+ * This file contains code for the onboard device of the telemetry
+ * system. The system receives the data from the sensors on the CAN bus
+ * and the data from the GPS on a UART port. An SD Card contains a
+ * configuration file with all the system parameters. The measurements
+ * are sent via Wi-Fi to a computer on the base station. The measurements
+ * are also saved in a CSV file on the SD card.
+ *--------------------------------------------------------------------*/
+
+#ifndef __UBX_PARSER_H
+#define __UBX_PARSER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * Message = 0xB5 0x62 | class (1) | id (1) | length (2) | payload | CK_A | CK_B
+ *
+ * All fields are little endian, the checksum (8 bits Fletcher) covers the
+ * class, id, length and payload. The messages not listed below are skipped
+ * with their length, a message longer than UBX_MAX_LENGTH is dropped.
+ */
+
+//sync characters
+#define UBX_SYNC1               0xB5
+#define UBX_SYNC2               0x62
+
+//classes and ids of the messages used
+#define UBX_CLASS_NAV           0x01
+#define UBX_CLASS_ACK           0x05
+#define UBX_CLASS_CFG           0x06
+#define UBX_ID_NAV_DOP          0x04
+#define UBX_ID_NAV_PVT          0x07
+#define UBX_ID_ACK_NAK          0x00
+#define UBX_ID_ACK_ACK          0x01
+#define UBX_ID_CFG_PRT          0x00
+#define UBX_ID_CFG_MSG          0x01
+#define UBX_ID_CFG_RATE         0x08
+
+//payload length of NAV-PVT (u-blox 8 and later)
+#define UBX_NAV_PVT_LENGTH      92
+//payload length of NAV-DOP
+#define UBX_NAV_DOP_LENGTH      18
+
+//max payload length of a message
+#define UBX_MAX_LENGTH          1024
+
+//frame added around a payload (sync, class, id, length, checksum)
+#define UBX_FRAME_OVERHEAD      8
+
+//messages read by the parser
+#define UBX_MSG_NONE            0
+#define UBX_MSG_NAV_PVT         1       //position, velocity and time
+#define UBX_MSG_ACK             2       //configuration message accepted
+#define UBX_MSG_NAK             3       //configuration message rejected
+#define UBX_MSG_NAV_DOP         4       //dilutions of precision
+
+//values present in the last NAV-PVT message (tUbxPvt.valid)
+#define UBX_HAS_DATE            (1u << 0)
+#define UBX_HAS_TIME            (1u << 1)
+#define UBX_HAS_FIX_OK          (1u << 2)
+
+//fix types of NAV-PVT
+#define UBX_FIX_NONE            0
+#define UBX_FIX_2D              2
+#define UBX_FIX_3D              3
+#define UBX_FIX_GNSS_DR         4       //GNSS and dead reckoning
+
+/*! @brief values of a NAV-PVT message
+    @param valid values present in the message (UBX_HAS_x)
+    @param iTow GPS time of week of the navigation epoch (ms)
+    @param time UTC time of day (ms)
+    @param day date (1..31)
+    @param month date (1..12)
+    @param year date (e.g. 2026)
+    @param fixType fix type (UBX_FIX_x)
+    @param numSv number of satellites used
+    @param lat latitude (1e-7 degree, north positive)
+    @param lon longitude (1e-7 degree, east positive)
+    @param speed ground speed (0.01 km/h)
+    @param heading heading of motion (1e-5 degree)
+    @param hAcc horizontal accuracy estimate (mm)
+    @param pDop position dilution of precision (0.01)
+*/
+typedef struct sUbxPvt{
+    uint32_t valid;
+    uint32_t iTow;
+    uint32_t time;
+    uint8_t day;
+    uint8_t month;
+    uint16_t year;
+    uint8_t fixType;
+    uint8_t numSv;
+    int32_t lat;
+    int32_t lon;
+    uint32_t speed;
+    int32_t heading;
+    uint32_t hAcc;
+    uint16_t pDop;
+}tUbxPvt;
+
+/*! @brief values of a NAV-DOP message
+    @param iTow GPS time of week of the navigation epoch (ms)
+    @param hDop horizontal dilution of precision (0.01)
+*/
+typedef struct sUbxDop{
+    uint32_t iTow;
+    uint16_t hDop;
+}tUbxDop;
+
+/*! @brief parser state
+    @param pvt values of the last valid NAV-PVT message
+    @param pending values of the NAV-PVT message being received
+    @param dop values of the last valid NAV-DOP message
+    @param pendingDop values of the NAV-DOP message being received
+    @param state position in the message
+    @param msgClass class of the message being received
+    @param msgId id of the message being received
+    @param length payload length of the message being received
+    @param index position in the payload
+    @param ckA first checksum byte computed
+    @param ckB second checksum byte computed
+    @param field index of the next field of the payload
+    @param value bytes of the current field
+    @param hour UTC time of the message being received
+    @param min UTC time of the message being received
+    @param sec UTC time of the message being received
+    @param nano fraction of second of the message being received (ns, -1e9..1e9)
+    @param ackClass class of the configuration message of the last ACK or NAK
+    @param ackId id of the configuration message of the last ACK or NAK
+    @param messages valid messages read
+    @param checksumErrors messages dropped because of the checksum
+    @param formatErrors messages dropped because they are too long or malformed
+*/
+typedef struct sUbxParser{
+    tUbxPvt pvt;
+    tUbxPvt pending;
+    tUbxDop dop;
+    tUbxDop pendingDop;
+    uint8_t state;
+    uint8_t msgClass;
+    uint8_t msgId;
+    uint16_t length;
+    uint16_t index;
+    uint8_t ckA;
+    uint8_t ckB;
+    uint8_t field;
+    uint32_t value;
+    uint8_t hour;
+    uint8_t min;
+    uint8_t sec;
+    int32_t nano;
+    uint8_t ackClass;
+    uint8_t ackId;
+    uint32_t messages;
+    uint32_t checksumErrors;
+    uint32_t formatErrors;
+}tUbxParser;
+
+/*! ubx_parser_init resets a parser
+* @param parser parser to reset
+*/
+void ubx_parser_init(tUbxParser * parser);
+
+/*! ubx_parse reads one byte
+* @param parser parser
+* @param c byte received from the GPS module
+* @retval UBX_MSG_x when the byte completes a valid message (the NAV-PVT
+*         values are in parser->pvt, the NAV-DOP values in parser->dop,
+*         the acknowledged message in
+*         parser->ackClass and parser->ackId), UBX_MSG_NONE otherwise
+*/
+int ubx_parse(tUbxParser * parser, uint8_t c);
+
+/*! ubx_frame writes a message with its sync characters and checksum
+* @param buf buffer for the message (length + UBX_FRAME_OVERHEAD bytes)
+* @param msgClass class of the message
+* @param msgId id of the message
+* @param payload payload of the message
+* @param length payload length
+* @retval length of the message
+*/
+int ubx_frame(uint8_t * buf, uint8_t msgClass, uint8_t msgId, const uint8_t * payload, uint16_t length);
+
+#endif /*__UBX_PARSER_H*/
@@ -30,12 +30,16 @@ LOG_MODULE_REGISTER(udp);
 #include <zephyr/posix/arpa/inet.h>
 #include <zephyr/net/socket.h>
 #include <unistd.h> 
+#include <string.h>
+#include <zephyr/sys/byteorder.h>
 
 //project file includes
 #include "udp_client.h"
 #include "deviceinformation.h"
 #include "memory_management.h"
 #include "config_read.h"
+#include "data_sender.h"
+#include "live_protocol.h"
 
 //! Stack size for the UDP_SERVER thread
 #define UDP_CLIENT_STACK_SIZE 8192
@@ -44,6 +48,95 @@ LOG_MODULE_REGISTER(udp);
 //! Time in miliseconds to wait to send the UDP message since the board 
 // gets a stable IP address
 #define UDP_CLIENT_WAIT_TO_SEND_MS 500
+//! Max size of a batch datagram (ethernet MTU - IP and UDP headers)
+#define UDP_BATCH_MAX_SIZE 1472
+//! Default time a message waits in a batch
+#define UDP_BATCH_DEFAULT_DELAY_MS 50
+//! Default max age of a message sent again on NACK
+#define UDP_RETRANSMIT_DEFAULT_DEADLINE_MS 500
+//! First delay before the reconnection of a server in error
+#define UDP_RECONNECT_MIN_MS 500
+//! Max delay between two reconnection attempts
+#define UDP_RECONNECT_MAX_MS 16000
+
+/*! @brief state of a server
+    @param socket socket connected to the server (-1 if closed)
+    @param address address of the server
+    @param healthy server reachable, the messages are sent to it
+    @param retry uptime of the next reconnection attempt
+    @param backoff delay before the next reconnection attempt (doubled after each failure)
+    @param group multicast or broadcast address: the socket is not connected so the
+                 NACKs of every receiver are read, the datagrams are sent with sendto
+*/
+typedef struct sUdpServer{
+    int socket;
+    struct sockaddr_in address;
+    bool group;
+    bool healthy;
+    uint32_t retry;
+    int backoff;
+}tUdpServer;
+
+/*! @brief batch of live messages for one server
+    @param data content of the datagram
+    @param length length of the datagram
+    @param size max length of the datagram (0 = batching disabled)
+    @param delay max time a message waits in the batch (ms)
+    @param start timestamp of the first message of the batch
+    @param deadline uptime when the batch must be sent
+*/
+typedef struct sUdpBatch{
+    uint8_t data[UDP_BATCH_MAX_SIZE];
+    int length;
+    int size;
+    int delay;
+    uint32_t start;
+    uint32_t deadline;
+}tUdpBatch;
+
+//! batches of the servers
+static tUdpBatch udpBatch[MAX_SERVERS];
+
+//! state of the servers
+static tUdpServer udpServers[MAX_SERVERS];
+
+//! statistics of the servers
+tServerStats serverStats[MAX_SERVERS];
+
+//! sent messages kept for retransmission (ring of udpHistoryDepth entries)
+static tUdpMessage * udpHistory[UDP_HISTORY_MAX_DEPTH];
+static int udpHistoryHead;
+
+//static functions prototypes
+
+/*! @brief send a datagram to a server */
+static void udp_send(int server, const uint8_t * data, int length);
+/*! @brief add a message to the batch of a server */
+static void udp_batch_add(int server, tUdpMessage * msg);
+/*! @brief send the batch of a server */
+static void udp_batch_flush(int server);
+/*! @brief send the batch of a server if it reached its deadline */
+static void udp_batch_due(int server);
+/*! @brief time until the next batch deadline or reconnection attempt */
+static k_timeout_t udp_timeout(int socketCount);
+/*! @brief open the socket of a server */
+static void udp_server_open(int server);
+/*! @brief open the unconnected socket of a multicast or broadcast server */
+static int udp_group_socket(int * udpClientSocket);
+/*! @brief close the socket of a server in error and schedule its reconnection */
+static void udp_server_fail(int server, int error);
+/*! @brief close the socket of a server */
+static void udp_server_close(int server);
+/*! @brief reconnect the servers in error whose retry time is reached */
+static void udp_server_retry(int socketCount);
+/*! @brief keep a sent message for retransmission or release it */
+static void udp_history_add(tUdpMessage * msg);
+/*! @brief release all the messages of the history */
+static void udp_history_clear(void);
+/*! @brief read the NACKs of a server and send the missing messages again */
+static void udp_nack_receive(int server);
+/*! @brief get the next message of the priority queue or of the udp queue */
+static int udp_queue_get(tUdpMessage ** msg, k_timeout_t timeout);
 
 
 //! UDP Client stack definition
@@ -57,49 +150,45 @@ static struct k_thread udpClientThread;
 * @brief UDP_Client uses BSD sockets to send messages to one or multiple UDP
 *		server(s). 
 *		The thread send to the UDP servers all the data pushed on the udpQueue.
+*		The messages of the udpPriorityQueue are sent first and without batching.
 */
 void UDP_Client() 
 {
 	//get number of servers the system needs to send data
 	int socketCount = configFile.serverCount;
 
-	//addresses of the sockets
-	char* addresses[socketCount];
-	//ports of the sockets
-	int ports[socketCount];
-
-	for(int i=0;i<socketCount;i++)		//loop for all sockets
+	for(int i=0;i<socketCount;i++)		//loop for all servers
 	{
-		addresses[i]=configFile.Server[i].address;		//assign address
-		ports[i]=configFile.Server[i].port;				//assign port
-	}
-	
-    int udpClientSocket[socketCount];					//client sockets
-	struct sockaddr_in serverAddress[socketCount];		//servers addresses for all sockets
-	int sentBytes[socketCount];						//sent bytes variable for all sockets
+		//batch configuration
+		udpBatch[i].size = MIN(configFile.Server[i].MTU,UDP_BATCH_MAX_SIZE);
+		udpBatch[i].delay = configFile.Server[i].BatchDelay > 0 ? configFile.Server[i].BatchDelay : UDP_BATCH_DEFAULT_DELAY_MS;
+		udpBatch[i].length = 0;
 
+		// Server IPV4 address configuration 
+		udpServers[i].socket = -1;
+		udpServers[i].address.sin_family = AF_INET;
+		udpServers[i].address.sin_port = htons(configFile.Server[i].port);
+		inet_pton(AF_INET, configFile.Server[i].address, &udpServers[i].address.sin_addr );
+		udpServers[i].group = udp_server_is_group(i);
+
+		if(udpServers[i].group)
+			LOG_INF( "UDP %d Client group address %s", i, configFile.Server[i].address );
+	}
 
 	// stop the thread until a DHCP IP is assigned to the board 
 	while(!context.ip_assigned)
 	{
-		//delete messages coming from queue while ip is not assigned
-		char * memPtr;										//message to get from queue
-		memPtr = k_queue_get(&udpQueue,K_FOREVER);			//wait for message in queue
-		k_heap_free(&messageHeap,memPtr);					//free memory allocation made in data sender
+		//spool messages coming from queue while ip is not assigned
+		tUdpMessage * msg;									//message to get from queue
+		if(udp_queue_get(&msg,K_FOREVER) == 0)				//wait for message in queue
+			data_Sender_spool(msg);							//keep message for backfill
 	}
 
-	for(int i=0;i<socketCount;i++)		//loop for all sockets
-	{
-		sentBytes[i]=0;					//set sent byte variable
-
-		// Server IPV4 address configuration 
-		serverAddress[i].sin_family = AF_INET;
-		serverAddress[i].sin_port = htons(ports[i]);
-		inet_pton(AF_INET, addresses[i], &serverAddress[i].sin_addr );
+	//connect UDP sockets
+	for(int i=0;i<socketCount;i++)
+		udp_server_open(i);
 
-		//connect UDP socket
-		connectUDPSocket(&udpClientSocket[i],&serverAddress[i]);
-	}
+	data_Sender_schema_request();		//announce the live schema to the servers
 
 	k_msleep(UDP_CLIENT_WAIT_TO_SEND_MS); //wait some time before sending messages
 
@@ -108,22 +197,28 @@ void UDP_Client()
 
 		if(!context.ip_assigned) 	// ------------------------------------ if wifi connection is lost
 		{
-			//close all sockets
+			//close all sockets and drop the pending batches
 			for(int i=0;i<socketCount;i++)
-				close(udpClientSocket[i]);		
+			{
+				udp_server_close(i);
+				udpBatch[i].length = 0;
+			}
+			udp_history_clear();
 
 			// stop the thread until a DHCP IP is assigned to the board 
 			while( !context.ip_assigned )
 			{
-				//delete messages coming from queue while ip is not assigned
-				char * memPtr;										//message to get from queue
-				memPtr = k_queue_get(&udpQueue,K_FOREVER);			//wait for message in queue
-				k_heap_free(&messageHeap,memPtr);					//free memory allocation made in data sender
+				//spool messages coming from queue while ip is not assigned
+				tUdpMessage * msg;									//message to get from queue
+				if(udp_queue_get(&msg,K_FOREVER) == 0)				//wait for message in queue
+					data_Sender_spool(msg);							//keep message for backfill
 			}
 			
 			// reconnect all sockets
 			for(int i=0;i<socketCount;i++)
-				connectUDPSocket(&udpClientSocket[i],&serverAddress[i]); 
+				udp_server_open(i);
+
+			data_Sender_schema_request();		//announce the live schema to the servers
 
 			//wait some time before sending messages
 			k_msleep( UDP_CLIENT_WAIT_TO_SEND_MS );
@@ -133,21 +228,25 @@ void UDP_Client()
 			//-----------------------------------------
 			//			Receive data from queue
 			
-			char udpMessage[udpQueueMesLength];				//message to send
-			char * memPtr;										//message to get from queue
-			memPtr = k_queue_get(&udpQueue,K_FOREVER);			//wait for message in queue
-			int size = 0;										//size of message
-			for(int i=0; i<udpQueueMesLength; i++)				//loop to copy message
+			tUdpMessage * msg;									//message to get from queue
+
+			if(udp_queue_get(&msg,udp_timeout(socketCount)) != 0)		//wait for message in queue, batch deadline or reconnection
 			{
-				udpMessage[i]=memPtr[i];				//copy char
-				if(udpMessage[i]=='}')					//if the loop reached the end of the JSON message
+				udp_server_retry(socketCount);		//reconnect the servers in error
+
+				for(int i=0;i<socketCount;i++)		//send the batches that reached their deadline
 				{
-					size = i+1;							//calculate size of the message
-					break;								//break loop
+					udp_batch_due(i);
+					udp_nack_receive(i);
 				}
+				continue;
 			}
 
-			k_heap_free(&messageHeap,memPtr);		//free memory allocation made in data sender
+			atomic_val_t latency = k_uptime_get_32() - msg->timestamp;		//time spent in the queue
+			if(latency > atomic_get(&linkStats.latencyMax))
+				atomic_set(&linkStats.latencyMax,latency);
+
+			udp_server_retry(socketCount);		//reconnect the servers in error
 
 
 			//------------------------------------------
@@ -155,18 +254,16 @@ void UDP_Client()
 
 			for(int i=0;i<socketCount;i++)		//loop for all sockets
 			{
-				// Send the udp message 
-				sentBytes[i] = send(udpClientSocket[i], udpMessage, size, 0);
-
-				//LOG_INF( "UDP %d Client mode. Sent: %d", i,sentBytes[i]);		//log message
-				
-				if ( sentBytes[i] < 0 ) 		//in case of error
-				{
-					LOG_ERR( "UDP %d Client error: send: %d\n", i,errno );		//log message
-					close(udpClientSocket[i]);									//close socket
-					LOG_ERR( "UDP %d Client error Connection from closed\n",i );
-				}
+				if(msg->flags & UDP_MSG_PRIORITY)		//priority class : not delayed in a batch
+					udp_send(i,msg->data,msg->length);
+				else
+					udp_batch_add(i,msg);
+				udp_batch_due(i);				//the queue may never be empty under a sustained backlog
+				udp_nack_receive(i);
 			}
+
+			atomic_inc(&linkStats.sent);
+			udp_history_add(msg);				//keep or release the block allocated in data sender
 		}
 	}	// ------------------------------------------------------------------------------  end of thread infinite loop
 }
@@ -174,23 +271,412 @@ void UDP_Client()
 
 
 //------------------------------------------------------------------------------------------------
-/*! @brief UDP socket connect function
- *  @param udpClientSocket UDP Client socket variable
+/*! @brief get the next message to send. The messages of the priority classes
+ *		   skip ahead of the messages waiting in the udp queue
+ *  @param msg message taken from a queue
+ *  @param timeout max time to wait for a message
+ *  @retval 0 on success, not 0 if no message came before the timeout
+ */
+static int udp_queue_get(tUdpMessage ** msg, k_timeout_t timeout)
+{
+	if(k_msgq_get(&udpPriorityQueue,msg,K_NO_WAIT) == 0 || k_msgq_get(&udpQueue,msg,K_NO_WAIT) == 0)
+		return 0;
+
+	struct k_poll_event events[] = {
+		K_POLL_EVENT_INITIALIZER(K_POLL_TYPE_MSGQ_DATA_AVAILABLE, K_POLL_MODE_NOTIFY_ONLY, &udpPriorityQueue),
+		K_POLL_EVENT_INITIALIZER(K_POLL_TYPE_MSGQ_DATA_AVAILABLE, K_POLL_MODE_NOTIFY_ONLY, &udpQueue),
+	};
+
+	int ret = k_poll(events,ARRAY_SIZE(events),timeout);		//wait for a message in one of the queues
+	if(ret != 0)
+		return ret;
+
+	if(k_msgq_get(&udpPriorityQueue,msg,K_NO_WAIT) == 0)
+		return 0;
+	return k_msgq_get(&udpQueue,msg,K_NO_WAIT);		//-ENOMSG if the data sender dropped it in the meantime
+}
+
+//------------------------------------------------------------------------------------------------
+/*! @brief send a datagram to a server without blocking. A full socket buffer
+ *		   drops the datagram for this server only, a network error closes the
+ *		   socket and schedules the reconnection of the server
+ *  @param server index of the server
+ *  @param data content of the datagram
+ *  @param length length of the datagram
+ */
+static void udp_send(int server, const uint8_t * data, int length)
+{
+	if(!udpServers[server].healthy)		//server in error, waiting for reconnection
+		return;
+
+	uint32_t start = k_cycle_get_32();
+
+	// Send the udp message 
+	int sentBytes;
+	if(udpServers[server].group)
+		sentBytes = sendto(udpServers[server].socket, data, length, MSG_DONTWAIT, (struct sockaddr *)&udpServers[server].address, sizeof(udpServers[server].address));
+	else
+		sentBytes = send(udpServers[server].socket, data, length, MSG_DONTWAIT);
+
+	atomic_val_t duration = k_cyc_to_us_floor32(k_cycle_get_32() - start);		//time spent in send
+	if(duration > atomic_get(&serverStats[server].latencyMax))
+		atomic_set(&serverStats[server].latencyMax,duration);
+
+	if(sentBytes >= 0)		//sent
+	{
+		atomic_inc(&serverStats[server].sent);
+		return;
+	}
+
+	int error = errno;
+	atomic_inc(&serverStats[server].errors);
+
+	if(error == EAGAIN || error == EWOULDBLOCK || error == ENOMEM || error == ENOBUFS)		//socket buffer full
+		return;		//datagram dropped for this server, the others are not delayed
+
+	udp_server_fail(server,error);
+}
+
+//------------------------------------------------------------------------------------------------
+/*! @brief add a message to the batch of a server. The batch is sent when the
+ *		   next message does not fit in the MTU. Messages are sent alone if 
+ *		   batching is disabled or if they do not fit in a batch
+ *  @param server index of the server
+ *  @param msg message to add
+ */
+static void udp_batch_add(int server, tUdpMessage * msg)
+{
+	tUdpBatch * batch = &udpBatch[server];
+	int entrySize = sizeof(tLiveBatchEntry) + msg->length;
+
+	if(!udpServers[server].healthy)		//server in error, nothing is kept for it
+		return;
+
+	if(sizeof(tLiveBatchHeader) + entrySize > batch->size)		//no batching
+	{
+		udp_batch_flush(server);					//keep messages order
+		udp_send(server,msg->data,msg->length);
+		return;
+	}
+
+	if(batch->length + entrySize > batch->size)		//batch full
+		udp_batch_flush(server);
+
+	tLiveBatchHeader * header = (tLiveBatchHeader *)batch->data;
+
+	if(batch->length == 0)		//new batch
+	{
+		header->magic = sys_cpu_to_le16(LIVE_MAGIC);
+		header->version = LIVE_PROTOCOL_VERSION;
+		header->type = LIVE_PKT_BATCH;
+		header->count = 0;
+		batch->length = sizeof(tLiveBatchHeader);
+		batch->start = msg->timestamp;
+		batch->deadline = k_uptime_get_32() + batch->delay;
+	}
+
+	tLiveBatchEntry * entry = (tLiveBatchEntry *)(batch->data + batch->length);
+	entry->timeDelta = sys_cpu_to_le16(MIN(msg->timestamp - batch->start,UINT16_MAX));
+	entry->length = sys_cpu_to_le16(msg->length);
+	memcpy(batch->data + batch->length + sizeof(tLiveBatchEntry),msg->data,msg->length);
+	batch->length += entrySize;
+	header->count++;
+
+	if(header->count == UINT8_MAX)		//max number of entries
+		udp_batch_flush(server);
+}
+
+//------------------------------------------------------------------------------------------------
+/*! @brief send the batch of a server
+ *  @param server index of the server
+ */
+static void udp_batch_flush(int server)
+{
+	if(udpBatch[server].length > 0)
+	{
+		int length = udpBatch[server].length;
+		udpBatch[server].length = 0;
+		udp_send(server,udpBatch[server].data,length);
+	}
+}
+
+//------------------------------------------------------------------------------------------------
+/*! @brief send the batch of a server if it reached its deadline (BatchDelay)
+ *  @param server index of the server
+ */
+static void udp_batch_due(int server)
+{
+	if(udpBatch[server].length > 0 && (int32_t)(k_uptime_get_32() - udpBatch[server].deadline) >= 0)
+		udp_batch_flush(server);
+}
+
+//------------------------------------------------------------------------------------------------
+/*! @brief time until the next batch deadline or reconnection attempt
+ *  @param socketCount number of servers
+ *  @retval timeout for the udp queue (K_FOREVER if nothing is pending)
+ */
+static k_timeout_t udp_timeout(int socketCount)
+{
+	k_timeout_t timeout = K_FOREVER;
+	int32_t minRemaining = INT32_MAX;
+
+	for(int i=0;i<socketCount;i++)
+	{
+		int32_t remaining = INT32_MAX;
+
+		if(udpBatch[i].length > 0)		//batch pending
+			remaining = udpBatch[i].deadline - k_uptime_get_32();
+		else if(!udpServers[i].healthy)		//reconnection pending
+			remaining = udpServers[i].retry - k_uptime_get_32();
+		else
+			continue;
+
+		minRemaining = MIN(minRemaining,MAX(remaining,0));
+		timeout = K_MSEC(minRemaining);
+	}
+	return timeout;
+}
+
+//------------------------------------------------------------------------------------------------
+/*! @brief open the socket of a server (non blocking). The reconnection is
+ *		   scheduled if the socket cannot be opened
+ *  @param server index of the server
+ */
+static void udp_server_open(int server)
+{
+	tUdpServer * udpServer = &udpServers[server];
+
+	int error = udpServer->group ? udp_group_socket(&udpServer->socket) : connectUDPSocket(&udpServer->socket,&udpServer->address);
+
+	if(error != 0)
+	{
+		udp_server_fail(server,error);
+		return;
+	}
+
+	if(udpServer->backoff > 0)		//reconnection after an error
+	{
+		atomic_inc(&serverStats[server].reconnects);
+		LOG_INF( "UDP %d Client reconnected", server );
+	}
+
+	udpServer->healthy = true;
+	udpServer->backoff = 0;
+	atomic_set(&serverStats[server].healthy,true);
+}
+
+//------------------------------------------------------------------------------------------------
+/*! @brief open the socket of a multicast or broadcast server. The socket is
+ *		   not connected: the NACKs of all the receivers come back on it
+ *  @param udpClientSocket UDP Client socket variable (-1 on error)
+ *  @retval 0 on success, errno on error
+ */
+static int udp_group_socket(int * udpClientSocket)
+{
+	*udpClientSocket = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+
+	if ( *udpClientSocket < 0 ) {
+		LOG_ERR( "UDP Client error: socket: %d\n", errno );
+		return errno;
+	}
+	LOG_INF( "UDP Client group socket open" );
+	return 0;
+}
+
+//------------------------------------------------------------------------------------------------
+/*! @brief close the socket of a server in error and schedule its reconnection.
+ *		   The delay before the reconnection is doubled after each failure
+ *  @param server index of the server
+ *  @param error errno of the failure
+ */
+static void udp_server_fail(int server, int error)
+{
+	tUdpServer * udpServer = &udpServers[server];
+
+	if(udpServer->healthy)
+		LOG_ERR( "UDP %d Client error: %d, server down", server, error );
+
+	udp_server_close(server);
+
+	udpServer->backoff = udpServer->backoff == 0 ? UDP_RECONNECT_MIN_MS : MIN(2*udpServer->backoff,UDP_RECONNECT_MAX_MS);
+	udpServer->retry = k_uptime_get_32() + udpServer->backoff;
+}
+
+//------------------------------------------------------------------------------------------------
+/*! @brief close the socket of a server and drop its pending batch
+ *  @param server index of the server
+ */
+static void udp_server_close(int server)
+{
+	if(udpServers[server].socket >= 0)
+	{
+		close(udpServers[server].socket);
+		udpServers[server].socket = -1;
+	}
+	udpServers[server].healthy = false;
+	udpBatch[server].length = 0;
+	atomic_set(&serverStats[server].healthy,false);
+}
+
+//------------------------------------------------------------------------------------------------
+/*! @brief reconnect the servers in error whose retry time is reached
+ *  @param socketCount number of servers
+ */
+static void udp_server_retry(int socketCount)
+{
+	for(int i=0;i<socketCount;i++)
+	{
+		if(!udpServers[i].healthy && (int32_t)(k_uptime_get_32() - udpServers[i].retry) >= 0)
+			udp_server_open(i);
+	}
+}
+
+//------------------------------------------------------------------------------------------------
+/*! @brief keep a sent message for retransmission. The oldest message of the
+ *		   history is released. Messages without UDP_MSG_RETRANSMIT are released
+ *  @param msg sent message
+ */
+static void udp_history_add(tUdpMessage * msg)
+{
+	if(!(msg->flags & UDP_MSG_RETRANSMIT) || udpHistoryDepth == 0)
+	{
+		k_mem_slab_free(&messageSlab,(void **)&msg);		//release the block allocated in data sender
+		return;
+	}
+
+	if(udpHistory[udpHistoryHead] != NULL)		//release oldest message
+		k_mem_slab_free(&messageSlab,(void **)&udpHistory[udpHistoryHead]);
+
+	udpHistory[udpHistoryHead] = msg;
+	udpHistoryHead = (udpHistoryHead+1) % udpHistoryDepth;
+}
+
+//------------------------------------------------------------------------------------------------
+/*! @brief release all the messages of the history
+ */
+static void udp_history_clear(void)
+{
+	for(int i=0;i<udpHistoryDepth;i++)
+	{
+		if(udpHistory[i] != NULL)
+		{
+			k_mem_slab_free(&messageSlab,(void **)&udpHistory[i]);
+			udpHistory[i] = NULL;
+		}
+	}
+	udpHistoryHead = 0;
+}
+
+//------------------------------------------------------------------------------------------------
+/*! @brief read the NACKs of a server (non blocking) and send the missing 
+ *		   messages again if they are still in the history and younger than
+ *		   the retransmit deadline. On a multicast or broadcast server every
+ *		   laptop NACKs the same loss and every resend reaches all of them :
+ *		   a message is sent again and counted as lost only once for the
+ *		   group, the other NACKs of the deadline window are ignored
+ *  @param server index of the server
+ */
+static void udp_nack_receive(int server)
+{
+	uint8_t nack[sizeof(tLiveNackHeader) + 4*LIVE_NACK_MAX_COUNT];
+	int deadline = configFile.LiveRetransmitDeadline > 0 ? configFile.LiveRetransmitDeadline : UDP_RETRANSMIT_DEFAULT_DEADLINE_MS;
+	int len;
+
+	if(!udpServers[server].healthy)		//no socket
+		return;
+
+	while((len = recv(udpServers[server].socket, nack, sizeof(nack), MSG_DONTWAIT)) >= (int)sizeof(tLiveNackHeader))
+	{
+		tLiveNackHeader * header = (tLiveNackHeader *)nack;
+
+		if(sys_le16_to_cpu(header->magic) != LIVE_MAGIC || header->type != LIVE_PKT_NACK)		//not a NACK
+			continue;
+
+		int count = MIN(header->count,(len-sizeof(tLiveNackHeader))/4);
+
+		for(int n=0;n<count;n++)		//loop for every missing sequence
+		{
+			uint32_t sequence = sys_get_le32(&nack[sizeof(tLiveNackHeader)+4*n]);
+			tUdpMessage * msg = NULL;
+
+			for(int i=0;i<udpHistoryDepth;i++)		//find the message in the history
+			{
+				if(udpHistory[i] != NULL && udpHistory[i]->sequence == sequence)
+					msg = udpHistory[i];
+			}
+
+			if(msg != NULL && udpServers[server].group)
+			{
+				if(msg->flags & UDP_MSG_GROUP_NACKED)		//NACK of another laptop of the group
+					continue;
+				msg->flags |= UDP_MSG_GROUP_NACKED;
+			}
+
+			if(msg != NULL)		//sent since the connection, not a spooled or backfilled sample
+				atomic_inc(&linkStats.nackLive);
+
+			if(msg != NULL && (int32_t)(k_uptime_get_32() - msg->timestamp) <= deadline)
+			{
+				udp_send(server,msg->data,msg->length);
+				atomic_inc(&linkStats.retransmitted);
+			}
+			else
+			{
+				atomic_inc(&linkStats.retransmitMissed);
+			}
+		}
+	}
+}
+
+//------------------------------------------------------------------------------------------------
+/*! @brief UDP socket connect function (does not block)
+ *  @param udpClientSocket UDP Client socket variable (-1 on error)
  *  @param serverAdress Socket Address struct
+ *  @retval 0 on success, errno on error
  */
-void connectUDPSocket(int * udpClientSocket,struct sockaddr_in * serverAddress)
+int connectUDPSocket(int * udpClientSocket,struct sockaddr_in * serverAddress)
 {
 	// Client socket creation 
 	*udpClientSocket = socket(serverAddress->sin_family, SOCK_DGRAM, IPPROTO_UDP );
 
+	if ( *udpClientSocket < 0 ) {
+		LOG_ERR( "UDP Client error: socket: %d\n", errno );
+		return errno;
+	}
+
 	// Connection to the server. 
 	int connectionResult = connect(*udpClientSocket, ( struct sockaddr * )serverAddress, sizeof( *serverAddress ));
 
 	if ( connectionResult < 0 ) {
-		LOG_ERR( "UDP Client error: connect: %d\n", errno );
-		k_sleep( K_FOREVER );
+		int error = errno;
+		LOG_ERR( "UDP Client error: connect: %d\n", error );
+		close(*udpClientSocket);
+		*udpClientSocket = -1;
+		return error;
 	}
 	LOG_INF( "UDP Client connected correctly" );
+	return 0;
+}
+
+//------------------------------------------------------------------------------------------------
+/*! @brief tells if a server of the config file is a multicast or broadcast
+ *		   address. The address decides when the mode is not set
+ *  @param server index of the server
+ *  @retval true for a multicast or broadcast server
+ */
+bool udp_server_is_group(int server)
+{
+	const char * mode = configFile.Server[server].Mode;
+
+	if(mode != NULL && mode[0] != '\0')
+		return strcmp(mode,"multicast") == 0 || strcmp(mode,"broadcast") == 0;
+
+	struct in_addr address;
+	if(inet_pton(AF_INET, configFile.Server[server].address, &address) != 1)
+		return false;
+
+	uint32_t ip = ntohl(address.s_addr);
+	return (ip >> 28) == 0xE || ip == 0xFFFFFFFF;		//224.0.0.0/4 or limited broadcast
 }
 
 //-----------------------------------------------------------------------------------------------------------------------
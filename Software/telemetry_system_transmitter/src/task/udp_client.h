@@ -41,11 +41,18 @@ void Task_UDP_Client_Init( void );
 
 //function prototype
 
-/*! @brief UDP socket connect function
- *  @param udpClientSocket UDP Client socket variable
+/*! @brief UDP socket connect function (does not block)
+ *  @param udpClientSocket UDP Client socket variable (-1 on error)
  *  @param serverAdress Socket Address struct
+ *  @retval 0 on success, errno on error
  */
-void connectUDPSocket(int * udpClientSocket,struct sockaddr_in * serverAddress);
+int connectUDPSocket(int * udpClientSocket,struct sockaddr_in * serverAddress);
+
+/*! @brief tells if a server of the config file is a multicast or broadcast address
+ *  @param server index of the server
+ *  @retval true for a multicast or broadcast server
+ */
+bool udp_server_is_group(int server);
 
 
 
@@ -10,7 +10,9 @@
  * ---------------------------------------------------------------------
  * @brief Wifi sta task connects the system to the configured WiFi
  * 		  Router and Redundancy WiFi Router. Connection status is
- * 		  saved in the deviceInformation.h file
+ * 		  saved in the deviceInformation.h file. When the signal gets
+ * 		  weak, the other router is scanned in background and the
+ * 		  connection switches to it if its signal is better.
  * ---------------------------------------------------------------------
  * Telemetry system for the Valais Wallis Racing Team.
  * This file contains code for the onboard device of the telemetry
@@ -41,6 +43,7 @@ LOG_MODULE_REGISTER(wifi);
 #include "deviceinformation.h"
 #include "wifi_sta.h"
 #include "config_read.h"
+#include "memory_management.h"
 
 //! Wifi thread priority level
 #define WIFI_STACK_SIZE 4096
@@ -52,17 +55,80 @@ K_THREAD_STACK_DEFINE(WIFI_STACK, WIFI_STACK_SIZE);
 //! Variable to identify the Wifi thread
 static struct k_thread wifiThread;
 
-#define WIFI_SHELL_MGMT_EVENTS (NET_EVENT_WIFI_CONNECT_RESULT | NET_EVENT_WIFI_DISCONNECT_RESULT)
+#define WIFI_SHELL_MGMT_EVENTS (NET_EVENT_WIFI_CONNECT_RESULT | NET_EVENT_WIFI_DISCONNECT_RESULT | \
+								NET_EVENT_WIFI_SCAN_RESULT | NET_EVENT_WIFI_SCAN_DONE)
 
 //timeout values
 #define CONNECTION_TIMEOUT_RED_ENABLED  30
 #define CONNECTION_TIMEOUT_RED_DISABLED  50000
 #define STATUS_POLLING_MS   300
+//period of the connection supervision
+#define LINK_POLLING_MS     100
+//period of the rssi measurement
+#define RSSI_POLLING_MS     1000
+//min time between two background scans
+#define ROAM_SCAN_PERIOD_MS 5000
+//max age of a scan result used to choose the router
+#define ROAM_SCAN_MAX_AGE_MS 15000
+//default min rssi difference to switch to the other router (dB)
+#define ROAM_DEFAULT_HYSTERESIS 8
+//max wait of the disconnection before a switch
+#define DISCONNECT_TIMEOUT_MS 1000
+//min remaining time of a DHCP lease to reuse it
+#define LEASE_MARGIN_MS     10000
+
+//configured routers
+#define WIFI_NETWORK_PRIMARY    0
+#define WIFI_NETWORK_REDUNDANCY 1
+#define WIFI_NETWORK_COUNT      2
+
+/*! @brief state of a configured router
+    @param params connection parameters (prepared once, the channel is the last one known)
+    @param rssi best rssi of the router in the last scan (dBm)
+    @param seen uptime of the last scan that found the router (0 = never)
+    @param scanRssi best rssi of the router in the running scan
+    @param scanChannel channel of the best access point in the running scan
+    @param lease DHCP lease obtained on this router is known
+    @param address leased address
+    @param netmask netmask of the lease
+    @param gateway gateway of the lease
+    @param leaseEnd uptime of the end of the lease (ms)
+*/
+typedef struct sWifiNetwork{
+    struct wifi_connect_req_params params;
+    int8_t rssi;
+    int64_t seen;
+    int8_t scanRssi;
+    uint8_t scanChannel;
+    bool lease;
+    struct in_addr address;
+    struct in_addr netmask;
+    struct in_addr gateway;
+    int64_t leaseEnd;
+}tWifiNetwork;
 
 //static functions prototypes
 
 /*!	@brief	wifi connect function -> sends a connect request to wifi driver*/
-static int wifi_connect(const char* ssid, char* pass);
+static int wifi_connect(int network);
+/*! @brief wifi disconnect function -> disconnects before a switch to the other router */
+static void wifi_disconnect(void);
+/*! @brief request a background scan */
+static void wifi_scan(void);
+/*! @brief wifi scan events function */
+static void handle_wifi_scan_result(struct net_mgmt_event_callback *cb);
+/*! @brief wifi scan done function */
+static void handle_wifi_scan_done(void);
+/*! @brief rssi of the current connection */
+static int wifi_rssi(void);
+/*! @brief router to connect to after a connection loss */
+static int wifi_next_network(int rssi);
+/*! @brief reuse the DHCP lease of a router */
+static void wifi_lease_reuse(int network);
+/*! @brief keep the DHCP lease of the current router */
+static void wifi_lease_store(const struct net_if_dhcpv4 *dhcpv4);
+/*! @brief report the outage and reconnection times when the ip is assigned */
+static void wifi_link_up(void);
 /*! @brief wifi args to params function -> set wifi param struct with ssid and password		*/
 static int __wifi_args_to_params(struct wifi_connect_req_params *params, const char* ssid, char* pass);
 /*! @brief net event callback (dhcp) */
@@ -88,6 +154,15 @@ static struct net_mgmt_event_callback net_shell_mgmt_cb;
 tContext context;
 int connectionTimeout;
 
+static tWifiNetwork networks[WIFI_NETWORK_COUNT];	//configured routers
+static int networkCount;							//number of configured routers
+static int currentNetwork;							//router of the current connection
+static volatile bool scanRunning;					//background scan in progress
+static int64_t connectStart;						//uptime of the last connect request
+static int64_t linkLost;							//uptime of the connection loss (0 = no outage)
+
+tWifiStats wifiStats;								//wifi statistics
+
 
 //-----------------------------------------------------------------------------------------------------------------------
 /*! Wifi_Sta implements the task WiFi Stationing.
@@ -108,81 +183,275 @@ void Wifi_Sta( void )
 	net_mgmt_init_event_callback(&net_shell_mgmt_cb, net_mgmt_event_handler, NET_EVENT_IPV4_DHCP_BOUND);
 	net_mgmt_add_event_callback(&net_shell_mgmt_cb);
 
+	//prepare the connection parameters of the routers once
+	networkCount = configFile.WiFiRouterRedundancy.Enabled ? WIFI_NETWORK_COUNT : 1;
+	__wifi_args_to_params(&networks[WIFI_NETWORK_PRIMARY].params,configFile.WiFiRouter.SSID,configFile.WiFiRouter.Password);
+	__wifi_args_to_params(&networks[WIFI_NETWORK_REDUNDANCY].params,configFile.WiFiRouterRedundancy.SSID,configFile.WiFiRouterRedundancy.Password);
+	currentNetwork = WIFI_NETWORK_PRIMARY;
+	linkLost = 0;
+
 	//wait some time before starting the thread
 	k_sleep(K_SECONDS(1));
 
 	while (1) 		//--------------   thread infinite loop
     {
-		wifi_connect(configFile.WiFiRouter.SSID,configFile.WiFiRouter.Password);							//try to connect to the first ssid
-		connection_handler();																				//bloc the thread if connection succeed
-
-		if(configFile.WiFiRouterRedundancy.Enabled)			//if redundancy is enabled
-		{
-			wifi_connect(configFile.WiFiRouterRedundancy.SSID,configFile.WiFiRouterRedundancy.Password);	//try to connect to the first ssid
-			connection_handler();																			//bloc the thread if connection succeed
-		}																		
-		
+		wifi_connect(currentNetwork);							//request the connection to the router
+		currentNetwork = connection_handler();					//bloc the thread while the connection is up
 	}				//--------------	en of thread infinite loop
 }
 
 
 //------------------------------------------------------------------------------------------------
-/*!	@brief	wifi connect function -> sends a connect request to wifi driver*/
-static int wifi_connect(const char* ssid, char* pass)
+/*!	@brief	wifi connect function -> sends a connect request to wifi driver
+ *  @param network index of the router (WIFI_NETWORK_x)
+*/
+static int wifi_connect(int network)
 {
 	//wifi params
 	struct net_if *iface = net_if_get_default();
-	static struct wifi_connect_req_params cnx_params;
 
 	//set context to disconnected state
 	context.connected = false;
 	context.ip_assigned = false;
 	context.connect_result = false;
+	context.disconnect_requested = false;
 
-	//set ssid and password
-	__wifi_args_to_params(&cnx_params,ssid,pass);
+	connectStart = k_uptime_get();
+	atomic_set(&wifiStats.network,network);
 
-	//request connection
-	if (net_mgmt(NET_REQUEST_WIFI_CONNECT, iface, &cnx_params, sizeof(struct wifi_connect_req_params))) 
+	//request connection with the cached parameters
+	if (net_mgmt(NET_REQUEST_WIFI_CONNECT, iface, &networks[network].params, sizeof(struct wifi_connect_req_params))) 
 	{
 		LOG_ERR("Connection request failed");
 		return -ENOEXEC;
 	}
 
-	LOG_INF("Connection requested");
+	LOG_INF("Connection to %s requested (channel %d)", networks[network].params.ssid, networks[network].params.channel);
 
 	return 0;
 }
 
+//------------------------------------------------------------------------------------------------
+/*! @brief wifi disconnect function -> disconnects before a switch to the
+ *         other router and waits for the disconnection
+*/
+static void wifi_disconnect(void)
+{
+	struct net_if *iface = net_if_get_default();
+
+	context.disconnect_requested = true;
+
+	if (net_mgmt(NET_REQUEST_WIFI_DISCONNECT, iface, NULL, 0)) 
+	{
+		LOG_ERR("Disconnection request failed");
+		return;
+	}
+
+	for (int t = 0; t < DISCONNECT_TIMEOUT_MS && context.connected; t += LINK_POLLING_MS)
+		k_msleep(LINK_POLLING_MS);
+}
+
 //------------------------------------------------------------------------------------------------
 /*! @brief connection handler must be called after the wifi_connect request.
- *         It handles the connection callbacks.
+ *         It handles the connection callbacks and supervises the connection:
+ *         when the rssi is below WiFiRoamRssi, the other router is scanned
+ *         and the connection switches to it if its rssi is better by
+ *         WiFiRoamHysteresis.
+ * @retval router to connect to next (WIFI_NETWORK_x)
 */
-void connection_handler(void)
+int connection_handler(void)
 {
+	int other = (currentNetwork + 1) % networkCount;
+	int hysteresis = configFile.WiFiRoamHysteresis > 0 ? configFile.WiFiRoamHysteresis : ROAM_DEFAULT_HYSTERESIS;
+	int rssi = 0;
+
 	for (int i = 0; i < connectionTimeout; i++) 		//wait some time 
 	{
 		k_sleep(K_MSEC(STATUS_POLLING_MS));
-		cmd_wifi_status();
 
 		if (context.connect_result) 				//break loop if connection succeed
 			break;
 	}
+
+	if (!context.connected) 				//log message if connection is down
+	{
+		LOG_INF("Connection Timed Out");
+		networks[currentNetwork].params.channel = WIFI_CHANNEL_ANY;		//the router may have changed its channel
+		return other;
+	}
+
+	cmd_wifi_status();
+	wifi_lease_reuse(currentNetwork);		//no DHCP wait if the lease is still valid
+
+	int64_t lastRssi = 0;
+	int64_t lastScan = 0;
+
 	while(context.connected) 				//wait while conncetion is up
 	{
-		k_msleep(100);
-	} 
-	if (!context.connect_result) 				//log message if connection is down
+		k_msleep(LINK_POLLING_MS);
+
+		if (k_uptime_get() - lastRssi < RSSI_POLLING_MS)
+			continue;
+		lastRssi = k_uptime_get();
+
+		rssi = wifi_rssi();
+		atomic_set(&wifiStats.rssi,rssi);
+
+		if (networkCount < WIFI_NETWORK_COUNT || configFile.WiFiRoamRssi == 0 || rssi >= configFile.WiFiRoamRssi)
+			continue;		//roaming disabled or signal good enough
+
+		if (!scanRunning && k_uptime_get() - lastScan >= ROAM_SCAN_PERIOD_MS)		//weak signal : look for the other router
+		{
+			lastScan = k_uptime_get();
+			wifi_scan();
+		}
+
+		if (networks[other].seen != 0 && k_uptime_get() - networks[other].seen < ROAM_SCAN_MAX_AGE_MS &&
+			networks[other].rssi >= rssi + hysteresis)
+		{
+			LOG_INF("Roaming to %s (%d dBm, current %d dBm)", networks[other].params.ssid, networks[other].rssi, rssi);
+			atomic_inc(&wifiStats.roams);
+			linkLost = k_uptime_get();
+			wifi_disconnect();
+			return other;
+		}
+	}
+
+	LOG_INF("Connection lost");
+	return wifi_next_network(rssi);
+}
+
+//------------------------------------------------------------------------------------------------
+/*! @brief router to connect to after a connection loss : the other router if
+ *         a recent scan found it with a better signal, the same one otherwise
+ *  @param rssi last rssi of the current connection
+ *  @retval router to connect to next (WIFI_NETWORK_x)
+*/
+static int wifi_next_network(int rssi)
+{
+	int other = (currentNetwork + 1) % networkCount;
+
+	if (other != currentNetwork && networks[other].seen != 0 && 
+		k_uptime_get() - networks[other].seen < ROAM_SCAN_MAX_AGE_MS && networks[other].rssi > rssi)
+		return other;
+
+	return currentNetwork;
+}
+
+//------------------------------------------------------------------------------------------------
+/*! @brief request a background scan. The results update the rssi and the
+ *         channel of the configured routers
+*/
+static void wifi_scan(void)
+{
+	struct net_if *iface = net_if_get_default();
+
+	for (int n = 0; n < networkCount; n++)
 	{
-		LOG_INF("Connection Timed Out");
+		networks[n].scanRssi = INT8_MIN;
+		networks[n].scanChannel = WIFI_CHANNEL_ANY;
+	}
+
+	scanRunning = true;
+
+	if (net_mgmt(NET_REQUEST_WIFI_SCAN, iface, NULL, 0)) 
+	{
+		LOG_ERR("Scan request failed");
+		scanRunning = false;
 	}
 }
 
+//------------------------------------------------------------------------------------------------
+/*! @brief rssi of the current connection
+ *  @retval rssi (dBm), 0 if the status is not available
+*/
+static int wifi_rssi(void)
+{
+	struct net_if *iface = net_if_get_default();
+	struct wifi_iface_status status = { 0 };
+
+	if (net_mgmt(NET_REQUEST_WIFI_IFACE_STATUS, iface, &status, sizeof(struct wifi_iface_status)) ||
+		status.state < WIFI_STATE_ASSOCIATED)
+		return 0;
+
+	networks[currentNetwork].params.channel = status.channel;		//next connection without full scan
+	return status.rssi;
+}
+
+//------------------------------------------------------------------------------------------------
+/*! @brief reuse the DHCP lease of a router if it is still valid. The address
+ *         is used at once, the DHCP exchange continues in background
+ *  @param network index of the router (WIFI_NETWORK_x)
+*/
+static void wifi_lease_reuse(int network)
+{
+	struct net_if *iface = net_if_get_default();
+	tWifiNetwork * net = &networks[network];
+
+	if (!net->lease || net->leaseEnd - k_uptime_get() < LEASE_MARGIN_MS || context.ip_assigned)
+		return;
+
+	for (int n = 0; n < networkCount; n++)		//remove the address of the other router
+	{
+		if (n != network && networks[n].lease && networks[n].address.s_addr != net->address.s_addr)
+			net_if_ipv4_addr_rm(iface, &networks[n].address);
+	}
 
+	struct net_if *addressIface;
+	if (net_if_ipv4_addr_lookup(&net->address, &addressIface) == NULL)
+		net_if_ipv4_addr_add(iface, &net->address, NET_ADDR_DHCP, 0);
+	net_if_ipv4_set_netmask(iface, &net->netmask);
+	net_if_ipv4_set_gw(iface, &net->gateway);
 
+	char address[NET_IPV4_ADDR_LEN];
+	LOG_INF("DHCP lease reused: %s", net_addr_ntop(AF_INET, &net->address, address, sizeof(address)));
+
+	wifi_link_up();
+}
 
 //------------------------------------------------------------------------------------------------
-/*! @brief wifi events callback (connect and disconnect)  */		
+/*! @brief keep the DHCP lease of the current router
+ *  @param dhcpv4 DHCP state of the interface
+*/
+static void wifi_lease_store(const struct net_if_dhcpv4 *dhcpv4)
+{
+	struct net_if *iface = net_if_get_default();
+	tWifiNetwork * net = &networks[currentNetwork];
+
+	if (net->lease && net->address.s_addr != dhcpv4->requested_ip.s_addr)		//new address : drop the reused one
+		net_if_ipv4_addr_rm(iface, &net->address);
+
+	net->address = dhcpv4->requested_ip;
+	net->netmask = iface->config.ip.ipv4->netmask;
+	net->gateway = iface->config.ip.ipv4->gw;
+	net->leaseEnd = k_uptime_get() + (int64_t)dhcpv4->lease_time * MSEC_PER_SEC;
+	net->lease = true;
+}
+
+//------------------------------------------------------------------------------------------------
+/*! @brief the ip is assigned : report the outage and reconnection times
+*/
+static void wifi_link_up(void)
+{
+	if (context.ip_assigned)
+		return;
+
+	int64_t now = k_uptime_get();
+
+	atomic_set(&wifiStats.reconnectTime,now - connectStart);
+	if (linkLost != 0)
+	{
+		atomic_set(&wifiStats.outageTime,now - linkLost);
+		LOG_INF("Link up after %d ms outage (reconnection %d ms)", (int32_t)(now - linkLost), (int32_t)(now - connectStart));
+		linkLost = 0;
+	}
+
+	context.ip_assigned = true;
+}
+
+
+//------------------------------------------------------------------------------------------------
+/*! @brief wifi events callback (connect, disconnect and scan)  */		
 static void wifi_mgmt_event_handler(struct net_mgmt_event_callback *cb, uint32_t mgmt_event, struct net_if *iface)
 {
 	switch (mgmt_event) 
@@ -193,6 +462,12 @@ static void wifi_mgmt_event_handler(struct net_mgmt_event_callback *cb, uint32_t
 	case NET_EVENT_WIFI_DISCONNECT_RESULT:		//disconnect event
 		handle_wifi_disconnect_result(cb);		//call function
 		break;
+	case NET_EVENT_WIFI_SCAN_RESULT:			//access point found
+		handle_wifi_scan_result(cb);			//call function
+		break;
+	case NET_EVENT_WIFI_SCAN_DONE:				//end of scan
+		handle_wifi_scan_done();				//call function
+		break;
 	default:
 		break;
 	}
@@ -237,15 +512,61 @@ static void handle_wifi_disconnect_result(struct net_mgmt_event_callback *cb)
 	{
 		LOG_INF("Disconnection request %s (%d)", status->status ? "failed" : "done", status->status);
 		context.disconnect_requested = false;
+		context.connected = false;
+		context.ip_assigned = false;
 	} 
 	else //disconnected
 	{
 		LOG_INF("Received Disconnected");
+		linkLost = k_uptime_get();					//start of the outage
 		memset(&context, 0, sizeof(context));		//reset context
 	}
 
 }
 
+//------------------------------------------------------------------------------------------------
+/*! @brief wifi scan event function : keeps the best access point of each
+ *         configured router */
+
+static void handle_wifi_scan_result(struct net_mgmt_event_callback *cb)
+{
+	const struct wifi_scan_result *entry = (const struct wifi_scan_result *)cb->info;
+
+	for (int n = 0; n < networkCount; n++)
+	{
+		tWifiNetwork * net = &networks[n];
+
+		if (entry->ssid_length == net->params.ssid_length && 
+			memcmp(entry->ssid, net->params.ssid, entry->ssid_length) == 0 &&
+			entry->rssi > net->scanRssi)
+		{
+			net->scanRssi = entry->rssi;
+			net->scanChannel = entry->channel;
+		}
+	}
+}
+
+//------------------------------------------------------------------------------------------------
+/*! @brief wifi scan done function : updates the rssi and the channel of the
+ *         routers found */
+
+static void handle_wifi_scan_done(void)
+{
+	for (int n = 0; n < networkCount; n++)
+	{
+		tWifiNetwork * net = &networks[n];
+
+		if (net->scanRssi == INT8_MIN)		//not found
+			continue;
+
+		net->rssi = net->scanRssi;
+		net->seen = k_uptime_get();
+		if (n != currentNetwork)			//the channel of the current router is known from the status
+			net->params.channel = net->scanChannel;
+	}
+	scanRunning = false;
+}
+
 
 //------------------------------------------------------------------------------------------------
 /*! @brief net event callback (dhcp) */
@@ -256,7 +577,8 @@ static void net_mgmt_event_handler(struct net_mgmt_event_callback *cb, uint32_t
 	{
 	case NET_EVENT_IPV4_DHCP_BOUND:		//ip address assigned
 		print_dhcp_ip(cb);				//print informations
-		context.ip_assigned=true;		//set context
+		wifi_lease_store(cb->info);		//keep the lease for the next connection
+		wifi_link_up();					//set context
 		break;
 	default:
 		break;
@@ -287,6 +609,9 @@ static int __wifi_args_to_params(struct wifi_connect_req_params *params, const c
 	// no timeout
 	params->timeout = SYS_FOREVER_MS;		
 
+	if (ssid == NULL)		//router not configured
+		return -EINVAL;
+
 	/* SSID */
 	params->ssid=ssid;
 	params->ssid_length = strlen(params->ssid);
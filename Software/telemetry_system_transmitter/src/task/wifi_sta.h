@@ -39,8 +39,10 @@ void Task_Wifi_Sta_Init( void );
 //functions prototypes
 
 /*! @brief connection handler must be called after the wifi_connect request.
- *         It handles the connection callbacks.
+ *         It handles the connection callbacks and switches to the other
+ *         router when the signal is weak.
+ * @retval router to connect to next
 */
-void connection_handler(void);
+int connection_handler(void);
 
 #endif /* WIFI_STA_H */
\ No newline at end of file